@@ -0,0 +1,305 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Benchmarks for the hash map, against the hash map it replaced
+//
+// The old map hashed each key with djb2, probed with double hashing, compared
+// keys with strcmp, and only grew when a probe sequence covered the whole
+// table. Its keys were the lexer's own copies of each identifier, so its
+// lookups use separately allocated copies of the keys.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchmarks.h"
+#include "engine.h"
+#include "util/container/hashMap.h"
+#include "util/format.h"
+#include "util/functional.h"
+#include "util/hash.h"
+#include "util/intern.h"
+
+/** the old hash map */
+typedef struct {
+  size_t size;
+  size_t capacity;
+  char const **keys;
+  void **values;
+} OldHashMap;
+
+static void oldHashMapInit(OldHashMap *map) {
+  map->size = 0;
+  map->capacity = 8;
+  map->keys = calloc(map->capacity, sizeof(char const *));
+  map->values = malloc(map->capacity * sizeof(void *));
+}
+
+static void *oldHashMapGet(OldHashMap const *map, char const *key) {
+  uint64_t hash = djb2xor(key) % map->capacity;
+  if (map->keys[hash] == NULL) {
+    return NULL;
+  } else if (strcmp(map->keys[hash], key) != 0) {
+    uint64_t hash2 = djb2add(key) + 1;
+    for (size_t idx = (hash + hash2) % map->capacity; idx != hash;
+         idx = (idx + hash2) % map->capacity) {
+      if (map->keys[idx] == NULL) {
+        return NULL;
+      } else if (strcmp(map->keys[idx], key) == 0) {
+        return map->values[idx];
+      }
+    }
+    return NULL;
+  } else {
+    return map->values[hash];
+  }
+}
+
+static int oldHashMapPut(OldHashMap *map, char const *key, void *data) {
+  uint64_t hash = djb2xor(key) % map->capacity;
+  if (map->keys[hash] == NULL) {
+    map->keys[hash] = key;
+    map->values[hash] = data;
+    ++map->size;
+    return 0;
+  } else if (strcmp(map->keys[hash], key) != 0) {
+    uint64_t hash2 = djb2add(key) + 1;
+    for (size_t idx = (hash + hash2) % map->capacity; idx != hash;
+         idx = (idx + hash2) % map->capacity) {
+      if (map->keys[idx] == NULL) {
+        map->keys[idx] = key;
+        map->values[idx] = data;
+        ++map->size;
+        return 0;
+      } else if (strcmp(map->keys[idx], key) == 0) {
+        return -1;
+      }
+    }
+    size_t oldSize = map->capacity;
+    char const **oldKeys = map->keys;
+    void **oldValues = map->values;
+    map->capacity *= 2;
+    map->keys = calloc(map->capacity, sizeof(char const *));
+    map->values = malloc(map->capacity * sizeof(void *));
+    map->size = 0;
+    for (size_t idx = 0; idx < oldSize; ++idx) {
+      if (oldKeys[idx] != NULL)
+        oldHashMapPut(map, oldKeys[idx], oldValues[idx]);
+    }
+    free(oldKeys);
+    free(oldValues);
+    return oldHashMapPut(map, key, data);
+  } else {
+    return -1;
+  }
+}
+
+static void oldHashMapUninit(OldHashMap *map) {
+  free(map->keys);
+  free(map->values);
+}
+
+/** number of distinct names used */
+#define NUM_NAMES 4096
+/** number of names in each local scope */
+#define SCOPE_SIZE 8
+/** number of nested local scopes */
+#define NUM_SCOPES 16
+/** number of times each benchmark is repeated */
+#define REPETITIONS 64
+
+/** name, a separate copy of the name, and the interned name */
+typedef struct {
+  char *name;
+  char *copy;
+  char const *interned;
+} Name;
+
+static Name names[NUM_NAMES];
+/** names that are never inserted, for lookups that miss */
+static Name missing[NUM_NAMES];
+
+static void makeNames(Name *out, char const *prefix) {
+  // identifiers of a few different shapes
+  for (size_t idx = 0; idx < NUM_NAMES; ++idx) {
+    switch (idx % 4) {
+      case 0: {
+        out[idx].name = format("%s%zu", prefix, idx);
+        break;
+      }
+      case 1: {
+        out[idx].name = format("%s_%zu_value", prefix, idx);
+        break;
+      }
+      case 2: {
+        out[idx].name = format("get%sAt%zu", prefix, idx);
+        break;
+      }
+      default: {
+        out[idx].name = format("%c%zu", prefix[0], idx);
+        break;
+      }
+    }
+    out[idx].copy = strdup(out[idx].name);
+    out[idx].interned = internString(out[idx].name);
+  }
+}
+
+static void freeNames(Name *out) {
+  for (size_t idx = 0; idx < NUM_NAMES; ++idx) {
+    free(out[idx].name);
+    free(out[idx].copy);
+  }
+}
+
+static void benchInsert(void) {
+  double oldTime = 0;
+  double newTime = 0;
+  for (size_t rep = 0; rep < REPETITIONS; ++rep) {
+    double start = benchNow();
+    OldHashMap oldMap;
+    oldHashMapInit(&oldMap);
+    for (size_t idx = 0; idx < NUM_NAMES; ++idx)
+      oldHashMapPut(&oldMap, names[idx].name, &names[idx]);
+    benchKeep(oldMap.keys);
+    oldHashMapUninit(&oldMap);
+    double middle = benchNow();
+    HashMap newMap;
+    hashMapInit(&newMap);
+    for (size_t idx = 0; idx < NUM_NAMES; ++idx)
+      hashMapPut(&newMap, names[idx].interned, &names[idx]);
+    benchKeep(newMap.keys);
+    hashMapUninit(&newMap, nullDtor);
+    double end = benchNow();
+    oldTime += middle - start;
+    newTime += end - middle;
+  }
+  benchReport("hashMap: insert 4096 names (old)", oldTime,
+              REPETITIONS * NUM_NAMES);
+  benchReport("hashMap: insert 4096 names (new)", newTime,
+              REPETITIONS * NUM_NAMES);
+}
+
+static void benchLookup(void) {
+  OldHashMap oldMap;
+  oldHashMapInit(&oldMap);
+  HashMap newMap;
+  hashMapInit(&newMap);
+  for (size_t idx = 0; idx < NUM_NAMES; ++idx) {
+    oldHashMapPut(&oldMap, names[idx].name, &names[idx]);
+    hashMapPut(&newMap, names[idx].interned, &names[idx]);
+  }
+
+  double oldHit = 0;
+  double newHit = 0;
+  double oldMiss = 0;
+  double newMiss = 0;
+  for (size_t rep = 0; rep < REPETITIONS; ++rep) {
+    double start = benchNow();
+    for (size_t idx = 0; idx < NUM_NAMES; ++idx)
+      benchKeep(oldHashMapGet(&oldMap, names[idx].copy));
+    double oldHitEnd = benchNow();
+    for (size_t idx = 0; idx < NUM_NAMES; ++idx)
+      benchKeep(hashMapGet(&newMap, names[idx].interned));
+    double newHitEnd = benchNow();
+    for (size_t idx = 0; idx < NUM_NAMES; ++idx)
+      benchKeep(oldHashMapGet(&oldMap, missing[idx].copy));
+    double oldMissEnd = benchNow();
+    for (size_t idx = 0; idx < NUM_NAMES; ++idx)
+      benchKeep(hashMapGet(&newMap, missing[idx].interned));
+    double newMissEnd = benchNow();
+    oldHit += oldHitEnd - start;
+    newHit += newHitEnd - oldHitEnd;
+    oldMiss += oldMissEnd - newHitEnd;
+    newMiss += newMissEnd - oldMissEnd;
+  }
+  benchReport("hashMap: lookup hit, 4096 names (old)", oldHit,
+              REPETITIONS * NUM_NAMES);
+  benchReport("hashMap: lookup hit, 4096 names (new)", newHit,
+              REPETITIONS * NUM_NAMES);
+  benchReport("hashMap: lookup miss, 4096 names (old)", oldMiss,
+              REPETITIONS * NUM_NAMES);
+  benchReport("hashMap: lookup miss, 4096 names (new)", newMiss,
+              REPETITIONS * NUM_NAMES);
+
+  oldHashMapUninit(&oldMap);
+  hashMapUninit(&newMap, nullDtor);
+}
+
+/**
+ * name resolution as done by the environment: NUM_SCOPES local scopes of
+ * SCOPE_SIZE names each are searched innermost first, then the module's
+ * symbol table, which holds the rest of the names
+ */
+static void benchScopedLookup(void) {
+  OldHashMap oldScopes[NUM_SCOPES + 1];
+  HashMap newScopes[NUM_SCOPES + 1];
+  for (size_t scope = 0; scope <= NUM_SCOPES; ++scope) {
+    oldHashMapInit(&oldScopes[scope]);
+    hashMapInit(&newScopes[scope]);
+  }
+  for (size_t idx = 0; idx < NUM_NAMES; ++idx) {
+    size_t scope = idx / SCOPE_SIZE < NUM_SCOPES ? idx / SCOPE_SIZE + 1 : 0;
+    oldHashMapPut(&oldScopes[scope], names[idx].name, &names[idx]);
+    hashMapPut(&newScopes[scope], names[idx].interned, &names[idx]);
+  }
+
+  double oldTime = 0;
+  double newTime = 0;
+  for (size_t rep = 0; rep < REPETITIONS; ++rep) {
+    double start = benchNow();
+    for (size_t idx = 0; idx < NUM_NAMES; ++idx) {
+      void *found = NULL;
+      for (size_t scope = NUM_SCOPES + 1; scope-- > 0 && found == NULL;)
+        found = oldHashMapGet(&oldScopes[scope], names[idx].copy);
+      benchKeep(found);
+    }
+    double middle = benchNow();
+    for (size_t idx = 0; idx < NUM_NAMES; ++idx) {
+      void *found = NULL;
+      for (size_t scope = NUM_SCOPES + 1; scope-- > 0 && found == NULL;)
+        found = hashMapGet(&newScopes[scope], names[idx].interned);
+      benchKeep(found);
+    }
+    double end = benchNow();
+    oldTime += middle - start;
+    newTime += end - middle;
+  }
+  benchReport("hashMap: resolve through 16 scopes (old)", oldTime,
+              REPETITIONS * NUM_NAMES);
+  benchReport("hashMap: resolve through 16 scopes (new)", newTime,
+              REPETITIONS * NUM_NAMES);
+
+  for (size_t scope = 0; scope <= NUM_SCOPES; ++scope) {
+    oldHashMapUninit(&oldScopes[scope]);
+    hashMapUninit(&newScopes[scope], nullDtor);
+  }
+}
+
+void benchHashMap(void) {
+  makeNames(names, "name");
+  makeNames(missing, "other");
+
+  benchInsert();
+  benchLookup();
+  benchScopedLookup();
+
+  freeNames(names);
+  freeNames(missing);
+}
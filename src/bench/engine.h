@@ -0,0 +1,53 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/**
+ * @file
+ * benchmark timing engine
+ */
+
+#ifndef TLC_BENCH_ENGINE_H_
+#define TLC_BENCH_ENGINE_H_
+
+#include <stddef.h>
+
+/**
+ * gets the current time
+ *
+ * @returns monotonic time, in nanoseconds
+ */
+double benchNow(void);
+
+/**
+ * reports the result of a benchmark
+ *
+ * @param name name of benchmark
+ * @param nanoseconds total time taken
+ * @param operations number of operations timed
+ */
+void benchReport(char const *name, double nanoseconds, size_t operations);
+
+/**
+ * keeps a result from being optimized away
+ *
+ * @param value result to keep
+ */
+void benchKeep(void const *value);
+
+#endif  // TLC_BENCH_ENGINE_H_
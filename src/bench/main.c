@@ -0,0 +1,42 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Calls all benchmark modules
+//
+// Benchmarks should be run from a release build (make bench)
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "benchmarks.h"
+
+static bool containsString(size_t argc, char **argv, char const *string) {
+  for (size_t idx = 1; idx < argc; ++idx) {
+    if (strcmp(argv[idx], string) == 0) return true;
+  }
+  return false;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc <= 1 || containsString((size_t)argc, argv, "hashMap"))
+    benchHashMap();
+
+  return 0;
+}
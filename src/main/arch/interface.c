@@ -77,10 +77,11 @@ IROperand *generateFunctionCall(IRBlock *b, IROperand *fun, IROperand **args,
   }
 }
 
-int validateIRArchSpecific(char const *phase, bool blocked) {
+int validateIRArchSpecific(FileListEntry *file, char const *phase,
+                           bool blocked) {
   switch (options.arch) {
     case OPTION_A_X86_64_LINUX: {
-      return x86_64LinuxValidateIRArchSpecific(phase, blocked);
+      return x86_64LinuxValidateIRArchSpecific(file, phase, blocked);
     }
     default: {
       error(__FILE__, __LINE__, "unrecognized architecture");
@@ -98,4 +99,15 @@ void backend(void) {
       error(__FILE__, __LINE__, "unrecognized architecture");
     }
   }
+}
+void backendFile(FileListEntry *file) {
+  switch (options.arch) {
+    case OPTION_A_X86_64_LINUX: {
+      x86_64LinuxBackendFile(file);
+      break;
+    }
+    default: {
+      error(__FILE__, __LINE__, "unrecognized architecture");
+    }
+  }
 }
\ No newline at end of file
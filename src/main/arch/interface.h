@@ -77,17 +77,26 @@ IROperand *generateFunctionCall(IRBlock *b, IROperand *fun, IROperand **args,
                                 Type const *funType, FileListEntry *file);
 
 /**
- * validate generated IR
+ * validate one file's generated IR
  *
+ * @param file file to validate
  * @param phase phase to blame for errors
  * @param blocked is the IR in basic blocks?
  * @returns -1 on failure, 0 on success
  */
-int validateIRArchSpecific(char const *phase, bool blocked);
+int validateIRArchSpecific(FileListEntry *file, char const *phase,
+                           bool blocked);
 
 /**
  * run the backend
  */
 void backend(void);
 
+/**
+ * run the backend on one code file, and free its IR
+ *
+ * @param file file to run the backend on
+ */
+void backendFile(FileListEntry *file);
+
 #endif  // TLC_ARCH_INTERFACE_H_
\ No newline at end of file
@@ -105,22 +105,15 @@ static TypeClass *layout(Type const *t) {
           for (size_t idx = 0; idx < size; ++idx)
             retval[idx] = X86_64_LINUX_TC_NO_CLASS;
 
-          size_t offset = 0;
           for (size_t idx = 0; idx < entry->data.structType.fieldTypes.size;
                ++idx) {
             Type const *fieldType =
                 entry->data.structType.fieldTypes.elements[idx];
             size_t fieldSize = typeSizeof(fieldType);
             TypeClass *fieldLayout = layout(fieldType);
-            memcpy(retval + offset, fieldLayout, sizeof(TypeClass) * fieldSize);
+            memcpy(retval + entry->data.structType.fieldOffsets[idx],
+                   fieldLayout, sizeof(TypeClass) * fieldSize);
             free(fieldLayout);
-
-            offset += fieldSize;
-            if (idx < entry->data.structType.fieldTypes.size - 1)
-              offset = incrementToMultiple(
-                  offset,
-                  typeAlignof(
-                      entry->data.structType.fieldTypes.elements[idx + 1]));
           }
           return retval;
         }
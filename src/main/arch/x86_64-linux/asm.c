@@ -5879,28 +5879,25 @@ static X86_64LinuxFrag *x86_64LinuxGenerateTextAsm(IRFrag *frag,
   }
   return assembly;
 }
-void x86_64LinuxGenerateAsm(void) {
-  for (size_t fileIdx = 0; fileIdx < fileList.size; ++fileIdx) {
-    FileListEntry *file = &fileList.entries[fileIdx];
-    X86_64LinuxFile *asmFile = file->asmFile =
-        x86_64LinuxFileCreate(format("lprefix .\n"), strdup(""));
-
-    for (size_t fragIdx = 0; fragIdx < file->irFrags.size; ++fragIdx) {
-      IRFrag *frag = file->irFrags.elements[fragIdx];
-      switch (frag->type) {
-        case FT_BSS:
-        case FT_RODATA:
-        case FT_DATA: {
-          vectorInsert(&asmFile->frags, x86_64LinuxGenerateDataAsm(frag));
-          break;
-        }
-        case FT_TEXT: {
-          vectorInsert(&asmFile->frags, x86_64LinuxGenerateTextAsm(frag, file));
-          break;
-        }
-        default: {
-          error(__FILE__, __LINE__, "invalid fragment type");
-        }
+void x86_64LinuxGenerateAsm(FileListEntry *file) {
+  X86_64LinuxFile *asmFile = file->asmFile =
+      x86_64LinuxFileCreate(format("lprefix .\n"), strdup(""));
+
+  for (size_t fragIdx = 0; fragIdx < file->irFrags.size; ++fragIdx) {
+    IRFrag *frag = file->irFrags.elements[fragIdx];
+    switch (frag->type) {
+      case FT_BSS:
+      case FT_RODATA:
+      case FT_DATA: {
+        vectorInsert(&asmFile->frags, x86_64LinuxGenerateDataAsm(frag));
+        break;
+      }
+      case FT_TEXT: {
+        vectorInsert(&asmFile->frags, x86_64LinuxGenerateTextAsm(frag, file));
+        break;
+      }
+      default: {
+        error(__FILE__, __LINE__, "invalid fragment type");
       }
     }
   }
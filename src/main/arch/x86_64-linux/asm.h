@@ -181,8 +181,10 @@ typedef struct {
 void x86_64LinuxFileFree(X86_64LinuxFile *file);
 
 /**
- * generate assembly from IR
+ * generate assembly for one file from its IR
+ *
+ * @param file file to generate assembly for
  */
-void x86_64LinuxGenerateAsm(void);
+void x86_64LinuxGenerateAsm(FileListEntry *file);
 
 #endif  // TLC_ARCH_X86_64_LINUX_ASM_H_
\ No newline at end of file
@@ -22,14 +22,14 @@
 #include "arch/x86_64-linux/asm.h"
 #include "fileList.h"
 #include "ir/ir.h"
+#include "util/threadPool.h"
 
-void x86_64LinuxBackend(void) {
+void x86_64LinuxBackendFile(FileListEntry *file) {
   // assembly generation
-  x86_64LinuxGenerateAsm();
+  x86_64LinuxGenerateAsm(file);
 
   // done with IR
-  for (size_t idx = 0; idx < fileList.size; ++idx)
-    vectorUninit(&fileList.entries[idx].irFrags, (void (*)(void *))irFragFree);
+  vectorUninit(&file->irFrags, (void (*)(void *))irFragFree);
 
   // assembly optimization 1
   // TODO
@@ -44,6 +44,15 @@ void x86_64LinuxBackend(void) {
   // TODO
 
   // cleanup
-  for (size_t idx = 0; idx < fileList.size; ++idx)
-    x86_64LinuxFileFree(fileList.entries[idx].asmFile);
-}
\ No newline at end of file
+  x86_64LinuxFileFree(file->asmFile);
+  file->asmFile = NULL;
+}
+
+static void x86_64LinuxBackendTask(size_t fileIdx, void *ignored) {
+  (void)ignored;
+  x86_64LinuxBackendFile(&fileList.entries[fileIdx]);
+}
+
+void x86_64LinuxBackend(void) {
+  threadPoolRun(fileList.size, x86_64LinuxBackendTask, NULL);
+}
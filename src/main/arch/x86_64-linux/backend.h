@@ -25,6 +25,18 @@
 #ifndef TLC_ARCH_X86_64_LINUX_BACKEND_H_
 #define TLC_ARCH_X86_64_LINUX_BACKEND_H_
 
+#include "fileList.h"
+
+/**
+ * runs the backend on all files
+ */
 void x86_64LinuxBackend(void);
 
+/**
+ * runs the backend on one file, freeing its IR
+ *
+ * @param file file to run the backend on
+ */
+void x86_64LinuxBackendFile(FileListEntry *file);
+
 #endif  // TLC_ARCH_X86_64_LINUX_BACKEND_H_
\ No newline at end of file
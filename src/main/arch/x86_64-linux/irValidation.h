@@ -22,16 +22,20 @@
 
 #include <stdbool.h>
 
+#include "fileList.h"
+
 /**
- * checks that all files in the file list have valid IR
+ * checks that a file has valid IR
  *
  * This checks that
  *  - all registers referenced are of normal size
  *
+ * @param file file to check
  * @param phase phase to blame for errors
  * @param blocked is the IR in blocks
  * @returns -1 on failure, 0 on success
  */
-int x86_64LinuxValidateIRArchSpecific(char const *phase, bool blocked);
+int x86_64LinuxValidateIRArchSpecific(FileListEntry *file, char const *phase,
+                                      bool blocked);
 
 #endif  // TLC_ARCH_X86_64_LINUX_IRVALIDATION_H_
\ No newline at end of file
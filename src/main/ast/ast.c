@@ -26,7 +26,10 @@
 #include "lexer/lexer.h"
 #include "util/container/stringBuilder.h"
 #include "util/conversions.h"
+#include "util/diagnostics.h"
 #include "util/format.h"
+#include "util/functional.h"
+#include "util/intern.h"
 #include "util/internalError.h"
 #include "util/numericSizing.h"
 
@@ -250,6 +253,11 @@ UnOpType postfixTokenToUnop(TokenType token) {
   }
 }
 
+/** arena to allocate nodes from */
+static _Thread_local Arena *currentArena = NULL;
+
+void nodeArenaSet(Arena *arena) { currentArena = arena; }
+
 /**
  * create a partially initialized node
  *
@@ -258,29 +266,123 @@ UnOpType postfixTokenToUnop(TokenType token) {
  * @param character character to attribute node to
  */
 static Node *createNode(NodeType type, size_t line, size_t character) {
-  Node *n = malloc(sizeof(Node));
+  if (currentArena == NULL)
+    error(__FILE__, __LINE__, "node created with no arena set");
+  Node *n = arenaAlloc(currentArena, sizeof(Node));
   n->type = type;
   n->line = line;
   n->character = character;
   return n;
 }
 
+/**
+ * moves a vector a node takes ownership of into the current arena
+ *
+ * @param v vector to move, may be null
+ * @returns moved vector, which can't grow any more
+ */
+static Vector *arenaVector(Vector *v) {
+  if (v == NULL) return NULL;
+  Vector *moved = arenaAlloc(currentArena, sizeof(Vector));
+  moved->size = v->size;
+  moved->capacity = v->size;
+  moved->elements = arenaAlloc(currentArena, sizeof(void *) * v->size);
+  memcpy(moved->elements, v->elements, sizeof(void *) * v->size);
+  vectorUninit(v, nullDtor);
+  free(v);
+  return moved;
+}
+
+/**
+ * releases what a node owns outside of its arena - registered as a cleanup
+ * with the arena for nodes that own anything
+ */
+static void nodeRelease(Node *n) {
+  switch (n->type) {
+    case NT_FILE: {
+      stabFree(n->data.file.stab);
+      if (n->data.file.index != NULL) {
+        hashMapUninit(n->data.file.index, nullDtor);
+        free(n->data.file.index);
+      }
+      // imports and bodies are added to after the file node is created
+      nodeVectorFree(n->data.file.imports);
+      nodeVectorFree(n->data.file.bodies);
+      break;
+    }
+    case NT_FUNDEFN: {
+      stabFree(n->data.funDefn.argStab);
+      break;
+    }
+    case NT_COMPOUNDSTMT: {
+      stabFree(n->data.compoundStmt.stab);
+      break;
+    }
+    case NT_IFSTMT: {
+      stabFree(n->data.ifStmt.consequentStab);
+      stabFree(n->data.ifStmt.alternativeStab);
+      break;
+    }
+    case NT_WHILESTMT: {
+      stabFree(n->data.whileStmt.bodyStab);
+      break;
+    }
+    case NT_DOWHILESTMT: {
+      stabFree(n->data.doWhileStmt.bodyStab);
+      break;
+    }
+    case NT_FORSTMT: {
+      stabFree(n->data.forStmt.loopStab);
+      stabFree(n->data.forStmt.bodyStab);
+      break;
+    }
+    case NT_SWITCHCASE: {
+      stabFree(n->data.switchCase.bodyStab);
+      break;
+    }
+    case NT_SWITCHDEFAULT: {
+      stabFree(n->data.switchDefault.bodyStab);
+      break;
+    }
+    case NT_UNPARSED: {
+      unparsedNodeFreeTokens(n);
+      break;
+    }
+    default: {
+      error(__FILE__, __LINE__, "node with nothing to release registered");
+    }
+  }
+}
+
+/**
+ * has the current arena release what a node owns outside of it
+ */
+static void registerRelease(Node *n) {
+  arenaAddCleanup(currentArena, (void (*)(void *))nodeRelease, n);
+}
+
 Node *fileNodeCreate(Node *module, Vector *imports, Vector *bodies) {
   Node *n = createNode(NT_FILE, module->line, module->character);
   n->data.file.stab = hashMapCreate();
+  n->data.file.index = NULL;
   n->data.file.module = module;
   n->data.file.imports = imports;
   n->data.file.bodies = bodies;
+  n->data.file.arena = NULL;
+  n->data.file.bodyArena = NULL;
+  registerRelease(n);
   return n;
 }
 Node *moduleNodeCreate(Token const *keyword, Node *id) {
   Node *n = createNode(NT_MODULE, keyword->line, keyword->character);
   n->data.module.id = id;
+  n->data.module.name = internId(id, 0);
   return n;
 }
 Node *importNodeCreate(Token const *keyword, Node *id) {
   Node *n = createNode(NT_IMPORT, keyword->line, keyword->character);
   n->data.import.id = id;
+  n->data.import.name = internId(id, 0);
   n->data.import.referenced = NULL;
   return n;
 }
@@ -290,17 +392,18 @@ Node *funDefnNodeCreate(Node *returnType, Node *name, Vector *argTypes,
   Node *n = createNode(NT_FUNDEFN, returnType->line, returnType->character);
   n->data.funDefn.returnType = returnType;
   n->data.funDefn.name = name;
-  n->data.funDefn.argTypes = argTypes;
-  n->data.funDefn.argNames = argNames;
+  n->data.funDefn.argTypes = arenaVector(argTypes);
+  n->data.funDefn.argNames = arenaVector(argNames);
   n->data.funDefn.argStab = hashMapCreate();
   n->data.funDefn.body = body;
+  registerRelease(n);
   return n;
 }
 Node *varDefnNodeCreate(Node *type, Vector *names, Vector *initializers) {
   Node *n = createNode(NT_VARDEFN, type->line, type->character);
   n->data.varDefn.type = type;
-  n->data.varDefn.names = names;
-  n->data.varDefn.initializers = initializers;
+  n->data.varDefn.names = arenaVector(names);
+  n->data.varDefn.initializers = arenaVector(initializers);
   return n;
 }
 
@@ -309,14 +412,14 @@ Node *funDeclNodeCreate(Node *returnType, Node *name, Vector *argTypes,
   Node *n = createNode(NT_FUNDECL, returnType->line, returnType->character);
   n->data.funDecl.returnType = returnType;
   n->data.funDecl.name = name;
-  n->data.funDecl.argTypes = argTypes;
-  n->data.funDecl.argNames = argNames;
+  n->data.funDecl.argTypes = arenaVector(argTypes);
+  n->data.funDecl.argNames = arenaVector(argNames);
   return n;
 }
 Node *varDeclNodeCreate(Node *type, Vector *names) {
   Node *n = createNode(NT_VARDECL, type->line, type->character);
   n->data.varDecl.type = type;
-  n->data.varDecl.names = names;
+  n->data.varDecl.names = arenaVector(names);
   return n;
 }
 Node *opaqueDeclNodeCreate(Token const *keyword, Node *name) {
@@ -327,21 +430,21 @@ Node *opaqueDeclNodeCreate(Token const *keyword, Node *name) {
 Node *structDeclNodeCreate(Token const *keyword, Node *name, Vector *fields) {
   Node *n = createNode(NT_STRUCTDECL, keyword->line, keyword->character);
   n->data.structDecl.name = name;
-  n->data.structDecl.fields = fields;
+  n->data.structDecl.fields = arenaVector(fields);
   return n;
 }
 Node *unionDeclNodeCreate(Token const *keyword, Node *name, Vector *options) {
   Node *n = createNode(NT_UNIONDECL, keyword->line, keyword->character);
   n->data.unionDecl.name = name;
-  n->data.unionDecl.options = options;
+  n->data.unionDecl.options = arenaVector(options);
   return n;
 }
 Node *enumDeclNodeCreate(Token const *keyword, Node *name,
                          Vector *constantNames, Vector *constantValues) {
   Node *n = createNode(NT_ENUMDECL, keyword->line, keyword->character);
   n->data.enumDecl.name = name;
-  n->data.enumDecl.constantNames = constantNames;
-  n->data.enumDecl.constantValues = constantValues;
+  n->data.enumDecl.constantNames = arenaVector(constantNames);
+  n->data.enumDecl.constantValues = arenaVector(constantValues);
   return n;
 }
 Node *typedefDeclNodeCreate(Token const *keyword, Node *originalType,
@@ -356,7 +459,8 @@ Node *compoundStmtNodeCreate(Token const *lbrace, Vector *stmts,
                              HashMap *stab) {
   Node *n = createNode(NT_COMPOUNDSTMT, lbrace->line, lbrace->character);
   n->data.compoundStmt.stab = stab;
-  n->data.compoundStmt.stmts = stmts;
+  n->data.compoundStmt.stmts = arenaVector(stmts);
+  registerRelease(n);
   return n;
 }
 Node *ifStmtNodeCreate(Token const *keyword, Node *predicate, Node *consequent,
@@ -368,6 +472,7 @@ Node *ifStmtNodeCreate(Token const *keyword, Node *predicate, Node *consequent,
   n->data.ifStmt.consequentStab = consequentStab;
   n->data.ifStmt.alternative = alternative;
   n->data.ifStmt.alternativeStab = alternativeStab;
+  registerRelease(n);
   return n;
 }
 Node *whileStmtNodeCreate(Token const *keyword, Node *condition, Node *body,
@@ -376,6 +481,7 @@ Node *whileStmtNodeCreate(Token const *keyword, Node *condition, Node *body,
   n->data.whileStmt.condition = condition;
   n->data.whileStmt.body = body;
   n->data.whileStmt.bodyStab = bodyStab;
+  registerRelease(n);
   return n;
 }
 Node *doWhileStmtNodeCreate(Token const *keyword, Node *body, HashMap *bodyStab,
@@ -384,6 +490,7 @@ Node *doWhileStmtNodeCreate(Token const *keyword, Node *body, HashMap *bodyStab,
   n->data.doWhileStmt.body = body;
   n->data.doWhileStmt.bodyStab = bodyStab;
   n->data.doWhileStmt.condition = condition;
+  registerRelease(n);
   return n;
 }
 Node *forStmtNodeCreate(Token const *keyword, HashMap *loopStab,
@@ -396,13 +503,14 @@ Node *forStmtNodeCreate(Token const *keyword, HashMap *loopStab,
   n->data.forStmt.increment = increment;
   n->data.forStmt.body = body;
   n->data.forStmt.bodyStab = bodyStab;
+  registerRelease(n);
   return n;
 }
 Node *switchStmtNodeCreate(Token const *keyword, Node *condition,
                            Vector *cases) {
   Node *n = createNode(NT_SWITCHSTMT, keyword->line, keyword->character);
   n->data.switchStmt.condition = condition;
-  n->data.switchStmt.cases = cases;
+  n->data.switchStmt.cases = arenaVector(cases);
   return n;
 }
 Node *breakStmtNodeCreate(Token const *keyword) {
@@ -421,8 +529,8 @@ Node *returnStmtNodeCreate(Token const *keyword, Node *value) {
 Node *varDefnStmtNodeCreate(Node *type, Vector *names, Vector *initializers) {
   Node *n = createNode(NT_VARDEFNSTMT, type->line, type->character);
   n->data.varDefnStmt.type = type;
-  n->data.varDefnStmt.names = names;
-  n->data.varDefnStmt.initializers = initializers;
+  n->data.varDefnStmt.names = arenaVector(names);
+  n->data.varDefnStmt.initializers = arenaVector(initializers);
   return n;
 }
 Node *expressionStmtNodeCreate(Node *expression) {
@@ -439,9 +547,10 @@ Node *nullStmtNodeCreate(Token const *semicolon) {
 Node *switchCaseNodeCreate(Token const *keyword, Vector *values, Node *body,
                            HashMap *bodyStab) {
   Node *n = createNode(NT_SWITCHCASE, keyword->line, keyword->character);
-  n->data.switchCase.values = values;
+  n->data.switchCase.values = arenaVector(values);
   n->data.switchCase.body = body;
   n->data.switchCase.bodyStab = bodyStab;
+  registerRelease(n);
   return n;
 }
 Node *switchDefaultNodeCreate(Token const *keyword, Node *body,
@@ -449,6 +558,7 @@ Node *switchDefaultNodeCreate(Token const *keyword, Node *body,
   Node *n = createNode(NT_SWITCHDEFAULT, keyword->line, keyword->character);
   n->data.switchDefault.body = body;
   n->data.switchDefault.bodyStab = bodyStab;
+  registerRelease(n);
   return n;
 }
 
@@ -505,7 +615,7 @@ Node *sizeofTypeExpNodeCreate(Token const *opToken, Node *targetNode,
 Node *funCallExpNodeCreate(Node *function, Vector *arguments) {
   Node *n = createNode(NT_FUNCALLEXP, function->line, function->character);
   n->data.funCallExp.function = function;
-  n->data.funCallExp.arguments = arguments;
+  n->data.funCallExp.arguments = arenaVector(arguments);
   n->data.funCallExp.type = NULL;
   return n;
 }
@@ -516,12 +626,17 @@ Node *literalNodeCreate(LiteralType type, Token const *t) {
   n->data.literal.type = NULL;
   return n;
 }
+Node *aggregateInitLiteralNodeCreate(Token const *lsquare, Vector *literals) {
+  Node *n = literalNodeCreate(LT_AGGREGATEINIT, lsquare);
+  n->data.literal.data.aggregateInitVal = arenaVector(literals);
+  return n;
+}
 Node *charLiteralNodeCreate(Token *t) {
   Node *n = createNode(NT_LITERAL, t->line, t->character);
   n->data.literal.literalType = LT_CHAR;
   n->data.literal.type = NULL;
 
-  char *string = t->string;
+  char const *string = t->string;
 
   if (string[0] == '\\') {
     // escape sequence
@@ -565,7 +680,6 @@ Node *charLiteralNodeCreate(Token *t) {
     n->data.literal.data.charVal = charToU8(string[0]);
   }
 
-  tokenUninit(t);
   return n;
 }
 Node *wcharLiteralNodeCreate(Token *t) {
@@ -573,7 +687,7 @@ Node *wcharLiteralNodeCreate(Token *t) {
   n->data.literal.literalType = LT_WCHAR;
   n->data.literal.type = NULL;
 
-  char *string = t->string;
+  char const *string = t->string;
 
   if (string[0] == '\\') {
     // escape sequence
@@ -625,7 +739,6 @@ Node *wcharLiteralNodeCreate(Token *t) {
     n->data.literal.data.wcharVal = charToU8(string[0]);
   }
 
-  tokenUninit(t);
   return n;
 }
 Node *stringLiteralNodeCreate(Token *t) {
@@ -635,7 +748,8 @@ Node *stringLiteralNodeCreate(Token *t) {
 
   TStringBuilder sb;
   tstringBuilderInit(&sb);
-  for (char *string = t->string; *string != '\0'; ++string) {
+  char const *end = t->string + t->length;
+  for (char const *string = t->string; string != end; ++string) {
     if (*string == '\\') {
       ++string;
       // escape sequence
@@ -682,9 +796,11 @@ Node *stringLiteralNodeCreate(Token *t) {
     }
   }
 
-  n->data.literal.data.stringVal = tstringBuilderData(&sb);
+  n->data.literal.data.stringVal =
+      arenaAlloc(currentArena, sizeof(uint8_t) * (sb.size + 1));
+  memcpy(n->data.literal.data.stringVal, sb.string, sizeof(uint8_t) * sb.size);
+  n->data.literal.data.stringVal[sb.size] = '\0';
   tstringBuilderUninit(&sb);
-  tokenUninit(t);
   return n;
 }
 Node *wstringLiteralNodeCreate(Token *t) {
@@ -694,7 +810,8 @@ Node *wstringLiteralNodeCreate(Token *t) {
 
   TWStringBuilder sb;
   twstringBuilderInit(&sb);
-  for (char *string = t->string; *string != '\0'; ++string) {
+  char const *end = t->string + t->length;
+  for (char const *string = t->string; string != end; ++string) {
     if (*string == '\\') {
       ++string;
       // escape sequence
@@ -751,9 +868,12 @@ Node *wstringLiteralNodeCreate(Token *t) {
     }
   }
 
-  n->data.literal.data.wstringVal = twstringBuilderData(&sb);
+  n->data.literal.data.wstringVal =
+      arenaAlloc(currentArena, sizeof(uint32_t) * (sb.size + 1));
+  memcpy(n->data.literal.data.wstringVal, sb.string,
+         sizeof(uint32_t) * sb.size);
+  n->data.literal.data.wstringVal[sb.size] = '\0';
   twstringBuilderUninit(&sb);
-  tokenUninit(t);
   return n;
 }
 Node *sizedIntegerLiteralNodeCreate(Token *t, int8_t sign, uint64_t magnitude) {
@@ -762,22 +882,18 @@ Node *sizedIntegerLiteralNodeCreate(Token *t, int8_t sign, uint64_t magnitude) {
     if (magnitude <= UBYTE_MAX) {
       Node *n = literalNodeCreate(LT_UBYTE, t);
       n->data.literal.data.ubyteVal = (uint8_t)magnitude;
-      tokenUninit(t);
       return n;
     } else if (magnitude <= USHORT_MAX) {
       Node *n = literalNodeCreate(LT_USHORT, t);
       n->data.literal.data.ushortVal = (uint16_t)magnitude;
-      tokenUninit(t);
       return n;
     } else if (magnitude <= UINT_MAX) {
       Node *n = literalNodeCreate(LT_UINT, t);
       n->data.literal.data.uintVal = (uint32_t)magnitude;
-      tokenUninit(t);
       return n;
     } else if (magnitude <= ULONG_MAX) {
       Node *n = literalNodeCreate(LT_ULONG, t);
       n->data.literal.data.ulongVal = (uint64_t)magnitude;
-      tokenUninit(t);
       return n;
     } else {
       error(__FILE__, __LINE__,
@@ -789,26 +905,21 @@ Node *sizedIntegerLiteralNodeCreate(Token *t, int8_t sign, uint64_t magnitude) {
     if (magnitude <= BYTE_MIN) {
       Node *n = literalNodeCreate(LT_BYTE, t);
       n->data.literal.data.byteVal = (int8_t)-magnitude;
-      tokenUninit(t);
       return n;
     } else if (magnitude <= SHORT_MIN) {
       Node *n = literalNodeCreate(LT_SHORT, t);
       n->data.literal.data.shortVal = (int16_t)-magnitude;
-      tokenUninit(t);
       return n;
     } else if (magnitude <= INT_MIN) {
       Node *n = literalNodeCreate(LT_INT, t);
       n->data.literal.data.intVal = (int32_t)-magnitude;
-      tokenUninit(t);
       return n;
     } else if (magnitude <= LONG_MIN) {
       Node *n = literalNodeCreate(LT_LONG, t);
       n->data.literal.data.longVal = (int64_t)-magnitude;
-      tokenUninit(t);
       return n;
     } else {
       // user-side size error
-      tokenUninit(t);
       return NULL;
     }
   } else if (sign == 1) {
@@ -816,26 +927,21 @@ Node *sizedIntegerLiteralNodeCreate(Token *t, int8_t sign, uint64_t magnitude) {
     if (magnitude <= BYTE_MAX) {
       Node *n = literalNodeCreate(LT_BYTE, t);
       n->data.literal.data.byteVal = (int8_t)magnitude;
-      tokenUninit(t);
       return n;
     } else if (magnitude <= SHORT_MAX) {
       Node *n = literalNodeCreate(LT_SHORT, t);
       n->data.literal.data.shortVal = (int16_t)magnitude;
-      tokenUninit(t);
       return n;
     } else if (magnitude <= INT_MAX) {
       Node *n = literalNodeCreate(LT_INT, t);
       n->data.literal.data.intVal = (int32_t)magnitude;
-      tokenUninit(t);
       return n;
     } else if (magnitude <= LONG_MAX) {
       Node *n = literalNodeCreate(LT_LONG, t);
       n->data.literal.data.longVal = (int64_t)magnitude;
-      tokenUninit(t);
       return n;
     } else {
       // user-side size error
-      tokenUninit(t);
       return NULL;
     }
   } else {
@@ -866,15 +972,15 @@ Node *funPtrTypeNodeCreate(Node *returnType, Vector *argTypes,
                            Vector *argNames) {
   Node *n = createNode(NT_FUNPTRTYPE, returnType->line, returnType->character);
   n->data.funPtrType.returnType = returnType;
-  n->data.funPtrType.argTypes = argTypes;
-  n->data.funPtrType.argNames = argNames;
+  n->data.funPtrType.argTypes = arenaVector(argTypes);
+  n->data.funPtrType.argNames = arenaVector(argNames);
   return n;
 }
 
 Node *scopedIdNodeCreate(Vector *components) {
   Node *first = components->elements[0];
   Node *n = createNode(NT_SCOPEDID, first->line, first->character);
-  n->data.scopedId.components = components;
+  n->data.scopedId.components = arenaVector(components);
   n->data.scopedId.entry = NULL;
   n->data.scopedId.type = NULL;
   return n;
@@ -887,11 +993,11 @@ Node *idNodeCreate(Token *id) {
   return n;
 }
 
-Node *unparsedNodeCreate(Vector *tokens) {
-  Token const *first = tokens->elements[0];
-  Node *n = createNode(NT_UNPARSED, first->line, first->character);
+Node *unparsedNodeCreate(TokenBuffer *tokens) {
+  Node *n = createNode(NT_UNPARSED, tokens->lines[0], tokens->characters[0]);
   n->data.unparsed.tokens = tokens;
   n->data.unparsed.curr = 0;
+  registerRelease(n);
   return n;
 }
 
@@ -919,8 +1025,29 @@ char *stringifyId(Node *id) {
   }
 }
 
+char const *internId(Node *id, size_t dropCount) {
+  if (id->type == NT_ID) return id->data.id.id;
+
+  Vector const *components = id->data.scopedId.components;
+  StringBuilder sb;
+  stringBuilderInit(&sb);
+  for (size_t idx = 0; idx < components->size - dropCount; ++idx) {
+    if (idx != 0) {
+      stringBuilderPush(&sb, ':');
+      stringBuilderPush(&sb, ':');
+    }
+    Node const *component = components->elements[idx];
+    for (char const *c = component->data.id.id; *c != '\0'; ++c)
+      stringBuilderPush(&sb, *c);
+  }
+  char const *interned = internRange(sb.string, sb.size);
+  stringBuilderUninit(&sb);
+  return interned;
+}
+
 static void errorNotPositive(Node *n, Environment *env) {
-  fprintf(stderr, "%s:%zu:%zu: error: array length must be positive",
+  fprintf(diagnosticStream(),
+          "%s:%zu:%zu: error: array length must be positive",
           env->currentModuleFile->inputFilename, n->line, n->character);
 }
 /**
@@ -996,7 +1123,7 @@ static uint64_t extendedIntLiteralToArrayLength(Node *n, Environment *env) {
       if (enumConst == NULL) {
         return 0;
       } else if (enumConst->kind != SK_ENUMCONST) {
-        fprintf(stderr,
+        fprintf(diagnosticStream(),
                 "%s:%zu:%zu: error: expected an extended integer "
                 "literal, found %s\n",
                 env->currentModuleFile->inputFilename, n->line, n->character,
@@ -1038,8 +1165,8 @@ Type *nodeToType(Node *n, Environment *env) {
         case TMK_CONST: {
           Type *inner = nodeToType(n->data.modifiedType.baseType, env);
           if (inner->kind == TK_QUALIFIED) {
-            inner->data.qualified.constQual = true;
-            return inner;
+            return qualifiedTypeCreate(inner->data.qualified.base, true,
+                                       inner->data.qualified.volatileQual);
           } else {
             return qualifiedTypeCreate(inner, true, false);
           }
@@ -1047,8 +1174,8 @@ Type *nodeToType(Node *n, Environment *env) {
         case TMK_VOLATILE: {
           Type *inner = nodeToType(n->data.modifiedType.baseType, env);
           if (inner->kind == TK_QUALIFIED) {
-            inner->data.qualified.volatileQual = true;
-            return inner;
+            return qualifiedTypeCreate(inner->data.qualified.base,
+                                       inner->data.qualified.constQual, true);
           } else {
             return qualifiedTypeCreate(inner, false, true);
           }
@@ -1070,20 +1197,20 @@ Type *nodeToType(Node *n, Environment *env) {
       Type *inner = nodeToType(n->data.funPtrType.returnType, env);
       if (inner == NULL) return NULL;
 
-      Type *retval = funPtrTypeCreate(inner);
-
+      Vector argTypes;
+      vectorInit(&argTypes);
       for (size_t idx = 0; idx < n->data.funPtrType.argTypes->size; ++idx) {
         Type *argType =
             nodeToType(n->data.funPtrType.argTypes->elements[idx], env);
         if (argType == NULL) {
-          typeFree(retval);
+          vectorUninit(&argTypes, nullDtor);
           return NULL;
         }
 
-        vectorInsert(&retval->data.funPtr.argTypes, argType);
+        vectorInsert(&argTypes, argType);
       }
 
-      return retval;
+      return funPtrTypeCreate(inner, &argTypes);
     }
     case NT_SCOPEDID: {
       SymbolTableEntry *entry = environmentLookup(env, n, false);
@@ -1098,7 +1225,7 @@ Type *nodeToType(Node *n, Environment *env) {
         }
         default: {
           char *idString = stringifyId(n);
-          fprintf(stderr, "%s:%zu:%zu: error: '%s' is not a type\n",
+          fprintf(diagnosticStream(), "%s:%zu:%zu: error: '%s' is not a type\n",
                   env->currentModuleFile->inputFilename, n->line, n->character,
                   idString);
           free(idString);
@@ -1121,7 +1248,7 @@ Type *nodeToType(Node *n, Environment *env) {
           return referenceTypeCreate(entry);
         }
         default: {
-          fprintf(stderr, "%s:%zu:%zu: error: '%s' is not a type\n",
+          fprintf(diagnosticStream(), "%s:%zu:%zu: error: '%s' is not a type\n",
                   env->currentModuleFile->inputFilename, n->line, n->character,
                   n->data.id.id);
           return NULL;
@@ -1138,7 +1265,7 @@ bool nameNodeEqual(Node *a, Node *b) {
   if (a->type != b->type) return false;
 
   if (a->type == NT_ID) {
-    return strcmp(a->data.id.id, b->data.id.id) == 0;
+    return a->data.id.id == b->data.id.id;
   } else {
     if (a->data.scopedId.components->size != b->data.scopedId.components->size)
       return false;
@@ -1146,8 +1273,7 @@ bool nameNodeEqual(Node *a, Node *b) {
     for (size_t idx = 0; idx < a->data.scopedId.components->size; ++idx) {
       Node *aComponent = a->data.scopedId.components->elements[idx];
       Node *bComponent = b->data.scopedId.components->elements[idx];
-      if (strcmp(aComponent->data.id.id, bComponent->data.id.id) != 0)
-        return false;
+      if (aComponent->data.id.id != bComponent->data.id.id) return false;
     }
     return true;
   }
@@ -1159,7 +1285,7 @@ bool nameNodeEqualWithDrop(Node *a, Node *b, size_t dropCount) {
   if (a->type == NT_ID) {
     if (compareLength == 1) {
       Node *first = b->data.scopedId.components->elements[0];
-      return strcmp(a->data.id.id, first->data.id.id) == 0;
+      return a->data.id.id == first->data.id.id;
     } else {
       return false;
     }
@@ -1169,253 +1295,45 @@ bool nameNodeEqualWithDrop(Node *a, Node *b, size_t dropCount) {
     for (size_t idx = 0; idx < compareLength; ++idx) {
       Node *aComponent = a->data.scopedId.components->elements[idx];
       Node *bComponent = b->data.scopedId.components->elements[idx];
-      if (strcmp(aComponent->data.id.id, bComponent->data.id.id) != 0)
-        return false;
+      if (aComponent->data.id.id != bComponent->data.id.id) return false;
     }
     return true;
   }
 }
 
-static void nullableTokenFree(Token *token) {
-  if (token != NULL) {
-    tokenUninit(token);
-    free(token);
-  }
-}
 void nodeFree(Node *n) {
-  if (n == NULL) return;
-  switch (n->type) {
-    case NT_FILE: {
-      stabFree(n->data.file.stab);
-      nodeFree(n->data.file.module);
-      nodeVectorFree(n->data.file.imports);
-      nodeVectorFree(n->data.file.bodies);
-      break;
-    }
-    case NT_MODULE: {
-      nodeFree(n->data.module.id);
-      break;
-    }
-    case NT_IMPORT: {
-      nodeFree(n->data.import.id);
-      break;
-    }
-    case NT_FUNDEFN: {
-      nodeFree(n->data.funDefn.returnType);
-      nodeFree(n->data.funDefn.name);
-      nodeVectorFree(n->data.funDefn.argTypes);
-      nodeVectorFree(n->data.funDefn.argNames);
-      stabFree(n->data.funDefn.argStab);
-      nodeFree(n->data.funDefn.body);
-      break;
-    }
-    case NT_VARDEFN: {
-      nodeFree(n->data.varDefn.type);
-      nodeVectorFree(n->data.varDefn.names);
-      nodeVectorFree(n->data.varDefn.initializers);
-      break;
-    }
-    case NT_FUNDECL: {
-      nodeFree(n->data.funDecl.returnType);
-      nodeFree(n->data.funDecl.name);
-      nodeVectorFree(n->data.funDecl.argTypes);
-      nodeVectorFree(n->data.funDecl.argNames);
-      break;
-    }
-    case NT_VARDECL: {
-      nodeFree(n->data.varDecl.type);
-      nodeVectorFree(n->data.varDecl.names);
-      break;
-    }
-    case NT_OPAQUEDECL: {
-      nodeFree(n->data.opaqueDecl.name);
-      break;
-    }
-    case NT_STRUCTDECL: {
-      nodeFree(n->data.structDecl.name);
-      nodeVectorFree(n->data.structDecl.fields);
-      break;
-    }
-    case NT_UNIONDECL: {
-      nodeFree(n->data.unionDecl.name);
-      nodeVectorFree(n->data.unionDecl.options);
-      break;
-    }
-    case NT_ENUMDECL: {
-      nodeFree(n->data.enumDecl.name);
-      nodeVectorFree(n->data.enumDecl.constantNames);
-      nodeVectorFree(n->data.enumDecl.constantValues);
-      break;
-    }
-    case NT_TYPEDEFDECL: {
-      nodeFree(n->data.typedefDecl.originalType);
-      nodeFree(n->data.typedefDecl.name);
-      break;
-    }
-    case NT_COMPOUNDSTMT: {
-      nodeVectorFree(n->data.compoundStmt.stmts);
-      stabFree(n->data.compoundStmt.stab);
-      break;
-    }
-    case NT_IFSTMT: {
-      nodeFree(n->data.ifStmt.predicate);
-      nodeFree(n->data.ifStmt.consequent);
-      stabFree(n->data.ifStmt.consequentStab);
-      nodeFree(n->data.ifStmt.alternative);
-      stabFree(n->data.ifStmt.alternativeStab);
-      break;
-    }
-    case NT_WHILESTMT: {
-      nodeFree(n->data.whileStmt.condition);
-      nodeFree(n->data.whileStmt.body);
-      stabFree(n->data.whileStmt.bodyStab);
-      break;
-    }
-    case NT_DOWHILESTMT: {
-      nodeFree(n->data.doWhileStmt.body);
-      nodeFree(n->data.doWhileStmt.condition);
-      stabFree(n->data.doWhileStmt.bodyStab);
-      break;
-    }
-    case NT_FORSTMT: {
-      stabFree(n->data.forStmt.loopStab);
-      nodeFree(n->data.forStmt.initializer);
-      nodeFree(n->data.forStmt.condition);
-      nodeFree(n->data.forStmt.increment);
-      nodeFree(n->data.forStmt.body);
-      stabFree(n->data.forStmt.bodyStab);
-      break;
-    }
-    case NT_SWITCHSTMT: {
-      nodeFree(n->data.switchStmt.condition);
-      nodeVectorFree(n->data.switchStmt.cases);
-      break;
-    }
-    case NT_BREAKSTMT: {
-      break;
-    }
-    case NT_CONTINUESTMT: {
-      break;
-    }
-    case NT_RETURNSTMT: {
-      nodeFree(n->data.returnStmt.value);
-      break;
-    }
-    case NT_VARDEFNSTMT: {
-      nodeFree(n->data.varDefnStmt.type);
-      nodeVectorFree(n->data.varDefnStmt.names);
-      nodeVectorFree(n->data.varDefnStmt.initializers);
-      break;
-    }
-    case NT_EXPRESSIONSTMT: {
-      nodeFree(n->data.expressionStmt.expression);
-      break;
-    }
-    case NT_NULLSTMT: {
-      break;
-    }
-    case NT_SWITCHCASE: {
-      nodeVectorFree(n->data.switchCase.values);
-      nodeFree(n->data.switchCase.body);
-      stabFree(n->data.switchCase.bodyStab);
-      break;
-    }
-    case NT_SWITCHDEFAULT: {
-      nodeFree(n->data.switchDefault.body);
-      stabFree(n->data.switchDefault.bodyStab);
-      break;
-    }
-    case NT_BINOPEXP: {
-      nodeFree(n->data.binOpExp.lhs);
-      nodeFree(n->data.binOpExp.rhs);
-      typeFree(n->data.binOpExp.type);
-      typeFree(n->data.binOpExp.comparisonType);
-      break;
-    }
-    case NT_TERNARYEXP: {
-      nodeFree(n->data.ternaryExp.predicate);
-      nodeFree(n->data.ternaryExp.consequent);
-      nodeFree(n->data.ternaryExp.alternative);
-      typeFree(n->data.ternaryExp.type);
-      break;
-    }
-    case NT_UNOPEXP: {
-      nodeFree(n->data.unOpExp.target);
-      typeFree(n->data.unOpExp.type);
-      break;
-    }
-    case NT_SIZEOFTYPEEXP: {
-      nodeFree(n->data.sizeofTypeExp.targetNode);
-      typeFree(n->data.sizeofTypeExp.targetType);
-      typeFree(n->data.sizeofTypeExp.type);
-      break;
-    }
-    case NT_FUNCALLEXP: {
-      nodeFree(n->data.funCallExp.function);
-      nodeVectorFree(n->data.funCallExp.arguments);
-      typeFree(n->data.funCallExp.type);
-      break;
-    }
-    case NT_LITERAL: {
-      switch (n->data.literal.literalType) {
-        case LT_STRING: {
-          free(n->data.literal.data.stringVal);
-          break;
-        }
-        case LT_WSTRING: {
-          free(n->data.literal.data.wstringVal);
-          break;
-        }
-        case LT_AGGREGATEINIT: {
-          nodeVectorFree(n->data.literal.data.aggregateInitVal);
-          break;
-        }
-        default: {
-          break;
-        }
-      }
-      typeFree(n->data.literal.type);
-      break;
-    }
-    case NT_KEYWORDTYPE: {
-      break;
-    }
-    case NT_MODIFIEDTYPE: {
-      nodeFree(n->data.modifiedType.baseType);
-      break;
-    }
-    case NT_ARRAYTYPE: {
-      nodeFree(n->data.arrayType.baseType);
-      nodeFree(n->data.arrayType.size);
-      break;
-    }
-    case NT_FUNPTRTYPE: {
-      nodeFree(n->data.funPtrType.returnType);
-      nodeVectorFree(n->data.funPtrType.argTypes);
-      nodeVectorFree(n->data.funPtrType.argNames);
-      break;
-    }
-    case NT_SCOPEDID: {
-      nodeVectorFree(n->data.scopedId.components);
-      typeFree(n->data.scopedId.type);
-      break;
-    }
-    case NT_ID: {
-      free(n->data.id.id);
-      typeFree(n->data.id.type);
-      break;
-    }
-    case NT_UNPARSED: {
-      vectorUninit(n->data.unparsed.tokens,
-                   (void (*)(void *))nullableTokenFree);
-      free(n->data.unparsed.tokens);
-      break;
-    }
-  }
-  free(n);
+  if (n == NULL || n->type != NT_FILE) return;
+  // the file node is in its own arena - free it last
+  Arena *arena = n->data.file.arena;
+  arenaFree(n->data.file.bodyArena);
+  arenaFree(arena);
 }
 
 void nodeVectorFree(Vector *v) {
-  vectorUninit(v, (void (*)(void *))nodeFree);
+  vectorUninit(v, nullDtor);
   free(v);
+}
+
+void unparsedNodeFreeTokens(Node *n) {
+  if (n->data.unparsed.tokens == NULL) return;
+  tokenBufferUninit(n->data.unparsed.tokens);
+  free(n->data.unparsed.tokens);
+  n->data.unparsed.tokens = NULL;
+}
+
+void fileNodeFreeFunctionBodies(Node *n) {
+  Vector *bodies = n->data.file.bodies;
+  for (size_t idx = 0; idx < bodies->size; ++idx) {
+    Node *body = bodies->elements[idx];
+    if (body->type != NT_FUNDEFN) continue;
+
+    // argument entries are owned by the argument stab
+    body->data.funDefn.name->data.id.entry->data.function.argumentEntries
+        .size = 0;
+    stabFree(body->data.funDefn.argStab);
+    body->data.funDefn.argStab = NULL;
+    body->data.funDefn.body = NULL;
+  }
+  arenaFree(n->data.file.bodyArena);
+  n->data.file.bodyArena = NULL;
 }
\ No newline at end of file
@@ -25,11 +25,13 @@
 #ifndef TLC_AST_AST_H_
 #define TLC_AST_AST_H_
 
+#include <stdbool.h>
 #include <stddef.h>
 
 #include "ast/environment.h"
 #include "ast/symbolTable.h"
 #include "lexer/lexer.h"
+#include "util/arena.h"
 #include "util/container/vector.h"
 
 /** the type of an AST node */
@@ -205,18 +207,26 @@ typedef struct Node {
   union {
     struct {
       HashMap *stab;       /**< symbol table for file */
+      HashMap *index;      /**< lookup index for unscoped names, or NULL -
+                              see environmentIndexModule */
       struct Node *module; /**< NT_MODULE */
       Vector *imports;     /**< vector of Nodes, each is an NT_IMPORT */
       Vector
           *bodies; /**< vector of Nodes, each is a definition or declaration */
+      Arena *arena;     /**< arena nodes of this file are allocated from, or
+                           NULL */
+      Arena *bodyArena; /**< arena nodes of function bodies are allocated
+                           from, or NULL */
     } file;
 
     struct {
-      struct Node *id; /**< NT_SCOPEDID or NT_ID */
+      struct Node *id;  /**< NT_SCOPEDID or NT_ID */
+      char const *name; /**< id, joined with "::" (interned) */
     } module;
     struct {
       struct Node *id;                 /**< NT_SCOPEDID or NT_ID */
-      FileListEntry const *referenced; /**< File that's referenced */
+      char const *name;                /**< id, joined with "::" (interned) */
+      FileListEntry *referenced; /**< File that's referenced */
     } import;
 
     struct {
@@ -408,15 +418,15 @@ typedef struct Node {
       Type *type;
     } scopedId;
     struct {
-      char *id;
+      char const *id; /**< interned */
       SymbolTableEntry *entry; /**< non-owning reference to the stab entry, if
                                   any, this references. Nullable */
       Type *type;
     } id;
 
     struct {
-      Vector *tokens; /**< vector of Tokens */
-      size_t curr;    /**< current token (for lexing-ish purposes) */
+      TokenBuffer *tokens; /**< owned */
+      size_t curr;         /**< current token (for lexing-ish purposes) */
     } unparsed;
   } data;
 } Node;
@@ -474,6 +484,7 @@ Node *sizeofTypeExpNodeCreate(Token const *opToken, Node *targetNode,
                               Type *targetType);
 Node *funCallExpNodeCreate(Node *function, Vector *arguments);
 Node *literalNodeCreate(LiteralType type, Token const *t);
+Node *aggregateInitLiteralNodeCreate(Token const *lsquare, Vector *literals);
 Node *charLiteralNodeCreate(Token *t);
 Node *wcharLiteralNodeCreate(Token *t);
 Node *stringLiteralNodeCreate(Token *t);
@@ -486,7 +497,7 @@ Node *funPtrTypeNodeCreate(Node *returnType, Vector *argTypes,
                            Vector *argNames);
 Node *scopedIdNodeCreate(Vector *components);
 Node *idNodeCreate(Token *id);
-Node *unparsedNodeCreate(Vector *tokens);
+Node *unparsedNodeCreate(TokenBuffer *tokens);
 
 /**
  * creates a stringified version of a scoped id or plain id
@@ -496,6 +507,16 @@ Node *unparsedNodeCreate(Vector *tokens);
  */
 char *stringifyId(Node *id);
 
+/**
+ * interns the stringified version of a scoped id or plain id, without its last
+ * dropCount components
+ *
+ * @param id id to stringify
+ * @param dropCount number of components to drop - must leave at least one
+ * @returns interned stringified version of id
+ */
+char const *internId(Node *id, size_t dropCount);
+
 /**
  * generates a Type * from a Node *, resolving references using the given
  * environment
@@ -526,17 +547,49 @@ bool nameNodeEqual(Node *a, Node *b);
 bool nameNodeEqualWithDrop(Node *a, Node *b, size_t dropCount);
 
 /**
- * de-inits and frees a node
+ * sets the arena nodes created by the current thread are allocated from
+ *
+ * nodes must be created with an arena set. Everything a node owns - child
+ * vectors, symbol tables, literal strings, tokens - goes to its arena, and is
+ * freed with it; a file node frees its arenas with itself
+ *
+ * @param arena arena to allocate from, or NULL once done creating nodes
+ */
+void nodeArenaSet(Arena *arena);
+
+/**
+ * frees a file node, and with its arenas, every node in the file
+ *
+ * other nodes are freed with their arena, so this does nothing for them
  *
  * @param n node to free, may be null
  */
 void nodeFree(Node *n);
 
 /**
- * deinits a vector of nodes
+ * frees a vector of nodes that hasn't been given to a node - the nodes
+ * themselves are freed with their arena
  *
- * @param v vector to deinit, can have null elements, may not itself be null
+ * @param v vector to free, can have null elements, may not itself be null
  */
 void nodeVectorFree(Vector *v);
 
+/**
+ * frees an unparsed node's tokens, once they've been parsed
+ *
+ * @param n NT_UNPARSED node
+ */
+void unparsedNodeFreeTokens(Node *n);
+
+/**
+ * frees the bodies and arguments of the function definitions in a file, and
+ * the file's body arena
+ *
+ * top level declarations and their symbol table entries are kept, since other
+ * files may refer to them
+ *
+ * @param n NT_FILE node
+ */
+void fileNodeFreeFunctionBodies(Node *n);
+
 #endif  // TLC_AST_AST_H_
\ No newline at end of file
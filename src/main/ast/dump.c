@@ -97,7 +97,7 @@ static void stabEntryDump(FILE *where, SymbolTableEntry *entry) {
         char *typeStr =
             typeToString(entry->data.structType.fieldTypes.elements[idx]);
         fprintf(where, ", FIELD(%s, %s)", typeStr,
-                (char *)entry->data.structType.fieldNames.elements[idx]);
+                entry->data.structType.fieldNames.elements[idx]);
         free(typeStr);
       }
       fprintf(where, ")");
@@ -111,7 +111,7 @@ static void stabEntryDump(FILE *where, SymbolTableEntry *entry) {
         char *typeStr =
             typeToString(entry->data.unionType.optionTypes.elements[idx]);
         fprintf(where, ", OPTION(%s, %s)", typeStr,
-                (char *)entry->data.unionType.optionNames.elements[idx]);
+                entry->data.unionType.optionNames.elements[idx]);
         free(typeStr);
       }
       fprintf(where, ")");
@@ -125,15 +125,13 @@ static void stabEntryDump(FILE *where, SymbolTableEntry *entry) {
         SymbolTableEntry *constEntry =
             entry->data.enumType.constantValues.elements[idx];
         if (constEntry->data.enumConst.signedness) {
-          fprintf(
-              where, ", CONSTANT(%s, %ld)",
-              (char const *)entry->data.enumType.constantNames.elements[idx],
-              constEntry->data.enumConst.data.signedValue);
+          fprintf(where, ", CONSTANT(%s, %ld)",
+                  entry->data.enumType.constantNames.elements[idx],
+                  constEntry->data.enumConst.data.signedValue);
         } else {
-          fprintf(
-              where, ", CONSTANT(%s, %lu)",
-              (char const *)entry->data.enumType.constantNames.elements[idx],
-              constEntry->data.enumConst.data.unsignedValue);
+          fprintf(where, ", CONSTANT(%s, %lu)",
+                  entry->data.enumType.constantNames.elements[idx],
+                  constEntry->data.enumConst.data.unsignedValue);
         }
       }
       fprintf(where, ")");
@@ -160,18 +158,16 @@ static void stabDump(FILE *where, HashMap *stab) {
 
   fprintf(where, "STAB(");
   bool started = true;
-  for (size_t idx = 0; idx < stab->capacity; ++idx) {
-    if (stab->keys[idx] != NULL) {
-      SymbolTableEntry *entry = stab->values[idx];
-      if (started) {
-        started = false;
-      } else {
-        fprintf(where, ", ");
-      }
-      fprintf(where, "ENTRY(%s, ", stab->keys[idx]);
-      stabEntryDump(where, entry);
-      fprintf(where, ")");
+  for (size_t idx = 0; idx < stab->size; ++idx) {
+    SymbolTableEntry *entry = stab->values[idx];
+    if (started) {
+      started = false;
+    } else {
+      fprintf(where, ", ");
     }
+    fprintf(where, "ENTRY(%s, ", stab->keys[idx]);
+    stabEntryDump(where, entry);
+    fprintf(where, ")");
   }
   fprintf(where, ")");
 }
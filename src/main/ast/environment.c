@@ -25,26 +25,96 @@
 
 #include "ast/ast.h"
 #include "fileList.h"
+#include "util/diagnostics.h"
 #include "util/functional.h"
+#include "util/internalError.h"
+
+/**
+ * marks a name in a lookup index that is declared in more than one import -
+ * only its address is used
+ */
+static SymbolTableEntry ambiguous;
+
+void environmentIndexModule(FileListEntry *file) {
+  Node *ast = file->ast;
+  if (ast->data.file.index != NULL) {
+    hashMapUninit(ast->data.file.index, nullDtor);
+  } else {
+    ast->data.file.index = malloc(sizeof(HashMap));
+  }
+  HashMap *index = ast->data.file.index;
+  hashMapInit(index);
+
+  // imports first - any of their names declared in the module itself or its
+  // implicit import get overwritten below
+  for (size_t importIdx = 0; importIdx < ast->data.file.imports->size;
+       ++importIdx) {
+    Node *import = ast->data.file.imports->elements[importIdx];
+    HashMap const *stab = import->data.import.referenced->ast->data.file.stab;
+    for (size_t idx = 0; idx < stab->size; ++idx) {
+      if (hashMapPut(index, stab->keys[idx], stab->values[idx]) != 0)
+        hashMapSet(index, stab->keys[idx], &ambiguous);
+    }
+  }
+
+  if (file->isCode) {
+    FileListEntry *declEntry =
+        fileListFindDeclName(ast->data.file.module->data.module.name);
+    if (declEntry != NULL) {
+      HashMap const *stab = declEntry->ast->data.file.stab;
+      for (size_t idx = 0; idx < stab->size; ++idx)
+        hashMapSet(index, stab->keys[idx], stab->values[idx]);
+    }
+  }
+
+  HashMap const *stab = ast->data.file.stab;
+  for (size_t idx = 0; idx < stab->size; ++idx)
+    hashMapSet(index, stab->keys[idx], stab->values[idx]);
+}
+
+/** a local declaration of a name, and the one it shadows */
+typedef struct Binding {
+  SymbolTableEntry *entry;
+  struct Binding *shadowed; /**< binding of the name in an outer scope, or
+                               NULL */
+} Binding;
+
+/**
+ * makes entry the innermost binding of name
+ */
+static void bind(Environment *env, char const *name, SymbolTableEntry *entry) {
+  Binding *binding = malloc(sizeof(Binding));
+  binding->entry = entry;
+  binding->shadowed = hashMapGet(&env->bindings, name);
+  hashMapSet(&env->bindings, name, binding);
+}
+
+/**
+ * removes the innermost binding of name
+ */
+static void unbind(Environment *env, char const *name) {
+  Binding *binding = hashMapGet(&env->bindings, name);
+  hashMapSet(&env->bindings, name, binding->shadowed);
+  free(binding);
+}
 
 void environmentInit(Environment *env, FileListEntry *currentModuleFile) {
   vectorInit(&env->importFiles);
   for (size_t idx = 0; idx < currentModuleFile->ast->data.file.imports->size;
        ++idx) {
     Node *import = currentModuleFile->ast->data.file.imports->elements[idx];
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wdiscarded-qualifiers"
     vectorInsert(&env->importFiles, import->data.import.referenced);
-#pragma GCC diagnostic pop
   }
   env->currentModuleFile = currentModuleFile;
   env->implicitImport = NULL;
   if (currentModuleFile->isCode) {
     FileListEntry *declEntry = fileListFindDeclName(
-        currentModuleFile->ast->data.file.module->data.module.id);
+        currentModuleFile->ast->data.file.module->data.module.name);
     if (declEntry != NULL) env->implicitImport = declEntry->ast->data.file.stab;
   }
+  env->index = currentModuleFile->ast->data.file.index;
   vectorInit(&env->scopes);
+  hashMapInit(&env->bindings);
 }
 
 /**
@@ -55,82 +125,68 @@ void environmentInit(Environment *env, FileListEntry *currentModuleFile) {
  */
 static void errorNoDecl(FileListEntry *file, Node *node) {
   if (node->type == NT_ID) {
-    fprintf(stderr, "%s:%zu:%zu: error: '%s' was not declared\n",
+    fprintf(diagnosticStream(), "%s:%zu:%zu: error: '%s' was not declared\n",
             file->inputFilename, node->line, node->character, node->data.id.id);
     file->errored = true;
   } else {
     char *str = stringifyId(node);
-    fprintf(stderr, "%s:%zu:%zu: error: '%s' was not declared\n",
+    fprintf(diagnosticStream(), "%s:%zu:%zu: error: '%s' was not declared\n",
             file->inputFilename, node->line, node->character, str);
     file->errored = true;
     free(str);
   }
 }
 
-static SymbolTableEntry *environmentLookupUnscoped(Environment *env,
-                                                   Node *nameNode, bool quiet) {
+/**
+ * complain about a name declared in more than one import
+ *
+ * @param env environment the name was looked up in
+ * @param nameNode id that was looked up
+ */
+static void errorAmbiguous(Environment *env, Node *nameNode) {
   char const *name = nameNode->data.id.id;
-  SymbolTableEntry *matched;
-  Vector *scopes = &env->scopes;
-  for (size_t idx = 0; idx < scopes->size; ++idx) {
-    // look at local scopes from last to first
-    HashMap *scope = scopes->elements[scopes->size - idx - 1];
-    matched = hashMapGet(scope, name);
-    if (matched != NULL) return matched;
-  }
-  // check the current module then implicit import
-  matched = hashMapGet(env->currentModuleFile->ast->data.file.stab, name);
-  if (matched != NULL) return matched;
-  if (env->implicitImport != NULL) {
-    matched = hashMapGet(env->implicitImport, name);
-    if (matched != NULL) return matched;
-  }
-
-  // search in the imports
+  fprintf(diagnosticStream(),
+          "%s:%zu:%zu: error: '%s' declared in mutliple imported modules\n",
+          env->currentModuleFile->inputFilename, nameNode->line,
+          nameNode->character, name);
+  env->currentModuleFile->errored = true;
   Vector *imports = &env->importFiles;
-  SymbolTableEntry **matches =
-      malloc(sizeof(SymbolTableEntry *) * imports->size);
-  size_t numMatches = 0;
   for (size_t idx = 0; idx < imports->size; ++idx) {
     FileListEntry *import = imports->elements[idx];
-    matched = hashMapGet(import->ast->data.file.stab, name);
-    if (matched != NULL) matches[numMatches++] = matched;
+    SymbolTableEntry *matched = hashMapGet(import->ast->data.file.stab, name);
+    if (matched != NULL)
+      fprintf(diagnosticStream(), "%s:%zu:%zu: note: declared here\n",
+              matched->file->inputFilename, matched->line, matched->character);
   }
+}
+
+static SymbolTableEntry *environmentLookupUnscoped(Environment *env,
+                                                   Node *nameNode, bool quiet) {
+  char const *name = nameNode->data.id.id;
+  Binding const *binding = hashMapGet(&env->bindings, name);
+  if (binding != NULL) return binding->entry;
 
-  if (numMatches == 0) {
+  SymbolTableEntry *matched = hashMapGet(env->index, name);
+  if (matched == NULL) {
     if (!quiet) errorNoDecl(env->currentModuleFile, nameNode);
-    free(matches);
     return NULL;
-  } else if (numMatches > 1) {
-    if (!quiet) {
-      fprintf(stderr,
-              "%s:%zu:%zu: error: '%s' declared in mutliple imported modules\n",
-              env->currentModuleFile->inputFilename, nameNode->line,
-              nameNode->character, name);
-      for (size_t idx = 0; idx < numMatches; ++idx)
-        fprintf(stderr, "%s:%zu:%zu: note: declared here\n",
-                matches[idx]->file->inputFilename, matches[idx]->line,
-                matches[idx]->character);
-    }
-    free(matches);
+  } else if (matched == &ambiguous) {
+    if (!quiet) errorAmbiguous(env, nameNode);
     return NULL;
   } else {
-    matched = matches[0];
-    free(matches);
     return matched;
   }
 }
 static FileListEntry *environmentFindModule(Environment *env, Node *name,
                                             size_t dropCount) {
-  if (nameNodeEqualWithDrop(
-          env->currentModuleFile->ast->data.file.module->data.module.id, name,
-          dropCount))
+  char const *moduleName = internId(name, dropCount);
+  if (moduleName ==
+      env->currentModuleFile->ast->data.file.module->data.module.name)
     return env->currentModuleFile;
-  for (size_t idx = 0; idx < env->importFiles.size; ++idx) {
-    FileListEntry *file = env->importFiles.elements[idx];
-    Node *moduleName = file->ast->data.file.module->data.module.id;
-    if (nameNodeEqualWithDrop(moduleName, name, dropCount)) return file;
-  }
+  FileListEntry *file = fileListFindDeclName(moduleName);
+  if (file == NULL) return NULL;
+  for (size_t idx = 0; idx < env->importFiles.size; ++idx)
+    if (env->importFiles.elements[idx] == file) return file;
   return NULL;
 }
 static SymbolTableEntry *environmentLookupScoped(Environment *env, Node *name,
@@ -189,6 +245,10 @@ SymbolTableEntry *environmentLookup(Environment *env, Node *name, bool quiet) {
   // multiple imports, it's declared as ambiguous, and complained about. If it
   // still isn't found, it's declared as missing and complained about.
   //
+  // The local scopes are kept flattened in the bindings, and everything from
+  // the current module onwards is precomputed in the module's lookup index, so
+  // this takes at most two probes.
+  //
   // If the name is scoped:
   // There are two possibilities: the name is an enum constant, or it isn't. To
   // cover these cases, first, the name, with the last id removed, is
@@ -211,6 +271,18 @@ SymbolTableEntry *environmentLookup(Environment *env, Node *name, bool quiet) {
 
 void environmentPush(Environment *env, HashMap *map) {
   vectorInsert(&env->scopes, map);
+  for (size_t idx = 0; idx < map->size; ++idx)
+    bind(env, map->keys[idx], map->values[idx]);
+}
+
+int environmentPut(Environment *env, char const *name,
+                   SymbolTableEntry *entry) {
+  if (env->scopes.size == 0)
+    error(__FILE__, __LINE__, "no local scope to add a symbol to");
+  if (hashMapPut(env->scopes.elements[env->scopes.size - 1], name, entry) != 0)
+    return -1;
+  bind(env, name, entry);
+  return 0;
 }
 
 HashMap *environmentTop(Environment *env) {
@@ -223,10 +295,14 @@ HashMap *environmentTop(Environment *env) {
 }
 
 HashMap *environmentPop(Environment *env) {
-  return env->scopes.elements[--env->scopes.size];
+  HashMap *map = env->scopes.elements[--env->scopes.size];
+  for (size_t idx = 0; idx < map->size; ++idx) unbind(env, map->keys[idx]);
+  return map;
 }
 
 void environmentUninit(Environment *env) {
+  while (env->scopes.size != 0) stabFree(environmentPop(env));
   vectorUninit(&env->importFiles, nullDtor);
-  vectorUninit(&env->scopes, (void (*)(void *))stabFree);
+  vectorUninit(&env->scopes, nullDtor);
+  hashMapUninit(&env->bindings, nullDtor);
 }
\ No newline at end of file
@@ -29,16 +29,40 @@
 
 typedef struct Node Node;
 
+/**
+ * An environment
+ *
+ * Unscoped names are looked up in bindings, which maps each name declared in
+ * a local scope to the innermost declaration of it, and then in the lookup
+ * index of the current module, which already has the implicit import and the
+ * imports merged in. Either way, that's one probe of one table per name.
+ */
 typedef struct {
   FileListEntry
       *currentModuleFile;  /**< FileListEntry reference to current module */
   Vector importFiles;      /**< Vector of FileListEntry, non-owning */
   HashMap *implicitImport; /**< symbol table for the implicit import in code
                               modules */
+  HashMap const *index;    /**< lookup index of the current module */
   Vector scopes; /**< vector of temporarily owning references to the current
                     scope (vector of symbol tables) */
+  HashMap bindings; /**< map from a name declared in the scopes to its
+                       innermost binding - owning */
 } Environment;
 
+/**
+ * build the lookup index of a module
+ *
+ * The index maps each name visible at file scope to what it refers to - the
+ * current module's declaration, then the implicit import's, then the one
+ * import that declares it, if only one does. Must be done once imports are
+ * resolved and top level symbol tables have all their names, and before any
+ * environment for the module is made. Replaces any existing index.
+ *
+ * @param file file to index
+ */
+void environmentIndexModule(FileListEntry *file);
+
 /**
  * initialize an environment
  *
@@ -46,7 +70,8 @@ typedef struct {
  * leaves scopes as the empty vector
  *
  * @param env environment to initialize
- * @param currentModuleFile FileListEntry of the current module
+ * @param currentModuleFile FileListEntry of the current module - must be
+ * indexed
  */
 void environmentInit(Environment *env, FileListEntry *currentModuleFile);
 
@@ -64,11 +89,25 @@ SymbolTableEntry *environmentLookup(Environment *env, Node *name, bool quiet);
 /**
  * add a stab to the list of scopes
  *
+ * anything already in the stab shadows outer declarations of the same names
+ *
  * @param env environment to look in
  * @param map
  */
 void environmentPush(Environment *env, HashMap *map);
 
+/**
+ * add a symbol to the topmost scope, shadowing outer declarations of the same
+ * name - there must be a scope
+ *
+ * @param env environment to add to
+ * @param name name of the symbol (interned)
+ * @param entry symbol to add
+ * @returns 0 if insertion is successful, -1 if the topmost scope already has
+ * the name
+ */
+int environmentPut(Environment *env, char const *name, SymbolTableEntry *entry);
+
 /**
  * get the topmost scope
  *
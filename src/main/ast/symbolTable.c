@@ -67,23 +67,28 @@ SymbolTableEntry *opaqueStabEntryCreate(FileListEntry *file, size_t line,
 SymbolTableEntry *structStabEntryCreate(FileListEntry *file, size_t line,
                                         size_t character, char const *id) {
   SymbolTableEntry *e = stabEntryCreate(file, line, character, id, SK_STRUCT);
-  vectorInit(&e->data.structType.fieldNames);
+  stringVectorInit(&e->data.structType.fieldNames);
   vectorInit(&e->data.structType.fieldTypes);
+  e->data.structType.layout.state = LS_NONE;
+  e->data.structType.fieldOffsets = NULL;
+  hashMapInit(&e->data.structType.fieldOffsetMap);
   return e;
 }
 SymbolTableEntry *unionStabEntryCreate(FileListEntry *file, size_t line,
                                        size_t character, char const *id) {
   SymbolTableEntry *e = stabEntryCreate(file, line, character, id, SK_UNION);
-  vectorInit(&e->data.unionType.optionNames);
+  stringVectorInit(&e->data.unionType.optionNames);
   vectorInit(&e->data.unionType.optionTypes);
+  e->data.unionType.layout.state = LS_NONE;
   return e;
 }
 SymbolTableEntry *enumStabEntryCreate(FileListEntry *file, size_t line,
                                       size_t character, char const *id) {
   SymbolTableEntry *e = stabEntryCreate(file, line, character, id, SK_ENUM);
-  vectorInit(&e->data.enumType.constantNames);
+  stringVectorInit(&e->data.enumType.constantNames);
   vectorInit(&e->data.enumType.constantValues);
   e->data.enumType.backingType = NULL;
+  e->data.enumType.layout.state = LS_NONE;
   return e;
 }
 SymbolTableEntry *enumConstStabEntryCreate(FileListEntry *file, size_t line,
@@ -120,8 +125,7 @@ SymbolTableEntry *functionStabEntryCreate(FileListEntry *file, size_t line,
 Type *structLookupField(SymbolTableEntry *structEntry, char const *field) {
   for (size_t idx = 0; idx < structEntry->data.structType.fieldNames.size;
        ++idx) {
-    if (strcmp(structEntry->data.structType.fieldNames.elements[idx], field) ==
-        0)
+    if (structEntry->data.structType.fieldNames.elements[idx] == field)
       return structEntry->data.structType.fieldTypes.elements[idx];
   }
   return NULL;
@@ -129,8 +133,7 @@ Type *structLookupField(SymbolTableEntry *structEntry, char const *field) {
 Type *unionLookupOption(SymbolTableEntry *unionEntry, char const *option) {
   for (size_t idx = 0; idx < unionEntry->data.unionType.optionNames.size;
        ++idx) {
-    if (strcmp(unionEntry->data.unionType.optionNames.elements[idx], option) ==
-        0)
+    if (unionEntry->data.unionType.optionNames.elements[idx] == option)
       return unionEntry->data.unionType.optionTypes.elements[idx];
   }
   return NULL;
@@ -139,7 +142,7 @@ SymbolTableEntry *enumLookupEnumConst(SymbolTableEntry *enumEntry,
                                       char const *name) {
   for (size_t idx = 0; idx < enumEntry->data.enumType.constantNames.size;
        ++idx) {
-    if (strcmp(enumEntry->data.enumType.constantNames.elements[idx], name) == 0)
+    if (enumEntry->data.enumType.constantNames.elements[idx] == name)
       return enumEntry->data.enumType.constantValues.elements[idx];
   }
   return NULL;
@@ -148,33 +151,25 @@ SymbolTableEntry *enumLookupEnumConst(SymbolTableEntry *enumEntry,
 void stabEntryFree(SymbolTableEntry *e) {
   switch (e->kind) {
     case SK_STRUCT: {
-      vectorUninit(&e->data.structType.fieldNames, nullDtor);
-      vectorUninit(&e->data.structType.fieldTypes, (void (*)(void *))typeFree);
+      stringVectorUninit(&e->data.structType.fieldNames);
+      vectorUninit(&e->data.structType.fieldTypes, nullDtor);
+      free(e->data.structType.fieldOffsets);
+      hashMapUninit(&e->data.structType.fieldOffsetMap, nullDtor);
       break;
     }
     case SK_UNION: {
-      vectorUninit(&e->data.unionType.optionNames, nullDtor);
-      vectorUninit(&e->data.unionType.optionTypes, (void (*)(void *))typeFree);
+      stringVectorUninit(&e->data.unionType.optionNames);
+      vectorUninit(&e->data.unionType.optionTypes, nullDtor);
       break;
     }
     case SK_ENUM: {
-      vectorUninit(&e->data.enumType.constantNames, nullDtor);
+      stringVectorUninit(&e->data.enumType.constantNames);
       vectorUninit(&e->data.enumType.constantValues,
                    (void (*)(void *))stabEntryFree);
-      typeFree(e->data.enumType.backingType);
-      break;
-    }
-    case SK_TYPEDEF: {
-      typeFree(e->data.typedefType.actual);
-      break;
-    }
-    case SK_VARIABLE: {
-      typeFree(e->data.variable.type);
       break;
     }
     case SK_FUNCTION: {
-      typeFree(e->data.function.returnType);
-      vectorUninit(&e->data.function.argumentTypes, (void (*)(void *))typeFree);
+      vectorUninit(&e->data.function.argumentTypes, nullDtor);
       vectorUninit(&e->data.function.argumentEntries, nullDtor);
       break;
     }
@@ -25,6 +25,8 @@
 #ifndef TLC_AST_SYMBOLTABLE_H_
 #define TLC_AST_SYMBOLTABLE_H_
 
+#include <stdatomic.h>
+
 #include "ast/type.h"
 #include "util/container/hashMap.h"
 #include "util/container/vector.h"
@@ -55,6 +57,21 @@ typedef enum {
  */
 char const *symbolKindToString(SymbolKind kind);
 
+/** how far along laying out a struct, union, or enum is */
+typedef enum {
+  LS_NONE,    /**< not laid out yet */
+  LS_PENDING, /**< being laid out - meeting it again means it's recursive */
+  LS_DONE,    /**< size and alignment are filled in */
+  LS_INVALID, /**< can't be laid out (recursive, or holds an opaque type) */
+} LayoutState;
+
+/** the cached size and alignment of a struct, union, or enum */
+typedef struct {
+  LayoutState state;
+  size_t size;
+  size_t alignment;
+} Layout;
+
 /** a symbol */
 typedef struct SymbolTableEntry {
   SymbolKind kind;
@@ -65,17 +82,23 @@ typedef struct SymbolTableEntry {
           *definition; /**< actual definition of this opaque, nullable */
     } opaqueType;
     struct {
-      Vector fieldNames; /**< vector of char * (non-owning) */
-      Vector fieldTypes; /**< vector of types */
+      StringVector fieldNames; /**< interned field names */
+      Vector fieldTypes;       /**< vector of types */
+      Layout layout;
+      size_t *fieldOffsets;   /**< offset of each field, in field order */
+      HashMap fieldOffsetMap; /**< map from field name (interned) to its
+                                 element of fieldOffsets */
     } structType;
     struct {
-      Vector optionNames; /**< vector of char * (non-owning) */
-      Vector optionTypes; /**< vector of types */
+      StringVector optionNames; /**< interned option names */
+      Vector optionTypes;       /**< vector of types */
+      Layout layout;
     } unionType;
     struct {
-      Vector constantNames;  /**< vector of char * (non-owning) */
-      Vector constantValues; /**< vector of SymbolTableEntry (enum consts) */
-      Type *backingType;     /**< type used to store this enum */
+      StringVector constantNames; /**< interned constant names */
+      Vector constantValues;      /**< vector of enum const SymbolTableEntry */
+      Type *backingType;          /**< type used to store this enum */
+      Layout layout;
     } enumType;
     struct {
       struct SymbolTableEntry
@@ -92,9 +115,10 @@ typedef struct SymbolTableEntry {
 
     // non-types
     struct {
-      Type *type;   /**< type of the variable */
-      size_t temp;  /**< IR temp in which it's stored (zero if global) */
-      bool escapes; /**< do we ever want the address of this variable */
+      Type *type;          /**< type of the variable */
+      size_t temp;         /**< IR temp in which it's stored (zero if global) */
+      atomic_bool escapes; /**< do we ever want the address of this variable -
+                              may be set by several typecheck tasks at once */
     } variable;
     struct {
       Type *returnType;
@@ -105,7 +129,7 @@ typedef struct SymbolTableEntry {
   FileListEntry *file;
   size_t line; /**< line and character of first declaration */
   size_t character;
-  char const *id;
+  char const *id; /**< interned */
 } SymbolTableEntry;
 
 /**
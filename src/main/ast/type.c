@@ -18,103 +18,295 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 // type implementation
+//
+// Types are interned. Each create function looks its type up in a table, and
+// only allocates if it's new. Children are interned before their parents, so
+// a type's hash and its equality with a candidate only depend on its own
+// fields and the addresses of its children. Like the identifier table, the
+// table is split into shards by hash, each with its own lock, since files and
+// functions are typechecked and translated in parallel. Keyword types don't
+// need the table at all - there's one static type per keyword.
 
 #include "ast/type.h"
 
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
 #include "ast/symbolTable.h"
+#include "util/arena.h"
+#include "util/functional.h"
 #include "util/internalError.h"
 #include "util/numericSizing.h"
 
-static Type *typeCreate(TypeKind kind) {
-  Type *t = malloc(sizeof(Type));
-  t->kind = kind;
-  return t;
-}
-Type *keywordTypeCreate(TypeKeyword keyword) {
-  Type *t = typeCreate(TK_KEYWORD);
-  t->data.keyword.keyword = keyword;
-  return t;
-}
-Type *qualifiedTypeCreate(Type *base, bool constQual, bool volatileQual) {
-  Type *t = typeCreate(TK_QUALIFIED);
-  t->data.qualified.constQual = constQual;
-  t->data.qualified.volatileQual = volatileQual;
-  t->data.qualified.base = base;
-  return t;
-}
-Type *pointerTypeCreate(Type *base) {
-  Type *t = typeCreate(TK_POINTER);
-  t->data.pointer.base = base;
-  return t;
-}
-Type *arrayTypeCreate(uint64_t length, Type *type) {
-  Type *t = typeCreate(TK_ARRAY);
-  t->data.array.length = length;
-  t->data.array.type = type;
-  return t;
-}
-Type *funPtrTypeCreate(Type *returnType) {
-  Type *t = typeCreate(TK_FUNPTR);
-  t->data.funPtr.returnType = returnType;
-  vectorInit(&t->data.funPtr.argTypes);
-  return t;
+/** the keyword types */
+static Type KEYWORD_TYPES[] = {
+    [TK_VOID] = {.kind = TK_KEYWORD, .data.keyword.keyword = TK_VOID},
+    [TK_UBYTE] = {.kind = TK_KEYWORD, .data.keyword.keyword = TK_UBYTE},
+    [TK_BYTE] = {.kind = TK_KEYWORD, .data.keyword.keyword = TK_BYTE},
+    [TK_CHAR] = {.kind = TK_KEYWORD, .data.keyword.keyword = TK_CHAR},
+    [TK_USHORT] = {.kind = TK_KEYWORD, .data.keyword.keyword = TK_USHORT},
+    [TK_SHORT] = {.kind = TK_KEYWORD, .data.keyword.keyword = TK_SHORT},
+    [TK_UINT] = {.kind = TK_KEYWORD, .data.keyword.keyword = TK_UINT},
+    [TK_INT] = {.kind = TK_KEYWORD, .data.keyword.keyword = TK_INT},
+    [TK_WCHAR] = {.kind = TK_KEYWORD, .data.keyword.keyword = TK_WCHAR},
+    [TK_ULONG] = {.kind = TK_KEYWORD, .data.keyword.keyword = TK_ULONG},
+    [TK_LONG] = {.kind = TK_KEYWORD, .data.keyword.keyword = TK_LONG},
+    [TK_FLOAT] = {.kind = TK_KEYWORD, .data.keyword.keyword = TK_FLOAT},
+    [TK_DOUBLE] = {.kind = TK_KEYWORD, .data.keyword.keyword = TK_DOUBLE},
+    [TK_BOOL] = {.kind = TK_KEYWORD, .data.keyword.keyword = TK_BOOL},
+};
+
+/** log base 2 of the number of shards */
+#define SHARD_BITS 4
+/** number of shards */
+#define NUM_SHARDS (1 << SHARD_BITS)
+/** starting capacity of a shard; must be a power of two */
+#define SHARD_INIT_CAPACITY 256
+
+/** part of the interning table */
+typedef struct {
+  pthread_mutex_t lock;
+  size_t size;
+  size_t capacity;
+  Type **types; /**< open addressed table of interned types */
+  Arena *arena; /**< storage for the types */
+} Shard;
+
+static Shard shards[NUM_SHARDS];
+static pthread_once_t shardsInitialized = PTHREAD_ONCE_INIT;
+
+static void shardsInit(void) {
+  for (size_t idx = 0; idx < NUM_SHARDS; ++idx) {
+    pthread_mutex_init(&shards[idx].lock, NULL);
+    shards[idx].size = 0;
+    shards[idx].capacity = SHARD_INIT_CAPACITY;
+    shards[idx].types = calloc(SHARD_INIT_CAPACITY, sizeof(Type *));
+    shards[idx].arena = arenaCreate();
+  }
 }
-Type *aggregateTypeCreate(void) {
-  Type *t = typeCreate(TK_AGGREGATE);
-  vectorInit(&t->data.aggregate.types);
-  return t;
+
+/**
+ * mixes a word into a hash
+ */
+static uint64_t hashMix(uint64_t hash, uint64_t word) {
+  hash = (hash ^ word) * 0x9e3779b97f4a7c15;
+  return hash ^ (hash >> 29);
 }
-Type *referenceTypeCreate(SymbolTableEntry *entry) {
-  Type *t = typeCreate(TK_REFERENCE);
-  t->data.reference.entry = entry;
-  return t;
+
+/**
+ * mixes the addresses of a vector of types into a hash
+ */
+static uint64_t hashMixVector(uint64_t hash, Vector const *v) {
+  hash = hashMix(hash, v->size);
+  for (size_t idx = 0; idx < v->size; ++idx)
+    hash = hashMix(hash, (uintptr_t)v->elements[idx]);
+  return hash;
 }
-Type *typeCopy(Type const *t) {
-  if (t == NULL) return NULL;
+
+/**
+ * hashes a type's fields and the addresses of its children
+ */
+static uint64_t typeHash(Type const *t) {
+  uint64_t hash = hashMix(0, t->kind);
   switch (t->kind) {
-    case TK_KEYWORD: {
-      return keywordTypeCreate(t->data.keyword.keyword);
+    case TK_QUALIFIED: {
+      hash = hashMix(hash, ((uint64_t)t->data.qualified.constQual << 1) |
+                               t->data.qualified.volatileQual);
+      return hashMix(hash, (uintptr_t)t->data.qualified.base);
+    }
+    case TK_POINTER: {
+      return hashMix(hash, (uintptr_t)t->data.pointer.base);
+    }
+    case TK_ARRAY: {
+      hash = hashMix(hash, t->data.array.length);
+      return hashMix(hash, (uintptr_t)t->data.array.type);
+    }
+    case TK_FUNPTR: {
+      hash = hashMix(hash, (uintptr_t)t->data.funPtr.returnType);
+      return hashMixVector(hash, &t->data.funPtr.argTypes);
+    }
+    case TK_AGGREGATE: {
+      return hashMixVector(hash, &t->data.aggregate.types);
     }
+    case TK_REFERENCE: {
+      return hashMix(hash, (uintptr_t)t->data.reference.entry);
+    }
+    default: {
+      error(__FILE__, __LINE__, "bad type given to typeHash");
+    }
+  }
+}
+
+/**
+ * do two vectors of types hold the same addresses
+ */
+static bool vectorsIdentical(Vector const *a, Vector const *b) {
+  if (a->size != b->size) return false;
+  for (size_t idx = 0; idx < a->size; ++idx)
+    if (a->elements[idx] != b->elements[idx]) return false;
+  return true;
+}
+
+/**
+ * does a type have the same fields and children as another
+ */
+static bool typeIdentical(Type const *a, Type const *b) {
+  if (a->kind != b->kind) return false;
+  switch (a->kind) {
     case TK_QUALIFIED: {
-      return qualifiedTypeCreate(typeCopy(t->data.qualified.base),
-                                 t->data.qualified.constQual,
-                                 t->data.qualified.volatileQual);
+      return a->data.qualified.constQual == b->data.qualified.constQual &&
+             a->data.qualified.volatileQual == b->data.qualified.volatileQual &&
+             a->data.qualified.base == b->data.qualified.base;
     }
     case TK_POINTER: {
-      return pointerTypeCreate(typeCopy(t->data.pointer.base));
+      return a->data.pointer.base == b->data.pointer.base;
     }
     case TK_ARRAY: {
-      return arrayTypeCreate(t->data.array.length,
-                             typeCopy(t->data.array.type));
+      return a->data.array.length == b->data.array.length &&
+             a->data.array.type == b->data.array.type;
     }
     case TK_FUNPTR: {
-      Type *copy = funPtrTypeCreate(typeCopy(t->data.funPtr.returnType));
-      for (size_t idx = 0; idx < t->data.funPtr.argTypes.size; ++idx)
-        vectorInsert(&copy->data.funPtr.argTypes,
-                     typeCopy(t->data.funPtr.argTypes.elements[idx]));
-      return copy;
+      return a->data.funPtr.returnType == b->data.funPtr.returnType &&
+             vectorsIdentical(&a->data.funPtr.argTypes,
+                              &b->data.funPtr.argTypes);
     }
     case TK_AGGREGATE: {
-      Type *copy = aggregateTypeCreate();
-      for (size_t idx = 0; idx < t->data.aggregate.types.size; ++idx)
-        vectorInsert(&copy->data.funPtr.argTypes,
-                     typeCopy(t->data.aggregate.types.elements[idx]));
-      return copy;
+      return vectorsIdentical(&a->data.aggregate.types,
+                              &b->data.aggregate.types);
     }
     case TK_REFERENCE: {
-      return referenceTypeCreate(t->data.reference.entry);
+      return a->data.reference.entry == b->data.reference.entry;
     }
     default: {
-      error(__FILE__, __LINE__, "bad type given to typeCopy");
+      error(__FILE__, __LINE__, "bad type given to typeIdentical");
     }
   }
 }
+
+/**
+ * inserts an interned type into a shard's table, which must have room
+ */
+static void shardInsert(Shard *shard, Type *t) {
+  size_t mask = shard->capacity - 1;
+  size_t idx = t->hash & mask;
+  while (shard->types[idx] != NULL) idx = (idx + 1) & mask;
+  shard->types[idx] = t;
+  ++shard->size;
+}
+
+/**
+ * doubles the capacity of a shard's table
+ */
+static void shardGrow(Shard *shard) {
+  size_t oldCapacity = shard->capacity;
+  Type **oldTypes = shard->types;
+  shard->capacity *= 2;
+  shard->types = calloc(shard->capacity, sizeof(Type *));
+  shard->size = 0;
+  for (size_t idx = 0; idx < oldCapacity; ++idx)
+    if (oldTypes[idx] != NULL) shardInsert(shard, oldTypes[idx]);
+  free(oldTypes);
+}
+
+/**
+ * finds or adds the interned type identical to a candidate
+ *
+ * @param candidate type to intern - if it holds a vector, the vector is taken
+ * by the interned type, or uninitialized if the type already exists
+ * @returns interned type
+ */
+static Type *typeIntern(Type *candidate) {
+  candidate->hash = typeHash(candidate);
+  // low bits pick the slot, so use high bits to pick the shard
+  Shard *shard = &shards[candidate->hash >> (64 - SHARD_BITS)];
+
+  pthread_once(&shardsInitialized, shardsInit);
+  pthread_mutex_lock(&shard->lock);
+
+  size_t mask = shard->capacity - 1;
+  for (size_t idx = candidate->hash & mask; shard->types[idx] != NULL;
+       idx = (idx + 1) & mask) {
+    Type *existing = shard->types[idx];
+    if (existing->hash == candidate->hash &&
+        typeIdentical(existing, candidate)) {
+      pthread_mutex_unlock(&shard->lock);
+      if (candidate->kind == TK_FUNPTR)
+        vectorUninit(&candidate->data.funPtr.argTypes, nullDtor);
+      else if (candidate->kind == TK_AGGREGATE)
+        vectorUninit(&candidate->data.aggregate.types, nullDtor);
+      return existing;
+    }
+  }
+
+  // not found - add it
+  Type *stored = arenaAlloc(shard->arena, sizeof(Type));
+  *stored = *candidate;
+
+  // keep the table at most half full
+  if (2 * (shard->size + 1) > shard->capacity) shardGrow(shard);
+  shardInsert(shard, stored);
+  pthread_mutex_unlock(&shard->lock);
+  return stored;
+}
+
+Type *keywordTypeCreate(TypeKeyword keyword) {
+  return &KEYWORD_TYPES[keyword];
+}
+Type *qualifiedTypeCreate(Type *base, bool constQual, bool volatileQual) {
+  Type t;
+  t.kind = TK_QUALIFIED;
+  t.data.qualified.constQual = constQual;
+  t.data.qualified.volatileQual = volatileQual;
+  t.data.qualified.base = base;
+  return typeIntern(&t);
+}
+Type *pointerTypeCreate(Type *base) {
+  Type t;
+  t.kind = TK_POINTER;
+  t.data.pointer.base = base;
+  return typeIntern(&t);
+}
+Type *arrayTypeCreate(uint64_t length, Type *type) {
+  Type t;
+  t.kind = TK_ARRAY;
+  t.data.array.length = length;
+  t.data.array.type = type;
+  return typeIntern(&t);
+}
+Type *funPtrTypeCreate(Type *returnType, Vector *argTypes) {
+  Type t;
+  t.kind = TK_FUNPTR;
+  t.data.funPtr.returnType = returnType;
+  t.data.funPtr.argTypes = *argTypes;
+  return typeIntern(&t);
+}
+Type *aggregateTypeCreate(Vector *types) {
+  Type t;
+  t.kind = TK_AGGREGATE;
+  t.data.aggregate.types = *types;
+  return typeIntern(&t);
+}
+Type *referenceTypeCreate(SymbolTableEntry *entry) {
+  Type t;
+  t.kind = TK_REFERENCE;
+  t.data.reference.entry = entry;
+  return typeIntern(&t);
+}
+Type *typeCopy(Type const *t) {
+  // interned types are never written through once created, so dropping const
+  // is safe - going through uintptr_t keeps this a plain, lock-free cast
+  return (Type *)(uintptr_t)t;
+}
 bool typeEqual(Type const *a, Type const *b) {
+  // identical types are interned to the same type, so this only needs to
+  // recurse when different types might refer to the same opaque type
+  if (a == b) return true;
   if (a->kind != b->kind) return false;
 
   switch (a->kind) {
     case TK_KEYWORD: {
-      return a->data.keyword.keyword == b->data.keyword.keyword;
+      return false;
     }
     case TK_QUALIFIED: {
       return a->data.qualified.constQual == b->data.qualified.constQual &&
@@ -153,8 +345,7 @@ bool typeEqual(Type const *a, Type const *b) {
     case TK_REFERENCE: {
       SymbolTableEntry *aEntry = a->data.reference.entry;
       SymbolTableEntry *bEntry = b->data.reference.entry;
-      return aEntry == bEntry ||
-             (aEntry->kind == SK_OPAQUE &&
+      return (aEntry->kind == SK_OPAQUE &&
               aEntry->data.opaqueType.definition == bEntry) ||
              (bEntry->kind == SK_OPAQUE &&
               aEntry == bEntry->data.opaqueType.definition) ||
@@ -632,6 +823,136 @@ Type *comparisonTypeMerge(Type const *a, Type const *b) {
   }
 }
 
+/**
+ * gets the cached layout of a struct, union, or enum, if it has one
+ *
+ * @returns layout, or NULL if this kind of entry doesn't have one
+ */
+static Layout *entryLayout(SymbolTableEntry *e) {
+  switch (e->kind) {
+    case SK_STRUCT: {
+      return &e->data.structType.layout;
+    }
+    case SK_UNION: {
+      return &e->data.unionType.layout;
+    }
+    case SK_ENUM: {
+      return &e->data.enumType.layout;
+    }
+    default: {
+      return NULL;
+    }
+  }
+}
+/**
+ * gets the layout of a struct, union, or enum, which must already be laid out
+ */
+static Layout const *laidOut(SymbolTableEntry *e) {
+  Layout const *layout = entryLayout(e);
+  if (layout->state != LS_DONE)
+    error(__FILE__, __LINE__, "type used before it was laid out");
+  return layout;
+}
+/**
+ * finds the size and alignment of a field type, laying out any struct, union,
+ * or enum it refers to first
+ *
+ * @returns whether the type could be laid out
+ */
+static bool layoutType(Type const *t, size_t *size, size_t *alignment) {
+  switch (t->kind) {
+    case TK_KEYWORD:
+    case TK_POINTER:
+    case TK_FUNPTR: {
+      *size = *alignment = typeSizeof(t);
+      return true;
+    }
+    case TK_QUALIFIED: {
+      return layoutType(t->data.qualified.base, size, alignment);
+    }
+    case TK_ARRAY: {
+      if (!layoutType(t->data.array.type, size, alignment)) return false;
+      *size *= t->data.array.length;
+      return true;
+    }
+    case TK_REFERENCE: {
+      SymbolTableEntry *entry = t->data.reference.entry;
+      if (entry->kind == SK_TYPEDEF)
+        return layoutType(entry->data.typedefType.actual, size, alignment);
+
+      Layout *layout = entryLayout(entry);
+      if (layout == NULL) return false;  // opaque types can't be laid out
+      stabEntryLayout(entry);
+      if (layout->state != LS_DONE) return false;
+      *size = layout->size;
+      *alignment = layout->alignment;
+      return true;
+    }
+    default: {
+      error(__FILE__, __LINE__, "invalid type kind");
+    }
+  }
+}
+void stabEntryLayout(SymbolTableEntry *e) {
+  Layout *layout = entryLayout(e);
+  if (layout == NULL || layout->state != LS_NONE) return;
+  layout->state = LS_PENDING;
+
+  size_t size = 0;
+  size_t alignment = 0;
+  switch (e->kind) {
+    case SK_STRUCT: {
+      Vector *fieldTypes = &e->data.structType.fieldTypes;
+      size_t *offsets = malloc(sizeof(size_t) * fieldTypes->size);
+      for (size_t idx = 0; idx < fieldTypes->size; ++idx) {
+        size_t fieldSize;
+        size_t fieldAlignment;
+        if (!layoutType(fieldTypes->elements[idx], &fieldSize,
+                        &fieldAlignment)) {
+          free(offsets);
+          layout->state = LS_INVALID;
+          return;
+        }
+        size = incrementToMultiple(size, fieldAlignment);
+        offsets[idx] = size;
+        size += fieldSize;
+        if (fieldAlignment > alignment) alignment = fieldAlignment;
+      }
+      if (alignment != 0) size = incrementToMultiple(size, alignment);
+
+      e->data.structType.fieldOffsets = offsets;
+      for (size_t idx = 0; idx < fieldTypes->size; ++idx)
+        hashMapPut(&e->data.structType.fieldOffsetMap,
+                   e->data.structType.fieldNames.elements[idx], &offsets[idx]);
+      break;
+    }
+    case SK_UNION: {
+      Vector *optionTypes = &e->data.unionType.optionTypes;
+      for (size_t idx = 0; idx < optionTypes->size; ++idx) {
+        size_t optionSize;
+        size_t optionAlignment;
+        if (!layoutType(optionTypes->elements[idx], &optionSize,
+                        &optionAlignment)) {
+          layout->state = LS_INVALID;
+          return;
+        }
+        if (optionSize > size) size = optionSize;
+        if (optionAlignment > alignment) alignment = optionAlignment;
+      }
+      break;
+    }
+    case SK_ENUM: {
+      layoutType(e->data.enumType.backingType, &size, &alignment);
+      break;
+    }
+    default: {
+      error(__FILE__, __LINE__, "invalid symbol kind");
+    }
+  }
+  layout->size = size;
+  layout->alignment = alignment;
+  layout->state = LS_DONE;
+}
 size_t typeSizeof(Type const *t) {
   switch (t->kind) {
     case TK_KEYWORD: {
@@ -689,34 +1010,10 @@ size_t typeSizeof(Type const *t) {
     case TK_REFERENCE: {
       SymbolTableEntry *entry = t->data.reference.entry;
       switch (entry->kind) {
-        case SK_STRUCT: {
-          size_t size = 0;
-          for (size_t idx = 0; idx < entry->data.structType.fieldTypes.size;
-               ++idx) {
-            size += typeSizeof(entry->data.structType.fieldTypes.elements[idx]);
-            if (idx < entry->data.structType.fieldTypes.size - 1) {
-              size = incrementToMultiple(
-                  size,
-                  typeAlignof(
-                      entry->data.structType.fieldTypes.elements[idx + 1]));
-            } else {
-              size = incrementToMultiple(size, typeAlignof(t));
-            }
-          }
-          return size;
-        }
-        case SK_UNION: {
-          size_t size = 0;
-          for (size_t idx = 0; idx < entry->data.unionType.optionTypes.size;
-               ++idx) {
-            size_t compare =
-                typeSizeof(entry->data.unionType.optionTypes.elements[idx]);
-            if (compare > size) size = compare;
-          }
-          return size;
-        }
+        case SK_STRUCT:
+        case SK_UNION:
         case SK_ENUM: {
-          return typeSizeof(entry->data.enumType.backingType);
+          return laidOut(entry)->size;
         }
         case SK_TYPEDEF: {
           return typeSizeof(entry->data.typedefType.actual);
@@ -732,14 +1029,9 @@ size_t typeSizeof(Type const *t) {
   }
 }
 size_t structOffsetof(struct SymbolTableEntry const *e, char const *field) {
-  size_t offset = 0;
-  for (size_t idx = 0;
-       strcmp(e->data.structType.fieldNames.elements[idx], field) != 0; ++idx) {
-    offset += typeSizeof(e->data.structType.fieldTypes.elements[idx]);
-    offset = incrementToMultiple(
-        offset, typeAlignof(e->data.structType.fieldTypes.elements[idx + 1]));
-  }
-  return offset;
+  size_t const *offset = hashMapGet(&e->data.structType.fieldOffsetMap, field);
+  if (offset == NULL) error(__FILE__, __LINE__, "no such field laid out");
+  return *offset;
 }
 size_t typeAlignof(Type const *t) {
   switch (t->kind) {
@@ -765,28 +1057,10 @@ size_t typeAlignof(Type const *t) {
     case TK_REFERENCE: {
       SymbolTableEntry *entry = t->data.reference.entry;
       switch (entry->kind) {
-        case SK_STRUCT: {
-          size_t alignment = 0;
-          for (size_t idx = 0; idx < entry->data.structType.fieldTypes.size;
-               ++idx) {
-            size_t compare =
-                typeAlignof(entry->data.structType.fieldTypes.elements[idx]);
-            if (compare > alignment) alignment = compare;
-          }
-          return alignment;
-        }
-        case SK_UNION: {
-          size_t alignment = 0;
-          for (size_t idx = 0; idx < entry->data.unionType.optionTypes.size;
-               ++idx) {
-            size_t compare =
-                typeAlignof(entry->data.unionType.optionTypes.elements[idx]);
-            if (compare > alignment) alignment = compare;
-          }
-          return alignment;
-        }
+        case SK_STRUCT:
+        case SK_UNION:
         case SK_ENUM: {
-          return typeAlignof(entry->data.enumType.backingType);
+          return laidOut(entry)->alignment;
         }
         case SK_TYPEDEF: {
           return typeAlignof(entry->data.typedefType.actual);
@@ -1025,39 +1299,3 @@ char *typeToString(Type const *t) {
     }
   }
 }
-void typeFree(Type *t) {
-  if (t == NULL) return;
-
-  switch (t->kind) {
-    case TK_QUALIFIED: {
-      typeFree(t->data.qualified.base);
-      break;
-    }
-    case TK_POINTER: {
-      typeFree(t->data.pointer.base);
-      break;
-    }
-    case TK_ARRAY: {
-      typeFree(t->data.array.type);
-      break;
-    }
-    case TK_FUNPTR: {
-      vectorUninit(&t->data.funPtr.argTypes, (void (*)(void *))typeFree);
-      typeFree(t->data.funPtr.returnType);
-      break;
-    }
-    case TK_AGGREGATE: {
-      vectorUninit(&t->data.aggregate.types, (void (*)(void *))typeFree);
-      break;
-    }
-    default: {
-      break;  // nothing to do
-    }
-  }
-  free(t);
-}
-
-void typeVectorFree(Vector *v) {
-  vectorUninit(v, (void (*)(void *))typeFree);
-  free(v);
-}
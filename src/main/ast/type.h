@@ -20,6 +20,12 @@
 /**
  * @file
  * types
+ *
+ * Types are interned: each structurally distinct type is created once, and
+ * lives until the end of the program. Types must never be modified, and are
+ * never freed. Identical types are the same object, so they can be compared by
+ * address, but types referring to an opaque type and to its definition are
+ * different objects that are still equal - use typeEqual to compare them.
  */
 
 #ifndef TLC_AST_TYPE_H_
@@ -65,6 +71,7 @@ struct SymbolTableEntry;
 /** the type of a variable or value */
 typedef struct Type {
   TypeKind kind;
+  uint64_t hash; /**< hash of the type, for interning */
   union {
     struct {
       TypeKeyword keyword;
@@ -120,23 +127,24 @@ Type *arrayTypeCreate(uint64_t length, Type *type);
 /**
  * create a function pointer type
  *
- * argTypes is initialized as the empty vector
+ * argTypes (a vector of Type) is taken by the type, and is left uninitialized
  */
-Type *funPtrTypeCreate(Type *returnType);
+Type *funPtrTypeCreate(Type *returnType, Vector *argTypes);
 /**
  * create a aggregate init type
  *
- * types is initialized as the empty vector
+ * types (a vector of Type) is taken by the type, and is left uninitialized
  */
-Type *aggregateTypeCreate(void);
+Type *aggregateTypeCreate(Vector *types);
 /**
  * create a reference type
  */
 Type *referenceTypeCreate(struct SymbolTableEntry *entry);
 /**
- * deep copies a type
+ * "copies" a type - types are interned, so this returns t itself, non-const so
+ * it may be stored in nodes and symbol table entries
  */
-Type *typeCopy(Type const *);
+Type *typeCopy(Type const *t);
 /**
  * is a equal to b
  */
@@ -215,15 +223,28 @@ Type *ternaryTypeMerge(Type const *a, Type const *b);
  */
 Type *comparisonTypeMerge(Type const *a, Type const *b);
 /**
- * produce the size of a type
+ * lay out a struct, union, or enum, caching its size, alignment, and (for a
+ * struct) field offsets in its entry, if it hasn't been laid out yet
+ *
+ * Everything the entry refers to is laid out first. Entries that can't be laid
+ * out (recursive ones, or ones holding an opaque type) are marked as such,
+ * without a diagnostic - the typechecker reports those. Not thread safe: the
+ * entries of every file must be laid out before any thread takes a size.
+ *
+ * @param e entry to lay out - other kinds of entries are ignored
+ */
+void stabEntryLayout(struct SymbolTableEntry *e);
+/**
+ * produce the size of a type - structs, unions, and enums must be laid out
  */
 size_t typeSizeof(Type const *t);
 /**
- * produce the offset of a struct field
+ * produce the offset of a struct field, in constant time - the struct must be
+ * laid out
  */
 size_t structOffsetof(struct SymbolTableEntry const *e, char const *field);
 /**
- * produce the alignment of a type
+ * produce the alignment of a type - structs, unions, and enums must be laid out
  */
 size_t typeAlignof(Type const *t);
 /**
@@ -257,17 +278,5 @@ char *typeVectorToString(Vector const *v);
  * format a type
  */
 char *typeToString(Type const *t);
-/**
- * deinitializes a type
- *
- * @param t type to uninit
- */
-void typeFree(Type *t);
-/**
- * deinitializes a vector of types
- *
- * @param v vector to uninit
- */
-void typeVectorFree(Vector *v);
 
 #endif  // TLC_AST_TYPE_H_
\ No newline at end of file
@@ -0,0 +1,140 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Implementation of dependency file output
+
+#include "dependencyFile.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fileList.h"
+#include "options.h"
+#include "util/container/vector.h"
+#include "util/format.h"
+#include "util/functional.h"
+
+/**
+ * makes a file name with the extension of a source file name replaced
+ *
+ * @param filename name of source file, ending in a three character extension
+ * @param extension new extension, including the dot
+ * @returns new file name, malloc'd
+ */
+static char *replaceExtension(char const *filename, char const *extension) {
+  size_t length = strlen(filename) - 3;
+  return format("%.*s%s", (int)length, filename, extension);
+}
+
+/**
+ * writes a file name, escaping characters special to make
+ */
+static void writeFilename(FILE *out, char const *filename) {
+  for (; *filename != '\0'; ++filename) {
+    switch (*filename) {
+      case ' ':
+      case '#':
+      case '\\': {
+        fputc('\\', out);
+        fputc(*filename, out);
+        break;
+      }
+      case '$': {
+        fputs("$$", out);
+        break;
+      }
+      default: {
+        fputc(*filename, out);
+        break;
+      }
+    }
+  }
+}
+
+/**
+ * writes the rule for one code file
+ */
+static void writeRule(FILE *out, FileListEntry *entry) {
+  char *target = replaceExtension(entry->inputFilename, ".s");
+  writeFilename(out, target);
+  free(target);
+  fputs(": ", out);
+  writeFilename(out, entry->inputFilename);
+
+  Vector dependencies;
+  vectorInit(&dependencies);
+  fileListFindDependencies(entry, &dependencies);
+  for (size_t idx = 0; idx < dependencies.size; ++idx) {
+    FileListEntry *dependency = dependencies.elements[idx];
+    fputs(" \\\n  ", out);
+    writeFilename(out, dependency->inputFilename);
+  }
+  vectorUninit(&dependencies, nullDtor);
+
+  fputs("\n", out);
+}
+
+int writeDependencyFiles(void) {
+  if (options.dependencyFileName != NULL) {
+    FILE *out = fopen(options.dependencyFileName, "w");
+    if (out == NULL) {
+      fprintf(stderr, "tlc: error: cannot open dependency file '%s'\n",
+              options.dependencyFileName);
+      return -1;
+    }
+
+    for (size_t idx = 0; idx < fileList.size; ++idx) {
+      if (fileList.entries[idx].isCode) writeRule(out, &fileList.entries[idx]);
+    }
+
+    bool failed = ferror(out) != 0;
+    if (fclose(out) != 0 || failed) {
+      fprintf(stderr, "tlc: error: cannot write dependency file '%s'\n",
+              options.dependencyFileName);
+      return -1;
+    }
+    return 0;
+  }
+
+  int retval = 0;
+  for (size_t idx = 0; idx < fileList.size; ++idx) {
+    FileListEntry *entry = &fileList.entries[idx];
+    if (!entry->isCode) continue;
+
+    char *filename = replaceExtension(entry->inputFilename, ".d");
+    FILE *out = fopen(filename, "w");
+    if (out == NULL) {
+      fprintf(stderr, "tlc: error: cannot open dependency file '%s'\n",
+              filename);
+      retval = -1;
+    } else {
+      writeRule(out, entry);
+      bool failed = ferror(out) != 0;
+      if (fclose(out) != 0 || failed) {
+        fprintf(stderr, "tlc: error: cannot write dependency file '%s'\n",
+                filename);
+        retval = -1;
+      }
+    }
+    free(filename);
+  }
+  return retval;
+}
@@ -0,0 +1,40 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/**
+ * @file
+ * make-style dependency file output
+ */
+
+#ifndef TLC_DEPENDENCYFILE_H_
+#define TLC_DEPENDENCYFILE_H_
+
+/**
+ * writes a make rule for each code file, listing the code file and every decl
+ * file it depends on as prerequisites of its assembly file
+ *
+ * rules are written to options.dependencyFileName if given, or else to one
+ * file per code file, named after the code file with the extension replaced
+ * by '.d'. Imports must already be resolved
+ *
+ * @returns status code (0 = OK)
+ */
+int writeDependencyFiles(void);
+
+#endif  // TLC_DEPENDENCYFILE_H_
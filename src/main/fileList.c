@@ -24,6 +24,9 @@
 #include <string.h>
 
 #include "options.h"
+#include "util/container/bitSet.h"
+#include "util/functional.h"
+#include "util/intern.h"
 
 FileList fileList;
 
@@ -33,6 +36,8 @@ void fileListEntryInit(FileListEntry *entry, char const *inputName,
   entry->isCode = isCode;
   entry->errored = false;
   entry->ast = NULL;
+  entry->sourceHash = 0;
+  entry->precompiled = NULL;
   entry->nextId = 1;
   vectorInit(&entry->irFrags);
   entry->asmFile = NULL;
@@ -44,6 +49,7 @@ int parseFiles(size_t argc, char const *const *argv, size_t numFiles) {
   // setup the fileList
   fileList.size = 0;  // eventually going to be at most numFiles long
   fileList.entries = malloc(sizeof(FileListEntry) * numFiles);
+  hashMapInit(&fileList.paths);
 
   // read the args
   bool allFiles = false;
@@ -79,16 +85,9 @@ int parseFiles(size_t argc, char const *const *argv, size_t numFiles) {
         }
       }
       if (recognized) {
-        // search for duplicates
-        bool duplicate = false;
-        for (size_t searchIdx = 0; searchIdx < fileList.size; ++searchIdx) {
-          if (strcmp(argv[idx], fileList.entries[searchIdx].inputFilename) ==
-              0) {
-            duplicate = true;
-            break;
-          }
-        }
-        if (duplicate) {
+        char const *path = internString(argv[idx]);
+        if (hashMapPut(&fileList.paths, path,
+                       fileList.entries + fileList.size) != 0) {
           switch (options.duplicateFile) {
             case OPTION_W_ERROR: {
               fprintf(stderr, "%s: error: duplicated file\n", argv[idx]);
@@ -104,19 +103,22 @@ int parseFiles(size_t argc, char const *const *argv, size_t numFiles) {
             }
           }
         } else {
-          fileListEntryInit(fileList.entries + fileList.size, argv[idx],
-                            isCode);
+          fileListEntryInit(fileList.entries + fileList.size, path, isCode);
           ++fileList.size;
         }
       }
     } else if (strcmp(argv[idx], "--") == 0) {
       allFiles = true;
+    } else if (strcmp(argv[idx], "-j") == 0 || strcmp(argv[idx], "-MF") == 0) {
+      // skip the option's argument
+      ++idx;
     }
   }
 
-  // shrink down to size
+  // shrink down to size, which moves the entries the index points to
   fileList.entries =
       realloc(fileList.entries, sizeof(FileListEntry) * fileList.size);
+  fileListIndexPaths();
 
   // need at least one code file
   bool noCodes = true;
@@ -134,12 +136,73 @@ int parseFiles(size_t argc, char const *const *argv, size_t numFiles) {
   return err;
 }
 
-FileListEntry *fileListFindDeclName(Node *name) {
+void fileListIndexPaths(void) {
+  hashMapUninit(&fileList.paths, nullDtor);
+  hashMapInit(&fileList.paths);
+  for (size_t idx = 0; idx < fileList.size; ++idx)
+    hashMapPut(&fileList.paths,
+               internString(fileList.entries[idx].inputFilename),
+               &fileList.entries[idx]);
+}
+
+FileListEntry *fileListFindPath(char const *path) {
+  return hashMapGet(&fileList.paths, path);
+}
+
+void fileListIndexModules(Vector *duplicates) {
+  hashMapUninit(&fileList.declModules, nullDtor);
+  hashMapInit(&fileList.declModules);
   for (size_t idx = 0; idx < fileList.size; ++idx) {
-    if (!fileList.entries[idx].isCode &&
-        nameNodeEqual(
-            name, fileList.entries[idx].ast->data.file.module->data.module.id))
-      return &fileList.entries[idx];
+    FileListEntry *entry = &fileList.entries[idx];
+    if (!entry->isCode && entry->ast != NULL &&
+        hashMapPut(&fileList.declModules,
+                   entry->ast->data.file.module->data.module.name,
+                   entry) != 0 &&
+        duplicates != NULL)
+      vectorInsert(duplicates, entry);
   }
-  return NULL;
-}
\ No newline at end of file
+}
+
+FileListEntry *fileListFindDeclName(char const *name) {
+  return hashMapGet(&fileList.declModules, name);
+}
+
+/**
+ * adds file to dependencies, then everything it imports, if it hasn't already
+ * been visited
+ *
+ * @param visited set of indices into fileList.entries already walked
+ */
+static void addDependency(FileListEntry *file, uint64_t *visited,
+                          Vector *dependencies) {
+  size_t index = (size_t)(file - fileList.entries);
+  if (bitSetContains(visited, index)) return;
+  bitSetAdd(visited, index);
+
+  vectorInsert(dependencies, file);
+  Vector *imports = file->ast->data.file.imports;
+  for (size_t idx = 0; idx < imports->size; ++idx) {
+    Node *import = imports->elements[idx];
+    addDependency(import->data.import.referenced, visited, dependencies);
+  }
+}
+
+void fileListFindDependencies(FileListEntry const *entry,
+                              Vector *dependencies) {
+  uint64_t *visited = bitSetCreate(fileList.size);
+  bitSetAdd(visited, (size_t)(entry - fileList.entries));
+
+  if (entry->isCode) {
+    FileListEntry *declEntry =
+        fileListFindDeclName(entry->ast->data.file.module->data.module.name);
+    if (declEntry != NULL) addDependency(declEntry, visited, dependencies);
+  }
+
+  Vector *imports = entry->ast->data.file.imports;
+  for (size_t idx = 0; idx < imports->size; ++idx) {
+    Node *import = imports->elements[idx];
+    addDependency(import->data.import.referenced, visited, dependencies);
+  }
+
+  free(visited);
+}
@@ -25,20 +25,26 @@
 #ifndef TLC_FILE_LIST_H_
 #define TLC_FILE_LIST_H_
 
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
 
 #include "ast/ast.h"
 #include "lexer/lexer.h"
+#include "parser/precompiled.h"
 #include "util/container/hashMap.h"
 
 /** an entry in the filelist */
 typedef struct FileListEntry {
-  bool errored;              /**< has an error been signaled for this entry? */
+  atomic_bool errored; /**< has an error been signaled for this entry? - may
+                          be set by several tasks working on the entry */
   char const *inputFilename; /**< path to the input file */
   bool isCode;           /**< does the input file path point to a code file */
   LexerState lexerState; /**< state of the lexer - cleaned up during parse */
   Node *ast; /**< AST for this file - cleaned up at entry to the middleend */
+  uint64_t sourceHash;            /**< hash of the source file's contents */
+  PrecompiledModule *precompiled; /**< .tdi file the AST was loaded from, or
+                                     NULL if parsed from source - owning */
   size_t nextId;  /**< next IR id for this file */
   Vector irFrags; /**< vector of IRFrag - translated IR fragments - cleaned up
                      at entry to the backend */
@@ -60,6 +66,9 @@ void fileListEntryInit(FileListEntry *entry, char const *inputName,
 typedef struct {
   size_t size;
   FileListEntry *entries;
+  HashMap paths; /**< map from input filename (interned) to its entry */
+  HashMap declModules; /**< map from module name (interned) to the first decl
+                          file declaring it - built by fileListIndexModules */
 } FileList;
 
 /**
@@ -73,11 +82,49 @@ typedef struct {
 int parseFiles(size_t argc, char const *const *argv, size_t numFiles);
 
 /**
- * finds the declaration file FileListEntry that matches the specified name node
+ * re-indexes the file list by input filename, after files are dropped from it
+ */
+void fileListIndexPaths(void);
+
+/**
+ * finds the FileListEntry with the specified input filename
+ *
+ * if no file was found, return NULL
+ *
+ * @param path input filename (interned)
+ */
+FileListEntry *fileListFindPath(char const *path);
+
+/**
+ * indexes decl files by module name, once their modules have been parsed or
+ * loaded - files that failed to parse are skipped
+ *
+ * @param duplicates vector to add decl files to if their module was already
+ * declared by an earlier decl file (vector of FileListEntry, non-owning), or
+ * NULL
+ */
+void fileListIndexModules(Vector *duplicates);
+
+/**
+ * finds the declaration file FileListEntry that declares the specified module
  *
  * if no name was found, return NULL
+ *
+ * @param name module name, joined with "::" (interned)
+ */
+FileListEntry *fileListFindDeclName(char const *name);
+
+/**
+ * finds all decl files that a file imports, directly or indirectly
+ *
+ * for a code file, this includes the decl file of its own module, if any; the
+ * file itself is never included. Imports must already be resolved
+ *
+ * @param entry file to find the dependencies of
+ * @param dependencies vector to add dependencies to (vector of FileListEntry,
+ * non-owning)
  */
-FileListEntry *fileListFindDeclName(Node *name);
+void fileListFindDependencies(FileListEntry const *entry, Vector *dependencies);
 
 /** global file list object */
 extern FileList fileList;
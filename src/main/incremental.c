@@ -0,0 +1,327 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Implementation of incremental builds
+//
+// Each code file's record is kept in a file named after a hash of the working
+// directory and the code file's name. A record is text: a header line, the
+// target architecture, a hash of the names of all the decl files in the
+// compilation, then the hash and name of the code file, then the hash and name
+// of each decl file it depends on.
+
+#include "incremental.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fileList.h"
+#include "ir/ir.h"
+#include "options.h"
+#include "util/container/stringBuilder.h"
+#include "util/container/vector.h"
+#include "util/format.h"
+#include "util/functional.h"
+#include "util/hash.h"
+#include "util/intern.h"
+
+/** first line of a record - change when the format does */
+#define RECORD_HEADER "tlc incremental record 1\n"
+
+/** a record waiting to be written */
+typedef struct {
+  char *filename; /**< file to write the record to */
+  char *contents; /**< text of the record */
+} PendingRecord;
+
+/** vector of PendingRecord */
+static Vector pending;
+
+/**
+ * gets the name of the record for a code file
+ *
+ * @param inputFilename name of the code file
+ * @returns name of the record file, or NULL if the working directory is
+ * unavailable
+ */
+static char *recordFilename(char const *inputFilename) {
+  char *cwd = getcwd(NULL, 0);
+  if (cwd == NULL) return NULL;
+  char *key = format("%s/%s", cwd, inputFilename);
+  free(cwd);
+  char *filename = format("%s/%016" PRIx64 ".rec", options.incrementalDir,
+                          fnv1a(key, strlen(key)));
+  free(key);
+  return filename;
+}
+
+/**
+ * hashes the names of all decl files in the compilation, in any order
+ */
+static uint64_t declNamesHash(void) {
+  uint64_t hash = 0;
+  for (size_t idx = 0; idx < fileList.size; ++idx) {
+    FileListEntry *entry = &fileList.entries[idx];
+    if (!entry->isCode)
+      hash ^= fnv1a(entry->inputFilename, strlen(entry->inputFilename));
+  }
+  return hash;
+}
+
+/**
+ * finds a decl file in the file list by name
+ *
+ * @returns index into the file list, or fileList.size if not found
+ */
+static size_t findDecl(char const *filename) {
+  FileListEntry *entry = fileListFindPath(internString(filename));
+  if (entry == NULL || entry->isCode) return fileList.size;
+  return (size_t)(entry - fileList.entries);
+}
+
+/**
+ * reads one "hash filename" line from a record
+ *
+ * @param in file to read from
+ * @param line buffer for getline
+ * @param lineSize size of buffer for getline
+ * @param hash output parameter for the hash
+ * @returns the file name, pointing into line, or NULL at end of file or on an
+ * invalid line
+ */
+static char *readEntry(FILE *in, char **line, size_t *lineSize,
+                       uint64_t *hash) {
+  ssize_t length = getline(line, lineSize, in);
+  if (length <= 0 || (*line)[length - 1] != '\n') return NULL;
+  (*line)[length - 1] = '\0';
+
+  int nameStart;
+  if (sscanf(*line, "%" SCNx64 " %n", hash, &nameStart) != 1) return NULL;
+  return *line + nameStart;
+}
+
+/**
+ * checks whether a record matches a code file's current inputs
+ *
+ * @param in record to read
+ * @param line buffer for getline
+ * @param lineSize size of buffer for getline
+ * @param entry code file to check
+ * @param declHashes hashes of decl files, by file list index, filled in as
+ * needed
+ * @param declHashed which entries of declHashes are filled in
+ */
+static bool recordMatches(FILE *in, char **line, size_t *lineSize,
+                          FileListEntry *entry, uint64_t *declHashes,
+                          bool *declHashed) {
+  // header, target, and set of decl files must be the same
+  char *expected = format(RECORD_HEADER "arch %d\ndecls %016" PRIx64 "\n",
+                          (int)options.arch, declNamesHash());
+  bool matches = true;
+  for (char const *expectedLine = expected; *expectedLine != '\0' && matches;) {
+    ssize_t length = getline(line, lineSize, in);
+    matches = length > 0 && strncmp(*line, expectedLine, (size_t)length) == 0;
+    if (matches) expectedLine += length;
+  }
+  free(expected);
+  if (!matches) return false;
+
+  // code file must be unchanged
+  uint64_t hash;
+  uint64_t currentHash;
+  char *name = readEntry(in, line, lineSize, &hash);
+  if (name == NULL || strcmp(name, entry->inputFilename) != 0 ||
+      fnv1aFile(entry->inputFilename, &currentHash) != 0 ||
+      currentHash != hash)
+    return false;
+
+  // each dependency must be in this compilation and unchanged
+  while ((name = readEntry(in, line, lineSize, &hash)) != NULL) {
+    size_t declIdx = findDecl(name);
+    if (declIdx == fileList.size) return false;
+    if (!declHashed[declIdx]) {
+      if (fnv1aFile(name, &declHashes[declIdx]) != 0) return false;
+      declHashed[declIdx] = true;
+    }
+    if (declHashes[declIdx] != hash) return false;
+  }
+  return feof(in) != 0;
+}
+
+/**
+ * checks whether a code file's record matches its current inputs
+ *
+ * @param entry code file to check
+ * @param declHashes hashes of decl files, by file list index, filled in as
+ * needed
+ * @param declHashed which entries of declHashes are filled in
+ */
+static bool upToDate(FileListEntry *entry, uint64_t *declHashes,
+                     bool *declHashed) {
+  char *filename = recordFilename(entry->inputFilename);
+  if (filename == NULL) return false;
+  FILE *in = fopen(filename, "r");
+  free(filename);
+  if (in == NULL) return false;
+
+  char *line = NULL;
+  size_t lineSize = 0;
+  bool matches =
+      recordMatches(in, &line, &lineSize, entry, declHashes, declHashed);
+  free(line);
+  fclose(in);
+  return matches;
+}
+
+size_t incrementalFilter(void) {
+  if (options.incrementalDir != NULL) vectorInit(&pending);
+
+  size_t numCodes = 0;
+  if (options.incrementalDir == NULL || options.dump != OPTION_DD_NONE) {
+    for (size_t idx = 0; idx < fileList.size; ++idx)
+      if (fileList.entries[idx].isCode) ++numCodes;
+    return numCodes;
+  }
+
+  uint64_t *declHashes = malloc(sizeof(uint64_t) * fileList.size);
+  bool *declHashed = calloc(fileList.size, sizeof(bool));
+  bool *skip = calloc(fileList.size, sizeof(bool));
+  for (size_t idx = 0; idx < fileList.size; ++idx) {
+    FileListEntry *entry = &fileList.entries[idx];
+    if (entry->isCode) skip[idx] = upToDate(entry, declHashes, declHashed);
+  }
+  free(declHashes);
+  free(declHashed);
+
+  // drop skipped files, keeping the order of the rest
+  size_t numKept = 0;
+  for (size_t idx = 0; idx < fileList.size; ++idx) {
+    FileListEntry *entry = &fileList.entries[idx];
+    if (skip[idx]) {
+      vectorUninit(&entry->irFrags, (void (*)(void *))irFragFree);
+    } else {
+      if (entry->isCode) ++numCodes;
+      fileList.entries[numKept++] = *entry;
+    }
+  }
+  fileList.size = numKept;
+  fileListIndexPaths();
+  free(skip);
+
+  return numCodes;
+}
+
+/**
+ * adds a record line for an input file to the end of a record
+ */
+static void pushInputLine(StringBuilder *sb, uint64_t hash,
+                          char const *inputFilename) {
+  char *line = format("%016" PRIx64 " %s\n", hash, inputFilename);
+  for (char const *c = line; *c != '\0'; ++c) stringBuilderPush(sb, *c);
+  free(line);
+}
+
+void incrementalCollect(void) {
+  if (options.incrementalDir == NULL) return;
+
+  uint64_t namesHash = declNamesHash();
+  char *header = format(RECORD_HEADER "arch %d\ndecls %016" PRIx64 "\n",
+                        (int)options.arch, namesHash);
+  for (size_t idx = 0; idx < fileList.size; ++idx) {
+    FileListEntry *entry = &fileList.entries[idx];
+    if (!entry->isCode || strchr(entry->inputFilename, '\n') != NULL) continue;
+
+    char *filename = recordFilename(entry->inputFilename);
+    if (filename == NULL) continue;
+
+    StringBuilder contents;
+    stringBuilderInit(&contents);
+    for (char const *c = header; *c != '\0'; ++c)
+      stringBuilderPush(&contents, *c);
+    pushInputLine(&contents, entry->sourceHash, entry->inputFilename);
+
+    Vector dependencies;
+    vectorInit(&dependencies);
+    fileListFindDependencies(entry, &dependencies);
+    for (size_t depIdx = 0; depIdx < dependencies.size; ++depIdx) {
+      FileListEntry *dependency = dependencies.elements[depIdx];
+      pushInputLine(&contents, dependency->sourceHash,
+                    dependency->inputFilename);
+    }
+    vectorUninit(&dependencies, nullDtor);
+
+    PendingRecord *record = malloc(sizeof(PendingRecord));
+    record->filename = filename;
+    record->contents = stringBuilderData(&contents);
+    stringBuilderUninit(&contents);
+    vectorInsert(&pending, record);
+  }
+  free(header);
+}
+
+/**
+ * writes a record, replacing any old one
+ *
+ * @returns status code (0 = OK)
+ */
+static int writeRecord(PendingRecord const *record) {
+  char *tempFilename = format("%s.XXXXXX", record->filename);
+  int retval = -1;
+  int fd = mkstemp(tempFilename);
+  if (fd != -1) {
+    FILE *out = fdopen(fd, "w");
+    if (out == NULL) {
+      close(fd);
+    } else {
+      bool written = fputs(record->contents, out) != EOF;
+      if (fclose(out) == 0 && written &&
+          rename(tempFilename, record->filename) == 0)
+        retval = 0;
+    }
+    if (retval != 0) unlink(tempFilename);
+  }
+  free(tempFilename);
+  return retval;
+}
+
+static void pendingRecordFree(PendingRecord *record) {
+  free(record->filename);
+  free(record->contents);
+  free(record);
+}
+
+void incrementalFinish(bool success) {
+  if (options.incrementalDir == NULL) return;
+
+  if (success) {
+    mkdir(options.incrementalDir, 0777);
+    for (size_t idx = 0; idx < pending.size; ++idx) {
+      PendingRecord *record = pending.elements[idx];
+      if (writeRecord(record) != 0)
+        fprintf(stderr,
+                "tlc: warning: cannot write incremental build record '%s'\n",
+                record->filename);
+    }
+  }
+
+  vectorUninit(&pending, (void (*)(void *))pendingRecordFree);
+}
@@ -0,0 +1,61 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/**
+ * @file
+ * incremental builds - skipping code files whose inputs are unchanged
+ *
+ * After a successful compilation, a record of the hashes of each code file and
+ * the decl files it depends on is kept in options.incrementalDir. Later
+ * compilations drop code files whose record still matches before parsing.
+ */
+
+#ifndef TLC_INCREMENTAL_H_
+#define TLC_INCREMENTAL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * removes code files whose inputs are unchanged from the global file list
+ *
+ * does nothing unless options.incrementalDir is set; must be called before
+ * parsing, and before incrementalCollect and incrementalFinish
+ *
+ * @returns number of code files left to compile
+ */
+size_t incrementalFilter(void);
+
+/**
+ * builds the records for all code files being compiled
+ *
+ * does nothing unless options.incrementalDir is set; must be called after
+ * parsing succeeds, while the ASTs still exist
+ */
+void incrementalCollect(void);
+
+/**
+ * writes out the records built by incrementalCollect if the compilation
+ * succeeded, and frees them
+ *
+ * @param success did the compilation succeed
+ */
+void incrementalFinish(bool success);
+
+#endif  // TLC_INCREMENTAL_H_
@@ -0,0 +1,255 @@
+// Copyright 2022 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "ir/dataflow.h"
+
+#include <stdlib.h>
+
+#include "util/container/bitSet.h"
+
+void dataflowInit(Dataflow *flow, IRCfg const *cfg,
+                  DataflowDirection direction, DataflowMeet meet, size_t size) {
+  flow->cfg = cfg;
+  flow->direction = direction;
+  flow->meet = meet;
+  flow->size = size;
+  flow->words = bitSetWords(size);
+  size_t total = flow->words * cfg->numBlocks;
+  flow->gen = calloc(total, sizeof(uint64_t));
+  flow->kill = calloc(total, sizeof(uint64_t));
+  flow->in = calloc(total, sizeof(uint64_t));
+  flow->out = calloc(total, sizeof(uint64_t));
+}
+uint64_t *dataflowGen(Dataflow const *flow, size_t block) {
+  return flow->gen + block * flow->words;
+}
+uint64_t *dataflowKill(Dataflow const *flow, size_t block) {
+  return flow->kill + block * flow->words;
+}
+uint64_t *dataflowIn(Dataflow const *flow, size_t block) {
+  return flow->in + block * flow->words;
+}
+uint64_t *dataflowOut(Dataflow const *flow, size_t block) {
+  return flow->out + block * flow->words;
+}
+void dataflowSolve(Dataflow *flow) {
+  IRCfg const *cfg = flow->cfg;
+  size_t numBlocks = cfg->numBlocks;
+  size_t size = flow->size;
+  bool forward = flow->direction == DD_FORWARD;
+  uint64_t *(*input)(Dataflow const *, size_t) =
+      forward ? dataflowIn : dataflowOut;
+  uint64_t *(*result)(Dataflow const *, size_t) =
+      forward ? dataflowOut : dataflowIn;
+  // edges facts flow in along, and edges to blocks depending on this block
+  size_t const *fromStart = forward ? cfg->predStart : cfg->succStart;
+  size_t const *from = forward ? cfg->preds : cfg->succs;
+  size_t const *toStart = forward ? cfg->succStart : cfg->predStart;
+  size_t const *to = forward ? cfg->succs : cfg->preds;
+
+  // results start at the top of the lattice
+  for (size_t idx = 0; idx < numBlocks; ++idx) {
+    if (flow->meet == DM_UNION)
+      bitSetClear(result(flow, idx), size);
+    else
+      bitSetFill(result(flow, idx), size);
+  }
+
+  // reverse postorder, with unreachable blocks after in list order - backwards
+  // problems visit in the opposite order
+  size_t *order = malloc(sizeof(size_t) * numBlocks);
+  size_t numOrdered = irCfgReversePostorder(cfg, order);
+  bool *pending = calloc(numBlocks, sizeof(bool));
+  for (size_t idx = 0; idx < numOrdered; ++idx) pending[order[idx]] = true;
+  for (size_t idx = 0; idx < numBlocks; ++idx) {
+    if (!pending[idx]) {
+      order[numOrdered++] = idx;
+      pending[idx] = true;
+    }
+  }
+  if (!forward) {
+    for (size_t idx = 0; idx < numBlocks / 2; ++idx) {
+      size_t temp = order[idx];
+      order[idx] = order[numBlocks - idx - 1];
+      order[numBlocks - idx - 1] = temp;
+    }
+  }
+
+  uint64_t *scratch = bitSetCreate(size);
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t orderIdx = 0; orderIdx < numBlocks; ++orderIdx) {
+      size_t block = order[orderIdx];
+      if (!pending[block]) continue;
+      pending[block] = false;
+
+      // meet over incoming edges
+      uint64_t *in = input(flow, block);
+      if (forward ? block == 0 : fromStart[block] == fromStart[block + 1]) {
+        bitSetClear(in, size);
+      } else if (flow->meet == DM_UNION) {
+        bitSetClear(in, size);
+        for (size_t edge = fromStart[block]; edge < fromStart[block + 1];
+             ++edge)
+          bitSetUnion(in, result(flow, from[edge]), size);
+      } else {
+        bitSetFill(in, size);
+        for (size_t edge = fromStart[block]; edge < fromStart[block + 1];
+             ++edge)
+          bitSetIntersect(in, result(flow, from[edge]), size);
+      }
+
+      // transfer through the block
+      bitSetTransfer(scratch, dataflowGen(flow, block), in,
+                     dataflowKill(flow, block), size);
+      uint64_t *out = result(flow, block);
+      if (!bitSetEqual(scratch, out, size)) {
+        bitSetCopy(out, scratch, size);
+        for (size_t edge = toStart[block]; edge < toStart[block + 1]; ++edge)
+          pending[to[edge]] = true;
+        changed = true;
+      }
+    }
+  }
+
+  free(scratch);
+  free(pending);
+  free(order);
+}
+void dataflowUninit(Dataflow *flow) {
+  free(flow->gen);
+  free(flow->kill);
+  free(flow->in);
+  free(flow->out);
+}
+
+/** is an operand a temp tracked by the liveness sets */
+static bool isTracked(Liveness const *liveness, IROperand const *arg) {
+  return arg->kind == OK_TEMP && arg->data.temp.name >= liveness->firstId &&
+         arg->data.temp.name - liveness->firstId < liveness->numIds;
+}
+/** index of a temp in the liveness sets */
+static size_t tempIndex(Liveness const *liveness, IROperand const *temp) {
+  return temp->data.temp.name - liveness->firstId;
+}
+/**
+ * add the temps read by phis along a block's out edges to a set
+ */
+static void addPhiUses(Liveness const *liveness, size_t block, uint64_t *set) {
+  IRCfg const *cfg = liveness->flow.cfg;
+  size_t label = cfg->blocks[block]->label;
+  for (size_t edge = cfg->succStart[block]; edge < cfg->succStart[block + 1];
+       ++edge) {
+    IRBlock const *succ = cfg->blocks[cfg->succs[edge]];
+    LinkedList const *instructions = &succ->instructions;
+    for (ListNode *curr = instructions->head->next;
+         curr != instructions->tail &&
+         ((IRInstruction const *)curr->data)->op == IO_PHI;
+         curr = curr->next) {
+      IRInstruction const *phi = curr->data;
+      for (size_t idx = 1; idx < phi->arity; idx += 2) {
+        if (localOperandName(phi->args[idx]) == label &&
+            isTracked(liveness, phi->args[idx + 1]))
+          bitSetAdd(set, tempIndex(liveness, phi->args[idx + 1]));
+      }
+    }
+  }
+}
+void livenessInit(Liveness *liveness, IRCfg const *cfg, size_t firstId,
+                  size_t numIds) {
+  liveness->firstId = firstId;
+  liveness->numIds = numIds;
+  liveness->addressTaken = bitSetCreate(numIds);
+  dataflowInit(&liveness->flow, cfg, DD_BACKWARD, DM_UNION, numIds);
+
+  uint64_t *phiUses = bitSetCreate(numIds);
+  for (size_t block = 0; block < cfg->numBlocks; ++block) {
+    uint64_t *gen = dataflowGen(&liveness->flow, block);
+    uint64_t *kill = dataflowKill(&liveness->flow, block);
+    LinkedList const *instructions = &cfg->blocks[block]->instructions;
+    for (ListNode *curr = instructions->tail->prev; curr != instructions->head;
+         curr = curr->prev) {
+      IRInstruction const *i = curr->data;
+      for (size_t idx = 0; idx < i->arity; ++idx) {
+        IROperand const *arg = i->args[idx];
+        if (!isTracked(liveness, arg)) continue;
+        switch (irOperandUse(i->op, idx)) {
+          case OU_WRITE: {
+            bitSetAdd(kill, tempIndex(liveness, arg));
+            break;
+          }
+          case OU_ADDRESS: {
+            bitSetAdd(liveness->addressTaken, tempIndex(liveness, arg));
+            break;
+          }
+          default: {
+            // doesn't kill
+            break;
+          }
+        }
+      }
+      livenessStep(liveness, gen, i);
+    }
+
+    // phi uses along the out edges are read at the very end of the block
+    bitSetClear(phiUses, numIds);
+    addPhiUses(liveness, block, phiUses);
+    bitSetTransfer(gen, gen, phiUses, kill, numIds);
+  }
+
+  dataflowSolve(&liveness->flow);
+
+  for (size_t block = 0; block < cfg->numBlocks; ++block)
+    addPhiUses(liveness, block, dataflowOut(&liveness->flow, block));
+  free(phiUses);
+}
+uint64_t const *livenessIn(Liveness const *liveness, size_t block) {
+  return dataflowIn(&liveness->flow, block);
+}
+uint64_t const *livenessOut(Liveness const *liveness, size_t block) {
+  return dataflowOut(&liveness->flow, block);
+}
+bool livenessIsLive(Liveness const *liveness, uint64_t const *live,
+                    IROperand const *temp) {
+  if (!isTracked(liveness, temp)) return true;
+  size_t idx = tempIndex(liveness, temp);
+  return bitSetContains(live, idx) ||
+         bitSetContains(liveness->addressTaken, idx);
+}
+void livenessStep(Liveness const *liveness, uint64_t *live,
+                  IRInstruction const *i) {
+  // writes end a live range, then reads start one - a phi's reads belong to
+  // its predecessors
+  for (size_t idx = 0; idx < i->arity; ++idx) {
+    if (isTracked(liveness, i->args[idx]) &&
+        irOperandUse(i->op, idx) == OU_WRITE)
+      bitSetRemove(live, tempIndex(liveness, i->args[idx]));
+  }
+  if (i->op == IO_PHI) return;
+  for (size_t idx = 0; idx < i->arity; ++idx) {
+    if (isTracked(liveness, i->args[idx]) &&
+        irOperandUse(i->op, idx) == OU_READ)
+      bitSetAdd(live, tempIndex(liveness, i->args[idx]));
+  }
+}
+void livenessUninit(Liveness *liveness) {
+  free(liveness->addressTaken);
+  dataflowUninit(&liveness->flow);
+}
@@ -0,0 +1,150 @@
+// Copyright 2022 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/**
+ * @file
+ * bitvector dataflow analyses over blocked IR
+ */
+
+#ifndef TLC_IR_DATAFLOW_H_
+#define TLC_IR_DATAFLOW_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ir/ir.h"
+
+/** which way facts flow along control flow edges */
+typedef enum {
+  DD_FORWARD,  /**< from the entry block towards the exits */
+  DD_BACKWARD, /**< from the exits towards the entry block */
+} DataflowDirection;
+
+/** how facts from several edges are combined */
+typedef enum {
+  DM_UNION,        /**< a fact holding along any edge holds */
+  DM_INTERSECTION, /**< a fact must hold along every edge to hold */
+} DataflowMeet;
+
+/**
+ * a gen/kill dataflow problem over the blocks of a control flow graph
+ *
+ * Each block has a gen, kill, in, and out set of size bits, stored as bit sets
+ * one after another. For forward problems, out = gen | (in & ~kill), and in is
+ * the meet of the predecessors' outs; backward problems swap in and out, and
+ * use successors. The entry block's in (forward) and the outs of blocks with no
+ * successors (backward) are empty.
+ *
+ * The client fills in gen and kill, then solves for in and out.
+ */
+typedef struct {
+  IRCfg const *cfg;
+  DataflowDirection direction;
+  DataflowMeet meet;
+  size_t size;   /**< number of bits in each set */
+  size_t words;  /**< number of words in each set */
+  uint64_t *gen; /**< gen sets, indexed by block */
+  uint64_t *kill;
+  uint64_t *in;
+  uint64_t *out;
+} Dataflow;
+
+/**
+ * initialize a problem with empty gen and kill sets
+ *
+ * @param flow problem to initialize
+ * @param cfg graph to solve over - must outlive flow
+ * @param direction direction of the problem
+ * @param meet how to combine edges
+ * @param size number of facts
+ */
+void dataflowInit(Dataflow *flow, IRCfg const *cfg,
+                  DataflowDirection direction, DataflowMeet meet, size_t size);
+/** get one block's set */
+uint64_t *dataflowGen(Dataflow const *flow, size_t block);
+uint64_t *dataflowKill(Dataflow const *flow, size_t block);
+uint64_t *dataflowIn(Dataflow const *flow, size_t block);
+uint64_t *dataflowOut(Dataflow const *flow, size_t block);
+/**
+ * solve the problem for in and out
+ *
+ * Blocks are visited in reverse postorder (postorder for backward problems)
+ * until nothing changes; only blocks whose inputs changed are revisited
+ */
+void dataflowSolve(Dataflow *flow);
+/** dtor */
+void dataflowUninit(Dataflow *flow);
+
+/**
+ * temp liveness over a control flow graph
+ *
+ * Temps named [firstId, firstId + numIds) are tracked by their index in that
+ * range - usually the fragment's id range. Temps outside it, and temps whose
+ * address is taken, may be read anywhere, so they are always live.
+ *
+ * A phi's reads happen on the edge from the matching predecessor, so they are
+ * live at the end of that predecessor, but not at the start of the phi's block.
+ */
+typedef struct {
+  size_t firstId;         /**< name of the temp with index zero */
+  size_t numIds;          /**< number of temps tracked */
+  uint64_t *addressTaken; /**< temps that are always live */
+  Dataflow flow;          /**< the solved backward problem */
+} Liveness;
+
+/**
+ * compute the live temps at the start and end of each block
+ *
+ * @param liveness analysis to initialize
+ * @param cfg control flow graph to analyze - must outlive liveness
+ * @param firstId name of the first temp to track
+ * @param numIds number of temps to track
+ */
+void livenessInit(Liveness *liveness, IRCfg const *cfg, size_t firstId,
+                  size_t numIds);
+/** temps live at the start of a block */
+uint64_t const *livenessIn(Liveness const *liveness, size_t block);
+/** temps live at the end of a block */
+uint64_t const *livenessOut(Liveness const *liveness, size_t block);
+/**
+ * is a temp live
+ *
+ * @param liveness analysis the set is from
+ * @param live set of live temps
+ * @param temp TEMP operand to check
+ */
+bool livenessIsLive(Liveness const *liveness, uint64_t const *live,
+                    IROperand const *temp);
+/**
+ * update a set of live temps from just after an instruction to just before it
+ *
+ * Walking a block's instructions backwards from livenessOut gives the live
+ * temps at each point in the block
+ *
+ * @param liveness analysis the set is from
+ * @param live set of live temps (mutated)
+ * @param i instruction to step back over
+ */
+void livenessStep(Liveness const *liveness, uint64_t *live,
+                  IRInstruction const *i);
+/** dtor */
+void livenessUninit(Liveness *liveness);
+
+#endif  // TLC_IR_DATAFLOW_H_
@@ -139,8 +139,17 @@ static void fourOperandInstructionDump(FILE *where, char const *name,
   operandDump(where, i->args[3]);
   fprintf(where, ")");
 }
+static void variadicInstructionDump(FILE *where, char const *name,
+                                    IRInstruction *i) {
+  fprintf(where, "%s(", name);
+  for (size_t idx = 0; idx < i->arity; ++idx) {
+    if (idx != 0) fprintf(where, ", ");
+    operandDump(where, i->args[idx]);
+  }
+  fprintf(where, ")");
+}
 static void instructionDump(FILE *where, IRInstruction *i) {
-  switch (irOperatorArity(i->op)) {
+  switch (i->arity) {
     case 0: {
       zeroOperandInstructionDump(where, IROPERATOR_NAMES[i->op], i);
       break;
@@ -162,7 +171,9 @@ static void instructionDump(FILE *where, IRInstruction *i) {
       break;
     }
     default: {
-      error(__FILE__, __LINE__, "invalid IROperand enum");
+      // only PHI has more operands
+      variadicInstructionDump(where, IROPERATOR_NAMES[i->op], i);
+      break;
     }
   }
 }
@@ -27,6 +27,14 @@
 #include "util/numericSizing.h"
 #include "util/string.h"
 
+/** arena to allocate blocks, instructions and operands from, if any */
+static _Thread_local Arena *currentArena = NULL;
+
+void irArenaSet(Arena *arena) {
+  currentArena = arena;
+  linkedListArenaSet(arena);
+}
+
 static IRFrag *fragCreate(FragmentType type, FragmentNameType nameType) {
   IRFrag *df = malloc(sizeof(IRFrag));
   df->type = type;
@@ -50,16 +58,14 @@ IRFrag *localDataFragCreate(FragmentType type, size_t name, size_t alignment) {
 IRFrag *textFragCreate(char *name) {
   IRFrag *df = fragCreate(FT_TEXT, FNT_GLOBAL);
   df->name.global = name;
+  df->data.text.arena = arenaCreate();
+  linkedListArenaSet(df->data.text.arena);
   linkedListInit(&df->data.text.blocks);
+  linkedListArenaSet(currentArena);
+  df->data.text.firstId = 0;
+  df->data.text.numIds = 0;
   return df;
 }
-IRFrag *findFrag(Vector *frags, size_t label) {
-  for (size_t idx = 0; idx < frags->size; ++idx) {
-    IRFrag *f = frags->elements[idx];
-    if (f->nameType == FNT_LOCAL && f->name.local == label) return f;
-  }
-  return NULL;
-}
 void irFragFree(IRFrag *f) {
   switch (f->nameType) {
     case FNT_GLOBAL: {
@@ -78,7 +84,8 @@ void irFragFree(IRFrag *f) {
       break;
     }
     case FT_TEXT: {
-      linkedListUninit(&f->data.text.blocks, (void (*)(void *))irBlockFree);
+      // blocks, and everything in them, live in the arena
+      arenaFree(f->data.text.arena);
       break;
     }
     default: {
@@ -90,6 +97,31 @@ void irFragFree(IRFrag *f) {
 void irFragVectorUninit(Vector *v) {
   vectorUninit(v, (void (*)(void *))irFragFree);
 }
+void irFragIndexInit(IRFragIndex *index, Vector const *frags,
+                     size_t numLabels) {
+  index->numLabels = numLabels;
+  index->frags = calloc(numLabels, sizeof(IRFrag *));
+  index->dataTargets = calloc(numLabels, sizeof(bool));
+  for (size_t fragIdx = 0; fragIdx < frags->size; ++fragIdx) {
+    IRFrag *f = frags->elements[fragIdx];
+    if (f->nameType == FNT_LOCAL) index->frags[f->name.local] = f;
+    if (f->type == FT_RODATA) {
+      Vector const *data = &f->data.data.data;
+      for (size_t datumIdx = 0; datumIdx < data->size; ++datumIdx) {
+        IRDatum const *datum = data->elements[datumIdx];
+        if (datum->type == DT_LOCAL)
+          index->dataTargets[datum->data.localLabel] = true;
+      }
+    }
+  }
+}
+IRFrag *irFragIndexFind(IRFragIndex const *index, size_t label) {
+  return label < index->numLabels ? index->frags[label] : NULL;
+}
+void irFragIndexUninit(IRFragIndex *index) {
+  free(index->frags);
+  free(index->dataTargets);
+}
 
 static IRDatum *datumCreate(DatumType type) {
   IRDatum *d = malloc(sizeof(IRDatum));
@@ -264,7 +296,14 @@ static size_t irDatumSizeof(IRDatum const *d) {
 }
 
 static IROperand *irOperandCreate(OperandKind kind) {
-  IROperand *o = malloc(sizeof(IROperand));
+  IROperand *o;
+  if (currentArena != NULL) {
+    o = arenaAlloc(currentArena, sizeof(IROperand));
+    o->inArena = true;
+  } else {
+    o = malloc(sizeof(IROperand));
+    o->inArena = false;
+  }
   o->kind = kind;
   return o;
 }
@@ -283,10 +322,21 @@ IROperand *regOperandCreate(size_t name, size_t size) {
   o->data.reg.size = size;
   return o;
 }
+static void constantDataFree(Vector *data) {
+  vectorUninit(data, (void (*)(void *))irDatumFree);
+}
 IROperand *constantOperandCreate(size_t alignment) {
   IROperand *o = irOperandCreate(OK_CONSTANT);
   o->data.constant.alignment = alignment;
   vectorInit(&o->data.constant.data);
+  if (o->inArena)
+    arenaAddCleanup(currentArena, (void (*)(void *))constantDataFree,
+                    &o->data.constant.data);
+  return o;
+}
+IROperand *localOperandCreate(size_t name) {
+  IROperand *o = constantOperandCreate(POINTER_WIDTH);
+  vectorInsert(&o->data.constant.data, localLabelDatumCreate(name));
   return o;
 }
 IROperand *irOperandCopy(IROperand const *o) {
@@ -404,11 +454,12 @@ bool isFpTemp(IROperand const *o) {
 }
 bool isConst(IROperand const *o) { return o->kind == OK_CONSTANT; }
 void irOperandFree(IROperand *o) {
-  if (o == NULL) return;
+  // arena operands' data is released by the arena's cleanups
+  if (o == NULL || o->inArena) return;
 
   switch (o->kind) {
     case OK_CONSTANT: {
-      vectorUninit(&o->data.constant.data, (void (*)(void *))irDatumFree);
+      constantDataFree(&o->data.constant.data);
       break;
     }
     default: {
@@ -420,6 +471,9 @@ void irOperandFree(IROperand *o) {
 
 size_t irOperatorArity(IROperator op) {
   switch (op) {
+    case IO_PHI: {
+      error(__FILE__, __LINE__, "PHI has no fixed arity");
+    }
     case IO_NOP:
     case IO_RETURN: {
       return 0;
@@ -541,60 +595,393 @@ size_t irOperatorArity(IROperator op) {
     }
   }
 }
+OperandUse irOperandUse(IROperator op, size_t idx) {
+  switch (op) {
+    case IO_LABEL:
+    case IO_NOP:
+    case IO_RETURN: {
+      return OU_NONE;
+    }
+    case IO_VOLATILE:
+    case IO_MEM_STORE:
+    case IO_STK_STORE:
+    case IO_JUMP:
+    case IO_CALL: {
+      return OU_READ;
+    }
+    case IO_UNINITIALIZED: {
+      return OU_WRITE;
+    }
+    case IO_ADDROF: {
+      return idx == 0 ? OU_WRITE : OU_ADDRESS;
+    }
+    case IO_PHI: {
+      // destination, then label and value pairs
+      if (idx == 0)
+        return OU_WRITE;
+      else
+        return idx % 2 == 1 ? OU_NONE : OU_READ;
+    }
+    case IO_OFFSET_STORE: {
+      return idx == 0 ? OU_PARTIAL_WRITE : OU_READ;
+    }
+    case IO_JUMPTABLE: {
+      return idx == 0 ? OU_READ : OU_NONE;
+    }
+    case IO_MOVE:
+    case IO_MEM_LOAD:
+    case IO_STK_LOAD:
+    case IO_OFFSET_LOAD:
+    case IO_ADD:
+    case IO_SUB:
+    case IO_SMUL:
+    case IO_UMUL:
+    case IO_SDIV:
+    case IO_UDIV:
+    case IO_SMOD:
+    case IO_UMOD:
+    case IO_FADD:
+    case IO_FSUB:
+    case IO_FMUL:
+    case IO_FDIV:
+    case IO_FMOD:
+    case IO_NEG:
+    case IO_FNEG:
+    case IO_SLL:
+    case IO_SLR:
+    case IO_SAR:
+    case IO_AND:
+    case IO_XOR:
+    case IO_OR:
+    case IO_NOT:
+    case IO_L:
+    case IO_LE:
+    case IO_E:
+    case IO_NE:
+    case IO_G:
+    case IO_GE:
+    case IO_A:
+    case IO_AE:
+    case IO_B:
+    case IO_BE:
+    case IO_FL:
+    case IO_FLE:
+    case IO_FE:
+    case IO_FNE:
+    case IO_FG:
+    case IO_FGE:
+    case IO_Z:
+    case IO_NZ:
+    case IO_FZ:
+    case IO_FNZ:
+    case IO_LNOT:
+    case IO_SX:
+    case IO_ZX:
+    case IO_TRUNC:
+    case IO_U2F:
+    case IO_S2F:
+    case IO_FRESIZE:
+    case IO_F2I: {
+      return idx == 0 ? OU_WRITE : OU_READ;
+    }
+    case IO_J2L:
+    case IO_J2LE:
+    case IO_J2E:
+    case IO_J2NE:
+    case IO_J2G:
+    case IO_J2GE:
+    case IO_J2A:
+    case IO_J2AE:
+    case IO_J2B:
+    case IO_J2BE:
+    case IO_J2FL:
+    case IO_J2FLE:
+    case IO_J2FE:
+    case IO_J2FNE:
+    case IO_J2FG:
+    case IO_J2FGE:
+    case IO_J2Z:
+    case IO_J2NZ:
+    case IO_J2FZ:
+    case IO_J2FNZ: {
+      // both targets, then the arguments
+      return idx < 2 ? OU_NONE : OU_READ;
+    }
+    case IO_J1L:
+    case IO_J1LE:
+    case IO_J1E:
+    case IO_J1NE:
+    case IO_J1G:
+    case IO_J1GE:
+    case IO_J1A:
+    case IO_J1AE:
+    case IO_J1B:
+    case IO_J1BE:
+    case IO_J1FL:
+    case IO_J1FLE:
+    case IO_J1FE:
+    case IO_J1FNE:
+    case IO_J1FG:
+    case IO_J1FGE:
+    case IO_J1Z:
+    case IO_J1NZ:
+    case IO_J1FZ:
+    case IO_J1FNZ: {
+      return idx < 1 ? OU_NONE : OU_READ;
+    }
+    default: {
+      error(__FILE__, __LINE__, "invalid IROperator enum");
+    }
+  }
+}
 
-IRInstruction *irInstructionCreate(IROperator op) {
-  IRInstruction *i = malloc(sizeof(IRInstruction));
+static IRInstruction *instructionCreate(IROperator op, size_t arity) {
+  size_t argsSize = arity * sizeof(IROperand *);
+  IRInstruction *i;
+  if (currentArena != NULL) {
+    // args directly follow the instruction
+    i = arenaAlloc(currentArena, sizeof(IRInstruction) + argsSize);
+    i->inArena = true;
+    i->args = (IROperand **)(i + 1);
+  } else {
+    i = malloc(sizeof(IRInstruction));
+    i->inArena = false;
+    i->args = malloc(argsSize);
+  }
   i->op = op;
-  i->args = malloc(irOperatorArity(op) * sizeof(IRInstruction *));
+  i->arity = arity;
   return i;
 }
+IRInstruction *irInstructionCreate(IROperator op) {
+  return instructionCreate(op, irOperatorArity(op));
+}
+IRInstruction *irPhiCreate(size_t numPreds) {
+  return instructionCreate(IO_PHI, 1 + 2 * numPreds);
+}
 IRInstruction *irInstructionCopy(IRInstruction const *i) {
-  IRInstruction *copy = irInstructionCreate(i->op);
-  for (size_t idx = 0; idx < irOperatorArity(i->op); ++idx)
+  IRInstruction *copy = instructionCreate(i->op, i->arity);
+  for (size_t idx = 0; idx < i->arity; ++idx)
     copy->args[idx] = irOperandCopy(i->args[idx]);
   return copy;
 }
 static void irOperandArrayFree(IROperand **arry, size_t size) {
   for (size_t idx = 0; idx < size; ++idx) irOperandFree(arry[idx]);
-  free(arry);
 }
 void irInstructionFree(IRInstruction *i) {
-  irOperandArrayFree(i->args, irOperatorArity(i->op));
-  free(i);
+  irOperandArrayFree(i->args, i->arity);
+  if (!i->inArena) {
+    free(i->args);
+    free(i);
+  }
 }
 void irInstructionMakeNop(IRInstruction *i) {
-  irOperandArrayFree(i->args, irOperatorArity(i->op));
-  i->args = malloc(0);
+  irOperandArrayFree(i->args, i->arity);
+  if (!i->inArena) {
+    free(i->args);
+    i->args = malloc(0);
+  }
   i->op = IO_NOP;
+  i->arity = 0;
 }
 
 IRBlock *irBlockCreate(size_t label) {
-  IRBlock *b = malloc(sizeof(IRBlock));
+  IRBlock *b;
+  if (currentArena != NULL) {
+    b = arenaAlloc(currentArena, sizeof(IRBlock));
+    b->inArena = true;
+  } else {
+    b = malloc(sizeof(IRBlock));
+    b->inArena = false;
+  }
   b->label = label;
   linkedListInit(&b->instructions);
   return b;
 }
-size_t indexOfBlock(LinkedList *blocks, size_t label) {
-  size_t idx = 0;
-  for (ListNode *curr = blocks->head->next; curr != blocks->tail;
-       curr = curr->next) {
-    IRBlock *b = curr->data;
-    if (b->label == label) return idx;
-    ++idx;
+void irBlockFree(IRBlock *b) {
+  linkedListUninit(&b->instructions, (void (*)(void *))irInstructionFree);
+  if (!b->inArena) free(b);
+}
+
+/**
+ * gets the labels a block may jump to
+ *
+ * @param b block to look at
+ * @param frags index of the file's fragments, for jump tables
+ * @param targets array to write labels to, or NULL to only count them
+ * @returns number of labels
+ */
+static size_t jumpTargets(IRBlock const *b, IRFragIndex const *frags,
+                          size_t *targets) {
+  IRInstruction const *last = b->instructions.tail->prev->data;
+  switch (last->op) {
+    case IO_JUMP: {
+      if (!irOperandIsLocal(last->args[0])) return 0;
+      if (targets != NULL) targets[0] = localOperandName(last->args[0]);
+      return 1;
+    }
+    case IO_JUMPTABLE: {
+      IRFrag const *table =
+          irFragIndexFind(frags, localOperandName(last->args[1]));
+      Vector const *data = &table->data.data.data;
+      if (targets != NULL) {
+        for (size_t idx = 0; idx < data->size; ++idx) {
+          IRDatum const *datum = data->elements[idx];
+          targets[idx] = datum->data.localLabel;
+        }
+      }
+      return data->size;
+    }
+    case IO_J2L:
+    case IO_J2LE:
+    case IO_J2E:
+    case IO_J2NE:
+    case IO_J2G:
+    case IO_J2GE:
+    case IO_J2A:
+    case IO_J2AE:
+    case IO_J2B:
+    case IO_J2BE:
+    case IO_J2FL:
+    case IO_J2FLE:
+    case IO_J2FE:
+    case IO_J2FNE:
+    case IO_J2FG:
+    case IO_J2FGE:
+    case IO_J2Z:
+    case IO_J2NZ:
+    case IO_J2FZ:
+    case IO_J2FNZ: {
+      if (targets != NULL) {
+        targets[0] = localOperandName(last->args[0]);
+        targets[1] = localOperandName(last->args[1]);
+      }
+      return 2;
+    }
+    default: {
+      // leaves the function
+      return 0;
+    }
   }
-  error(__FILE__, __LINE__, "given block label doesn't exist");
 }
-IRBlock *findBlock(LinkedList *blocks, size_t label) {
+void irCfgInit(IRCfg *cfg, LinkedList const *blocks, IRFragIndex const *frags) {
+  // number the blocks
+  cfg->numBlocks = 0;
+  for (ListNode *curr = blocks->head->next; curr != blocks->tail;
+       curr = curr->next)
+    ++cfg->numBlocks;
+  cfg->blocks = malloc(sizeof(IRBlock *) * cfg->numBlocks);
+  size_t firstLabel = SIZE_MAX;
+  size_t lastLabel = 0;
+  size_t numTargets = 0;
+  size_t idx = 0;
   for (ListNode *curr = blocks->head->next; curr != blocks->tail;
        curr = curr->next) {
     IRBlock *b = curr->data;
-    if (b->label == label) return b;
+    cfg->blocks[idx++] = b;
+    if (b->label < firstLabel) firstLabel = b->label;
+    if (b->label > lastLabel) lastLabel = b->label;
+    numTargets += jumpTargets(b, frags, NULL);
   }
-  return NULL;
+
+  // index them by label
+  cfg->firstLabel = firstLabel;
+  cfg->numLabels = cfg->numBlocks == 0 ? 0 : lastLabel - firstLabel + 1;
+  cfg->indices = malloc(sizeof(size_t) * cfg->numLabels);
+  for (idx = 0; idx < cfg->numLabels; ++idx)
+    cfg->indices[idx] = cfg->numBlocks;
+  for (idx = 0; idx < cfg->numBlocks; ++idx)
+    cfg->indices[cfg->blocks[idx]->label - firstLabel] = idx;
+
+  // successors, dropping jumps out of the fragment
+  cfg->succStart = malloc(sizeof(size_t) * (cfg->numBlocks + 1));
+  cfg->succs = malloc(sizeof(size_t) * numTargets);
+  size_t *predCounts = calloc(cfg->numBlocks, sizeof(size_t));
+  size_t numEdges = 0;
+  for (idx = 0; idx < cfg->numBlocks; ++idx) {
+    cfg->succStart[idx] = numEdges;
+    size_t *targets = cfg->succs + numEdges;
+    size_t count = jumpTargets(cfg->blocks[idx], frags, targets);
+    for (size_t targetIdx = 0; targetIdx < count; ++targetIdx) {
+      size_t succ = irCfgIndexOf(cfg, targets[targetIdx]);
+      if (succ == cfg->numBlocks) continue;
+      cfg->succs[numEdges++] = succ;
+      ++predCounts[succ];
+    }
+  }
+  cfg->succStart[cfg->numBlocks] = numEdges;
+
+  // predecessors, in the order of their edges
+  cfg->predStart = malloc(sizeof(size_t) * (cfg->numBlocks + 1));
+  cfg->preds = malloc(sizeof(size_t) * numEdges);
+  size_t start = 0;
+  for (idx = 0; idx < cfg->numBlocks; ++idx) {
+    cfg->predStart[idx] = start;
+    start += predCounts[idx];
+    predCounts[idx] = cfg->predStart[idx];
+  }
+  cfg->predStart[cfg->numBlocks] = start;
+  for (idx = 0; idx < cfg->numBlocks; ++idx) {
+    for (size_t edge = cfg->succStart[idx]; edge < cfg->succStart[idx + 1];
+         ++edge)
+      cfg->preds[predCounts[cfg->succs[edge]]++] = idx;
+  }
+  free(predCounts);
+}
+size_t irCfgIndexOf(IRCfg const *cfg, size_t label) {
+  if (label < cfg->firstLabel || label - cfg->firstLabel >= cfg->numLabels)
+    return cfg->numBlocks;
+  return cfg->indices[label - cfg->firstLabel];
+}
+size_t irCfgReversePostorder(IRCfg const *cfg, size_t *order) {
+  if (cfg->numBlocks == 0) return 0;
+
+  // iterative depth-first search - each stack entry is a block and the next
+  // of its successor edges to visit
+  bool *seen = calloc(cfg->numBlocks, sizeof(bool));
+  size_t *stack = malloc(sizeof(size_t) * cfg->numBlocks);
+  size_t *nextEdge = malloc(sizeof(size_t) * cfg->numBlocks);
+  size_t stackSize = 0;
+  size_t numVisited = 0;
+
+  seen[0] = true;
+  stack[stackSize] = 0;
+  nextEdge[stackSize++] = cfg->succStart[0];
+  while (stackSize != 0) {
+    size_t curr = stack[stackSize - 1];
+    size_t edge = nextEdge[stackSize - 1];
+    if (edge == cfg->succStart[curr + 1]) {
+      order[numVisited++] = curr;
+      --stackSize;
+      continue;
+    }
+    nextEdge[stackSize - 1] = edge + 1;
+    size_t succ = cfg->succs[edge];
+    if (!seen[succ]) {
+      seen[succ] = true;
+      stack[stackSize] = succ;
+      nextEdge[stackSize++] = cfg->succStart[succ];
+    }
+  }
+
+  // reverse the postorder
+  for (size_t idx = 0; idx < numVisited / 2; ++idx) {
+    size_t temp = order[idx];
+    order[idx] = order[numVisited - idx - 1];
+    order[numVisited - idx - 1] = temp;
+  }
+
+  free(nextEdge);
+  free(stack);
+  free(seen);
+  return numVisited;
 }
-void irBlockFree(IRBlock *b) {
-  linkedListUninit(&b->instructions, (void (*)(void *))irInstructionFree);
-  free(b);
+void irCfgUninit(IRCfg *cfg) {
+  free(cfg->blocks);
+  free(cfg->indices);
+  free(cfg->succStart);
+  free(cfg->succs);
+  free(cfg->predStart);
+  free(cfg->preds);
 }
 
 char const *const IROPERATOR_NAMES[] = {
@@ -603,6 +990,7 @@ char const *const IROPERATOR_NAMES[] = {
     "UNINITIALIZED",
     "ADDROF",
     "NOP",
+    "PHI",
     "MOVE",
     "MEM_STORE",
     "MEM_LOAD",
@@ -1061,9 +1449,63 @@ static void validateArgJumpTarget(IRInstruction const *i, size_t idx,
     }
   }
 }
-static int validateIr(char const *phase, bool blocked) {
+/**
+ * checks that each phi's labels are distinct predecessors of its block
+ */
+static void validatePhiLabels(LinkedList const *blocks, FileListEntry *file,
+                              char const *phase) {
+  IRFragIndex frags;
+  irFragIndexInit(&frags, &file->irFrags, file->nextId);
+  IRCfg cfg;
+  irCfgInit(&cfg, blocks, &frags);
+  for (size_t blockIdx = 0; blockIdx < cfg.numBlocks; ++blockIdx) {
+    IRBlock const *block = cfg.blocks[blockIdx];
+    for (ListNode *currInst = block->instructions.head->next;
+         currInst != block->instructions.tail &&
+         ((IRInstruction const *)currInst->data)->op == IO_PHI;
+         currInst = currInst->next) {
+      IRInstruction const *i = currInst->data;
+      for (size_t idx = 1; idx < i->arity; idx += 2) {
+        size_t label = localOperandName(i->args[idx]);
+        size_t labelIdx = irCfgIndexOf(&cfg, label);
+        bool isPred = false;
+        for (size_t predIdx = cfg.predStart[blockIdx];
+             predIdx < cfg.predStart[blockIdx + 1]; ++predIdx) {
+          if (cfg.preds[predIdx] == labelIdx) isPred = true;
+        }
+        if (!isPred) {
+          fprintf(stderr,
+                  "%s: internal compiler error: IR validation after %s "
+                  "failed - phi in block %zu chooses a value from block %zu, "
+                  "which is not a predecessor\n",
+                  file->inputFilename, phase, block->label, label);
+          file->errored = true;
+        }
+        for (size_t prevIdx = 1; prevIdx < idx; prevIdx += 2) {
+          if (localOperandName(i->args[prevIdx]) == label) {
+            fprintf(stderr,
+                    "%s: internal compiler error: IR validation after %s "
+                    "failed - phi in block %zu chooses a value from block %zu "
+                    "more than once\n",
+                    file->inputFilename, phase, block->label, label);
+            file->errored = true;
+            break;
+          }
+        }
+      }
+    }
+  }
+  irCfgUninit(&cfg);
+  irFragIndexUninit(&frags);
+}
+/**
+ * checks the IR of the files in the file list from first up to but not
+ * including last
+ */
+static int validateIr(size_t first, size_t last, char const *phase,
+                      bool blocked) {
   bool errored = false;
-  for (size_t fileIdx = 0; fileIdx < fileList.size; ++fileIdx) {
+  for (size_t fileIdx = first; fileIdx < last; ++fileIdx) {
     FileListEntry *file = &fileList.entries[fileIdx];
     for (size_t fragIdx = 0; fragIdx < file->irFrags.size; ++fragIdx) {
       IRFrag const *frag = file->irFrags.elements[fragIdx];
@@ -1207,6 +1649,46 @@ static int validateIr(char const *phase, bool blocked) {
               case IO_NOP: {
                 break;
               }
+              case IO_PHI: {
+                if (!blocked) {
+                  fprintf(stderr,
+                          "%s: internal compiler error: IR validation after %s "
+                          "failed - phi encountered in scheduled IR\n",
+                          file->inputFilename, phase);
+                  file->errored = true;
+                  break;
+                }
+                if (currInst->prev != block->instructions.head &&
+                    ((IRInstruction const *)currInst->prev->data)->op !=
+                        IO_PHI) {
+                  fprintf(stderr,
+                          "%s: internal compiler error: IR validation after %s "
+                          "failed - phi encountered after the start of a "
+                          "basic block\n",
+                          file->inputFilename, phase);
+                  file->errored = true;
+                }
+                if (i->arity < 3 || i->arity % 2 != 1) {
+                  fprintf(stderr,
+                          "%s: internal compiler error: IR validation after %s "
+                          "failed - phi has %zu operands instead of a "
+                          "destination and label and value pairs\n",
+                          file->inputFilename, phase, i->arity);
+                  file->errored = true;
+                  break;
+                }
+
+                if (validateArgKind(i, 0, OK_TEMP, phase, file))
+                  validateTempWrite(temps, i->args[0], phase, file);
+
+                // values may be written later in the list of blocks, so they
+                // are checked once every block has been seen
+                for (size_t idx = 1; idx < i->arity; idx += 2) {
+                  if (validateArgLocal(i, idx, phase, file))
+                    validateLocalJumpTarget(i, idx, localLabels, phase, file);
+                }
+                break;
+              }
               case IO_MOVE: {
                 validateArgWritable(i, 0, temps, phase, file);
 
@@ -1821,6 +2303,27 @@ static int validateIr(char const *phase, bool blocked) {
             }
           }
         }
+        if (blocked) {
+          // phi values
+          for (ListNode *currBlock = blocks->head->next;
+               currBlock != blocks->tail; currBlock = currBlock->next) {
+            IRBlock *block = currBlock->data;
+            for (ListNode *currInst = block->instructions.head->next;
+                 currInst != block->instructions.tail &&
+                 ((IRInstruction const *)currInst->data)->op == IO_PHI;
+                 currInst = currInst->next) {
+              IRInstruction const *i = currInst->data;
+              if (i->arity < 3 || i->arity % 2 != 1) continue;
+              for (size_t idx = 2; idx < i->arity; idx += 2) {
+                validateArgReadNoPtr(i, idx, temps, phase, file);
+                validateArgsSameSize(i, 0, idx, phase, file);
+              }
+            }
+          }
+
+          // phi labels - the blocks must be well formed to build the cfg
+          if (!file->errored) validatePhiLabels(blocks, file, phase);
+        }
         free(temps);
         free(localLabels);
       }
@@ -1830,9 +2333,31 @@ static int validateIr(char const *phase, bool blocked) {
 
   if (errored) return -1;
 
-  return validateIRArchSpecific(phase, blocked);
+  for (size_t fileIdx = first; fileIdx < last; ++fileIdx) {
+    if (validateIRArchSpecific(&fileList.entries[fileIdx], phase, blocked) !=
+        0)
+      errored = true;
+  }
+
+  if (errored) return -1;
+
+  return 0;
+}
+
+int validateBlockedIr(char const *phase) {
+  return validateIr(0, fileList.size, phase, true);
 }
 
-int validateBlockedIr(char const *phase) { return validateIr(phase, true); }
+int validateScheduledIr(char const *phase) {
+  return validateIr(0, fileList.size, phase, false);
+}
+
+int validateFileBlockedIr(FileListEntry *file, char const *phase) {
+  size_t fileIdx = (size_t)(file - fileList.entries);
+  return validateIr(fileIdx, fileIdx + 1, phase, true);
+}
 
-int validateScheduledIr(char const *phase) { return validateIr(phase, false); }
\ No newline at end of file
+int validateFileScheduledIr(FileListEntry *file, char const *phase) {
+  size_t fileIdx = (size_t)(file - fileList.entries);
+  return validateIr(fileIdx, fileIdx + 1, phase, false);
+}
\ No newline at end of file
@@ -25,13 +25,17 @@
 #ifndef TLC_IR_IR_H_
 #define TLC_IR_IR_H_
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
 #include "ast/type.h"
+#include "util/arena.h"
 #include "util/container/linkedList.h"
 #include "util/container/vector.h"
 
+typedef struct FileListEntry FileListEntry;
+
 /** the type of a fragment name */
 typedef enum {
   FNT_LOCAL,
@@ -59,6 +63,15 @@ typedef struct {
     } data;
     struct {
       LinkedList blocks; /**< list of IRBlock - first one is the entry block */
+      Arena *arena;      /**< arena blocks, instructions, operands and list
+                            nodes in this fragment are allocated from */
+      size_t firstId;    /**< first id given out while translating this
+                            fragment */
+      size_t numIds; /**< number of ids given out while translating this
+                        fragment - every block label, and every temp made
+                        during translation, is in [firstId, firstId +
+                        numIds), so id - firstId numbers them densely;
+                        temps made by later passes are outside it */
     } text;
   } data;
 } IRFrag;
@@ -67,14 +80,37 @@ typedef struct {
 IRFrag *globalDataFragCreate(FragmentType type, char *name, size_t alignment);
 IRFrag *localDataFragCreate(FragmentType type, size_t name, size_t alignment);
 IRFrag *textFragCreate(char *name);
-/**
- * given a list of frags, find the one with the label
- */
-IRFrag *findFrag(Vector *frags, size_t label);
 /** dtor */
 void irFragFree(IRFrag *);
 void irFragVectorUninit(Vector *);
 
+/** a file's fragments, indexed by local label */
+typedef struct {
+  size_t numLabels; /**< labels below this are in the index */
+  IRFrag **frags;   /**< fragment with each local label, or NULL */
+  bool *dataTargets; /**< is each label referred to by a local label datum in
+                        read-only data (i.e. a jump table) */
+} IRFragIndex;
+
+/**
+ * index a file's fragments - the fragments must not change while the index is
+ * in use
+ *
+ * @param index index to initialize
+ * @param frags vector of IRFrag to index
+ * @param numLabels one more than the largest label in the file
+ */
+void irFragIndexInit(IRFragIndex *index, Vector const *frags,
+                     size_t numLabels);
+/**
+ * find the fragment with a local label, in constant time
+ *
+ * @returns fragment, or NULL if no fragment has the label
+ */
+IRFrag *irFragIndexFind(IRFragIndex const *index, size_t label);
+/** dtor */
+void irFragIndexUninit(IRFragIndex *index);
+
 /** the type of a datum */
 typedef enum {
   DT_BYTE,
@@ -129,6 +165,7 @@ typedef enum {
 /** an operand in an IR entry */
 typedef struct IROperand {
   OperandKind kind;
+  bool inArena; /**< allocated from an arena, and freed with it */
   union {
     /**
      * temporary variable
@@ -250,6 +287,18 @@ typedef enum IROperator {
    * no operands
    */
   IO_NOP,
+  /**
+   * choose a value based on which block control came from - only in SSA form,
+   * and only at the start of a block
+   *
+   * one plus twice the number of predecessors operands
+   * 0: TEMP, written - destination
+   * 2n + 1: LOCAL - label of the nth predecessor
+   * 2n + 2: TEMP, read | CONST - value if control came from that predecessor
+   *
+   * sizeof(0) == sizeof(2n + 2)
+   */
+  IO_PHI,
 
   // data transfer
   /**
@@ -669,18 +718,55 @@ typedef enum IROperator {
 } IROperator;
 
 /**
- * get the arity of an ir operator
+ * get the arity of an ir operator - PHI has no fixed arity
  */
 size_t irOperatorArity(IROperator op);
 
+/** how an instruction uses one of its operands */
+typedef enum {
+  OU_NONE,          /**< not a value - labels and jump targets */
+  OU_READ,          /**< read */
+  OU_WRITE,         /**< written in whole */
+  OU_PARTIAL_WRITE, /**< written in part; the rest keeps its old value */
+  OU_ADDRESS,       /**< address taken - may be read or written through that
+                       address later */
+} OperandUse;
+
+/**
+ * get how an ir operator uses one of its operands
+ *
+ * @param op operator to look at
+ * @param idx index of the operand, less than the arity of op
+ */
+OperandUse irOperandUse(IROperator op, size_t idx);
+
 /** ir instruction */
 typedef struct {
   IROperator op;
+  bool inArena; /**< allocated, along with args, from an arena */
+  size_t arity; /**< number of args - the operator's arity, except for PHI */
   IROperand **args;
 } IRInstruction;
 
+/**
+ * sets the arena IR blocks, instructions, operands and list nodes created by
+ * the current thread are allocated from
+ *
+ * everything allocated must end up in the text fragment owning the arena,
+ * which releases it all at once
+ *
+ * @param arena arena to allocate from, or NULL to allocate individually
+ */
+void irArenaSet(Arena *arena);
+
 /** generic ctor */
 IRInstruction *irInstructionCreate(IROperator op);
+/**
+ * phi ctor - args are left for the caller to fill in
+ *
+ * @param numPreds number of predecessors to choose between
+ */
+IRInstruction *irPhiCreate(size_t numPreds);
 IRInstruction *irInstructionCopy(IRInstruction const *i);
 /** dtor */
 void irInstructionFree(IRInstruction *);
@@ -688,21 +774,65 @@ void irInstructionMakeNop(IRInstruction *);
 
 typedef struct {
   size_t label;
+  bool inArena; /**< allocated from an arena, and freed with it */
   LinkedList instructions;
 } IRBlock;
 
 /** ctor */
 IRBlock *irBlockCreate(size_t label);
+/** dtor */
+void irBlockFree(IRBlock *);
+
 /**
- * find the index of a block given its label
+ * the control flow graph of a text fragment's blocks
+ *
+ * Blocks are numbered densely in list order, and can be found from their label
+ * in constant time. Successors and predecessors are stored as one array each,
+ * with the edges of block idx in [start[idx], start[idx + 1]) - an edge is
+ * listed once per jump along it, and edges to blocks outside of the fragment
+ * are left out.
+ *
+ * The graph is a snapshot: it must be rebuilt if blocks are added or removed,
+ * or if their last instructions change.
  */
-size_t indexOfBlock(LinkedList *blocks, size_t label);
+typedef struct {
+  size_t numBlocks; /**< number of blocks */
+  IRBlock **blocks; /**< blocks, in list order - first is the entry block */
+  size_t firstLabel; /**< smallest label of any block */
+  size_t numLabels;  /**< number of labels from firstLabel in indices */
+  size_t *indices;   /**< index of the block with label firstLabel + idx, or
+                        numBlocks if there's no such block */
+  size_t *succStart; /**< start of each block's successors, plus the end */
+  size_t *succs;     /**< successor indices */
+  size_t *predStart; /**< start of each block's predecessors, plus the end */
+  size_t *preds;     /**< predecessor indices */
+} IRCfg;
+
 /**
- * get a block given its label
+ * build the control flow graph of a list of blocks
+ *
+ * @param cfg graph to initialize
+ * @param blocks list of IRBlock - must end in jumps, as in blocked IR
+ * @param frags index of the fragments of the file the blocks are from
+ */
+void irCfgInit(IRCfg *cfg, LinkedList const *blocks, IRFragIndex const *frags);
+/**
+ * find the index of a block given its label, in constant time
+ *
+ * @returns index, or cfg->numBlocks if no block has the label
+ */
+size_t irCfgIndexOf(IRCfg const *cfg, size_t label);
+/**
+ * list the blocks reachable from the entry block in reverse postorder - each
+ * block comes before its successors, except along back edges
+ *
+ * @param cfg graph to traverse
+ * @param order array of cfg->numBlocks indices to write the order to
+ * @returns number of reachable blocks written
  */
-IRBlock *findBlock(LinkedList *blocks, size_t label);
+size_t irCfgReversePostorder(IRCfg const *cfg, size_t *order);
 /** dtor */
-void irBlockFree(IRBlock *);
+void irCfgUninit(IRCfg *cfg);
 
 extern char const *const IROPERATOR_NAMES[];
 extern char const *const IROPERAND_NAMES[];
@@ -740,4 +870,26 @@ int validateBlockedIr(char const *phase);
  */
 int validateScheduledIr(char const *phase);
 
+/**
+ * checks that one file has valid IR (while IR is in basic blocks)
+ *
+ * Checks the same things as validateBlockedIr
+ *
+ * @param file file to check
+ * @param phase phase to name as the one at fault
+ * @returns -1 on failure, 0 on success
+ */
+int validateFileBlockedIr(FileListEntry *file, char const *phase);
+
+/**
+ * checks that one file has valid IR (while IR is a single block)
+ *
+ * Checks the same things as validateScheduledIr
+ *
+ * @param file file to check
+ * @param phase phase to name as the one at fault
+ * @returns -1 on failure, 0 on success
+ */
+int validateFileScheduledIr(FileListEntry *file, char const *phase);
+
 #endif  // TLC_IR_IR_H_
\ No newline at end of file
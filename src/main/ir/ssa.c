@@ -0,0 +1,658 @@
+// Copyright 2022 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "ir/ssa.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "fileList.h"
+#include "ir/dataflow.h"
+#include "translation/translation.h"
+#include "util/container/bitSet.h"
+#include "util/internalError.h"
+
+/** walk up the dominator tree from two blocks until they meet */
+static size_t intersect(size_t const *idom, size_t const *rpoNumber, size_t a,
+                        size_t b) {
+  while (a != b) {
+    while (rpoNumber[a] > rpoNumber[b]) a = idom[a];
+    while (rpoNumber[b] > rpoNumber[a]) b = idom[b];
+  }
+  return a;
+}
+/**
+ * walk up from the predecessors of each block to its immediate dominator,
+ * adding the block to the frontier of everything passed on the way
+ *
+ * @param doms dominators with idom filled in
+ * @param cfg graph the dominators are of
+ * @param counts if true, count frontiers into frontierStart; otherwise, fill
+ * in frontier using next as the next free slot for each block
+ * @param next next free slot in frontier for each block
+ */
+static void walkFrontiers(IRDominators *doms, IRCfg const *cfg, bool counts,
+                          size_t *next) {
+  size_t numBlocks = cfg->numBlocks;
+  size_t *lastAdded = malloc(sizeof(size_t) * numBlocks);
+  for (size_t idx = 0; idx < numBlocks; ++idx) lastAdded[idx] = numBlocks;
+
+  for (size_t block = 0; block < numBlocks; ++block) {
+    if (doms->idom[block] == numBlocks) continue;
+    for (size_t edge = cfg->predStart[block]; edge < cfg->predStart[block + 1];
+         ++edge) {
+      size_t pred = cfg->preds[edge];
+      if (doms->idom[pred] == numBlocks) continue;
+      for (size_t runner = pred; runner != doms->idom[block];
+           runner = doms->idom[runner]) {
+        if (lastAdded[runner] == block) continue;
+        lastAdded[runner] = block;
+        if (counts)
+          ++doms->frontierStart[runner + 1];
+        else
+          doms->frontier[next[runner]++] = block;
+      }
+    }
+  }
+
+  free(lastAdded);
+}
+void irDominatorsInit(IRDominators *doms, IRCfg const *cfg) {
+  size_t numBlocks = cfg->numBlocks;
+  doms->numBlocks = numBlocks;
+  doms->idom = malloc(sizeof(size_t) * numBlocks);
+  doms->childStart = calloc(numBlocks + 1, sizeof(size_t));
+  doms->frontierStart = calloc(numBlocks + 1, sizeof(size_t));
+
+  size_t *order = malloc(sizeof(size_t) * numBlocks);
+  size_t numReachable = irCfgReversePostorder(cfg, order);
+  size_t *rpoNumber = malloc(sizeof(size_t) * numBlocks);
+  for (size_t idx = 0; idx < numBlocks; ++idx) {
+    doms->idom[idx] = numBlocks;
+    rpoNumber[idx] = numBlocks;
+  }
+  for (size_t idx = 0; idx < numReachable; ++idx) rpoNumber[order[idx]] = idx;
+
+  // Cooper, Harvey, and Kennedy's iterative algorithm - a block's immediate
+  // dominator is where the paths from its already-visited predecessors meet
+  if (numReachable != 0) doms->idom[order[0]] = order[0];
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t orderIdx = 1; orderIdx < numReachable; ++orderIdx) {
+      size_t block = order[orderIdx];
+      size_t newIdom = numBlocks;
+      for (size_t edge = cfg->predStart[block];
+           edge < cfg->predStart[block + 1]; ++edge) {
+        size_t pred = cfg->preds[edge];
+        if (doms->idom[pred] == numBlocks) continue;
+        newIdom = newIdom == numBlocks
+                      ? pred
+                      : intersect(doms->idom, rpoNumber, pred, newIdom);
+      }
+      if (doms->idom[block] != newIdom) {
+        doms->idom[block] = newIdom;
+        changed = true;
+      }
+    }
+  }
+
+  // children, in block order
+  size_t *next = malloc(sizeof(size_t) * numBlocks);
+  for (size_t block = 0; block < numBlocks; ++block) {
+    size_t idom = doms->idom[block];
+    if (idom != numBlocks && idom != block) ++doms->childStart[idom + 1];
+  }
+  for (size_t idx = 0; idx < numBlocks; ++idx) {
+    doms->childStart[idx + 1] += doms->childStart[idx];
+    next[idx] = doms->childStart[idx];
+  }
+  doms->children = malloc(sizeof(size_t) * doms->childStart[numBlocks]);
+  for (size_t block = 0; block < numBlocks; ++block) {
+    size_t idom = doms->idom[block];
+    if (idom != numBlocks && idom != block)
+      doms->children[next[idom]++] = block;
+  }
+
+  // frontiers
+  walkFrontiers(doms, cfg, true, NULL);
+  for (size_t idx = 0; idx < numBlocks; ++idx) {
+    doms->frontierStart[idx + 1] += doms->frontierStart[idx];
+    next[idx] = doms->frontierStart[idx];
+  }
+  doms->frontier = malloc(sizeof(size_t) * doms->frontierStart[numBlocks]);
+  walkFrontiers(doms, cfg, false, next);
+
+  free(next);
+  free(rpoNumber);
+  free(order);
+}
+void irDominatorsUninit(IRDominators *doms) {
+  free(doms->idom);
+  free(doms->childStart);
+  free(doms->children);
+  free(doms->frontierStart);
+  free(doms->frontier);
+}
+
+/** is an operand a temp made while translating the fragment */
+static bool isOriginal(IRFrag const *frag, IROperand const *arg) {
+  return arg->kind == OK_TEMP &&
+         arg->data.temp.name >= frag->data.text.firstId &&
+         arg->data.temp.name - frag->data.text.firstId <
+             frag->data.text.numIds;
+}
+/** is an operand a version */
+static bool isVersion(IRSsa const *ssa, IROperand const *arg) {
+  return arg->kind == OK_TEMP && arg->data.temp.name >= ssa->firstTemp &&
+         arg->data.temp.name - ssa->firstTemp < ssa->numTemps;
+}
+/** copy a temp, giving the copy a different name */
+static IROperand *renamedCopy(IROperand const *temp, size_t name) {
+  IROperand *copy = irOperandCopy(temp);
+  copy->data.temp.name = name;
+  return copy;
+}
+/** make a new version of a temp */
+static size_t newVersion(IRSsa *ssa, size_t original) {
+  ssa->original[ssa->numTemps] = original;
+  return ssa->firstTemp + ssa->numTemps++;
+}
+/** original name of the temp a phi chooses a version of */
+static size_t phiTemp(IRSsa const *ssa, IRInstruction const *phi) {
+  IROperand const *dest = phi->args[0];
+  return isVersion(ssa, dest) ? ssa->original[dest->data.temp.name -
+                                              ssa->firstTemp]
+                              : dest->data.temp.name;
+}
+
+void irSsaConstruct(IRSsa *ssa, IRFrag *frag, IRCfg const *cfg,
+                    FileListEntry *file) {
+  size_t firstId = frag->data.text.firstId;
+  size_t numIds = frag->data.text.numIds;
+  size_t numBlocks = cfg->numBlocks;
+  ssa->firstTemp = file->nextId;
+  ssa->numTemps = 0;
+  ssa->original = NULL;
+  // a phi in the entry block would have nothing to choose on entry
+  if (numBlocks == 0 || cfg->predStart[0] != cfg->predStart[1]) return;
+
+  // find the temps that get versions, and the blocks writing to them
+  uint64_t *excluded = bitSetCreate(numIds);
+  uint64_t *versioned = bitSetCreate(numIds);
+  IROperand const **samples = calloc(numIds, sizeof(IROperand const *));
+  size_t *defStart = calloc(numIds + 1, sizeof(size_t));
+  size_t *lastDef = malloc(sizeof(size_t) * numIds);
+  for (size_t idx = 0; idx < numIds; ++idx) lastDef[idx] = numBlocks;
+  size_t numDefs = 0;
+  for (size_t block = 0; block < numBlocks; ++block) {
+    LinkedList const *instructions = &cfg->blocks[block]->instructions;
+    for (ListNode *curr = instructions->head->next; curr != instructions->tail;
+         curr = curr->next) {
+      IRInstruction const *i = curr->data;
+      for (size_t idx = 0; idx < i->arity; ++idx) {
+        IROperand const *arg = i->args[idx];
+        if (!isOriginal(frag, arg)) continue;
+        size_t temp = arg->data.temp.name - firstId;
+        if (samples[temp] == NULL) samples[temp] = arg;
+        switch (irOperandUse(i->op, idx)) {
+          case OU_WRITE: {
+            ++numDefs;
+            if (lastDef[temp] != block) {
+              lastDef[temp] = block;
+              ++defStart[temp + 1];
+            }
+            break;
+          }
+          case OU_READ: {
+            break;
+          }
+          default: {
+            bitSetAdd(excluded, temp);
+            break;
+          }
+        }
+      }
+    }
+  }
+  size_t numVersioned = 0;
+  for (size_t temp = 0; temp < numIds; ++temp) {
+    if (defStart[temp + 1] != 0 && !bitSetContains(excluded, temp)) {
+      bitSetAdd(versioned, temp);
+      ++numVersioned;
+    }
+    defStart[temp + 1] += defStart[temp];
+    lastDef[temp] = numBlocks;
+  }
+  size_t *defBlocks = malloc(sizeof(size_t) * defStart[numIds]);
+  size_t *next = malloc(sizeof(size_t) * numIds);
+  for (size_t temp = 0; temp < numIds; ++temp) next[temp] = defStart[temp];
+  for (size_t block = 0; block < numBlocks; ++block) {
+    LinkedList const *instructions = &cfg->blocks[block]->instructions;
+    for (ListNode *curr = instructions->head->next; curr != instructions->tail;
+         curr = curr->next) {
+      IRInstruction const *i = curr->data;
+      for (size_t idx = 0; idx < i->arity; ++idx) {
+        IROperand const *arg = i->args[idx];
+        if (!isOriginal(frag, arg) || irOperandUse(i->op, idx) != OU_WRITE)
+          continue;
+        size_t temp = arg->data.temp.name - firstId;
+        if (lastDef[temp] != block) {
+          lastDef[temp] = block;
+          defBlocks[next[temp]++] = block;
+        }
+      }
+    }
+  }
+  free(next);
+  free(lastDef);
+  free(excluded);
+
+  // distinct predecessors of each block, for the phis' choices
+  size_t *uniquePredStart = malloc(sizeof(size_t) * (numBlocks + 1));
+  size_t *uniquePreds = malloc(sizeof(size_t) * cfg->predStart[numBlocks]);
+  size_t *lastPred = malloc(sizeof(size_t) * numBlocks);
+  for (size_t block = 0; block < numBlocks; ++block) lastPred[block] = numBlocks;
+  size_t numUniquePreds = 0;
+  for (size_t block = 0; block < numBlocks; ++block) {
+    uniquePredStart[block] = numUniquePreds;
+    for (size_t edge = cfg->predStart[block]; edge < cfg->predStart[block + 1];
+         ++edge) {
+      size_t pred = cfg->preds[edge];
+      if (lastPred[pred] != block) {
+        lastPred[pred] = block;
+        uniquePreds[numUniquePreds++] = pred;
+      }
+    }
+  }
+  uniquePredStart[numBlocks] = numUniquePreds;
+  free(lastPred);
+
+  // every versioned temp starts out as its entry version - that's what's read
+  // along paths that never write to it
+  ssa->original = malloc(sizeof(size_t) * (numVersioned + numDefs));
+  size_t *current = malloc(sizeof(size_t) * numIds);
+  for (size_t temp = 0; temp < numIds; ++temp) {
+    if (bitSetContains(versioned, temp))
+      current[temp] = newVersion(ssa, firstId + temp);
+  }
+
+  // place phis at the iterated dominance frontiers of the writes, where the
+  // temp is live
+  Liveness liveness;
+  livenessInit(&liveness, cfg, firstId, numIds);
+  IRDominators doms;
+  irDominatorsInit(&doms, cfg);
+  size_t *hasPhi = malloc(sizeof(size_t) * numBlocks);
+  size_t *onWorklist = malloc(sizeof(size_t) * numBlocks);
+  size_t *worklist = malloc(sizeof(size_t) * numBlocks);
+  for (size_t block = 0; block < numBlocks; ++block)
+    hasPhi[block] = onWorklist[block] = numIds;
+  size_t numPhis = 0;
+  for (size_t temp = 0; temp < numIds; ++temp) {
+    if (!bitSetContains(versioned, temp)) continue;
+
+    size_t worklistSize = 0;
+    for (size_t idx = defStart[temp]; idx < defStart[temp + 1]; ++idx) {
+      onWorklist[defBlocks[idx]] = temp;
+      worklist[worklistSize++] = defBlocks[idx];
+    }
+    while (worklistSize != 0) {
+      size_t block = worklist[--worklistSize];
+      for (size_t idx = doms.frontierStart[block];
+           idx < doms.frontierStart[block + 1]; ++idx) {
+        size_t join = doms.frontier[idx];
+        if (hasPhi[join] == temp) continue;
+        hasPhi[join] = temp;
+        if (!bitSetContains(livenessIn(&liveness, join), temp)) continue;
+
+        size_t numPreds = uniquePredStart[join + 1] - uniquePredStart[join];
+        IRInstruction *phi = irPhiCreate(numPreds);
+        phi->args[0] = renamedCopy(samples[temp], firstId + temp);
+        for (size_t predIdx = 0; predIdx < numPreds; ++predIdx) {
+          size_t pred = uniquePreds[uniquePredStart[join] + predIdx];
+          phi->args[2 * predIdx + 1] =
+              localOperandCreate(cfg->blocks[pred]->label);
+          phi->args[2 * predIdx + 2] =
+              renamedCopy(samples[temp], current[temp]);
+        }
+        insertNodeAfter(cfg->blocks[join]->instructions.head, phi);
+        ++numPhis;
+
+        if (onWorklist[join] != temp) {
+          onWorklist[join] = temp;
+          worklist[worklistSize++] = join;
+        }
+      }
+    }
+  }
+  ssa->original = realloc(ssa->original,
+                          sizeof(size_t) * (numVersioned + numDefs + numPhis));
+  free(worklist);
+  free(onWorklist);
+  free(hasPhi);
+  livenessUninit(&liveness);
+  free(uniquePreds);
+  free(uniquePredStart);
+  free(defBlocks);
+  free(defStart);
+  free(samples);
+
+  // rename down the dominator tree - each block sees the versions current at
+  // the end of its immediate dominator, and the versions it makes are undone
+  // once its subtree is done
+  size_t undoCapacity = numDefs + numPhis;
+  size_t *undoTemps = malloc(sizeof(size_t) * undoCapacity);
+  size_t *undoVersions = malloc(sizeof(size_t) * undoCapacity);
+  size_t undoSize = 0;
+  size_t *undoStart = malloc(sizeof(size_t) * numBlocks);
+  bool *entered = calloc(numBlocks, sizeof(bool));
+  size_t *stack = malloc(sizeof(size_t) * numBlocks);
+  size_t stackSize = 0;
+  stack[stackSize++] = 0;
+  while (stackSize != 0) {
+    size_t block = stack[stackSize - 1];
+    if (entered[block]) {
+      --stackSize;
+      while (undoSize != undoStart[block]) {
+        --undoSize;
+        current[undoTemps[undoSize]] = undoVersions[undoSize];
+      }
+      continue;
+    }
+    entered[block] = true;
+    undoStart[block] = undoSize;
+
+    LinkedList *instructions = &cfg->blocks[block]->instructions;
+    for (ListNode *curr = instructions->head->next; curr != instructions->tail;
+         curr = curr->next) {
+      IRInstruction *i = curr->data;
+      // reads see the versions from before the instruction
+      if (i->op != IO_PHI) {
+        for (size_t idx = 0; idx < i->arity; ++idx) {
+          IROperand *arg = i->args[idx];
+          if (isOriginal(frag, arg) && irOperandUse(i->op, idx) == OU_READ &&
+              bitSetContains(versioned, arg->data.temp.name - firstId))
+            arg->data.temp.name = current[arg->data.temp.name - firstId];
+        }
+      }
+      for (size_t idx = 0; idx < i->arity; ++idx) {
+        IROperand *arg = i->args[idx];
+        if (isOriginal(frag, arg) && irOperandUse(i->op, idx) == OU_WRITE &&
+            bitSetContains(versioned, arg->data.temp.name - firstId)) {
+          size_t temp = arg->data.temp.name - firstId;
+          undoTemps[undoSize] = temp;
+          undoVersions[undoSize++] = current[temp];
+          current[temp] = newVersion(ssa, arg->data.temp.name);
+          arg->data.temp.name = current[temp];
+        }
+      }
+    }
+
+    // fill in the successors' choices along the edges from this block
+    size_t label = cfg->blocks[block]->label;
+    for (size_t edge = cfg->succStart[block]; edge < cfg->succStart[block + 1];
+         ++edge) {
+      LinkedList const *succInstructions =
+          &cfg->blocks[cfg->succs[edge]]->instructions;
+      for (ListNode *curr = succInstructions->head->next;
+           curr != succInstructions->tail &&
+           ((IRInstruction const *)curr->data)->op == IO_PHI;
+           curr = curr->next) {
+        IRInstruction *phi = curr->data;
+        size_t temp = phiTemp(ssa, phi) - firstId;
+        for (size_t idx = 1; idx < phi->arity; idx += 2) {
+          if (localOperandName(phi->args[idx]) == label)
+            phi->args[idx + 1]->data.temp.name = current[temp];
+        }
+      }
+    }
+
+    for (size_t idx = doms.childStart[block]; idx < doms.childStart[block + 1];
+         ++idx)
+      stack[stackSize++] = doms.children[idx];
+  }
+  free(stack);
+  free(entered);
+  free(undoStart);
+  free(undoVersions);
+  free(undoTemps);
+  irDominatorsUninit(&doms);
+  free(current);
+  free(versioned);
+
+  file->nextId = ssa->firstTemp + ssa->numTemps;
+}
+
+/** the live versions at some point, while finding interfering versions */
+typedef struct {
+  IRSsa const *ssa;
+  size_t firstId;   /**< name of the fragment's temp with index zero */
+  uint64_t *live;   /**< live versions */
+  size_t *numLive;  /**< number of live versions of each original temp */
+  bool *interferes; /**< are two versions of each original temp ever live at
+                       the same time */
+} Interference;
+
+/** index of the original temp of a version */
+static size_t originalIndex(Interference const *interference,
+                            IROperand const *version) {
+  IRSsa const *ssa = interference->ssa;
+  return ssa->original[version->data.temp.name - ssa->firstTemp] -
+         interference->firstId;
+}
+/** add the live versions to the counts, or remove them */
+static void countLive(Interference *interference, bool add) {
+  IRSsa const *ssa = interference->ssa;
+  for (size_t word = 0; word < bitSetWords(ssa->numTemps); ++word) {
+    for (uint64_t bits = interference->live[word]; bits != 0;
+         bits &= bits - 1) {
+      size_t version = word * 64 + (size_t)__builtin_ctzll(bits);
+      size_t temp = ssa->original[version] - interference->firstId;
+      if (add)
+        ++interference->numLive[temp];
+      else
+        --interference->numLive[temp];
+    }
+  }
+}
+/**
+ * step the live versions back over an instruction, noting any version written
+ * while another version of the same temp is live
+ */
+static void interferenceStep(Interference *interference,
+                             IRInstruction const *i) {
+  IRSsa const *ssa = interference->ssa;
+  for (size_t idx = 0; idx < i->arity; ++idx) {
+    IROperand const *arg = i->args[idx];
+    if (!isVersion(ssa, arg) || irOperandUse(i->op, idx) != OU_WRITE) continue;
+    size_t version = arg->data.temp.name - ssa->firstTemp;
+    size_t temp = originalIndex(interference, arg);
+    bool live = bitSetContains(interference->live, version);
+    if (interference->numLive[temp] - live != 0)
+      interference->interferes[temp] = true;
+    if (live) {
+      bitSetRemove(interference->live, version);
+      --interference->numLive[temp];
+    }
+  }
+  if (i->op == IO_PHI) return;
+  for (size_t idx = 0; idx < i->arity; ++idx) {
+    IROperand const *arg = i->args[idx];
+    if (!isVersion(ssa, arg) || irOperandUse(i->op, idx) != OU_READ) continue;
+    size_t version = arg->data.temp.name - ssa->firstTemp;
+    if (!bitSetContains(interference->live, version)) {
+      bitSetAdd(interference->live, version);
+      ++interference->numLive[originalIndex(interference, arg)];
+    }
+  }
+}
+/**
+ * note temps that can't take a MOVE for a phi choice at the end of a block -
+ * the MOVE would have to write the original temp while another version is
+ * live, or the choice isn't a version of the same temp
+ */
+static void interferenceAtJump(Interference *interference, IRCfg const *cfg,
+                               size_t block) {
+  size_t label = cfg->blocks[block]->label;
+  for (size_t edge = cfg->succStart[block]; edge < cfg->succStart[block + 1];
+       ++edge) {
+    LinkedList const *instructions =
+        &cfg->blocks[cfg->succs[edge]]->instructions;
+    for (ListNode *curr = instructions->head->next;
+         curr != instructions->tail &&
+         ((IRInstruction const *)curr->data)->op == IO_PHI;
+         curr = curr->next) {
+      IRInstruction const *phi = curr->data;
+      size_t temp = originalIndex(interference, phi->args[0]);
+      for (size_t idx = 1; idx < phi->arity; idx += 2) {
+        if (localOperandName(phi->args[idx]) != label) continue;
+        IROperand const *choice = phi->args[idx + 1];
+        if (isVersion(interference->ssa, choice) &&
+            originalIndex(interference, choice) == temp)
+          continue;
+        if (choice->kind == OK_TEMP || interference->numLive[temp] != 0)
+          interference->interferes[temp] = true;
+      }
+    }
+  }
+}
+
+void irSsaDestruct(IRSsa *ssa, IRFrag *frag, IRCfg const *cfg,
+                   FileListEntry *file) {
+  size_t numTemps = ssa->numTemps;
+  size_t numIds = frag->data.text.numIds;
+  if (numTemps == 0) {
+    free(ssa->original);
+    return;
+  }
+
+  // versions of a temp can share its original name unless two of them are
+  // live at once
+  Liveness liveness;
+  livenessInit(&liveness, cfg, ssa->firstTemp, numTemps);
+  Interference interference;
+  interference.ssa = ssa;
+  interference.firstId = frag->data.text.firstId;
+  interference.live = bitSetCreate(numTemps);
+  interference.numLive = calloc(numIds, sizeof(size_t));
+  interference.interferes = calloc(numIds, sizeof(bool));
+  for (size_t block = 0; block < cfg->numBlocks; ++block) {
+    LinkedList const *instructions = &cfg->blocks[block]->instructions;
+    bitSetCopy(interference.live, livenessOut(&liveness, block), numTemps);
+    countLive(&interference, true);
+
+    ListNode *curr = instructions->tail->prev;
+    interferenceStep(&interference, curr->data);
+    interferenceAtJump(&interference, cfg, block);
+    for (curr = curr->prev; curr != instructions->head; curr = curr->prev)
+      interferenceStep(&interference, curr->data);
+
+    // the entry versions are all written on entry
+    if (block == 0) {
+      for (size_t version = 0; version < numTemps; ++version) {
+        if (bitSetContains(interference.live, version) &&
+            interference.numLive[ssa->original[version] -
+                                 interference.firstId] > 1)
+          interference.interferes[ssa->original[version] -
+                                  interference.firstId] = true;
+      }
+    }
+
+    countLive(&interference, false);
+  }
+  livenessUninit(&liveness);
+
+  // give the ids back, then name the versions - versions of interfering temps
+  // each get a new temp, outside of the fragment's range
+  file->nextId = ssa->firstTemp;
+  size_t *names = malloc(sizeof(size_t) * numTemps);
+  for (size_t version = 0; version < numTemps; ++version) {
+    size_t original = ssa->original[version];
+    names[version] =
+        interference.interferes[original - interference.firstId]
+            ? fresh(file)
+            : original;
+  }
+  free(interference.interferes);
+  free(interference.numLive);
+  free(interference.live);
+
+  for (size_t block = 0; block < cfg->numBlocks; ++block) {
+    LinkedList *instructions = &cfg->blocks[block]->instructions;
+    ListNode *curr = instructions->head->next;
+    while (curr != instructions->tail) {
+      IRInstruction *i = curr->data;
+      ListNode *next = curr->next;
+      for (size_t idx = 0; idx < i->arity; ++idx) {
+        IROperand *arg = i->args[idx];
+        if (isVersion(ssa, arg))
+          arg->data.temp.name = names[arg->data.temp.name - ssa->firstTemp];
+      }
+      // moves between versions given the same name do nothing
+      if (i->op == IO_MOVE && i->args[0]->kind == OK_TEMP &&
+          i->args[1]->kind == OK_TEMP &&
+          i->args[0]->data.temp.name == i->args[1]->data.temp.name)
+        irInstructionFree(removeNode(curr));
+      curr = next;
+    }
+  }
+  free(names);
+
+  // replace the phis with MOVEs at the ends of the predecessors - a phi for a
+  // renamed temp goes through a new temp, since the MOVE may run on edges to
+  // other blocks, and other phis in the block may read the old value
+  for (size_t block = 0; block < cfg->numBlocks; ++block) {
+    LinkedList *instructions = &cfg->blocks[block]->instructions;
+    ListNode *curr = instructions->head->next;
+    while (curr != instructions->tail &&
+           ((IRInstruction const *)curr->data)->op == IO_PHI) {
+      IRInstruction *phi = curr->data;
+      IROperand *dest = phi->args[0];
+      bool direct = isOriginal(frag, dest);
+      IROperand *via = direct ? dest : renamedCopy(dest, fresh(file));
+      for (size_t idx = 1; idx < phi->arity; idx += 2) {
+        IROperand const *choice = phi->args[idx + 1];
+        if (choice->kind == OK_TEMP &&
+            choice->data.temp.name == via->data.temp.name)
+          continue;
+        size_t pred = irCfgIndexOf(cfg, localOperandName(phi->args[idx]));
+        if (pred == cfg->numBlocks)
+          error(__FILE__, __LINE__, "phi choice from outside the fragment");
+        IRInstruction *move = irInstructionCreate(IO_MOVE);
+        move->args[0] = irOperandCopy(via);
+        move->args[1] = irOperandCopy(choice);
+        insertNodeBefore(cfg->blocks[pred]->instructions.tail->prev, move);
+      }
+      if (!direct) {
+        IRInstruction *move = irInstructionCreate(IO_MOVE);
+        move->args[0] = irOperandCopy(dest);
+        move->args[1] = via;
+        insertNodeBefore(curr, move);
+      }
+
+      ListNode *next = curr->next;
+      irInstructionFree(removeNode(curr));
+      curr = next;
+    }
+  }
+
+  free(ssa->original);
+}
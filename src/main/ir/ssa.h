@@ -0,0 +1,111 @@
+// Copyright 2022 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/**
+ * @file
+ * dominators and static single assignment form for blocked IR
+ */
+
+#ifndef TLC_IR_SSA_H_
+#define TLC_IR_SSA_H_
+
+#include <stddef.h>
+
+#include "ir/ir.h"
+
+typedef struct FileListEntry FileListEntry;
+
+/**
+ * the dominator tree and dominance frontiers of a control flow graph
+ *
+ * Only blocks reachable from the entry block are in the tree. Children and
+ * frontiers are stored like the graph's edges, with those of block idx in
+ * [start[idx], start[idx + 1]).
+ */
+typedef struct {
+  size_t numBlocks;      /**< number of blocks in the graph */
+  size_t *idom;          /**< immediate dominator of each block - the entry
+                            block is its own, and unreachable blocks have
+                            numBlocks */
+  size_t *childStart;    /**< start of each block's children, plus the end */
+  size_t *children;      /**< blocks immediately dominated by each block */
+  size_t *frontierStart; /**< start of each block's frontier, plus the end */
+  size_t *frontier;      /**< dominance frontier of each block */
+} IRDominators;
+
+/**
+ * compute the dominators of a control flow graph
+ *
+ * @param doms dominators to initialize
+ * @param cfg graph to analyze
+ */
+void irDominatorsInit(IRDominators *doms, IRCfg const *cfg);
+/** dtor */
+void irDominatorsUninit(IRDominators *doms);
+
+/**
+ * a text fragment in static single assignment form
+ *
+ * Temps that are only ever read or written whole (never partially written, and
+ * never having their address taken) are split into versions, each written
+ * exactly once; a PHI at the start of a block picks the version that reaches
+ * it. The versions are named [firstTemp, firstTemp + numTemps), borrowed from
+ * the top of the file's ids, so no other ids may be given out in the file
+ * while a fragment is in SSA form.
+ *
+ * Blocks unreachable from the entry block are left as they were.
+ */
+typedef struct {
+  size_t firstTemp; /**< name of the first version */
+  size_t numTemps;  /**< number of versions */
+  size_t *original; /**< name of the temp each version is a version of */
+} IRSsa;
+
+/**
+ * put a text fragment into SSA form
+ *
+ * Fragments whose entry block has predecessors are left alone, with no
+ * versions
+ *
+ * @param ssa SSA information to initialize
+ * @param frag fragment to convert (mutated)
+ * @param cfg control flow graph of the fragment
+ * @param file file the fragment is from
+ */
+void irSsaConstruct(IRSsa *ssa, IRFrag *frag, IRCfg const *cfg,
+                    FileListEntry *file);
+/**
+ * take a text fragment out of SSA form
+ *
+ * Versions of a temp are given back their original name unless two of them
+ * are live at once, in which case each version gets a new temp. PHIs become
+ * MOVEs at the ends of their predecessors; where the versions were renamed,
+ * each PHI goes through a new temp, so PHIs reading each other's results and
+ * edges from blocks with several successors are handled without splitting
+ * edges.
+ *
+ * @param ssa SSA information from irSsaConstruct (uninitialized)
+ * @param frag fragment to convert (mutated)
+ * @param cfg control flow graph of the fragment - must be current
+ * @param file file the fragment is from
+ */
+void irSsaDestruct(IRSsa *ssa, IRFrag *frag, IRCfg const *cfg,
+                   FileListEntry *file);
+
+#endif  // TLC_IR_SSA_H_
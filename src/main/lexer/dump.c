@@ -31,8 +31,8 @@ void lexDump(FileListEntry *entry) {
   do {
     lex(entry, &t);
     if (t.type >= TT_ID && t.type <= TT_LIT_FLOAT)
-      fprintf(stderr, "%zu:%zu: %s (%s)\n", t.line, t.character,
-              TOKEN_NAMES[t.type], t.string);
+      fprintf(stderr, "%zu:%zu: %s (%.*s)\n", t.line, t.character,
+              TOKEN_NAMES[t.type], (int)t.length, t.string);
     else
       fprintf(stderr, "%zu:%zu: %s\n", t.line, t.character,
               TOKEN_NAMES[t.type]);
@@ -29,7 +29,7 @@
 
 /**
  * Prints the lexed results of a file to stderr. Assumes that entry has not been
- * initialized for lexing. The function lexerInitMaps() must be called first.
+ * initialized for lexing.
  *
  * @param entry entry to lex, must not be initialized for lexing already
  */
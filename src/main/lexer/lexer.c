@@ -29,11 +29,17 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 #include "fileList.h"
 #include "util/container/stringBuilder.h"
 #include "util/conversions.h"
+#include "util/diagnostics.h"
 #include "util/format.h"
 #include "util/functional.h"
+#include "util/intern.h"
 #include "util/internalError.h"
 #include "util/string.h"
 #include "version.h"
@@ -157,13 +163,15 @@ char const *const TOKEN_NAMES[] = {
  * @param token token to initialize
  * @param type type of token
  * @param string additional data, may be null, depends on type
+ * @param length length of string
  */
 static void tokenInit(LexerState *state, Token *token, TokenType type,
-                      char *string) {
+                      char const *string, size_t length) {
   token->type = type;
   token->line = state->line;
   token->character = state->character;
   token->string = string;
+  token->length = length;
 
   // consistency check
   if (!(token->string == NULL ||
@@ -173,68 +181,154 @@ static void tokenInit(LexerState *state, Token *token, TokenType type,
           "stringed token type");
 }
 
-void tokenUninit(Token *token) { free(token->string); }
-
-/** keyword map */
-HashMap keywordMap;
-char const *const KEYWORD_STRINGS[] = {
-    "module",  "import", "opaque",   "struct",   "union", "enum",   "typedef",
-    "if",      "else",   "while",    "do",       "for",   "switch", "case",
-    "default", "break",  "continue", "return",   "cast",  "sizeof", "true",
-    "false",   "null",   "void",     "ubyte",    "byte",  "char",   "ushort",
-    "short",   "uint",   "int",      "wchar",    "ulong", "long",   "float",
-    "double",  "bool",   "const",    "volatile",
-};
-TokenType const KEYWORD_TOKENS[] = {
-    TT_MODULE,  TT_IMPORT, TT_OPAQUE,   TT_STRUCT, TT_UNION,    TT_ENUM,
-    TT_TYPEDEF, TT_IF,     TT_ELSE,     TT_WHILE,  TT_DO,       TT_FOR,
-    TT_SWITCH,  TT_CASE,   TT_DEFAULT,  TT_BREAK,  TT_CONTINUE, TT_RETURN,
-    TT_CAST,    TT_SIZEOF, TT_TRUE,     TT_FALSE,  TT_NULL,     TT_VOID,
-    TT_UBYTE,   TT_BYTE,   TT_CHAR,     TT_USHORT, TT_SHORT,    TT_UINT,
-    TT_INT,     TT_WCHAR,  TT_ULONG,    TT_LONG,   TT_FLOAT,    TT_DOUBLE,
-    TT_BOOL,    TT_CONST,  TT_VOLATILE,
-};
+char *tokenCopyString(Token const *token) {
+  char *copy = malloc(token->length + 1);
+  memcpy(copy, token->string, token->length);
+  copy[token->length] = '\0';
+  return copy;
+}
 
-/** magic token map */
-HashMap magicMap;
-char const *const MAGIC_STRINGS[] = {
-    "__FILE__",
-    "__LINE__",
-    "__VERSION__",
-};
+void tokenBufferInit(TokenBuffer *buffer) {
+  buffer->size = 0;
+  buffer->capacity = 0;
+  buffer->types = NULL;
+  buffer->lines = NULL;
+  buffer->characters = NULL;
+  buffer->strings = NULL;
+  buffer->lengths = NULL;
+}
+
+void tokenBufferPush(TokenBuffer *buffer, Token const *token) {
+  if (buffer->size == buffer->capacity) {
+    buffer->capacity = buffer->capacity == 0 ? 64 : buffer->capacity * 2;
+    buffer->types = realloc(buffer->types, buffer->capacity * sizeof(uint8_t));
+    buffer->lines = realloc(buffer->lines, buffer->capacity * sizeof(size_t));
+    buffer->characters =
+        realloc(buffer->characters, buffer->capacity * sizeof(size_t));
+    buffer->strings =
+        realloc(buffer->strings, buffer->capacity * sizeof(char const *));
+    buffer->lengths =
+        realloc(buffer->lengths, buffer->capacity * sizeof(size_t));
+  }
+  buffer->types[buffer->size] = (uint8_t)token->type;
+  buffer->lines[buffer->size] = token->line;
+  buffer->characters[buffer->size] = token->character;
+  buffer->strings[buffer->size] = token->string;
+  buffer->lengths[buffer->size] = token->length;
+  ++buffer->size;
+}
+
+void tokenBufferGet(TokenBuffer const *buffer, size_t idx, Token *token) {
+  token->type = buffer->types[idx];
+  token->line = buffer->lines[idx];
+  token->character = buffer->characters[idx];
+  token->string = buffer->strings[idx];
+  token->length = buffer->lengths[idx];
+}
+
+void tokenBufferUninit(TokenBuffer *buffer) {
+  free(buffer->types);
+  free(buffer->lines);
+  free(buffer->characters);
+  free(buffer->strings);
+  free(buffer->lengths);
+}
+
+/** kinds of magic tokens */
 typedef enum {
+  MTT_NONE, /**< not a magic token */
   MTT_FILE,
   MTT_LINE,
   MTT_VERSION,
 } MagicTokenType;
-MagicTokenType const MAGIC_TOKENS[] = {
-    MTT_FILE,
-    MTT_LINE,
-    MTT_VERSION,
-};
 
-void lexerInitMaps(void) {
-  hashMapInit(&keywordMap);
-  for (size_t idx = 0; idx < sizeof(KEYWORD_STRINGS) / sizeof(char const *);
-       ++idx) {
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wcast-qual"
-    hashMapSet(&keywordMap, KEYWORD_STRINGS[idx], (void *)&KEYWORD_TOKENS[idx]);
-#pragma GCC diagnostic pop
-  }
-  hashMapInit(&magicMap);
-  for (size_t idx = 0; idx < sizeof(MAGIC_STRINGS) / sizeof(char const *);
-       ++idx) {
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wcast-qual"
-    hashMapSet(&magicMap, MAGIC_STRINGS[idx], (void *)&MAGIC_TOKENS[idx]);
-#pragma GCC diagnostic pop
-  }
+/** a keyword or magic token */
+typedef struct {
+  char const *string; /**< NULL if this slot of the table is unused */
+  size_t length;
+  TokenType keyword;    /**< token type, if this is a keyword */
+  MagicTokenType magic; /**< magic token type, or MTT_NONE for keywords */
+} ReservedWord;
+
+/** number of slots in RESERVED_WORDS, must be a power of two */
+#define NUM_RESERVED_SLOTS 128
+
+/**
+ * hashes a word for RESERVED_WORDS
+ *
+ * The coefficients were chosen so that no two reserved words collide; adding a
+ * reserved word means checking that is still so, and placing it in the table
+ * at its hash.
+ *
+ * @param start start of the word
+ * @param length length of the word, at least 1
+ */
+static size_t reservedWordHash(char const *start, size_t length) {
+  return (12 * (size_t)(unsigned char)start[0] +
+          5 * (size_t)(unsigned char)start[length / 2] +
+          7 * (size_t)(unsigned char)start[length - 1] + length) &
+         (NUM_RESERVED_SLOTS - 1);
 }
 
-void lexerUninitMaps(void) {
-  hashMapUninit(&keywordMap, nullDtor);
-  hashMapUninit(&magicMap, nullDtor);
+/** perfect hash table of keywords and magic tokens, by reservedWordHash */
+static ReservedWord const RESERVED_WORDS[NUM_RESERVED_SLOTS] = {
+    [0] = {"true", 4, TT_TRUE, MTT_NONE},
+    [3] = {"break", 5, TT_BREAK, MTT_NONE},
+    [4] = {"enum", 4, TT_ENUM, MTT_NONE},
+    [6] = {"switch", 6, TT_SWITCH, MTT_NONE},
+    [11] = {"long", 4, TT_LONG, MTT_NONE},
+    [16] = {"union", 5, TT_UNION, MTT_NONE},
+    [17] = {"__FILE__", 8, TT_EOF, MTT_FILE},
+    [19] = {"cast", 4, TT_CAST, MTT_NONE},
+    [20] = {"for", 3, TT_FOR, MTT_NONE},
+    [23] = {"volatile", 8, TT_VOLATILE, MTT_NONE},
+    [27] = {"__LINE__", 8, TT_EOF, MTT_LINE},
+    [33] = {"ubyte", 5, TT_UBYTE, MTT_NONE},
+    [35] = {"byte", 4, TT_BYTE, MTT_NONE},
+    [36] = {"float", 5, TT_FLOAT, MTT_NONE},
+    [41] = {"return", 6, TT_RETURN, MTT_NONE},
+    [42] = {"case", 4, TT_CASE, MTT_NONE},
+    [43] = {"char", 4, TT_CHAR, MTT_NONE},
+    [44] = {"false", 5, TT_FALSE, MTT_NONE},
+    [45] = {"sizeof", 6, TT_SIZEOF, MTT_NONE},
+    [46] = {"module", 6, TT_MODULE, MTT_NONE},
+    [50] = {"opaque", 6, TT_OPAQUE, MTT_NONE},
+    [54] = {"if", 2, TT_IF, MTT_NONE},
+    [55] = {"__VERSION__", 11, TT_EOF, MTT_VERSION},
+    [58] = {"typedef", 7, TT_TYPEDEF, MTT_NONE},
+    [59] = {"bool", 4, TT_BOOL, MTT_NONE},
+    [60] = {"null", 4, TT_NULL, MTT_NONE},
+    [63] = {"wchar", 5, TT_WCHAR, MTT_NONE},
+    [64] = {"short", 5, TT_SHORT, MTT_NONE},
+    [65] = {"int", 3, TT_INT, MTT_NONE},
+    [66] = {"else", 4, TT_ELSE, MTT_NONE},
+    [72] = {"default", 7, TT_DEFAULT, MTT_NONE},
+    [73] = {"import", 6, TT_IMPORT, MTT_NONE},
+    [82] = {"uint", 4, TT_UINT, MTT_NONE},
+    [85] = {"void", 4, TT_VOID, MTT_NONE},
+    [89] = {"ushort", 6, TT_USHORT, MTT_NONE},
+    [95] = {"struct", 6, TT_STRUCT, MTT_NONE},
+    [99] = {"double", 6, TT_DOUBLE, MTT_NONE},
+    [102] = {"do", 2, TT_DO, MTT_NONE},
+    [105] = {"while", 5, TT_WHILE, MTT_NONE},
+    [123] = {"const", 5, TT_CONST, MTT_NONE},
+    [124] = {"continue", 8, TT_CONTINUE, MTT_NONE},
+    [125] = {"ulong", 5, TT_ULONG, MTT_NONE},
+};
+
+/**
+ * looks up a word in the reserved word table
+ *
+ * @param start start of the word
+ * @param length length of the word, at least 1
+ * @returns reserved word, or NULL if it's not a reserved word
+ */
+static ReservedWord const *reservedWordGet(char const *start, size_t length) {
+  ReservedWord const *word = &RESERVED_WORDS[reservedWordHash(start, length)];
+  if (word->length == length && memcmp(word->string, start, length) == 0)
+    return word;
+  else
+    return NULL;
 }
 
 int lexerStateInit(FileListEntry *entry) {
@@ -242,16 +336,21 @@ int lexerStateInit(FileListEntry *entry) {
   state->character = 1;
   state->line = 1;
   state->pushedBack = false;
+  state->pretokenized = false;
+  tokenBufferInit(&state->tokens);
+  state->nextToken = 0;
 
   // try to map the file
   int fd = open(entry->inputFilename, O_RDONLY);
   if (fd == -1) {
-    fprintf(stderr, "%s: error: cannot open file\n", entry->inputFilename);
+    fprintf(diagnosticStream(), "%s: error: cannot open file\n",
+            entry->inputFilename);
     return -1;
   }
   struct stat statbuf;
   if (fstat(fd, &statbuf) != 0) {
-    fprintf(stderr, "%s: error: cannot stat file\n", entry->inputFilename);
+    fprintf(diagnosticStream(), "%s: error: cannot stat file\n",
+            entry->inputFilename);
     close(fd);
     return -1;
   }
@@ -263,7 +362,8 @@ int lexerStateInit(FileListEntry *entry) {
         mmap(NULL, state->length, PROT_READ, MAP_PRIVATE, fd, 0);
     close(fd);
     if (state->map == (void *)-1) {
-      fprintf(stderr, "%s: error: cannot mmap file\n", entry->inputFilename);
+      fprintf(diagnosticStream(), "%s: error: cannot mmap file\n",
+              entry->inputFilename);
       return -1;
     }
   }
@@ -291,6 +391,127 @@ static void put(LexerState *state, size_t n) {
   if (state->current < state->map)
     error(__FILE__, __LINE__, "lexer pushed back past start of mapping");
 }
+#if defined(__AVX2__)
+/** number of characters classified at once */
+#define BLOCK_WIDTH 32
+#elif defined(__SSE2__)
+#define BLOCK_WIDTH 16
+#endif
+
+#ifdef BLOCK_WIDTH
+/** classes of characters in a block, one bit per character */
+typedef struct {
+  uint32_t blank; /**< spaces and tabs */
+  uint32_t lf;
+  uint32_t cr;
+  uint32_t star;
+  uint32_t eot; /**< '\x04', which get() also returns at the end of the file */
+} BlockMasks;
+
+#if defined(__AVX2__)
+static uint32_t matchByte(__m256i block, char c) {
+  return (uint32_t)_mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(block, _mm256_set1_epi8(c)));
+}
+
+static void classifyBlock(char const *start, BlockMasks *masks) {
+  __m256i block = _mm256_loadu_si256((__m256i const *)start);
+  masks->blank = matchByte(block, ' ') | matchByte(block, '\t');
+  masks->lf = matchByte(block, '\n');
+  masks->cr = matchByte(block, '\r');
+  masks->star = matchByte(block, '*');
+  masks->eot = matchByte(block, '\x04');
+}
+#else
+static uint32_t matchByte(__m128i block, char c) {
+  return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(c)));
+}
+
+static void classifyBlock(char const *start, BlockMasks *masks) {
+  __m128i block = _mm_loadu_si128((__m128i const *)start);
+  masks->blank = matchByte(block, ' ') | matchByte(block, '\t');
+  masks->lf = matchByte(block, '\n');
+  masks->cr = matchByte(block, '\r');
+  masks->star = matchByte(block, '*');
+  masks->eot = matchByte(block, '\x04');
+}
+#endif
+#endif
+
+/** kinds of runs of characters that can be skipped a block at a time */
+typedef enum {
+  RUN_WHITESPACE,    /**< spaces, tabs, and newlines */
+  RUN_LINE_COMMENT,  /**< anything but newlines */
+  RUN_BLOCK_COMMENT, /**< anything but stars */
+} RunKind;
+
+/**
+ * skips a run of characters a block at a time, updating the line and
+ * character exactly as get()-ing them one at a time would
+ *
+ * Stops before the first character that ends the run, or when less than a
+ * block is left, so the caller must still handle the rest of the run one
+ * character at a time. Never stops between a cr and a following lf.
+ *
+ * @param state lexer state to update
+ * @param kind kind of run to skip
+ */
+static void skipRun(LexerState *state, RunKind kind) {
+#ifdef BLOCK_WIDTH
+  char const *end = state->map + state->length;
+  while (end - state->current >= BLOCK_WIDTH) {
+    BlockMasks masks;
+    classifyBlock(state->current, &masks);
+
+    uint32_t stop;
+    switch (kind) {
+      case RUN_WHITESPACE: {
+        stop = ~(masks.blank | masks.lf | masks.cr);
+        break;
+      }
+      case RUN_LINE_COMMENT: {
+        stop = masks.lf | masks.cr | masks.eot;
+        break;
+      }
+      default: {
+        stop = masks.star | masks.eot;
+        break;
+      }
+    }
+    stop &= (uint32_t)((1ULL << BLOCK_WIDTH) - 1);
+
+    unsigned length;
+    if (stop != 0) {
+      length = (unsigned)__builtin_ctz(stop);
+    } else if ((masks.cr >> (BLOCK_WIDTH - 1)) != 0) {
+      // leave a trailing cr for the next block, in case an lf follows it
+      length = BLOCK_WIDTH - 1;
+    } else {
+      length = BLOCK_WIDTH;
+    }
+
+    uint32_t inRun = (uint32_t)((1ULL << length) - 1);
+    uint32_t cr = masks.cr & inRun;
+    uint32_t lf = masks.lf & inRun;
+    // a cr-lf pair is one newline; a run never starts just after a cr
+    uint32_t newlines = cr | (lf & ~(cr << 1));
+    if (newlines == 0) {
+      state->character += length;
+    } else {
+      unsigned lastBreak = 31 - (unsigned)__builtin_clz(cr | lf);
+      state->line += (size_t)__builtin_popcount(newlines);
+      state->character = length - lastBreak;
+    }
+    state->current += length;
+
+    if (stop != 0) return;
+  }
+#else
+  (void)state;
+  (void)kind;
+#endif
+}
+
 /**
  * consumes whitespace while updating the entry
  * @param entry entry to munch from
@@ -299,6 +520,7 @@ static void lexWhitespace(FileListEntry *entry) {
   LexerState *state = &entry->lexerState;
   bool whitespace = true;
   while (whitespace) {
+    skipRun(state, RUN_WHITESPACE);
     char c = get(state);
     switch (c) {
       case ' ':
@@ -325,6 +547,7 @@ static void lexWhitespace(FileListEntry *entry) {
           case '/': {
             // line comment
             state->character += 2;
+            skipRun(state, RUN_LINE_COMMENT);
 
             bool inComment = true;
             while (inComment) {
@@ -365,10 +588,11 @@ static void lexWhitespace(FileListEntry *entry) {
 
             bool inComment = true;
             while (inComment) {
+              skipRun(state, RUN_BLOCK_COMMENT);
               char commentChar = get(state);
               switch (commentChar) {
                 case '\x04': {
-                  fprintf(stderr,
+                  fprintf(diagnosticStream(),
                           "%s:%zu:%zu: error: unterminated block comment\n",
                           entry->inputFilename, state->line, state->character);
                   put(state, 1);
@@ -433,13 +657,23 @@ static void lexWhitespace(FileListEntry *entry) {
   }
 }
 
+/**
+ * initializes a token whose string isn't in the file, interning the string
+ *
+ * @param string string to intern, freed
+ */
+static void magicTokenInit(LexerState *state, Token *token, TokenType type,
+                           char *string) {
+  char const *interned = internString(string);
+  free(string);
+  tokenInit(state, token, type, interned, strlen(interned));
+}
+
 /** gets a clip as a token, from some starting pointer */
 static void clip(LexerState *state, Token *token, char const *start,
                  TokenType type) {
   size_t length = (size_t)(state->current - start);
-  char *clip = strncpy(malloc(length + 1), start, length);
-  clip[length] = '\0';
-  tokenInit(state, token, type, clip);
+  tokenInit(state, token, type, start, length);
   state->character += length;
 }
 
@@ -451,10 +685,11 @@ static void lexHex(FileListEntry *entry, Token *token, char const *start) {
   if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') ||
         (c >= 'A' && c <= 'F'))) {
     // error!
-    fprintf(stderr, "%s:%zu:%zu: error: invalid hexadecimal integer literal\n",
+    fprintf(diagnosticStream(),
+            "%s:%zu:%zu: error: invalid hexadecimal integer literal\n",
             entry->inputFilename, state->line, state->character);
     put(state, 1);
-    tokenInit(state, token, TT_BAD_HEX, NULL);
+    tokenInit(state, token, TT_BAD_HEX, NULL, 0);
     state->character += 2;
     entry->errored = true;
     return;
@@ -523,10 +758,11 @@ static void lexBinary(FileListEntry *entry, Token *token, char const *start) {
   char c = get(state);
   if (!(c >= '0' && c <= '1')) {
     // error!
-    fprintf(stderr, "%s:%zu:%zu: error: invalid binary integer literal\n",
+    fprintf(diagnosticStream(),
+            "%s:%zu:%zu: error: invalid binary integer literal\n",
             entry->inputFilename, state->line, state->character);
     put(state, 1);
-    tokenInit(state, token, TT_BAD_BIN, NULL);
+    tokenInit(state, token, TT_BAD_BIN, NULL, 0);
     state->character += 2;
     entry->errored = true;
     return;
@@ -622,47 +858,40 @@ static void lexId(FileListEntry *entry, Token *token) {
       // end of identifier
       put(state, 1);
       size_t length = (size_t)(state->current - start);
-      char *clip = strncpy(malloc(length + 1), start, length);
-      clip[length] = '\0';
 
       // classify the clip
-      TokenType const *keywordToken = hashMapGet(&keywordMap, clip);
-      if (keywordToken != NULL) {
-        // this is a keyword
-        tokenInit(state, token, *keywordToken, NULL);
-        state->character += length;
-        free(clip);
-        return;
-      }
-      MagicTokenType const *magicToken = hashMapGet(&magicMap, clip);
-      if (magicToken != NULL) {
-        // this is a magic token
-        switch (*magicToken) {
+      ReservedWord const *reserved = reservedWordGet(start, length);
+      if (reserved != NULL) {
+        switch (reserved->magic) {
+          case MTT_NONE: {
+            // this is a keyword
+            tokenInit(state, token, reserved->keyword, NULL, 0);
+            state->character += length;
+            return;
+          }
           case MTT_FILE: {
-            tokenInit(state, token, TT_LIT_STRING,
-                      escapeString(entry->inputFilename));
+            magicTokenInit(state, token, TT_LIT_STRING,
+                           escapeString(entry->inputFilename));
             state->character += length;
-            free(clip);
             return;
           }
           case MTT_LINE: {
-            tokenInit(state, token, TT_LIT_INT_D, format("%zu", state->line));
+            magicTokenInit(state, token, TT_LIT_INT_D,
+                           format("%zu", state->line));
             state->character += length;
-            free(clip);
             return;
           }
           case MTT_VERSION: {
-            tokenInit(state, token, TT_LIT_STRING,
-                      escapeString(VERSION_STRING));
+            magicTokenInit(state, token, TT_LIT_STRING,
+                           escapeString(VERSION_STRING));
             state->character += length;
-            free(clip);
             return;
           }
         }
       }
 
       // this is a regular id
-      tokenInit(state, token, TT_ID, clip);
+      tokenInit(state, token, TT_ID, internRange(start, length), length);
       state->character += length;
       return;
     }
@@ -743,9 +972,6 @@ static void lexString(FileListEntry *entry, Token *token) {
       case '"': {
         // end of string
         size_t length = (size_t)(state->current - start - 1);
-        char *clip = strncpy(malloc(length + 1), start, length);
-        clip[length] = '\0';
-
         if (type == TT_LIT_STRING) {
           // check for w-string-ness
           char next = get(state);
@@ -758,18 +984,18 @@ static void lexString(FileListEntry *entry, Token *token) {
           // check for ending w
           char next = get(state);
           if (next != 'w') {
-            fprintf(stderr,
+            fprintf(diagnosticStream(),
                     "%s:%zu:%zu: error: wide characters in narrow string\n",
                     entry->inputFilename, state->line, state->character);
             put(state, 1);
-            tokenInit(state, token, TT_LIT_WSTRING, clip);
+            tokenInit(state, token, TT_LIT_WSTRING, start, length);
             state->character += length + 2;
             entry->errored = true;
             return;
           }
         }
 
-        tokenInit(state, token, type, clip);
+        tokenInit(state, token, type, start, length);
         state->character += length + (type == TT_LIT_STRING ? 2 : 3);
         return;
       }
@@ -783,12 +1009,12 @@ static void lexString(FileListEntry *entry, Token *token) {
               char hex = get(state);
               if (!isNybble(hex)) {
                 fprintf(
-                    stderr,
+                    diagnosticStream(),
                     "%s:%zu:%zu: error: invalid hexadecimal escape sequence\n",
                     entry->inputFilename, state->line,
                     state->character + (size_t)(state->current - start));
                 put(state, 1);
-                tokenInit(state, token, TT_BAD_STRING, NULL);
+                tokenInit(state, token, TT_BAD_STRING, NULL, 0);
                 state->character += (size_t)(state->current - start + 1);
                 panicString(state);
                 entry->errored = true;
@@ -803,12 +1029,12 @@ static void lexString(FileListEntry *entry, Token *token) {
               char hex = get(state);
               if (!isNybble(hex)) {
                 fprintf(
-                    stderr,
+                    diagnosticStream(),
                     "%s:%zu:%zu: error: invalid hexadecimal escape sequence\n",
                     entry->inputFilename, state->line,
                     state->character + (size_t)(state->current - start));
                 put(state, 1);
-                tokenInit(state, token, TT_BAD_STRING, NULL);
+                tokenInit(state, token, TT_BAD_STRING, NULL, 0);
                 state->character += (size_t)(state->current - start + 1);
                 panicString(state);
                 entry->errored = true;
@@ -821,11 +1047,11 @@ static void lexString(FileListEntry *entry, Token *token) {
           default: {
             if (next != 'n' && next != 'r' && next != 't' && next != '0' &&
                 next != '\\' && next != '"') {
-              fprintf(stderr,
+              fprintf(diagnosticStream(),
                       "%s:%zu:%zu: error: unrecognized escape sequence\n",
                       entry->inputFilename, state->line,
                       state->character + (size_t)(state->current - start));
-              tokenInit(state, token, TT_BAD_STRING, NULL);
+              tokenInit(state, token, TT_BAD_STRING, NULL, 0);
               state->character += (size_t)(state->current - start + 1);
               panicString(state);
               entry->errored = true;
@@ -838,29 +1064,27 @@ static void lexString(FileListEntry *entry, Token *token) {
       case '\x04':
       case '\n':
       case '\r': {
-        fprintf(stderr, "%s:%zu:%zu: error: unterminated string literal\n",
+        fprintf(diagnosticStream(),
+                "%s:%zu:%zu: error: unterminated string literal\n",
                 entry->inputFilename, state->line,
                 state->character + (size_t)(state->current - start));
         put(state, 1);
 
         size_t length = (size_t)(state->current - start);
-        char *clip = strncpy(malloc(length + 1), start, length);
-        clip[length] = '\0';
-
-        tokenInit(state, token, type, clip);
+        tokenInit(state, token, type, start, length);
         state->character += length + 1;
         entry->errored = true;
         return;
       }
       default: {
         if (!((c >= ' ' && c <= '~' && c != '"' && c != '\\') || c == '\t')) {
-          fprintf(stderr,
+          fprintf(diagnosticStream(),
                   "%s:%zu:%zu: error: unsupported character encountered in "
                   "string literal\n",
                   entry->inputFilename, state->line,
                   state->character + (size_t)(state->current - start) + 1);
           put(state, 1);
-          tokenInit(state, token, TT_BAD_STRING, NULL);
+          tokenInit(state, token, TT_BAD_STRING, NULL, 0);
           state->character += (size_t)(state->current - start);
           entry->errored = true;
           return;
@@ -943,9 +1167,10 @@ static void lexChar(FileListEntry *entry, Token *token) {
   switch (c) {
     case '\'': {
       // empty literal
-      fprintf(stderr, "%s:%zu:%zu: error: empty character literal\n",
+      fprintf(diagnosticStream(),
+              "%s:%zu:%zu: error: empty character literal\n",
               entry->inputFilename, state->line, state->character);
-      tokenInit(state, token, TT_BAD_CHAR, NULL);
+      tokenInit(state, token, TT_BAD_CHAR, NULL, 0);
       state->character += 2;
       char next = get(state);
       if (next != 'w')
@@ -965,13 +1190,13 @@ static void lexChar(FileListEntry *entry, Token *token) {
             char hex = get(state);
             if (!isNybble(hex)) {
               fprintf(
-                  stderr,
+                  diagnosticStream(),
                   "%s:%zu:%zu: error: invalid hexadecimal escape sequence\n",
                   entry->inputFilename, state->line,
                   state->character +
                       ((size_t)(state->current - start) + 1 - idx));
               put(state, 1);
-              tokenInit(state, token, TT_BAD_CHAR, NULL);
+              tokenInit(state, token, TT_BAD_CHAR, NULL, 0);
               state->character += (size_t)(state->current - start + 1);
               panicChar(state);
               entry->errored = true;
@@ -986,13 +1211,13 @@ static void lexChar(FileListEntry *entry, Token *token) {
             char hex = get(state);
             if (!isNybble(hex)) {
               fprintf(
-                  stderr,
+                  diagnosticStream(),
                   "%s:%zu:%zu: error: invalid hexadecimal escape sequence\n",
                   entry->inputFilename, state->line,
                   state->character +
                       ((size_t)(state->current - start) + 1 - idx));
               put(state, 1);
-              tokenInit(state, token, TT_BAD_CHAR, NULL);
+              tokenInit(state, token, TT_BAD_CHAR, NULL, 0);
               state->character += (size_t)(state->current - start + 1);
               panicChar(state);
               entry->errored = true;
@@ -1005,10 +1230,11 @@ static void lexChar(FileListEntry *entry, Token *token) {
         default: {
           if (next != 'n' && next != 'r' && next != 't' && next != '0' &&
               next != '\\' && next != '\'') {
-            fprintf(stderr, "%s:%zu:%zu: error: unrecognized escape sequence\n",
+            fprintf(diagnosticStream(),
+                    "%s:%zu:%zu: error: unrecognized escape sequence\n",
                     entry->inputFilename, state->line,
                     state->character + (size_t)(state->current - start));
-            tokenInit(state, token, TT_BAD_CHAR, NULL);
+            tokenInit(state, token, TT_BAD_CHAR, NULL, 0);
             state->character += (size_t)(state->current - start + 1);
             panicChar(state);
             entry->errored = true;
@@ -1021,24 +1247,24 @@ static void lexChar(FileListEntry *entry, Token *token) {
     case '\x04':
     case '\r':
     case '\n': {
-      fprintf(stderr,
+      fprintf(diagnosticStream(),
               "%s:%zu:%zu: error: unterminated empty character literal\n",
               entry->inputFilename, state->line,
               state->character + (size_t)(state->current - start));
       put(state, 1);
-      tokenInit(state, token, TT_BAD_CHAR, NULL);
+      tokenInit(state, token, TT_BAD_CHAR, NULL, 0);
       state->character += (size_t)(state->current - start + 1);
       entry->errored = true;
       return;
     }
     default: {
       if (!((c >= ' ' && c <= '~' && c != '"' && c != '\\') || c == '\t')) {
-        fprintf(stderr,
+        fprintf(diagnosticStream(),
                 "%s:%zu:%zu: error: unsupported character encountered in "
                 "character literal\n",
                 entry->inputFilename, state->line,
                 state->character + (size_t)(state->current - start) + 1);
-        tokenInit(state, token, TT_BAD_CHAR, NULL);
+        tokenInit(state, token, TT_BAD_CHAR, NULL, 0);
         state->character += (size_t)(state->current - start + 1);
         panicChar(state);
         entry->errored = true;
@@ -1048,19 +1274,17 @@ static void lexChar(FileListEntry *entry, Token *token) {
   }
 
   size_t length = (size_t)(state->current - start);
-  char *clip = strncpy(malloc(length + 1), start, length);
-  clip[length] = '\0';
-
   c = get(state);
   switch (c) {
     case '\x04':
     case '\r':
     case '\n': {
-      fprintf(stderr, "%s:%zu:%zu: error: unterminated character literal\n",
+      fprintf(diagnosticStream(),
+              "%s:%zu:%zu: error: unterminated character literal\n",
               entry->inputFilename, state->line,
               state->character + (size_t)(state->current - start));
       put(state, 1);
-      tokenInit(state, token, type, clip);
+      tokenInit(state, token, type, start, length);
       state->character += length + 1;
       entry->errored = true;
       return;
@@ -1068,12 +1292,12 @@ static void lexChar(FileListEntry *entry, Token *token) {
     default: {
       if (c != '\'') {
         fprintf(
-            stderr,
+            diagnosticStream(),
             "%s:%zu:%zu: error: multiple characters in a character literal\n",
             entry->inputFilename, state->line,
             (size_t)(state->current - start) + 1);
         put(state, 1);
-        tokenInit(state, token, type, clip);
+        tokenInit(state, token, type, start, length);
         state->character += length + 1;
         panicChar(state);
         entry->errored = true;
@@ -1096,24 +1320,44 @@ static void lexChar(FileListEntry *entry, Token *token) {
     char next = get(state);
     if (next != 'w') {
       fprintf(
-          stderr,
+          diagnosticStream(),
           "%s:%zu:%zu: error: wide characters in narrow character literal\n",
           entry->inputFilename, state->line, state->character);
       put(state, 1);
-      tokenInit(state, token, TT_LIT_WCHAR, clip);
+      tokenInit(state, token, TT_LIT_WCHAR, start, length);
       state->character += length + 2;
       entry->errored = true;
       return;
     }
   }
 
-  tokenInit(state, token, type, clip);
+  tokenInit(state, token, type, start, length);
   state->character += length + (type == TT_LIT_CHAR ? 2 : 3);
 }
 
+void lexerStatePretokenize(FileListEntry *entry) {
+  LexerState *state = &entry->lexerState;
+  Token token;
+  do {
+    lex(entry, &token);
+    tokenBufferPush(&state->tokens, &token);
+  } while (token.type != TT_EOF);
+  state->pretokenized = true;
+  state->nextToken = 0;
+}
+
 void lex(FileListEntry *entry, Token *token) {
   LexerState *state = &entry->lexerState;
 
+  // read from the token buffer - every token past the end is the eof
+  if (state->pretokenized) {
+    size_t last = state->tokens.size - 1;
+    tokenBufferGet(&state->tokens,
+                   state->nextToken < last ? state->nextToken : last, token);
+    ++state->nextToken;
+    return;
+  }
+
   // check pushback buffer
   if (state->pushedBack) {
     state->pushedBack = false;
@@ -1129,53 +1373,53 @@ void lex(FileListEntry *entry, Token *token) {
   switch (c) {
     // EOF
     case '\x04': {
-      tokenInit(state, token, TT_EOF, NULL);
+      tokenInit(state, token, TT_EOF, NULL, 0);
       return;
     }
 
     // punctuation
     case ';': {
-      tokenInit(state, token, TT_SEMI, NULL);
+      tokenInit(state, token, TT_SEMI, NULL, 0);
       state->character += 1;
       return;
     }
     case ',': {
-      tokenInit(state, token, TT_COMMA, NULL);
+      tokenInit(state, token, TT_COMMA, NULL, 0);
       state->character += 1;
       return;
     }
     case '(': {
-      tokenInit(state, token, TT_LPAREN, NULL);
+      tokenInit(state, token, TT_LPAREN, NULL, 0);
       state->character += 1;
       return;
     }
     case ')': {
-      tokenInit(state, token, TT_RPAREN, NULL);
+      tokenInit(state, token, TT_RPAREN, NULL, 0);
       state->character += 1;
       return;
     }
     case '[': {
-      tokenInit(state, token, TT_LSQUARE, NULL);
+      tokenInit(state, token, TT_LSQUARE, NULL, 0);
       state->character += 1;
       return;
     }
     case ']': {
-      tokenInit(state, token, TT_RSQUARE, NULL);
+      tokenInit(state, token, TT_RSQUARE, NULL, 0);
       state->character += 1;
       return;
     }
     case '{': {
-      tokenInit(state, token, TT_LBRACE, NULL);
+      tokenInit(state, token, TT_LBRACE, NULL, 0);
       state->character += 1;
       return;
     }
     case '}': {
-      tokenInit(state, token, TT_RBRACE, NULL);
+      tokenInit(state, token, TT_RBRACE, NULL, 0);
       state->character += 1;
       return;
     }
     case '.': {
-      tokenInit(state, token, TT_DOT, NULL);
+      tokenInit(state, token, TT_DOT, NULL, 0);
       state->character += 1;
       return;
     }
@@ -1184,19 +1428,19 @@ void lex(FileListEntry *entry, Token *token) {
       switch (next) {
         case '>': {
           // ->
-          tokenInit(state, token, TT_ARROW, NULL);
+          tokenInit(state, token, TT_ARROW, NULL, 0);
           state->character += 2;
           return;
         }
         case '-': {
           // --
-          tokenInit(state, token, TT_DEC, NULL);
+          tokenInit(state, token, TT_DEC, NULL, 0);
           state->character += 2;
           return;
         }
         case '=': {
           // -=
-          tokenInit(state, token, TT_SUBASSIGN, NULL);
+          tokenInit(state, token, TT_SUBASSIGN, NULL, 0);
           state->character += 2;
           return;
         }
@@ -1209,7 +1453,7 @@ void lex(FileListEntry *entry, Token *token) {
           } else {
             // just -
             put(state, 1);
-            tokenInit(state, token, TT_MINUS, NULL);
+            tokenInit(state, token, TT_MINUS, NULL, 0);
             state->character += 1;
             return;
           }
@@ -1221,13 +1465,13 @@ void lex(FileListEntry *entry, Token *token) {
       switch (next) {
         case '+': {
           // ++
-          tokenInit(state, token, TT_INC, NULL);
+          tokenInit(state, token, TT_INC, NULL, 0);
           state->character += 2;
           return;
         }
         case '=': {
           // +=
-          tokenInit(state, token, TT_ADDASSIGN, NULL);
+          tokenInit(state, token, TT_ADDASSIGN, NULL, 0);
           state->character += 2;
           return;
         }
@@ -1240,7 +1484,7 @@ void lex(FileListEntry *entry, Token *token) {
           } else {
             // just +
             put(state, 1);
-            tokenInit(state, token, TT_PLUS, NULL);
+            tokenInit(state, token, TT_PLUS, NULL, 0);
             state->character += 1;
             return;
           }
@@ -1252,14 +1496,14 @@ void lex(FileListEntry *entry, Token *token) {
       switch (next) {
         case '=': {
           // *=
-          tokenInit(state, token, TT_MULASSIGN, NULL);
+          tokenInit(state, token, TT_MULASSIGN, NULL, 0);
           state->character += 2;
           return;
         }
         default: {
           // just *
           put(state, 1);
-          tokenInit(state, token, TT_STAR, NULL);
+          tokenInit(state, token, TT_STAR, NULL, 0);
           state->character += 1;
           return;
         }
@@ -1274,14 +1518,14 @@ void lex(FileListEntry *entry, Token *token) {
           switch (next2) {
             case '=': {
               // &&=
-              tokenInit(state, token, TT_LANDASSIGN, NULL);
+              tokenInit(state, token, TT_LANDASSIGN, NULL, 0);
               state->character += 3;
               return;
             }
             default: {
               // just &&
               put(state, 1);
-              tokenInit(state, token, TT_LAND, NULL);
+              tokenInit(state, token, TT_LAND, NULL, 0);
               state->character += 2;
               return;
             }
@@ -1289,14 +1533,14 @@ void lex(FileListEntry *entry, Token *token) {
         }
         case '=': {
           // &=
-          tokenInit(state, token, TT_BITANDASSIGN, NULL);
+          tokenInit(state, token, TT_BITANDASSIGN, NULL, 0);
           state->character += 2;
           return;
         }
         default: {
           // just &
           put(state, 1);
-          tokenInit(state, token, TT_AMP, NULL);
+          tokenInit(state, token, TT_AMP, NULL, 0);
           state->character += 1;
           return;
         }
@@ -1307,21 +1551,21 @@ void lex(FileListEntry *entry, Token *token) {
       switch (next) {
         case '=': {
           // !=
-          tokenInit(state, token, TT_NEQ, NULL);
+          tokenInit(state, token, TT_NEQ, NULL, 0);
           state->character += 2;
           return;
         }
         default: {
           // just !
           put(state, 1);
-          tokenInit(state, token, TT_BANG, NULL);
+          tokenInit(state, token, TT_BANG, NULL, 0);
           state->character += 1;
           return;
         }
       }
     }
     case '~': {
-      tokenInit(state, token, TT_TILDE, NULL);
+      tokenInit(state, token, TT_TILDE, NULL, 0);
       state->character += 1;
       return;
     }
@@ -1330,32 +1574,32 @@ void lex(FileListEntry *entry, Token *token) {
       switch (next) {
         case '=': {
           // ==
-          tokenInit(state, token, TT_EQ, NULL);
+          tokenInit(state, token, TT_EQ, NULL, 0);
           state->character += 2;
           return;
         }
         case '-': {
           // =-
-          tokenInit(state, token, TT_NEGASSIGN, NULL);
+          tokenInit(state, token, TT_NEGASSIGN, NULL, 0);
           state->character += 2;
           return;
         }
         case '!': {
           // =!
-          tokenInit(state, token, TT_LNOTASSIGN, NULL);
+          tokenInit(state, token, TT_LNOTASSIGN, NULL, 0);
           state->character += 2;
           return;
         }
         case '~': {
           // =~
-          tokenInit(state, token, TT_BITNOTASSIGN, NULL);
+          tokenInit(state, token, TT_BITNOTASSIGN, NULL, 0);
           state->character += 2;
           return;
         }
         default: {
           // just =
           put(state, 1);
-          tokenInit(state, token, TT_ASSIGN, NULL);
+          tokenInit(state, token, TT_ASSIGN, NULL, 0);
           state->character += 1;
           return;
         }
@@ -1367,14 +1611,14 @@ void lex(FileListEntry *entry, Token *token) {
       switch (next) {
         case '=': {
           // /=
-          tokenInit(state, token, TT_DIVASSIGN, NULL);
+          tokenInit(state, token, TT_DIVASSIGN, NULL, 0);
           state->character += 2;
           return;
         }
         default: {
           // just /
           put(state, 1);
-          tokenInit(state, token, TT_SLASH, NULL);
+          tokenInit(state, token, TT_SLASH, NULL, 0);
           state->character += 1;
           return;
         }
@@ -1385,14 +1629,14 @@ void lex(FileListEntry *entry, Token *token) {
       switch (next) {
         case '=': {
           // %=
-          tokenInit(state, token, TT_MODASSIGN, NULL);
+          tokenInit(state, token, TT_MODASSIGN, NULL, 0);
           state->character += 2;
           return;
         }
         default: {
           // just %
           put(state, 1);
-          tokenInit(state, token, TT_PERCENT, NULL);
+          tokenInit(state, token, TT_PERCENT, NULL, 0);
           state->character += 1;
           return;
         }
@@ -1406,28 +1650,28 @@ void lex(FileListEntry *entry, Token *token) {
           char next2 = get(state);
           switch (next2) {
             case '=': {
-              tokenInit(state, token, TT_LSHIFTASSIGN, NULL);
+              tokenInit(state, token, TT_LSHIFTASSIGN, NULL, 0);
               state->character += 3;
               return;
             }
             default: {
               // just <<
               put(state, 1);
-              tokenInit(state, token, TT_LSHIFT, NULL);
+              tokenInit(state, token, TT_LSHIFT, NULL, 0);
               state->character += 2;
               return;
             }
           }
         }
         case '=': {
-          tokenInit(state, token, TT_LTEQ, NULL);
+          tokenInit(state, token, TT_LTEQ, NULL, 0);
           state->character += 2;
           return;
         }
         default: {
           // just <
           put(state, 1);
-          tokenInit(state, token, TT_LANGLE, NULL);
+          tokenInit(state, token, TT_LANGLE, NULL, 0);
           state->character += 1;
           return;
         }
@@ -1446,14 +1690,14 @@ void lex(FileListEntry *entry, Token *token) {
               switch (next3) {
                 case '=': {
                   // >>>=
-                  tokenInit(state, token, TT_LRSHIFTASSIGN, NULL);
+                  tokenInit(state, token, TT_LRSHIFTASSIGN, NULL, 0);
                   state->character += 4;
                   return;
                 }
                 default: {
                   // just >>>
                   put(state, 1);
-                  tokenInit(state, token, TT_LRSHIFT, NULL);
+                  tokenInit(state, token, TT_LRSHIFT, NULL, 0);
                   state->character += 3;
                   return;
                 }
@@ -1461,14 +1705,14 @@ void lex(FileListEntry *entry, Token *token) {
             }
             case '=': {
               // >>=
-              tokenInit(state, token, TT_ARSHIFTASSIGN, NULL);
+              tokenInit(state, token, TT_ARSHIFTASSIGN, NULL, 0);
               state->character += 3;
               return;
             }
             default: {
               // just >>
               put(state, 1);
-              tokenInit(state, token, TT_ARSHIFT, NULL);
+              tokenInit(state, token, TT_ARSHIFT, NULL, 0);
               state->character += 2;
               return;
             }
@@ -1476,14 +1720,14 @@ void lex(FileListEntry *entry, Token *token) {
         }
         case '=': {
           // >=
-          tokenInit(state, token, TT_GTEQ, NULL);
+          tokenInit(state, token, TT_GTEQ, NULL, 0);
           state->character += 2;
           return;
         }
         default: {
           // just >
           put(state, 1);
-          tokenInit(state, token, TT_RANGLE, NULL);
+          tokenInit(state, token, TT_RANGLE, NULL, 0);
           state->character += 1;
           return;
         }
@@ -1498,14 +1742,14 @@ void lex(FileListEntry *entry, Token *token) {
           switch (next2) {
             case '=': {
               // ||=
-              tokenInit(state, token, TT_LORASSIGN, NULL);
+              tokenInit(state, token, TT_LORASSIGN, NULL, 0);
               state->character += 3;
               return;
             }
             default: {
               // just ||
               put(state, 1);
-              tokenInit(state, token, TT_LOR, NULL);
+              tokenInit(state, token, TT_LOR, NULL, 0);
               state->character += 2;
               return;
             }
@@ -1513,14 +1757,14 @@ void lex(FileListEntry *entry, Token *token) {
         }
         case '=': {
           // |=
-          tokenInit(state, token, TT_BITORASSIGN, NULL);
+          tokenInit(state, token, TT_BITORASSIGN, NULL, 0);
           state->character += 2;
           return;
         }
         default: {
           // just |
           put(state, 1);
-          tokenInit(state, token, TT_BAR, NULL);
+          tokenInit(state, token, TT_BAR, NULL, 0);
           state->character += 1;
           return;
         }
@@ -1531,21 +1775,21 @@ void lex(FileListEntry *entry, Token *token) {
       switch (next) {
         case '=': {
           // ^=
-          tokenInit(state, token, TT_BITXORASSIGN, NULL);
+          tokenInit(state, token, TT_BITXORASSIGN, NULL, 0);
           state->character += 2;
           return;
         }
         default: {
           // just ^
           put(state, 1);
-          tokenInit(state, token, TT_CARET, NULL);
+          tokenInit(state, token, TT_CARET, NULL, 0);
           state->character += 1;
           return;
         }
       }
     }
     case '?': {
-      tokenInit(state, token, TT_QUESTION, NULL);
+      tokenInit(state, token, TT_QUESTION, NULL, 0);
       state->character += 1;
       return;
     }
@@ -1554,14 +1798,14 @@ void lex(FileListEntry *entry, Token *token) {
       switch (next) {
         case ':': {
           // ::
-          tokenInit(state, token, TT_SCOPE, NULL);
+          tokenInit(state, token, TT_SCOPE, NULL, 0);
           state->character += 2;
           return;
         }
         default: {
           // just :
           put(state, 1);
-          tokenInit(state, token, TT_COLON, NULL);
+          tokenInit(state, token, TT_COLON, NULL, 0);
           state->character += 1;
           return;
         }
@@ -1591,7 +1835,8 @@ void lex(FileListEntry *entry, Token *token) {
       } else {
         // error
         char *prettyString = escapeChar(c);
-        fprintf(stderr, "%s:%zu:%zu: error: unexpected character: %s\n",
+        fprintf(diagnosticStream(),
+                "%s:%zu:%zu: error: unexpected character: %s\n",
                 entry->inputFilename, state->line, state->character,
                 prettyString);
         free(prettyString);
@@ -1606,8 +1851,13 @@ void lex(FileListEntry *entry, Token *token) {
 }
 
 void unLex(FileListEntry *entry, Token const *token) {
-  // only one token of lookahead is allowed
   LexerState *state = &entry->lexerState;
+  if (state->pretokenized) {
+    --state->nextToken;
+    return;
+  }
+
+  // only one token of lookahead is allowed
   if (state->pushedBack)
     error(__FILE__, __LINE__, "unLex called while token already pushed back");
   state->pushedBack = true;
@@ -1616,6 +1866,6 @@ void unLex(FileListEntry *entry, Token const *token) {
 
 void lexerStateUninit(FileListEntry *entry) {
   LexerState *state = &entry->lexerState;
+  tokenBufferUninit(&state->tokens);
   if (state->map != NULL) munmap((void *)state->map, state->length);
-  if (state->pushedBack) tokenUninit(&state->previous);
 }
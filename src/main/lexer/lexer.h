@@ -27,8 +27,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
-
-#include "util/container/hashMap.h"
+#include <stdint.h>
 
 typedef struct FileListEntry FileListEntry;
 
@@ -162,33 +161,71 @@ typedef struct {
   TokenType type;
   size_t line;
   size_t character;
-  char *string; /**< optional, depends on Token#type. For ids, contains the
-                   string of the id. For strings and chars, contains the data
-                   between the quotes (quotes excluded), for numbers, contains
-                   the whole number (sign and prefix included) */
+  char const *string; /**< optional, depends on Token#type. For ids, contains
+                         the interned string of the id. For strings and chars,
+                         contains the data between the quotes (quotes
+                         excluded), for numbers, contains the whole number
+                         (sign and prefix included). Except for ids, this is
+                         not NUL-terminated, and points into the lexer's map
+                         of the file, so it is only valid until the lexer
+                         state is uninitialized */
+  size_t length;      /**< length of Token#string */
 } Token;
 
 /**
- * uninitializes the token
+ * copies the token's string into a new NUL-terminated string
+ *
+ * @param token token to copy the string of
+ * @returns copied string, owned by the caller
+ */
+char *tokenCopyString(Token const *token);
+
+/**
+ * a sequence of tokens, stored as a structure of arrays
  *
- * only needs to be called if token has a string that isn't used (i.e. token is
- * in the range TT_ID to TT_LIT_FLOAT and Token#string was ignored)
+ * Each array holds one field of each token - see Token for the meaning of each
+ * field. Token types are stored as bytes.
+ */
+typedef struct {
+  size_t size;
+  size_t capacity;
+  uint8_t *types;
+  size_t *lines;
+  size_t *characters;
+  char const **strings;
+  size_t *lengths;
+} TokenBuffer;
+
+/**
+ * initializes a token buffer, empty
  *
- * @param token token to deinitialize
+ * @param buffer buffer to initialize
  */
-void tokenUninit(Token *token);
+void tokenBufferInit(TokenBuffer *buffer);
 
 /**
- * Initializes keyword and magic token maps - must be called before any lexing
- * is done
+ * adds a token to the end of a token buffer
+ *
+ * @param buffer buffer to add to
+ * @param token token to add
  */
-void lexerInitMaps(void);
+void tokenBufferPush(TokenBuffer *buffer, Token const *token);
 
 /**
- * Deinitializes keyword and magic token maps - may be called after all lexing
- * is done
+ * reads a token from a token buffer
+ *
+ * @param buffer buffer to read from
+ * @param idx index of the token, must be less than the buffer's size
+ * @param token token to write into
  */
-void lexerUninitMaps(void);
+void tokenBufferGet(TokenBuffer const *buffer, size_t idx, Token *token);
+
+/**
+ * uninitializes a token buffer
+ *
+ * @param buffer buffer to uninitialize
+ */
+void tokenBufferUninit(TokenBuffer *buffer);
 
 /** internal state for a lexer for some file */
 typedef struct {
@@ -201,6 +238,10 @@ typedef struct {
 
   Token previous;
   bool pushedBack;
+
+  bool pretokenized;  /**< are tokens read from LexerState#tokens */
+  TokenBuffer tokens; /**< every token in the file, if pretokenized */
+  size_t nextToken;   /**< index of the next token to read, if pretokenized */
 } LexerState;
 
 /**
@@ -211,6 +252,16 @@ typedef struct {
  */
 int lexerStateInit(FileListEntry *entry);
 
+/**
+ * lexes the whole file into the lexer state's token buffer, after which lex
+ * and unLex read from the buffer
+ *
+ * Lexing errors for the whole file are reported by this function.
+ *
+ * @param entry entry to lex from - may set error flag on this entry
+ */
+void lexerStatePretokenize(FileListEntry *entry);
+
 /**
  * lexes one token
  *
@@ -219,7 +270,8 @@ int lexerStateInit(FileListEntry *entry);
  */
 void lex(FileListEntry *entry, Token *token);
 /**
- * pushes back one token. Must not call this twice in a row.
+ * pushes back one token, which must be the last token lexed. Must not call
+ * this twice in a row, unless the lexer state is pretokenized.
  *
  * @param entry entry to return token to
  * @param token token to return
@@ -26,7 +26,10 @@
 
 #include "arch/interface.h"
 #include "ast/dump.h"
+#include "dependencyFile.h"
+#include "exitCode.h"
 #include "fileList.h"
+#include "incremental.h"
 #include "ir/dump.h"
 #include "ir/ir.h"
 #include "lexer/dump.h"
@@ -34,10 +37,16 @@
 #include "optimization/optimization.h"
 #include "options.h"
 #include "parser/parser.h"
+#include "parser/precompiled.h"
+#include "server.h"
+#include "streaming.h"
 #include "translation/traceSchedule.h"
 #include "translation/translation.h"
 #include "typechecker/typechecker.h"
+#include "util/functional.h"
 #include "util/internalError.h"
+#include "util/threadPool.h"
+#include "util/timeReport.h"
 #include "version.h"
 
 /**
@@ -72,77 +81,140 @@ static bool helpRequested(size_t argc, char **argv) {
   return false;
 }
 
-/** possible return values for main */
-enum {
-  CODE_SUCCESS = EXIT_SUCCESS,
-  CODE_OPTION_ERROR,
-  CODE_FILE_ERROR,
-  CODE_PARSE_ERROR,
-  CODE_TYPECHECK_ERROR,
-  CODE_IR_ERROR,
-};
+/**
+ * finds the value of the last argument in argv starting with prefix
+ *
+ * @param argc number of arguments (including name of program)
+ * @param argv list of arguments (including name of program)
+ * @param prefix prefix to look for, including the '='
+ * @returns value of the argument, or NULL if there is no such argument
+ */
+static char const *findValue(size_t argc, char **argv, char const *prefix) {
+  char const *value = NULL;
+  size_t length = strlen(prefix);
+  for (size_t idx = 1; idx < argc; ++idx) {
+    if (strncmp(argv[idx], prefix, length) == 0 && argv[idx][length] != '\0')
+      value = argv[idx] + length;
+  }
+  return value;
+}
 
-// compile the given declaration and code files into one assembly file per code
-// file, given the flags
-int main(int argc, char **argv) {
-  // handle overriding command line arguments
-  if (helpRequested((size_t)argc, argv)) {
-    printf(
-        "Usage: tlc [options] file...\n"
-        "For more information, see the 'README.md' file.\n"
-        "\n"
-        "Options:\n"
-        "  --help, -h, -?    Display this information, and stop\n"
-        "  --version         Display version information, and stop\n"
-        "  --arch=...        Set the target architecture\n"
-        "  -W...=...         Configure warning options\n"
-        "  --debug-dump=...  Configure debug information\n"
-        "\n"
-        "Please report bugs at "
-        "<https://github.com/JustinHuPrime/TCompiler/issues>\n");
-    return CODE_SUCCESS;
-  } else if (versionRequested((size_t)argc, argv)) {
-    printf(
-        "%s\n"
-        "Copyright 2021 Justin Hu\n"
-        "This is free software; see the source for copying conditions. There "
-        "is NO\n"
-        "warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR "
-        "PURPOSE.\n",
-        VERSION_STRING);
-    return CODE_SUCCESS;
+/** has the backend freed the IR of the current compilation */
+static bool irFreed;
+
+/**
+ * frees what's left of the global file list
+ *
+ * @param irFreed has the IR already been freed by the backend
+ */
+static void freeFileList(bool irFreed) {
+  for (size_t idx = 0; idx < fileList.size; ++idx) {
+    FileListEntry *entry = &fileList.entries[idx];
+    nodeFree(entry->ast);
+    precompiledUnload(entry);
+    if (!irFreed) vectorUninit(&entry->irFrags, (void (*)(void *))irFragFree);
   }
+  free(fileList.entries);
+  fileList.entries = NULL;
+  fileList.size = 0;
+  hashMapUninit(&fileList.paths, nullDtor);
+  hashMapInit(&fileList.paths);
+  hashMapUninit(&fileList.declModules, nullDtor);
+  hashMapInit(&fileList.declModules);
+}
 
+/**
+ * reports timings, records incremental build state, stops the thread pool, and
+ * frees the file list
+ *
+ * @param code exit code to return
+ * @returns exit code for main
+ */
+static int finish(int code) {
+  threadPoolUninit();
+  incrementalFinish(code == CODE_SUCCESS);
+
+  if (options.timeReport) timeReportPrint(stderr);
+  if (options.timeTraceFile != NULL &&
+      timeReportWriteTrace(options.timeTraceFile) != 0) {
+    fprintf(stderr, "tlc: error: cannot write time trace to '%s'\n",
+            options.timeTraceFile);
+    if (code == CODE_SUCCESS) code = CODE_FILE_ERROR;
+  }
+  timeReportUninit();
+  freeFileList(irFreed);
+
+  return code;
+}
+
+/**
+ * compiles the given declaration and code files
+ *
+ * @param argc number of arguments (including name of program)
+ * @param argv list of arguments (including name of program)
+ * @returns exit code for main
+ */
+static int compile(size_t argc, char const *const *argv) {
   // parse options, get number of files
   size_t numFiles;
-  if (parseArgs((size_t)argc, (char const *const *)argv, &numFiles) != 0)
-    return CODE_OPTION_ERROR;
+  if (parseArgs(argc, argv, &numFiles) != 0) return CODE_OPTION_ERROR;
 
   // fill in global file list
-  if (parseFiles((size_t)argc, (char const *const *)argv, numFiles) != 0)
+  if (parseFiles(argc, argv, numFiles) != 0) {
+    freeFileList(false);
     return CODE_FILE_ERROR;
+  }
+
+  irFreed = false;
+  threadPoolInit(options.jobs);
+  if (options.timeReport || options.timeTraceFile != NULL) timeReportInit();
+
+  // skip code files that haven't changed since they were last compiled
+  if (incrementalFilter() == 0) return finish(CODE_SUCCESS);
 
   // debug-dump stop for lexing
   if (options.dump == OPTION_DD_LEX) {
-    lexerInitMaps();
     for (size_t idx = 0; idx < fileList.size; ++idx)
       lexDump(&fileList.entries[idx]);
-    lexerUninitMaps();
+    return finish(CODE_SUCCESS);
   }
 
   // front-end
 
   // parse
-  if (parse() != 0) return CODE_PARSE_ERROR;
+  if (parse() != 0) return finish(CODE_PARSE_ERROR);
+
+  // write dependency files
+  if (options.dependencyFile && writeDependencyFiles() != 0)
+    return finish(CODE_FILE_ERROR);
+
+  incrementalCollect();
+
+  // write precompiled declaration modules
+  if (options.emitTdi) {
+    timePhaseStart("write precompiled declarations");
+    precompiledWriteAll();
+    timePhaseEnd();
+  }
+
+  // keep decl modules for later compilations, if running as a server
+  precompiledCacheAll();
 
   // debug-dump stop for parsing
   if (options.dump == OPTION_DD_PARSE) {
     for (size_t idx = 0; idx < fileList.size; ++idx)
       astDump(stderr, &fileList.entries[idx]);
+    return finish(CODE_SUCCESS);
   }
 
+  // finish one code file at a time
+  if (options.stream) return finish(compileStreaming(&irFreed));
+
   // typecheck
-  if (typecheck() != 0) return CODE_TYPECHECK_ERROR;
+  timePhaseStart("typecheck");
+  int retval = typecheck();
+  timePhaseEnd();
+  if (retval != 0) return finish(CODE_TYPECHECK_ERROR);
 
   // debug-dump stop for typechecking
   // TODO: write this
@@ -154,7 +226,9 @@ int main(int argc, char **argv) {
   // TODO: write this
 
   // translate to IR
+  timePhaseStart("translation");
   translate();
+  timePhaseEnd();
 
   // debug-dump stop for IR
   if (options.dump == OPTION_DD_TRANSLATION) {
@@ -164,13 +238,17 @@ int main(int argc, char **argv) {
   }
 
   if (options.debugValidateIr && validateBlockedIr("translation") != 0)
-    return CODE_IR_ERROR;
+    return finish(CODE_IR_ERROR);
+  if (options.dump == OPTION_DD_TRANSLATION) return finish(CODE_SUCCESS);
 
   // middle-end
 
   // clean up AST
-  for (size_t idx = 0; idx < fileList.size; ++idx)
+  for (size_t idx = 0; idx < fileList.size; ++idx) {
     nodeFree(fileList.entries[idx].ast);
+    fileList.entries[idx].ast = NULL;
+    precompiledUnload(&fileList.entries[idx]);
+  }
 
   // blocked ir optimization
   optimizeBlockedIr();
@@ -184,10 +262,14 @@ int main(int argc, char **argv) {
 
   if (options.debugValidateIr &&
       validateBlockedIr("optimization before trace scheduling") != 0)
-    return CODE_IR_ERROR;
+    return finish(CODE_IR_ERROR);
+  if (options.dump == OPTION_DD_BLOCKED_OPTIMIZATION)
+    return finish(CODE_SUCCESS);
 
   // trace scheduling
+  timePhaseStart("trace scheduling");
   traceSchedule();
+  timePhaseEnd();
 
   // debug-dump stop for trace-scheduled IR
   if (options.dump == OPTION_DD_TRACE_SCHEDULING) {
@@ -197,7 +279,8 @@ int main(int argc, char **argv) {
   }
 
   if (options.debugValidateIr && validateScheduledIr("trace scheduling") != 0)
-    return CODE_IR_ERROR;
+    return finish(CODE_IR_ERROR);
+  if (options.dump == OPTION_DD_TRACE_SCHEDULING) return finish(CODE_SUCCESS);
 
   // scheduled ir optimization
   optimizeScheduledIr();
@@ -211,10 +294,84 @@ int main(int argc, char **argv) {
 
   if (options.debugValidateIr &&
       validateScheduledIr("optimization after trace scheduling") != 0)
-    return CODE_IR_ERROR;
+    return finish(CODE_IR_ERROR);
+  if (options.dump == OPTION_DD_SCHEDULED_OPTIMIZATION)
+    return finish(CODE_SUCCESS);
 
   // hand off to arch-specific backend
+  timePhaseStart("backend");
   backend();
+  irFreed = true;
+  timePhaseEnd();
+
+  return finish(CODE_SUCCESS);
+}
 
-  return CODE_SUCCESS;
-}
\ No newline at end of file
+// compile the given declaration and code files into one assembly file per code
+// file, given the flags
+int main(int argc, char **argv) {
+  // handle overriding command line arguments
+  if (helpRequested((size_t)argc, argv)) {
+    printf(
+        "Usage: tlc [options] file...\n"
+        "For more information, see the 'README.md' file.\n"
+        "\n"
+        "Options:\n"
+        "  --help, -h, -?    Display this information, and stop\n"
+        "  --version         Display version information, and stop\n"
+        "  --arch=...        Set the target architecture\n"
+        "  -W...=...         Configure warning options\n"
+        "  -j N              Compile using N threads\n"
+        "  --stream          Compile one code file at a time to save memory\n"
+        "  --pretokenize     Lex each whole file before parsing it\n"
+        "  --time-report     Report time and memory used by each phase\n"
+        "  --time-trace=...  Write a Chrome trace of each phase to a file\n"
+        "  --emit-tdi        Write precompiled declaration modules\n"
+        "  --use-tdi         Load up-to-date precompiled declaration modules\n"
+        "  -MD               Write a make dependency file for each code file\n"
+        "  -MF <file>        With -MD, write all make dependencies to a file\n"
+        "  --incremental=... Skip unchanged code files, using a directory\n"
+        "  --server=...      Run a compile server listening on a socket\n"
+        "  --connect=...     Compile using the server listening on a socket\n"
+        "  --debug-dump=...  Configure debug information\n"
+        "\n"
+        "Please report bugs at "
+        "<https://github.com/JustinHuPrime/TCompiler/issues>\n");
+    return CODE_SUCCESS;
+  } else if (versionRequested((size_t)argc, argv)) {
+    printf(
+        "%s\n"
+        "Copyright 2021 Justin Hu\n"
+        "This is free software; see the source for copying conditions. There "
+        "is NO\n"
+        "warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR "
+        "PURPOSE.\n",
+        VERSION_STRING);
+    return CODE_SUCCESS;
+  }
+
+  // run as or use a compile server
+  char const *serverSocket = findValue((size_t)argc, argv, "--server=");
+  char const *connectSocket = findValue((size_t)argc, argv, "--connect=");
+  if (serverSocket != NULL) {
+    if (argc != 2) {
+      fprintf(stderr, "tlc: error: '--server' takes no other arguments\n");
+      return CODE_OPTION_ERROR;
+    }
+    return serverRun(serverSocket, compile);
+  } else if (connectSocket != NULL) {
+    // forward everything but the socket to the server
+    size_t numArgs = 0;
+    for (size_t idx = 0; idx < (size_t)argc; ++idx) {
+      if (strncmp(argv[idx], "--connect=", 10) != 0)
+        argv[numArgs++] = argv[idx];
+    }
+
+    int code = clientRun(connectSocket, numArgs, (char const *const *)argv);
+    // compile here if the server isn't running
+    if (code == -1) code = compile(numArgs, (char const *const *)argv);
+    return code;
+  }
+
+  return compile((size_t)argc, (char const *const *)argv);
+}
@@ -0,0 +1,949 @@
+// Copyright 2022 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "optimization/constantPropagation.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/internalError.h"
+
+/** what is known about a version */
+typedef enum {
+  LK_UNKNOWN,  /**< not yet written by anything reachable */
+  LK_CONSTANT, /**< always the same value */
+  LK_VARYING,  /**< may have more than one value */
+} LatticeKind;
+typedef struct {
+  LatticeKind kind;
+  uint64_t bits; /**< the value, zero-extended, if constant */
+} LatticeValue;
+
+/** truncate bits to size bytes */
+static uint64_t truncateBits(uint64_t bits, size_t size) {
+  return size >= 8 ? bits : bits & (((uint64_t)1 << (size * 8)) - 1);
+}
+/** sign-extend size bytes of bits */
+static int64_t signExtend(uint64_t bits, size_t size) {
+  if (size >= 8) return (int64_t)bits;
+  uint64_t sign = (uint64_t)1 << (size * 8 - 1);
+  bits = truncateBits(bits, size);
+  return (int64_t)((bits ^ sign) - sign);
+}
+/** reinterpret bits as a float */
+static float bitsToFloat(uint64_t bits) {
+  uint32_t narrow = (uint32_t)bits;
+  float f;
+  memcpy(&f, &narrow, sizeof(float));
+  return f;
+}
+static uint64_t floatToBits(float f) {
+  uint32_t narrow;
+  memcpy(&narrow, &f, sizeof(float));
+  return narrow;
+}
+/** reinterpret bits as a double */
+static double bitsToDouble(uint64_t bits) {
+  double d;
+  memcpy(&d, &bits, sizeof(double));
+  return d;
+}
+static uint64_t doubleToBits(double d) {
+  uint64_t bits;
+  memcpy(&bits, &d, sizeof(double));
+  return bits;
+}
+/** value of a float or double of some size, widened to a double */
+static double floatingValue(uint64_t bits, size_t size) {
+  return size == 4 ? (double)bitsToFloat(bits) : bitsToDouble(bits);
+}
+
+/**
+ * fold floating binary arithmetic
+ *
+ * @returns whether the result could be computed
+ */
+static bool foldFloating(IROperator op, size_t size, uint64_t lhsBits,
+                         uint64_t rhsBits, uint64_t *result) {
+  if (size == 4) {
+    float lhs = bitsToFloat(lhsBits);
+    float rhs = bitsToFloat(rhsBits);
+    switch (op) {
+      case IO_FADD: {
+        *result = floatToBits(lhs + rhs);
+        return true;
+      }
+      case IO_FSUB: {
+        *result = floatToBits(lhs - rhs);
+        return true;
+      }
+      case IO_FMUL: {
+        *result = floatToBits(lhs * rhs);
+        return true;
+      }
+      case IO_FDIV: {
+        *result = floatToBits(lhs / rhs);
+        return true;
+      }
+      default: {
+        return false;
+      }
+    }
+  } else if (size == 8) {
+    double lhs = bitsToDouble(lhsBits);
+    double rhs = bitsToDouble(rhsBits);
+    switch (op) {
+      case IO_FADD: {
+        *result = doubleToBits(lhs + rhs);
+        return true;
+      }
+      case IO_FSUB: {
+        *result = doubleToBits(lhs - rhs);
+        return true;
+      }
+      case IO_FMUL: {
+        *result = doubleToBits(lhs * rhs);
+        return true;
+      }
+      case IO_FDIV: {
+        *result = doubleToBits(lhs / rhs);
+        return true;
+      }
+      default: {
+        return false;
+      }
+    }
+  } else {
+    return false;
+  }
+}
+
+/**
+ * fold an operator applied to constants
+ *
+ * @param op operator to fold - anything with a destination and one or two
+ * sources
+ * @param size size of the destination
+ * @param argSize size of the first source
+ * @param args values of the sources
+ * @param result set to the result, truncated to size
+ * @returns whether the result could be computed at compile time
+ */
+static bool fold(IROperator op, size_t size, size_t argSize,
+                 uint64_t const *args, uint64_t *result) {
+  uint64_t lhs = args[0];
+  uint64_t rhs = args[1];
+  switch (op) {
+    case IO_ADD: {
+      *result = lhs + rhs;
+      break;
+    }
+    case IO_SUB: {
+      *result = lhs - rhs;
+      break;
+    }
+    case IO_SMUL:
+    case IO_UMUL: {
+      // low bits are the same either way
+      *result = lhs * rhs;
+      break;
+    }
+    case IO_UDIV:
+    case IO_UMOD: {
+      if (rhs == 0) return false;
+      *result = op == IO_UDIV ? lhs / rhs : lhs % rhs;
+      break;
+    }
+    case IO_SDIV:
+    case IO_SMOD: {
+      // dividing the minimum by -1 traps, too
+      int64_t signedLhs = signExtend(lhs, size);
+      int64_t signedRhs = signExtend(rhs, size);
+      if (signedRhs == 0 ||
+          (signedRhs == -1 &&
+           signedLhs == signExtend((uint64_t)1 << (size * 8 - 1), size)))
+        return false;
+      *result = (uint64_t)(op == IO_SDIV ? signedLhs / signedRhs
+                                         : signedLhs % signedRhs);
+      break;
+    }
+    case IO_FADD:
+    case IO_FSUB:
+    case IO_FMUL:
+    case IO_FDIV:
+    case IO_FMOD: {
+      if (!foldFloating(op, size, lhs, rhs, result)) return false;
+      break;
+    }
+    case IO_NEG: {
+      *result = -lhs;
+      break;
+    }
+    case IO_FNEG: {
+      if (size != 4 && size != 8) return false;
+      *result = lhs ^ (uint64_t)1 << (size * 8 - 1);
+      break;
+    }
+    case IO_SLL:
+    case IO_SLR:
+    case IO_SAR: {
+      // the target masks the amount - leave that to it
+      if (rhs >= size * 8) return false;
+      if (op == IO_SLL)
+        *result = lhs << rhs;
+      else if (op == IO_SLR)
+        *result = lhs >> rhs;
+      else
+        *result = (uint64_t)(signExtend(lhs, size) >> rhs);
+      break;
+    }
+    case IO_AND: {
+      *result = lhs & rhs;
+      break;
+    }
+    case IO_XOR: {
+      *result = lhs ^ rhs;
+      break;
+    }
+    case IO_OR: {
+      *result = lhs | rhs;
+      break;
+    }
+    case IO_NOT: {
+      *result = ~lhs;
+      break;
+    }
+    case IO_L: {
+      *result = signExtend(lhs, argSize) < signExtend(rhs, argSize);
+      break;
+    }
+    case IO_LE: {
+      *result = signExtend(lhs, argSize) <= signExtend(rhs, argSize);
+      break;
+    }
+    case IO_E: {
+      *result = lhs == rhs;
+      break;
+    }
+    case IO_NE: {
+      *result = lhs != rhs;
+      break;
+    }
+    case IO_G: {
+      *result = signExtend(lhs, argSize) > signExtend(rhs, argSize);
+      break;
+    }
+    case IO_GE: {
+      *result = signExtend(lhs, argSize) >= signExtend(rhs, argSize);
+      break;
+    }
+    case IO_A: {
+      *result = lhs > rhs;
+      break;
+    }
+    case IO_AE: {
+      *result = lhs >= rhs;
+      break;
+    }
+    case IO_B: {
+      *result = lhs < rhs;
+      break;
+    }
+    case IO_BE: {
+      *result = lhs <= rhs;
+      break;
+    }
+    case IO_FL:
+    case IO_FLE:
+    case IO_FE:
+    case IO_FNE:
+    case IO_FG:
+    case IO_FGE: {
+      if (argSize != 4 && argSize != 8) return false;
+      double floatingLhs = floatingValue(lhs, argSize);
+      double floatingRhs = floatingValue(rhs, argSize);
+      // unordered comparisons are up to the target
+      if (isnan(floatingLhs) || isnan(floatingRhs)) return false;
+      bool holds;
+      switch (op) {
+        case IO_FL: {
+          holds = floatingLhs < floatingRhs;
+          break;
+        }
+        case IO_FLE: {
+          holds = floatingLhs <= floatingRhs;
+          break;
+        }
+        case IO_FE: {
+          holds = floatingLhs <= floatingRhs && floatingLhs >= floatingRhs;
+          break;
+        }
+        case IO_FNE: {
+          holds = floatingLhs < floatingRhs || floatingLhs > floatingRhs;
+          break;
+        }
+        case IO_FG: {
+          holds = floatingLhs > floatingRhs;
+          break;
+        }
+        default: {
+          holds = floatingLhs >= floatingRhs;
+          break;
+        }
+      }
+      *result = holds ? 1 : 0;
+      break;
+    }
+    case IO_Z: {
+      *result = lhs == 0;
+      break;
+    }
+    case IO_NZ: {
+      *result = lhs != 0;
+      break;
+    }
+    case IO_FZ:
+    case IO_FNZ: {
+      if (argSize != 4 && argSize != 8) return false;
+      double floatingLhs = floatingValue(lhs, argSize);
+      if (isnan(floatingLhs)) return false;
+      bool isZero = floatingLhs <= 0 && floatingLhs >= 0;
+      *result = isZero == (op == IO_FZ) ? 1 : 0;
+      break;
+    }
+    case IO_LNOT: {
+      if (lhs > 1) return false;
+      *result = lhs ^ 1;
+      break;
+    }
+    case IO_SX: {
+      *result = (uint64_t)signExtend(lhs, argSize);
+      break;
+    }
+    case IO_ZX:
+    case IO_TRUNC: {
+      *result = lhs;
+      break;
+    }
+    case IO_U2F:
+    case IO_S2F: {
+      int64_t signedLhs = signExtend(lhs, argSize);
+      if (size == 4) {
+        *result = floatToBits(op == IO_U2F ? (float)lhs : (float)signedLhs);
+      } else if (size == 8) {
+        *result = doubleToBits(op == IO_U2F ? (double)lhs : (double)signedLhs);
+      } else {
+        return false;
+      }
+      break;
+    }
+    case IO_FRESIZE: {
+      if (argSize == 4 && size == 8)
+        *result = doubleToBits((double)bitsToFloat(lhs));
+      else if (argSize == 8 && size == 4)
+        *result = floatToBits((float)bitsToDouble(lhs));
+      else
+        return false;
+      break;
+    }
+    case IO_F2I: {
+      // only values that mean the same thing signed and unsigned
+      if (argSize != 4 && argSize != 8) return false;
+      double floatingLhs = floatingValue(lhs, argSize);
+      double limit = (double)((uint64_t)1 << (size * 8 - 1));
+      if (!(floatingLhs > -1 && floatingLhs < limit)) return false;
+      *result = (uint64_t)floatingLhs;
+      break;
+    }
+    default: {
+      return false;
+    }
+  }
+  *result = truncateBits(*result, size);
+  return true;
+}
+
+/** the comparison a conditional jump makes */
+static IROperator jumpComparison(IROperator op) {
+  if (op >= IO_J2L && op <= IO_J2BE)
+    return IO_L + (op - IO_J2L);
+  else if (op >= IO_J2FL && op <= IO_J2FGE)
+    return IO_FL + (op - IO_J2FL);
+  else if (op >= IO_J2Z && op <= IO_J2NZ)
+    return IO_Z + (op - IO_J2Z);
+  else if (op >= IO_J2FZ && op <= IO_J2FNZ)
+    return IO_FZ + (op - IO_J2FZ);
+  else
+    return IO_NOP;
+}
+
+/** state of the propagation */
+typedef struct {
+  IRSsa const *ssa;
+  IRCfg const *cfg;
+  LatticeValue *values;   /**< value of each version */
+  size_t *useStart;       /**< start of each version's uses, plus the end */
+  IRInstruction **uses;   /**< instructions reading each version */
+  size_t *useBlocks;      /**< block each use is in */
+  bool *blockExecutable;  /**< has a taken edge reached each block */
+  bool *edgeExecutable;   /**< may each edge be taken - indexed like succs */
+  size_t *edgeWorklist;   /**< edges newly found to be taken */
+  size_t numEdgeWork;     /**< size of edgeWorklist */
+  size_t *valueWorklist;  /**< versions whose values changed */
+  size_t numValueWork;    /**< size of valueWorklist */
+} Propagation;
+
+/** is an operand a version */
+static bool isVersion(Propagation const *p, IROperand const *arg) {
+  return arg->kind == OK_TEMP && arg->data.temp.name >= p->ssa->firstTemp &&
+         arg->data.temp.name - p->ssa->firstTemp < p->ssa->numTemps;
+}
+/** set a lattice value */
+static void latticeSet(LatticeValue *value, LatticeKind kind, uint64_t bits) {
+  value->kind = kind;
+  value->bits = bits;
+}
+/** value of an operand */
+static void operandValue(Propagation const *p, IROperand const *arg,
+                         LatticeValue *value) {
+  latticeSet(value, LK_VARYING, 0);
+  if (isVersion(p, arg)) {
+    *value = p->values[arg->data.temp.name - p->ssa->firstTemp];
+  } else if (arg->kind == OK_CONSTANT && arg->data.constant.data.size == 1) {
+    IRDatum const *datum = arg->data.constant.data.elements[0];
+    switch (datum->type) {
+      case DT_BYTE: {
+        latticeSet(value, LK_CONSTANT, datum->data.byteVal);
+        break;
+      }
+      case DT_SHORT: {
+        latticeSet(value, LK_CONSTANT, datum->data.shortVal);
+        break;
+      }
+      case DT_INT: {
+        latticeSet(value, LK_CONSTANT, datum->data.intVal);
+        break;
+      }
+      case DT_LONG: {
+        latticeSet(value, LK_CONSTANT, datum->data.longVal);
+        break;
+      }
+      default: {
+        // labels and aggregates aren't folded
+        break;
+      }
+    }
+  }
+}
+/**
+ * value of an operator applied to some operands
+ *
+ * @param p propagation state
+ * @param op operator to fold
+ * @param size size of the result
+ * @param args source operands
+ * @param numArgs number of source operands - one or two
+ * @param value set to the value
+ */
+static void foldOperands(Propagation const *p, IROperator op, size_t size,
+                         IROperand *const *args, size_t numArgs,
+                         LatticeValue *value) {
+  uint64_t bits[2] = {0, 0};
+  bool unknown = false;
+  for (size_t idx = 0; idx < numArgs; ++idx) {
+    operandValue(p, args[idx], value);
+    if (value->kind == LK_VARYING)
+      return;
+    else if (value->kind == LK_UNKNOWN)
+      unknown = true;
+    bits[idx] = value->bits;
+  }
+
+  uint64_t result;
+  if (unknown)
+    latticeSet(value, LK_UNKNOWN, 0);
+  else if (fold(op, size, irOperandSizeof(args[0]), bits, &result))
+    latticeSet(value, LK_CONSTANT, result);
+  else
+    latticeSet(value, LK_VARYING, 0);
+}
+/** value written by a non-phi instruction */
+static void instructionValue(Propagation const *p, IRInstruction const *i,
+                             LatticeValue *value) {
+  switch (i->op) {
+    case IO_MOVE: {
+      operandValue(p, i->args[1], value);
+      break;
+    }
+    case IO_ADD:
+    case IO_SUB:
+    case IO_SMUL:
+    case IO_UMUL:
+    case IO_SDIV:
+    case IO_UDIV:
+    case IO_SMOD:
+    case IO_UMOD:
+    case IO_FADD:
+    case IO_FSUB:
+    case IO_FMUL:
+    case IO_FDIV:
+    case IO_FMOD:
+    case IO_SLL:
+    case IO_SLR:
+    case IO_SAR:
+    case IO_AND:
+    case IO_XOR:
+    case IO_OR:
+    case IO_L:
+    case IO_LE:
+    case IO_E:
+    case IO_NE:
+    case IO_G:
+    case IO_GE:
+    case IO_A:
+    case IO_AE:
+    case IO_B:
+    case IO_BE:
+    case IO_FL:
+    case IO_FLE:
+    case IO_FE:
+    case IO_FNE:
+    case IO_FG:
+    case IO_FGE: {
+      foldOperands(p, i->op, irOperandSizeof(i->args[0]), i->args + 1, 2,
+                   value);
+      break;
+    }
+    case IO_NEG:
+    case IO_FNEG:
+    case IO_NOT:
+    case IO_Z:
+    case IO_NZ:
+    case IO_FZ:
+    case IO_FNZ:
+    case IO_LNOT:
+    case IO_SX:
+    case IO_ZX:
+    case IO_TRUNC:
+    case IO_U2F:
+    case IO_S2F:
+    case IO_FRESIZE:
+    case IO_F2I: {
+      foldOperands(p, i->op, irOperandSizeof(i->args[0]), i->args + 1, 1,
+                   value);
+      break;
+    }
+    default: {
+      latticeSet(value, LK_VARYING, 0);
+      break;
+    }
+  }
+}
+/**
+ * which way a conditional jump goes
+ *
+ * @param p propagation state
+ * @param i instruction to check
+ * @param value set to LK_CONSTANT with bits set to whether the jump is taken,
+ * or to LK_UNKNOWN or LK_VARYING
+ */
+static void jumpValue(Propagation const *p, IRInstruction const *i,
+                      LatticeValue *value) {
+  IROperator comparison = jumpComparison(i->op);
+  if (comparison == IO_NOP)
+    latticeSet(value, LK_VARYING, 0);
+  else
+    foldOperands(p, comparison, 1, i->args + 2, i->arity - 2, value);
+}
+/** lower a version's value */
+static void setValue(Propagation *p, IROperand const *version,
+                     LatticeValue const *value) {
+  LatticeValue *old = &p->values[version->data.temp.name - p->ssa->firstTemp];
+  if (old->kind == LK_VARYING || value->kind == LK_UNKNOWN ||
+      (old->kind == LK_CONSTANT && value->kind == LK_CONSTANT &&
+       old->bits == value->bits))
+    return;
+  // two different constants don't agree
+  if (old->kind == LK_CONSTANT)
+    latticeSet(old, LK_VARYING, 0);
+  else
+    *old = *value;
+  p->valueWorklist[p->numValueWork++] =
+      version->data.temp.name - p->ssa->firstTemp;
+}
+/** mark an edge as taken */
+static void markEdge(Propagation *p, size_t edge) {
+  if (p->edgeExecutable[edge]) return;
+  p->edgeExecutable[edge] = true;
+  p->edgeWorklist[p->numEdgeWork++] = edge;
+}
+/** mark every edge from a block to the block with some label as taken */
+static void markEdgesTo(Propagation *p, size_t block, size_t label) {
+  IRCfg const *cfg = p->cfg;
+  for (size_t edge = cfg->succStart[block]; edge < cfg->succStart[block + 1];
+       ++edge) {
+    if (cfg->blocks[cfg->succs[edge]]->label == label) markEdge(p, edge);
+  }
+}
+/** mark every edge from a block as taken */
+static void markAllEdges(Propagation *p, size_t block) {
+  IRCfg const *cfg = p->cfg;
+  for (size_t edge = cfg->succStart[block]; edge < cfg->succStart[block + 1];
+       ++edge)
+    markEdge(p, edge);
+}
+/** is any edge from pred to block taken */
+static bool edgeExecutable(Propagation const *p, size_t pred, size_t block) {
+  IRCfg const *cfg = p->cfg;
+  for (size_t edge = cfg->succStart[pred]; edge < cfg->succStart[pred + 1];
+       ++edge) {
+    if (cfg->succs[edge] == block && p->edgeExecutable[edge]) return true;
+  }
+  return false;
+}
+/** evaluate an instruction in a reachable block */
+static void visit(Propagation *p, size_t block, IRInstruction const *i) {
+  switch (i->op) {
+    case IO_PHI: {
+      // meet of the choices along taken edges
+      LatticeValue value = {LK_UNKNOWN, 0};
+      LatticeValue choice;
+      for (size_t idx = 1; idx < i->arity; idx += 2) {
+        size_t pred = irCfgIndexOf(p->cfg, localOperandName(i->args[idx]));
+        if (pred == p->cfg->numBlocks || !edgeExecutable(p, pred, block))
+          continue;
+        operandValue(p, i->args[idx + 1], &choice);
+        if (choice.kind == LK_UNKNOWN || value.kind == LK_VARYING) {
+          continue;
+        } else if (value.kind == LK_UNKNOWN) {
+          value = choice;
+        } else if (choice.kind == LK_VARYING || choice.bits != value.bits) {
+          value.kind = LK_VARYING;
+        }
+      }
+      if (isVersion(p, i->args[0])) setValue(p, i->args[0], &value);
+      break;
+    }
+    case IO_JUMP: {
+      markEdgesTo(p, block, localOperandName(i->args[0]));
+      break;
+    }
+    case IO_JUMPTABLE:
+    case IO_RETURN: {
+      markAllEdges(p, block);
+      break;
+    }
+    default: {
+      if (jumpComparison(i->op) != IO_NOP) {
+        LatticeValue taken;
+        jumpValue(p, i, &taken);
+        if (taken.kind == LK_CONSTANT)
+          markEdgesTo(p, block, localOperandName(i->args[taken.bits ? 0 : 1]));
+        else if (taken.kind == LK_VARYING)
+          markAllEdges(p, block);
+      } else if (i->arity != 0 && isVersion(p, i->args[0]) &&
+                 irOperandUse(i->op, 0) == OU_WRITE) {
+        LatticeValue value;
+        instructionValue(p, i, &value);
+        setValue(p, i->args[0], &value);
+      }
+      break;
+    }
+  }
+}
+
+/** may a read operand be replaced with a constant */
+static bool takesConstant(IROperator op, size_t idx) {
+  switch (op) {
+    case IO_VOLATILE:
+    case IO_ADDROF:
+    case IO_JUMPTABLE:
+    case IO_CALL: {
+      return false;
+    }
+    case IO_OFFSET_LOAD: {
+      // the source must be a mem temp
+      return idx == 2;
+    }
+    default: {
+      return true;
+    }
+  }
+}
+/** make a constant operand */
+static IROperand *constantCreate(size_t size, uint64_t bits) {
+  IROperand *constant = constantOperandCreate(size);
+  IRDatum *datum;
+  switch (size) {
+    case 1: {
+      datum = byteDatumCreate((uint8_t)bits);
+      break;
+    }
+    case 2: {
+      datum = shortDatumCreate((uint16_t)bits);
+      break;
+    }
+    case 4: {
+      datum = intDatumCreate((uint32_t)bits);
+      break;
+    }
+    case 8: {
+      datum = longDatumCreate(bits);
+      break;
+    }
+    default: {
+      error(__FILE__, __LINE__, "invalid constant size");
+    }
+  }
+  vectorInsert(&constant->data.constant.data, datum);
+  return constant;
+}
+/** a version's value, if it's a constant that can be written out */
+static bool constantValue(Propagation const *p, IROperand const *arg,
+                          uint64_t *bits) {
+  if (!isVersion(p, arg)) return false;
+  size_t size = irOperandSizeof(arg);
+  if (size != 1 && size != 2 && size != 4 && size != 8) return false;
+  LatticeValue value = p->values[arg->data.temp.name - p->ssa->firstTemp];
+  *bits = value.bits;
+  return value.kind == LK_CONSTANT;
+}
+/** replace an operand with a constant, if it's a constant version */
+static void replaceWithConstant(Propagation const *p, IROperand **arg) {
+  uint64_t bits;
+  if (!constantValue(p, *arg, &bits)) return;
+  IROperand *constant = constantCreate(irOperandSizeof(*arg), bits);
+  irOperandFree(*arg);
+  *arg = constant;
+}
+/** make a MOVE of a constant into a version */
+static IRInstruction *constantMoveCreate(IROperand *dest, uint64_t bits) {
+  IRInstruction *move = irInstructionCreate(IO_MOVE);
+  move->args[0] = dest;
+  move->args[1] = constantCreate(irOperandSizeof(dest), bits);
+  return move;
+}
+/**
+ * rewrite a reachable block with what's known
+ *
+ * @returns whether the block's jump changed
+ */
+static bool rewriteBlock(Propagation const *p, size_t block) {
+  IRCfg const *cfg = p->cfg;
+  LinkedList *instructions = &cfg->blocks[block]->instructions;
+  ListNode *body = instructions->head->next;
+  while (body != instructions->tail &&
+         ((IRInstruction const *)body->data)->op == IO_PHI)
+    body = body->next;
+
+  // phis - drop choices along edges never taken, and replace constant ones
+  // with MOVEs after the rest
+  for (ListNode *curr = instructions->head->next; curr != body;) {
+    IRInstruction *phi = curr->data;
+    ListNode *next = curr->next;
+
+    size_t kept = 1;
+    for (size_t idx = 1; idx < phi->arity; idx += 2) {
+      size_t pred = irCfgIndexOf(cfg, localOperandName(phi->args[idx]));
+      if (pred != cfg->numBlocks && edgeExecutable(p, pred, block)) {
+        phi->args[kept++] = phi->args[idx];
+        phi->args[kept++] = phi->args[idx + 1];
+      } else {
+        irOperandFree(phi->args[idx]);
+        irOperandFree(phi->args[idx + 1]);
+      }
+    }
+    phi->arity = kept;
+
+    uint64_t bits;
+    if (constantValue(p, phi->args[0], &bits)) {
+      insertNodeBefore(body, constantMoveCreate(phi->args[0], bits));
+      phi->args[0] = NULL;
+      irInstructionFree(removeNode(curr));
+    } else {
+      for (size_t idx = 2; idx < phi->arity; idx += 2)
+        replaceWithConstant(p, &phi->args[idx]);
+    }
+
+    curr = next;
+  }
+
+  bool changed = false;
+  for (ListNode *curr = body; curr != instructions->tail; curr = curr->next) {
+    IRInstruction *i = curr->data;
+
+    uint64_t bits;
+    if (i->op != IO_MOVE && i->arity != 0 &&
+        irOperandUse(i->op, 0) == OU_WRITE &&
+        constantValue(p, i->args[0], &bits)) {
+      // folded
+      curr->data = constantMoveCreate(i->args[0], bits);
+      i->args[0] = NULL;
+      irInstructionFree(i);
+      continue;
+    }
+
+    LatticeValue taken;
+    jumpValue(p, i, &taken);
+    if (taken.kind == LK_CONSTANT) {
+      IRInstruction *jump = irInstructionCreate(IO_JUMP);
+      jump->args[0] = i->args[taken.bits ? 0 : 1];
+      i->args[taken.bits ? 0 : 1] = NULL;
+      curr->data = jump;
+      irInstructionFree(i);
+      changed = true;
+      continue;
+    }
+
+    for (size_t idx = 0; idx < i->arity; ++idx) {
+      if (irOperandUse(i->op, idx) == OU_READ && takesConstant(i->op, idx))
+        replaceWithConstant(p, &i->args[idx]);
+    }
+  }
+  return changed;
+}
+
+bool constantPropagation(IRSsa const *ssa, IRCfg const *cfg) {
+  size_t numTemps = ssa->numTemps;
+  size_t numBlocks = cfg->numBlocks;
+  size_t numEdges = cfg->succStart[numBlocks];
+  if (numBlocks == 0) return false;
+
+  Propagation p;
+  p.ssa = ssa;
+  p.cfg = cfg;
+
+  // versions start unknown, except ones nothing writes - those are read before
+  // being written, and could be anything
+  p.values = malloc(sizeof(LatticeValue) * numTemps);
+  for (size_t version = 0; version < numTemps; ++version)
+    latticeSet(&p.values[version], LK_VARYING, 0);
+  p.useStart = calloc(numTemps + 1, sizeof(size_t));
+  for (size_t block = 0; block < numBlocks; ++block) {
+    LinkedList const *instructions = &cfg->blocks[block]->instructions;
+    for (ListNode *curr = instructions->head->next; curr != instructions->tail;
+         curr = curr->next) {
+      IRInstruction const *i = curr->data;
+      for (size_t idx = 0; idx < i->arity; ++idx) {
+        IROperand const *arg = i->args[idx];
+        if (!isVersion(&p, arg)) continue;
+        size_t version = arg->data.temp.name - ssa->firstTemp;
+        switch (irOperandUse(i->op, idx)) {
+          case OU_READ: {
+            ++p.useStart[version + 1];
+            break;
+          }
+          case OU_WRITE: {
+            p.values[version].kind = LK_UNKNOWN;
+            break;
+          }
+          default: {
+            error(__FILE__, __LINE__, "version used in part");
+          }
+        }
+      }
+    }
+  }
+  size_t *next = malloc(sizeof(size_t) * numTemps);
+  for (size_t version = 0; version < numTemps; ++version) {
+    p.useStart[version + 1] += p.useStart[version];
+    next[version] = p.useStart[version];
+  }
+  p.uses = malloc(sizeof(IRInstruction *) * p.useStart[numTemps]);
+  p.useBlocks = malloc(sizeof(size_t) * p.useStart[numTemps]);
+  for (size_t block = 0; block < numBlocks; ++block) {
+    LinkedList const *instructions = &cfg->blocks[block]->instructions;
+    for (ListNode *curr = instructions->head->next; curr != instructions->tail;
+         curr = curr->next) {
+      IRInstruction *i = curr->data;
+      for (size_t idx = 0; idx < i->arity; ++idx) {
+        IROperand const *arg = i->args[idx];
+        if (isVersion(&p, arg) && irOperandUse(i->op, idx) == OU_READ) {
+          size_t use = next[arg->data.temp.name - ssa->firstTemp]++;
+          p.uses[use] = i;
+          p.useBlocks[use] = block;
+        }
+      }
+    }
+  }
+  free(next);
+
+  // propagate from the entry block - each edge is taken at most once, and
+  // each version changes at most twice
+  p.blockExecutable = calloc(numBlocks, sizeof(bool));
+  p.edgeExecutable = calloc(numEdges, sizeof(bool));
+  p.edgeWorklist = malloc(sizeof(size_t) * numEdges);
+  p.numEdgeWork = 0;
+  p.valueWorklist = malloc(sizeof(size_t) * 2 * numTemps);
+  p.numValueWork = 0;
+  p.blockExecutable[0] = true;
+  LinkedList const *entry = &cfg->blocks[0]->instructions;
+  for (ListNode *curr = entry->head->next; curr != entry->tail;
+       curr = curr->next)
+    visit(&p, 0, curr->data);
+  while (p.numEdgeWork != 0 || p.numValueWork != 0) {
+    if (p.numEdgeWork != 0) {
+      size_t block = cfg->succs[p.edgeWorklist[--p.numEdgeWork]];
+      // the first edge in reaches the whole block; later ones only change
+      // the phis
+      bool first = !p.blockExecutable[block];
+      p.blockExecutable[block] = true;
+      LinkedList const *instructions = &cfg->blocks[block]->instructions;
+      for (ListNode *curr = instructions->head->next;
+           curr != instructions->tail &&
+           (first || ((IRInstruction const *)curr->data)->op == IO_PHI);
+           curr = curr->next)
+        visit(&p, block, curr->data);
+    } else {
+      size_t version = p.valueWorklist[--p.numValueWork];
+      for (size_t use = p.useStart[version]; use < p.useStart[version + 1];
+           ++use) {
+        if (p.blockExecutable[p.useBlocks[use]])
+          visit(&p, p.useBlocks[use], p.uses[use]);
+      }
+    }
+  }
+
+  // rewrite - unreachable blocks just lose their phis, since their
+  // predecessors won't go there any more
+  bool changed = false;
+  for (size_t block = 0; block < numBlocks; ++block) {
+    if (p.blockExecutable[block]) {
+      changed = rewriteBlock(&p, block) || changed;
+    } else {
+      LinkedList *instructions = &cfg->blocks[block]->instructions;
+      while (instructions->head->next != instructions->tail &&
+             ((IRInstruction const *)instructions->head->next->data)->op ==
+                 IO_PHI)
+        irInstructionFree(removeNode(instructions->head->next));
+    }
+  }
+
+  free(p.valueWorklist);
+  free(p.edgeWorklist);
+  free(p.edgeExecutable);
+  free(p.blockExecutable);
+  free(p.useBlocks);
+  free(p.uses);
+  free(p.useStart);
+  free(p.values);
+  return changed;
+}
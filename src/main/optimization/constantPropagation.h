@@ -0,0 +1,55 @@
+// Copyright 2022 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/**
+ * @file
+ * sparse conditional constant propagation
+ */
+
+#ifndef TLC_OPTIMIZATION_CONSTANTPROPAGATION_H_
+#define TLC_OPTIMIZATION_CONSTANTPROPAGATION_H_
+
+#include <stdbool.h>
+
+#include "ir/ir.h"
+#include "ir/ssa.h"
+
+/**
+ * propagate and fold constants through a fragment in SSA form
+ *
+ * Versions start out unknown and blocks start out unreachable; only writes in
+ * blocks some taken jump reaches, and phi choices along taken edges, are
+ * evaluated (Wegman and Zadeck). Constants are folded with the same wrapping,
+ * extension, and IEEE semantics the target uses, and anything that would trap
+ * or is left to the target (division by zero, out-of-range shifts and
+ * conversions, NaN comparisons) is left alone.
+ *
+ * Afterwards, reads of constant versions become the constant, other writes of
+ * constant versions become MOVEs of the constant, conditional jumps that always
+ * go the same way become JUMPs, and phis in unreachable blocks, and choices
+ * along edges never taken, are removed. Unreachable blocks are left for dead
+ * block elimination.
+ *
+ * @param ssa SSA information for the fragment
+ * @param cfg control flow graph of the fragment - its blocks are mutated
+ * @returns whether any jumps changed, so the graph needs to be rebuilt
+ */
+bool constantPropagation(IRSsa const *ssa, IRCfg const *cfg);
+
+#endif  // TLC_OPTIMIZATION_CONSTANTPROPAGATION_H_
@@ -19,9 +19,25 @@
 
 #include "optimization/optimization.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "fileList.h"
+#include "ir/dataflow.h"
 #include "ir/ir.h"
+#include "ir/ssa.h"
+#include "optimization/constantPropagation.h"
+#include "options.h"
+#include "util/container/bitSet.h"
 #include "util/internalError.h"
+#include "util/threadPool.h"
+#include "util/timeReport.h"
+
+/** what a blocked optimization may use besides the fragment itself */
+typedef struct {
+  FileListEntry *file; /**< file the fragment is from */
+  IRFragIndex frags;   /**< index of the file's fragments */
+} BlockedOptimizationContext;
 
 /**
  * short-circuit unconditional-jump-to-any-jump
@@ -48,43 +64,48 @@
  *   JUMP(_B_) | BJUMP(_B_) | CJUMP(_B_)
  * }
  *
- * @param blocks blocks to apply optimization to (mutated)
+ * @param frag fragment to apply optimization to (mutated)
+ * @param context file and fragment index the fragment is from
  */
-static void shortCircuitJumps(LinkedList *blocks) {
+static void shortCircuitJumps(IRFrag *frag,
+                              BlockedOptimizationContext const *context) {
+  LinkedList *blocks = &frag->data.text.blocks;
+
+  IRCfg cfg;
+  irCfgInit(&cfg, blocks, &context->frags);
+
   /**
    * mapping between block index and its single jump instruction
    */
   IRInstruction **shortCircuits =
-      malloc(sizeof(IRInstruction *) * linkedListLength(blocks));
+      malloc(sizeof(IRInstruction *) * cfg.numBlocks);
 
-  size_t idx = 0;
-  for (ListNode *curr = blocks->head->next; curr != blocks->tail;
-       curr = curr->next) {
+  for (size_t idx = 0; idx < cfg.numBlocks; ++idx) {
     // for each block, if it only contains a jump, note that down in
     // shortCircuits
     // NOTE: blocks must contain at least one instruction, and that one
     // instruction must be some sort of jump
-    IRBlock *b = curr->data;
+    IRBlock *b = cfg.blocks[idx];
     if (b->instructions.head->next->next == b->instructions.tail)
       shortCircuits[idx] = b->instructions.head->next->data;
     else
       shortCircuits[idx] = NULL;
-    ++idx;
   }
 
   // iterate until no more changes happen
   bool changed = true;
   while (changed) {
     changed = false;
-    for (ListNode *curr = blocks->head->next; curr != blocks->tail;
-         curr = curr->next) {
+    for (size_t idx = 0; idx < cfg.numBlocks; ++idx) {
       // for each block, if it's last jump is an unconditional jump
-      IRBlock *b = curr->data;
+      IRBlock *b = cfg.blocks[idx];
       IRInstruction *last = b->instructions.tail->prev->data;
       if (last->op == IO_JUMP) {
         IROperand *targetArg = last->args[0];
         if (irOperandIsLocal(targetArg)) {
-          size_t target = indexOfBlock(blocks, localOperandName(targetArg));
+          size_t target = irCfgIndexOf(&cfg, localOperandName(targetArg));
+          if (target == cfg.numBlocks)
+            error(__FILE__, __LINE__, "given block label doesn't exist");
           if (shortCircuits[target] != NULL) {
             irInstructionFree(last);
             b->instructions.tail->prev->data =
@@ -97,93 +118,59 @@ static void shortCircuitJumps(LinkedList *blocks) {
   }
 
   free(shortCircuits);
+  irCfgUninit(&cfg);
 }
 
 /**
- * mark this block and everything reachable from here as reachable
+ * mark a block and everything reachable from there as reachable
+ *
+ * @param cfg graph of the blocks
+ * @param start index of the block to start from
+ * @param seen which blocks have been marked
+ * @param stack space for the blocks left to visit - one per block
  */
-static void markReachable(IRBlock *b, bool *seen, LinkedList *blocks,
-                          Vector *frags) {
-  if (seen[indexOfBlock(blocks, b->label)] == true)
-    return;  // we've been here before - break cycle
-
-  seen[indexOfBlock(blocks, b->label)] = true;
-  IRInstruction *last = b->instructions.tail->prev->data;
-  switch (last->op) {
-    case IO_JUMP: {
-      markReachable(findBlock(blocks, localOperandName(last->args[0])), seen,
-                    blocks, frags);
-      break;
-    }
-    case IO_JUMPTABLE: {
-      IRFrag *table = findFrag(frags, localOperandName(last->args[1]));
-      for (size_t idx = 0; idx < table->data.data.data.size; ++idx) {
-        IRDatum *datum = table->data.data.data.elements[idx];
-        markReachable(findBlock(blocks, datum->data.localLabel), seen, blocks,
-                      frags);
+static void markReachable(IRCfg const *cfg, size_t start, bool *seen,
+                          size_t *stack) {
+  if (seen[start]) return;  // we've been here before - break cycle
+
+  seen[start] = true;
+  size_t stackSize = 0;
+  stack[stackSize++] = start;
+  while (stackSize != 0) {
+    size_t idx = stack[--stackSize];
+    for (size_t edge = cfg->succStart[idx]; edge < cfg->succStart[idx + 1];
+         ++edge) {
+      size_t succ = cfg->succs[edge];
+      if (!seen[succ]) {
+        seen[succ] = true;
+        stack[stackSize++] = succ;
       }
-      break;
-    }
-    case IO_J2L:
-    case IO_J2LE:
-    case IO_J2E:
-    case IO_J2NE:
-    case IO_J2G:
-    case IO_J2GE:
-    case IO_J2A:
-    case IO_J2AE:
-    case IO_J2B:
-    case IO_J2BE:
-    case IO_J2FL:
-    case IO_J2FLE:
-    case IO_J2FE:
-    case IO_J2FNE:
-    case IO_J2FG:
-    case IO_J2FGE:
-    case IO_J2Z:
-    case IO_J2NZ:
-    case IO_J2FZ:
-    case IO_J2FNZ: {
-      markReachable(findBlock(blocks, localOperandName(last->args[0])), seen,
-                    blocks, frags);
-      markReachable(findBlock(blocks, localOperandName(last->args[1])), seen,
-                    blocks, frags);
-      break;
-    }
-    default: {
-      // leaves the function - we're done here
-      break;
     }
   }
 }
 /**
  * dead block elimination
  */
-static void deadBlockElimination(LinkedList *blocks, Vector *frags) {
+static void deadBlockElimination(IRFrag *frag,
+                                 BlockedOptimizationContext const *context) {
+  IRFragIndex const *frags = &context->frags;
+  LinkedList *blocks = &frag->data.text.blocks;
+
+  IRCfg cfg;
+  irCfgInit(&cfg, blocks, frags);
+
   // mark all of the blocks we jump to as seen
-  bool *seen = calloc(linkedListLength(blocks), sizeof(bool));
-  markReachable(blocks->head->next->data, seen, blocks, frags);
+  bool *seen = calloc(cfg.numBlocks, sizeof(bool));
+  size_t *stack = malloc(sizeof(size_t) * cfg.numBlocks);
+  markReachable(&cfg, 0, seen, stack);
 
   // deal with jump tables
-  // TODO: refactor out of per-frag loop
-  for (size_t fragIdx = 0; fragIdx < frags->size; ++fragIdx) {
-    IRFrag *f = frags->elements[fragIdx];
-    switch (f->type) {
-      case FT_RODATA: {
-        Vector *data = &f->data.data.data;
-        for (size_t datumIdx = 0; datumIdx < data->size; ++datumIdx) {
-          IRDatum *datum = data->elements[datumIdx];
-          if (datum->type == DT_LOCAL) {
-            IRBlock *found = findBlock(blocks, datum->data.localLabel);
-            if (found != NULL) markReachable(found, seen, blocks, frags);
-          }
-        }
-      }
-      default: {
-        break;
-      }
-    }
+  for (size_t idx = 0; idx < cfg.numBlocks; ++idx) {
+    size_t label = cfg.blocks[idx]->label;
+    if (label < frags->numLabels && frags->dataTargets[label])
+      markReachable(&cfg, idx, seen, stack);
   }
+  free(stack);
 
   size_t idx = 0;
   for (ListNode *curr = blocks->head->next; curr != blocks->tail;) {
@@ -198,321 +185,203 @@ static void deadBlockElimination(LinkedList *blocks, Vector *frags) {
   }
 
   free(seen);
+  irCfgUninit(&cfg);
 }
 
-static void markTempUse(bool *seen, IROperand *arg) {
-  if (arg->kind == OK_TEMP) seen[arg->data.temp.name] = true;
-}
-static bool writesDeadTemp(bool *seen, IROperand *target) {
-  return target->kind == OK_TEMP && !seen[target->data.temp.name];
-}
 /**
  * dead temp elimination
+ *
+ * removes writes to temps that aren't live afterwards, along with any NOPs;
+ * removing one write can make the writes feeding it dead, so liveness is
+ * recomputed until nothing changes
  */
-static void deadTempElimination(LinkedList *blocks, size_t maxTemps) {
+static void deadTempElimination(IRFrag *frag,
+                                BlockedOptimizationContext const *context) {
+  IRCfg cfg;
+  irCfgInit(&cfg, &frag->data.text.blocks, &context->frags);
+  uint64_t *live = bitSetCreate(frag->data.text.numIds);
+
   bool changed = true;
   while (changed) {
     changed = false;
-    bool *seen = calloc(maxTemps, sizeof(bool));
-
-    for (ListNode *currBlock = blocks->head->next; currBlock != blocks->tail;
-         currBlock = currBlock->next) {
-      IRBlock *block = currBlock->data;
-      for (ListNode *currInst = block->instructions.head->next;
-           currInst != block->instructions.tail; currInst = currInst->next) {
-        IRInstruction *i = currInst->data;
-        switch (i->op) {
-          case IO_VOLATILE: {
-            markTempUse(seen, i->args[0]);
-            break;
-          }
-          case IO_ADDROF: {
-            // this means the value in the temp *might* be visible elsewhere
-            markTempUse(seen, i->args[0]);
-            break;
-          }
-          case IO_MOVE: {
-            markTempUse(seen, i->args[1]);
-            break;
-          }
-          case IO_MEM_STORE: {
-            markTempUse(seen, i->args[0]);
-            markTempUse(seen, i->args[1]);
-            markTempUse(seen, i->args[2]);
-            break;
-          }
-          case IO_MEM_LOAD: {
-            markTempUse(seen, i->args[1]);
-            markTempUse(seen, i->args[2]);
-            break;
-          }
-          case IO_STK_STORE: {
-            markTempUse(seen, i->args[0]);
-            markTempUse(seen, i->args[1]);
-            break;
-          }
-          case IO_STK_LOAD: {
-            markTempUse(seen, i->args[1]);
-            break;
-          }
-          case IO_OFFSET_STORE:
-          case IO_OFFSET_LOAD: {
-            markTempUse(seen, i->args[1]);
-            markTempUse(seen, i->args[2]);
-            break;
-          }
-          case IO_ADD:
-          case IO_SUB:
-          case IO_SMUL:
-          case IO_UMUL:
-          case IO_SDIV:
-          case IO_UDIV:
-          case IO_SMOD:
-          case IO_UMOD:
-          case IO_FADD:
-          case IO_FSUB:
-          case IO_FMUL:
-          case IO_FDIV:
-          case IO_FMOD:
-          case IO_SLL:
-          case IO_SLR:
-          case IO_SAR:
-          case IO_AND:
-          case IO_XOR:
-          case IO_OR:
-          case IO_L:
-          case IO_LE:
-          case IO_E:
-          case IO_NE:
-          case IO_G:
-          case IO_GE:
-          case IO_A:
-          case IO_AE:
-          case IO_B:
-          case IO_BE:
-          case IO_FL:
-          case IO_FLE:
-          case IO_FE:
-          case IO_FNE:
-          case IO_FG:
-          case IO_FGE: {
-            markTempUse(seen, i->args[1]);
-            markTempUse(seen, i->args[2]);
-            break;
-          }
-          case IO_NEG:
-          case IO_FNEG:
-          case IO_NOT:
-          case IO_Z:
-          case IO_NZ:
-          case IO_FZ:
-          case IO_FNZ:
-          case IO_LNOT:
-          case IO_SX:
-          case IO_ZX:
-          case IO_TRUNC:
-          case IO_U2F:
-          case IO_S2F:
-          case IO_FRESIZE:
-          case IO_F2I: {
-            markTempUse(seen, i->args[1]);
-            break;
-          }
-          case IO_JUMP: {
-            markTempUse(seen, i->args[0]);
-            break;
-          }
-          case IO_J2L:
-          case IO_J2LE:
-          case IO_J2E:
-          case IO_J2NE:
-          case IO_J2G:
-          case IO_J2GE:
-          case IO_J2A:
-          case IO_J2AE:
-          case IO_J2B:
-          case IO_J2BE:
-          case IO_J2FL:
-          case IO_J2FLE:
-          case IO_J2FE:
-          case IO_J2FNE:
-          case IO_J2FG:
-          case IO_J2FGE: {
-            markTempUse(seen, i->args[2]);
-            markTempUse(seen, i->args[3]);
-            break;
-          }
-          case IO_J2Z:
-          case IO_J2NZ:
-          case IO_J2FZ:
-          case IO_J2FNZ: {
-            markTempUse(seen, i->args[1]);
-            markTempUse(seen, i->args[2]);
-            break;
-          }
-          case IO_CALL: {
-            markTempUse(seen, i->args[0]);
-            break;
-          }
-          default: {
-            // no temp read
-            break;
-          }
-        }
-      }
-    }
+    Liveness liveness;
+    livenessInit(&liveness, &cfg, frag->data.text.firstId,
+                 frag->data.text.numIds);
 
-    for (ListNode *currBlock = blocks->head->next; currBlock != blocks->tail;
-         currBlock = currBlock->next) {
-      IRBlock *block = currBlock->data;
-      for (ListNode *currInst = block->instructions.head->next;
-           currInst != block->instructions.tail; currInst = currInst->next) {
-        IRInstruction *i = currInst->data;
-        switch (i->op) {
-          case IO_UNINITIALIZED:
-          case IO_ADDROF:
-          case IO_MOVE:
-          case IO_MEM_LOAD:
-          case IO_STK_LOAD:
-          case IO_OFFSET_STORE:
-          case IO_OFFSET_LOAD:
-          case IO_ADD:
-          case IO_SUB:
-          case IO_SMUL:
-          case IO_UMUL:
-          case IO_SDIV:
-          case IO_UDIV:
-          case IO_SMOD:
-          case IO_UMOD:
-          case IO_FADD:
-          case IO_FSUB:
-          case IO_FMUL:
-          case IO_FDIV:
-          case IO_FMOD:
-          case IO_NEG:
-          case IO_FNEG:
-          case IO_SLL:
-          case IO_SLR:
-          case IO_SAR:
-          case IO_AND:
-          case IO_XOR:
-          case IO_OR:
-          case IO_NOT:
-          case IO_L:
-          case IO_LE:
-          case IO_E:
-          case IO_NE:
-          case IO_G:
-          case IO_GE:
-          case IO_A:
-          case IO_AE:
-          case IO_B:
-          case IO_BE:
-          case IO_FL:
-          case IO_FLE:
-          case IO_FE:
-          case IO_FNE:
-          case IO_FG:
-          case IO_FGE:
-          case IO_Z:
-          case IO_NZ:
-          case IO_FZ:
-          case IO_FNZ:
-          case IO_LNOT:
-          case IO_SX:
-          case IO_ZX:
-          case IO_TRUNC:
-          case IO_U2F:
-          case IO_S2F:
-          case IO_FRESIZE:
-          case IO_F2I: {
-            if (writesDeadTemp(seen, i->args[0])) {
-              irInstructionMakeNop(i);
-              changed = true;
-            }
-            break;
-          }
-          default: {
-            // doesn't involve a write
-            break;
-          }
+    for (size_t idx = 0; idx < cfg.numBlocks; ++idx) {
+      LinkedList *instructions = &cfg.blocks[idx]->instructions;
+      bitSetCopy(live, livenessOut(&liveness, idx), liveness.numIds);
+      ListNode *curr = instructions->tail->prev;
+      while (curr != instructions->head) {
+        IRInstruction *i = curr->data;
+        ListNode *prev = curr->prev;
+        bool dead = i->op == IO_NOP;
+        if (!dead && i->arity != 0 && i->args[0]->kind == OK_TEMP) {
+          OperandUse use = irOperandUse(i->op, 0);
+          dead = (use == OU_WRITE || use == OU_PARTIAL_WRITE) &&
+                 !livenessIsLive(&liveness, live, i->args[0]);
         }
+        if (dead) {
+          // its reads go with it, so live is unchanged
+          irInstructionFree(removeNode(curr));
+          changed = true;
+          curr = prev;
+          continue;
+        }
+        livenessStep(&liveness, live, i);
+        curr = prev;
       }
     }
 
-    free(seen);
+    livenessUninit(&liveness);
   }
+
+  free(live);
+  irCfgUninit(&cfg);
 }
 
-void optimizeBlockedIr(void) {
-  for (size_t fileIdx = 0; fileIdx < fileList.size; ++fileIdx) {
-    FileListEntry *file = &fileList.entries[fileIdx];
-    Vector *irFrags = &fileList.entries[fileIdx].irFrags;
-    for (size_t fragIdx = 0; fragIdx < irFrags->size; ++fragIdx) {
-      IRFrag *frag = irFrags->elements[fragIdx];
-      if (frag->type == FT_TEXT) {
-        LinkedList *blocks = &frag->data.text.blocks;
-        // TODO: (difficult) inlining
-        // TODO: (difficult) constant propogation
-        // (if only ever used in context where a constant can be used, may
-        // replace temp with constant)
-        // TODO: (difficult) loop-invariant hoisting
-        // (if some expression doesn't change across loop iterations, compute it
-        // outside of the loop)
-        // TODO: (difficult) loop induction variables
-        // (only keep one iteration count for the loop, or reduce for loops to
-        // start and end pointer loops)
-        // TODO: (difficult) common subexpression elimination
-        // (if two expressions are the same, only compute them once)
-        // TODO: (difficult) copy propagation
-        // (if tempB is moved to tempA and tempB isn't changed afterwards,
-        // replace all instances of tempA afterwards with tempB)
-        // TODO: (difficult) tail call optimization
-        shortCircuitJumps(blocks);
-        deadBlockElimination(blocks, irFrags);
-        // TODO: dead label elimination
-        deadTempElimination(blocks, file->nextId);
-      }
-    }
+/**
+ * static single assignment optimizations
+ *
+ * puts the fragment into SSA form, propagates constants, then takes it back
+ * out again
+ *
+ * With --debug-validate-ir, the file is validated at each step, so a broken
+ * phi is reported by the step that made it - errors are recorded in the file
+ */
+static void ssaOptimizations(IRFrag *frag,
+                             BlockedOptimizationContext const *context) {
+  FileListEntry *file = context->file;
+  IRFragIndex const *frags = &context->frags;
+  IRCfg cfg;
+  irCfgInit(&cfg, &frag->data.text.blocks, frags);
+  IRSsa ssa;
+  irSsaConstruct(&ssa, frag, &cfg, file);
+  if (options.debugValidateIr) validateFileBlockedIr(file, "SSA construction");
+  if (constantPropagation(&ssa, &cfg)) {
+    irCfgUninit(&cfg);
+    irCfgInit(&cfg, &frag->data.text.blocks, frags);
+    if (options.debugValidateIr)
+      validateFileBlockedIr(file, "constant propagation");
   }
+  irSsaDestruct(&ssa, frag, &cfg, file);
+  irCfgUninit(&cfg);
+  if (options.debugValidateIr) validateFileBlockedIr(file, "SSA destruction");
 }
 
-static void deadLabelElimination(LinkedList *instructions, Vector *frags,
-                                 size_t maxLabels) {
-  // mark all of the blocks we jump to as seen
-  bool *seen = calloc(maxLabels, sizeof(bool));
+/** a blocked IR optimization, applied to one text fragment at a time */
+typedef struct {
+  char const *name; /**< name of the optimization, for the time report */
+  void (*apply)(IRFrag *frag, BlockedOptimizationContext const *context);
+} BlockedOptimization;
 
-  // deal with jump tables
-  // TODO: refactor out of per-frag loop
-  for (size_t fragIdx = 0; fragIdx < frags->size; ++fragIdx) {
-    IRFrag *f = frags->elements[fragIdx];
-    switch (f->type) {
-      case FT_RODATA: {
-        Vector *data = &f->data.data.data;
-        for (size_t datumIdx = 0; datumIdx < data->size; ++datumIdx) {
-          IRDatum *datum = data->elements[datumIdx];
-          if (datum->type == DT_LOCAL) seen[datum->data.localLabel] = true;
-        }
-      }
-      default: {
-        break;
-      }
+static BlockedOptimization const BLOCKED_OPTIMIZATIONS[] = {
+    {"blocked optimization: short circuit jumps", shortCircuitJumps},
+    {"blocked optimization: dead block elimination", deadBlockElimination},
+    {"blocked optimization: static single assignment", ssaOptimizations},
+    {"blocked optimization: short circuit jumps", shortCircuitJumps},
+    {"blocked optimization: dead block elimination", deadBlockElimination},
+    // TODO: dead label elimination
+    {"blocked optimization: dead temp elimination", deadTempElimination},
+};
+
+/**
+ * applies one blocked optimization to a file
+ */
+static void applyBlockedOptimization(BlockedOptimization const *optimization,
+                                     FileListEntry *file) {
+  Vector *irFrags = &file->irFrags;
+  BlockedOptimizationContext context;
+  context.file = file;
+  irFragIndexInit(&context.frags, irFrags, file->nextId);
+  for (size_t fragIdx = 0; fragIdx < irFrags->size; ++fragIdx) {
+    IRFrag *frag = irFrags->elements[fragIdx];
+    if (frag->type == FT_TEXT) {
+      irArenaSet(frag->data.text.arena);
+      optimization->apply(frag, &context);
+      irArenaSet(NULL);
     }
   }
+  irFragIndexUninit(&context.frags);
+}
+
+static void applyBlockedOptimizationTask(size_t fileIdx, void *data) {
+  size_t const *optimizationIdx = data;
+  applyBlockedOptimization(&BLOCKED_OPTIMIZATIONS[*optimizationIdx],
+                           &fileList.entries[fileIdx]);
+}
+
+void optimizeBlockedIr(void) {
+  // TODO: (difficult) inlining
+  // TODO: (difficult) loop-invariant hoisting
+  // (if some expression doesn't change across loop iterations, compute it
+  // outside of the loop)
+  // TODO: (difficult) loop induction variables
+  // (only keep one iteration count for the loop, or reduce for loops to
+  // start and end pointer loops)
+  // TODO: (difficult) common subexpression elimination
+  // (if two expressions are the same, only compute them once)
+  // TODO: (difficult) copy propagation
+  // (if tempB is moved to tempA and tempB isn't changed afterwards,
+  // replace all instances of tempA afterwards with tempB)
+  // TODO: (difficult) tail call optimization
+  for (size_t idx = 0;
+       idx < sizeof(BLOCKED_OPTIMIZATIONS) / sizeof(BlockedOptimization);
+       ++idx) {
+    timePhaseStart(BLOCKED_OPTIMIZATIONS[idx].name);
+    threadPoolRun(fileList.size, applyBlockedOptimizationTask, &idx);
+    timePhaseEnd();
+  }
+}
+
+void optimizeBlockedIrFile(FileListEntry *file) {
+  for (size_t idx = 0;
+       idx < sizeof(BLOCKED_OPTIMIZATIONS) / sizeof(BlockedOptimization);
+       ++idx)
+    applyBlockedOptimization(&BLOCKED_OPTIMIZATIONS[idx], file);
+}
+
+/**
+ * dead label elimination
+ *
+ * labels are tracked by their index in the fragment's id range - every label
+ * in the fragment, and every label it jumps to, is in that range
+ */
+/**
+ * index of a label among a fragment's ids
+ *
+ * only translation creates labels, so every label is numbered in its fragment
+ */
+static size_t labelIndex(size_t label, size_t firstId, size_t numIds) {
+  if (label - firstId >= numIds)
+    error(__FILE__, __LINE__, "label not numbered in its fragment");
+  return label - firstId;
+}
+
+static void deadLabelElimination(IRFrag *frag, IRFragIndex const *frags) {
+  IRBlock *block = frag->data.text.blocks.head->next->data;
+  LinkedList *instructions = &block->instructions;
+  size_t firstId = frag->data.text.firstId;
+  size_t numIds = frag->data.text.numIds;
+
+  // mark all of the blocks we jump to as seen, starting with jump table
+  // entries
+  bool *seen = malloc(sizeof(bool) * numIds);
+  memcpy(seen, frags->dataTargets + firstId, sizeof(bool) * numIds);
 
   for (ListNode *curr = instructions->head->next; curr != instructions->tail;
        curr = curr->next) {
     IRInstruction *i = curr->data;
     switch (i->op) {
       case IO_JUMP: {
-        seen[localOperandName(i->args[0])] = true;
+        seen[labelIndex(localOperandName(i->args[0]), firstId, numIds)] = true;
         break;
       }
       case IO_JUMPTABLE: {
-        IRFrag *table = findFrag(frags, localOperandName(i->args[1]));
+        IRFrag *table = irFragIndexFind(frags, localOperandName(i->args[1]));
         for (size_t idx = 0; idx < table->data.data.data.size; ++idx) {
           IRDatum *datum = table->data.data.data.elements[idx];
-          seen[datum->data.localLabel] = true;
+          seen[labelIndex(datum->data.localLabel, firstId, numIds)] = true;
         }
         break;
       }
@@ -536,7 +405,7 @@ static void deadLabelElimination(LinkedList *instructions, Vector *frags,
       case IO_J1NZ:
       case IO_J1FZ:
       case IO_J1FNZ: {
-        seen[localOperandName(i->args[0])] = true;
+        seen[labelIndex(localOperandName(i->args[0]), firstId, numIds)] = true;
         break;
       }
       default: {
@@ -548,7 +417,8 @@ static void deadLabelElimination(LinkedList *instructions, Vector *frags,
 
   for (ListNode *curr = instructions->head->next; curr != instructions->tail;) {
     IRInstruction *i = curr->data;
-    if (i->op == IO_LABEL && !seen[localOperandName(i->args[0])]) {
+    if (i->op == IO_LABEL &&
+        !seen[labelIndex(localOperandName(i->args[0]), firstId, numIds)]) {
       ListNode *toRemove = curr;
       curr = curr->next;
       irInstructionFree(removeNode(toRemove));
@@ -560,16 +430,28 @@ static void deadLabelElimination(LinkedList *instructions, Vector *frags,
   free(seen);
 }
 
-void optimizeScheduledIr(void) {
-  for (size_t fileIdx = 0; fileIdx < fileList.size; ++fileIdx) {
-    FileListEntry *file = &fileList.entries[fileIdx];
-    Vector *irFrags = &fileList.entries[fileIdx].irFrags;
-    for (size_t fragIdx = 0; fragIdx < irFrags->size; ++fragIdx) {
-      IRFrag *frag = irFrags->elements[fragIdx];
-      if (frag->type == FT_TEXT) {
-        IRBlock *block = frag->data.text.blocks.head->next->data;
-        deadLabelElimination(&block->instructions, irFrags, file->nextId);
-      }
+void optimizeScheduledIrFile(FileListEntry *file) {
+  Vector *irFrags = &file->irFrags;
+  IRFragIndex frags;
+  irFragIndexInit(&frags, irFrags, file->nextId);
+  for (size_t fragIdx = 0; fragIdx < irFrags->size; ++fragIdx) {
+    IRFrag *frag = irFrags->elements[fragIdx];
+    if (frag->type == FT_TEXT) {
+      irArenaSet(frag->data.text.arena);
+      deadLabelElimination(frag, &frags);
+      irArenaSet(NULL);
     }
   }
+  irFragIndexUninit(&frags);
+}
+
+static void optimizeScheduledIrTask(size_t fileIdx, void *ignored) {
+  (void)ignored;
+  optimizeScheduledIrFile(&fileList.entries[fileIdx]);
+}
+
+void optimizeScheduledIr(void) {
+  timePhaseStart("scheduled optimization: dead label elimination");
+  threadPoolRun(fileList.size, optimizeScheduledIrTask, NULL);
+  timePhaseEnd();
 }
\ No newline at end of file
@@ -25,14 +25,30 @@
 #ifndef TLC_OPTIMIZATION_OPTIMIZATION_H_
 #define TLC_OPTIMIZATION_OPTIMIZATION_H_
 
+typedef struct FileListEntry FileListEntry;
+
 /**
  * optimizes the blocked IR
  */
 void optimizeBlockedIr(void);
 
+/**
+ * optimizes one file's blocked IR
+ *
+ * @param file file to optimize
+ */
+void optimizeBlockedIrFile(FileListEntry *file);
+
 /**
  * optimizes the trace-scheduled IR
  */
 void optimizeScheduledIr(void);
 
+/**
+ * optimizes one file's trace-scheduled IR
+ *
+ * @param file file to optimize
+ */
+void optimizeScheduledIrFile(FileListEntry *file);
+
 #endif  // TLC_OPTIMIZATION_OPTIMIZATION_H_
\ No newline at end of file
@@ -20,13 +20,36 @@
 #include "options.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 Options options = {
     OPTION_W_ERROR, OPTION_W_ERROR, OPTION_W_ERROR,
     OPTION_DD_NONE, false,          OPTION_A_X86_64_LINUX,
+    1,              false,          NULL,
+    false,          false,          false,
+    NULL,           NULL,           false,
+    false,
 };
 
+/**
+ * parses the number of jobs given to -j
+ *
+ * @param s string to parse
+ * @param jobs output parameter for the number of jobs
+ * @returns status code (0 = OK)
+ */
+static int parseJobs(char const *s, size_t *jobs) {
+  if (!(*s >= '0' && *s <= '9')) return -1;
+
+  char *end;
+  unsigned long long value = strtoull(s, &end, 10);
+  if (*end != '\0' || value == 0) return -1;
+
+  *jobs = (size_t)value;
+  return 0;
+}
+
 int parseArgs(size_t argc, char const *const *argv, size_t *numFilesOut) {
   size_t numFiles = 0;
 
@@ -76,6 +99,53 @@ int parseArgs(size_t argc, char const *const *argv, size_t *numFilesOut) {
       options.debugValidateIr = false;
     } else if (strcmp(argv[idx], "--arch=x86_64-linux") == 0) {
       options.arch = OPTION_A_X86_64_LINUX;
+    } else if (strcmp(argv[idx], "--time-report") == 0) {
+      options.timeReport = true;
+    } else if (strncmp(argv[idx], "--time-trace=", 13) == 0 &&
+               argv[idx][13] != '\0') {
+      options.timeTraceFile = argv[idx] + 13;
+    } else if (strcmp(argv[idx], "--emit-tdi") == 0) {
+      options.emitTdi = true;
+    } else if (strcmp(argv[idx], "--no-emit-tdi") == 0) {
+      options.emitTdi = false;
+    } else if (strcmp(argv[idx], "--use-tdi") == 0) {
+      options.useTdi = true;
+    } else if (strcmp(argv[idx], "--no-use-tdi") == 0) {
+      options.useTdi = false;
+    } else if (strcmp(argv[idx], "-MD") == 0) {
+      options.dependencyFile = true;
+    } else if (strcmp(argv[idx], "-MF") == 0) {
+      // dependency file is the next argument
+      if (idx + 1 == argc) {
+        fprintf(stderr, "tlc: error: option '-MF' requires a file name\n");
+        return -1;
+      }
+      options.dependencyFileName = argv[++idx];
+    } else if (strncmp(argv[idx], "-MF", 3) == 0) {
+      options.dependencyFileName = argv[idx] + 3;
+    } else if (strcmp(argv[idx], "--stream") == 0) {
+      options.stream = true;
+    } else if (strcmp(argv[idx], "--no-stream") == 0) {
+      options.stream = false;
+    } else if (strcmp(argv[idx], "--pretokenize") == 0) {
+      options.pretokenize = true;
+    } else if (strcmp(argv[idx], "--no-pretokenize") == 0) {
+      options.pretokenize = false;
+    } else if (strncmp(argv[idx], "--incremental=", 14) == 0 &&
+               argv[idx][14] != '\0') {
+      options.incrementalDir = argv[idx] + 14;
+    } else if (strcmp(argv[idx], "-j") == 0) {
+      // number of jobs is the next argument
+      if (idx + 1 == argc || parseJobs(argv[idx + 1], &options.jobs) != 0) {
+        fprintf(stderr, "tlc: error: option '-j' requires a positive number\n");
+        return -1;
+      }
+      ++idx;
+    } else if (strncmp(argv[idx], "-j", 2) == 0) {
+      if (parseJobs(argv[idx] + 2, &options.jobs) != 0) {
+        fprintf(stderr, "tlc: error: options '%s' not recognized\n", argv[idx]);
+        return -1;
+      }
     } else {
       fprintf(stderr, "tlc: error: options '%s' not recognized\n", argv[idx]);
       return -1;
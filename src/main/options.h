@@ -56,6 +56,20 @@ typedef struct {
   DebugDumpOption dump;
   bool debugValidateIr;
   ArchOption arch;
+  size_t jobs;                    /**< number of threads to compile with */
+  bool timeReport;                /**< print per-phase timings */
+  char const *timeTraceFile;      /**< file to write a Chrome trace to, or
+                                     NULL */
+  bool emitTdi;                   /**< write .tdi files for decl modules */
+  bool useTdi;                    /**< load decl modules from .tdi files */
+  bool dependencyFile;            /**< write make-style dependency files */
+  char const *dependencyFileName; /**< file to write all dependencies to if
+                                     dependencyFile is set, or NULL for one
+                                     file per code file */
+  char const *incrementalDir;     /**< directory to keep incremental build
+                                     records in, or NULL */
+  bool stream;                    /**< compile code files one at a time */
+  bool pretokenize;               /**< lex each file before parsing it */
 } Options;
 
 /**
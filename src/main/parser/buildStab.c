@@ -31,71 +31,52 @@
 #include "util/container/hashMap.h"
 #include "util/container/hashSet.h"
 #include "util/container/vector.h"
+#include "util/diagnostics.h"
 #include "util/format.h"
 #include "util/functional.h"
 #include "util/internalError.h"
 #include "util/numericSizing.h"
 
-static bool fileListEntryArrayContains(FileListEntry **arry, size_t size,
-                                       FileListEntry *f) {
+static bool nameArrayContains(char const **arry, size_t size,
+                              char const *name) {
   for (size_t idx = 0; idx < size; ++idx)
-    if (arry[idx] == f) return true;
-  return false;
-}
-static bool nameArrayContains(Node **arry, size_t size, Node *n) {
-  for (size_t idx = 0; idx < size; ++idx)
-    if (nameNodeEqual(arry[idx], n)) return true;
+    if (arry[idx] == name) return true;
   return false;
 }
 int resolveImports(void) {
   bool errored = false;
 
-  // check for duplciate decl modules
-  FileListEntry **processed = malloc(sizeof(FileListEntry *) * fileList.size);
-  size_t numProcessed = 0;
-  for (size_t fileIdx = 0; fileIdx < fileList.size; ++fileIdx) {
-    if (!fileList.entries[fileIdx].isCode &&
-        !fileListEntryArrayContains(processed, numProcessed,
-                                    &fileList.entries[fileIdx])) {
-      // for each declaration file, if its name hasn't been processed yet,
-      // process it
-      FileListEntry **duplicateEntries =
-          malloc(sizeof(FileListEntry *) * fileList.size);
-      size_t numDuplicates = 0;
-      for (size_t compareIdx = fileIdx + 1; compareIdx < fileList.size;
-           ++compareIdx) {
-        // check it against each other file
-        if (!fileList.entries[compareIdx].isCode &&
-            nameNodeEqual(
-                fileList.entries[fileIdx].ast->data.file.module->data.module.id,
-                fileList.entries[compareIdx]
-                    .ast->data.file.module->data.module.id)) {
-          duplicateEntries[numDuplicates++] = &fileList.entries[compareIdx];
-        }
-      }
-      if (numDuplicates != 0) {
-        char *nameString = stringifyId(
-            fileList.entries[fileIdx].ast->data.file.module->data.module.id);
-        fprintf(stderr,
+  // index decl modules, checking for duplicates
+  Vector duplicates;
+  vectorInit(&duplicates);
+  fileListIndexModules(&duplicates);
+  for (size_t fileIdx = 0; fileIdx < fileList.size && duplicates.size != 0;
+       ++fileIdx) {
+    FileListEntry *entry = &fileList.entries[fileIdx];
+    char const *name = entry->ast->data.file.module->data.module.name;
+    if (entry->isCode || fileListFindDeclName(name) != entry) continue;
+
+    // for each declaration file that's the first to declare its module,
+    // complain about any others declaring it too
+    bool first = true;
+    for (size_t printIdx = 0; printIdx < duplicates.size; ++printIdx) {
+      FileListEntry *duplicate = duplicates.elements[printIdx];
+      if (duplicate->ast->data.file.module->data.module.name != name) continue;
+      if (first) {
+        fprintf(diagnosticStream(),
                 "%s:%zu:%zu: error: module '%s' declared in multiple "
                 "declaration modules\n",
-                fileList.entries[fileIdx].inputFilename,
-                fileList.entries[fileIdx].ast->line,
-                fileList.entries[fileIdx].ast->character, nameString);
-        free(nameString);
-        for (size_t printIdx = 0; printIdx < numDuplicates; ++printIdx)
-          fprintf(stderr, "%s:%zu:%zu: note: declared here\n",
-                  duplicateEntries[printIdx]->inputFilename,
-                  duplicateEntries[printIdx]->ast->line,
-                  duplicateEntries[printIdx]->ast->character);
-        errored = true;
+                entry->inputFilename, entry->ast->line, entry->ast->character,
+                name);
+        first = false;
       }
-      free(duplicateEntries);
-
-      processed[numProcessed++] = &fileList.entries[fileIdx];
+      fprintf(diagnosticStream(), "%s:%zu:%zu: note: declared here\n",
+              duplicate->inputFilename, duplicate->ast->line,
+              duplicate->ast->character);
+      errored = true;
     }
   }
-  free(processed);
+  vectorUninit(&duplicates, nullDtor);
 
   if (errored) return -1;
 
@@ -104,7 +85,7 @@ int resolveImports(void) {
     Node *ast = fileList.entries[fileIdx].ast;
     Vector *imports = ast->data.file.imports;
 
-    Node **processed = malloc(sizeof(Node *) * imports->size);
+    char const **processed = malloc(sizeof(char const *) * imports->size);
     size_t numProcessed = 0;
 
     // check for self-imports
@@ -112,8 +93,7 @@ int resolveImports(void) {
     size_t numColliding = 0;
     for (size_t importIdx = 0; importIdx < imports->size; ++importIdx) {
       Node *import = imports->elements[importIdx];
-      if (nameNodeEqual(import->data.import.id,
-                        ast->data.file.module->data.module.id)) {
+      if (import->data.import.name == ast->data.file.module->data.module.name) {
         colliding[numColliding++] = import;
       }
     }
@@ -121,13 +101,14 @@ int resolveImports(void) {
       switch (options.duplicateImport) {
         case OPTION_W_ERROR: {
           char *nameString = stringifyId(ast->data.file.module->data.module.id);
-          fprintf(stderr, "%s:%zu:%zu: error: '%s' imports itself\n",
+          fprintf(diagnosticStream(),
+                  "%s:%zu:%zu: error: '%s' imports itself\n",
                   fileList.entries[fileIdx].inputFilename,
                   ast->data.file.module->line, ast->data.file.module->character,
                   nameString);
           free(nameString);
           for (size_t idx = 0; idx < numColliding; ++idx)
-            fprintf(stderr, "%s:%zu:%zu: note: imported here\n",
+            fprintf(diagnosticStream(), "%s:%zu:%zu: note: imported here\n",
                     fileList.entries[fileIdx].inputFilename,
                     colliding[idx]->line, colliding[idx]->character);
           fileList.entries[fileIdx].errored = true;
@@ -135,13 +116,14 @@ int resolveImports(void) {
         }
         case OPTION_W_WARN: {
           char *nameString = stringifyId(ast->data.file.module->data.module.id);
-          fprintf(stderr, "%s:%zu:%zu: warning: '%s' imports itself\n",
+          fprintf(diagnosticStream(),
+                  "%s:%zu:%zu: warning: '%s' imports itself\n",
                   fileList.entries[fileIdx].inputFilename,
                   ast->data.file.module->line, ast->data.file.module->character,
                   nameString);
           free(nameString);
           for (size_t idx = 0; idx < numColliding; ++idx)
-            fprintf(stderr, "%s:%zu:%zu: note: imported here\n",
+            fprintf(diagnosticStream(), "%s:%zu:%zu: note: imported here\n",
                     fileList.entries[fileIdx].inputFilename,
                     colliding[idx]->line, colliding[idx]->character);
           break;
@@ -158,26 +140,27 @@ int resolveImports(void) {
 
       // note - we don't always abort after a duplicate, so this prevents
       // double-importing
-      if (!nameArrayContains(processed, numProcessed, import->data.import.id)) {
+      if (!nameArrayContains(processed, numProcessed,
+                             import->data.import.name)) {
         // check for upcoming duplicates
         numColliding = 0;
         for (size_t checkIdx = importIdx + 1; checkIdx < imports->size;
              ++checkIdx) {
           Node *toCheck = imports->elements[checkIdx];
-          if (nameNodeEqual(import->data.import.id, toCheck->data.import.id))
+          if (import->data.import.name == toCheck->data.import.name)
             colliding[numColliding++] = toCheck;
         }
         if (numColliding != 0) {
           switch (options.duplicateImport) {
             case OPTION_W_ERROR: {
               char *nameString = stringifyId(import->data.import.id);
-              fprintf(stderr,
+              fprintf(diagnosticStream(),
                       "%s:%zu:%zu: error: '%s' imported multiple times\n",
                       fileList.entries[fileIdx].inputFilename, import->line,
                       import->character, nameString);
               free(nameString);
               for (size_t idx = 0; idx < numColliding; ++idx)
-                fprintf(stderr, "%s:%zu:%zu: note: imported here\n",
+                fprintf(diagnosticStream(), "%s:%zu:%zu: note: imported here\n",
                         fileList.entries[fileIdx].inputFilename,
                         colliding[idx]->line, colliding[idx]->character);
               fileList.entries[fileIdx].errored = true;
@@ -185,13 +168,13 @@ int resolveImports(void) {
             }
             case OPTION_W_WARN: {
               char *nameString = stringifyId(import->data.import.id);
-              fprintf(stderr,
+              fprintf(diagnosticStream(),
                       "%s:%zu:%zu: warning: '%s' imported multiple times\n",
                       fileList.entries[fileIdx].inputFilename, import->line,
                       import->character, nameString);
               free(nameString);
               for (size_t idx = 0; idx < numColliding; ++idx)
-                fprintf(stderr, "%s:%zu:%zu: note: imported here\n",
+                fprintf(diagnosticStream(), "%s:%zu:%zu: note: imported here\n",
                         fileList.entries[fileIdx].inputFilename,
                         colliding[idx]->line, colliding[idx]->character);
               break;
@@ -203,18 +186,19 @@ int resolveImports(void) {
         }
 
         import->data.import.referenced =
-            fileListFindDeclName(import->data.import.id);
+            fileListFindDeclName(import->data.import.name);
 
         if (import->data.import.referenced == NULL) {
           char *name = stringifyId(import->data.import.id);
-          fprintf(stderr, "%s:%zu:%zu error: cannot find module '%s'\n",
+          fprintf(diagnosticStream(),
+                  "%s:%zu:%zu error: cannot find module '%s'\n",
                   fileList.entries[fileIdx].inputFilename, import->line,
                   import->character, name);
           free(name);
           errored = true;
         }
 
-        processed[numProcessed] = import->data.import.id;
+        processed[numProcessed] = import->data.import.name;
         ++numProcessed;
       }
     }
@@ -234,7 +218,7 @@ void startTopLevelStab(FileListEntry *entry) {
   HashMap *implicitStab = NULL;
   if (entry->isCode) {
     FileListEntry *declEntry =
-        fileListFindDeclName(entry->ast->data.file.module->data.module.id);
+        fileListFindDeclName(entry->ast->data.file.module->data.module.name);
     if (declEntry != NULL) implicitStab = declEntry->ast->data.file.stab;
   }
 
@@ -368,8 +352,8 @@ void startTopLevelStab(FileListEntry *entry) {
                                  constantName->data.id.id, existing->file,
                                  existing->line, existing->character);
             } else {
-              vectorInsert(&parentEnum->data.enumType.constantNames,
-                           constantName->data.id.id);
+              stringVectorInsert(&parentEnum->data.enumType.constantNames,
+                                 constantName->data.id.id);
 
               constantName->data.id.entry = enumConstStabEntryCreate(
                   entry, constantName->line, constantName->character,
@@ -565,6 +549,22 @@ int buildTopLevelEnumStab(void) {
         }
       }
     }
+
+    // precompiled enum constants already have values, but may be depended on
+    if (entry->precompiled != NULL) {
+      HashMap *stab = entry->ast->data.file.stab;
+      for (size_t stabIdx = 0; stabIdx < stab->size; ++stabIdx) {
+        SymbolTableEntry *thisEnum = stab->values[stabIdx];
+        if (thisEnum->kind != SK_ENUM) continue;
+        Vector *constantSymbols = &thisEnum->data.enumType.constantValues;
+        for (size_t constantIdx = 0; constantIdx < constantSymbols->size;
+             ++constantIdx) {
+          vectorInsert(&enumConstants, constantSymbols->elements[constantIdx]);
+          vectorInsert(&dependencies, NULL);
+          vectorInsert(&enumValues, NULL);
+        }
+      }
+    }
   }
 
   // for each enum in each file
@@ -613,7 +613,7 @@ int buildTopLevelEnumStab(void) {
                 // error - no such enum
                 errored = true;
               } else if (stabEntry->kind != SK_ENUMCONST) {
-                fprintf(stderr,
+                fprintf(diagnosticStream(),
                         "%s:%zu:%zu: error: expected an extended integer "
                         "literal, found %s\n",
                         entry->inputFilename, constantValueNode->line,
@@ -660,7 +660,7 @@ int buildTopLevelEnumStab(void) {
           if (curr == startIdx) {
             errored = true;
             SymbolTableEntry *start = enumConstants.elements[startIdx];
-            fprintf(stderr,
+            fprintf(diagnosticStream(),
                     "%s:%zu:%zu: error: circular reference in enumeration "
                     "constants\n",
                     start->file->inputFilename, start->line, start->character);
@@ -669,7 +669,8 @@ int buildTopLevelEnumStab(void) {
               currPathNode = currPathNode->prev;
               SymbolTableEntry *currEntry =
                   enumConstants.elements[currPathNode->curr];
-              fprintf(stderr, "%s:%zu:%zu: note: references above\n",
+              fprintf(diagnosticStream(),
+                      "%s:%zu:%zu: note: references above\n",
                       currEntry->file->inputFilename, currEntry->line,
                       currEntry->character);
             }
@@ -719,6 +720,13 @@ int buildTopLevelEnumStab(void) {
   // build the enum values
   size_t numProcessed = 0;
   memset(processed, 0, sizeof(bool) * enumConstants.size);
+  for (size_t idx = 0; idx < enumConstants.size; ++idx) {
+    SymbolTableEntry *constant = enumConstants.elements[idx];
+    if (constant->file->precompiled != NULL) {
+      processed[idx] = true;
+      ++numProcessed;
+    }
+  }
   while (numProcessed < enumConstants.size && !errored) {
     for (size_t idx = 0; idx < enumConstants.size; ++idx) {
       // for each unprocessed enum
@@ -831,7 +839,7 @@ int buildTopLevelEnumStab(void) {
                 if (dependency->data.enumConst.data.unsignedValue ==
                     ULONG_MAX) {
                   errored = true;
-                  fprintf(stderr,
+                  fprintf(diagnosticStream(),
                           "%s:%zu:%zu: error: unrepresentable enumeration "
                           "constant value - value would overflow a ulong",
                           current->file->inputFilename, current->line,
@@ -895,7 +903,7 @@ int buildTopLevelEnumStab(void) {
             // must be signed - this is a negative
             if (requiredSign == 1) {
               // unrepresentable enum
-              fprintf(stderr,
+              fprintf(diagnosticStream(),
                       "%s:%zu:%zu: error: unrepresentable enumeration - "
                       "enumeration values must be signed, but are large enough "
                       "to overflow a long",
@@ -913,7 +921,7 @@ int buildTopLevelEnumStab(void) {
               if (requiredSign == -1) {
                 // unrepresentable enum
                 fprintf(
-                    stderr,
+                    diagnosticStream(),
                     "%s:%zu:%zu: error: unrepresentable enumeration - "
                     "enumeration values must be signed, but are large enough "
                     "to overflow a long",
@@ -1036,12 +1044,14 @@ static bool checkScopedIdCollisionsBetween(Node *longImport, Node *shortImport,
           char *longNameString = stringifyId(longName);
           char *collidingName = format(
               "%s::%s", longNameString,
-              (char *)nameMatch->data.enumType.constantNames.elements[enumIdx]);
-          fprintf(stderr, "%s:%zu:%zu: error: '%s' introduced multiple times\n",
+              nameMatch->data.enumType.constantNames.elements[enumIdx]);
+          fprintf(diagnosticStream(),
+                  "%s:%zu:%zu: error: '%s' introduced multiple times\n",
                   currentFilename, longImport->line, longImport->character,
                   collidingName);
-          fprintf(stderr, "%s:%zu:%zu: note: also introduced here\n",
-                  currentFilename, shortImport->line, shortImport->character);
+          fprintf(diagnosticStream(),
+                  "%s:%zu:%zu: note: also introduced here\n", currentFilename,
+                  shortImport->line, shortImport->character);
           free(longNameString);
           free(collidingName);
           return true;
@@ -1074,12 +1084,13 @@ static bool checkScopedIdCollisionsWithCurrent(Node *import,
             nameMatch->data.enumType.constantNames.elements[enumIdx]);
         if (colliding != NULL) {
           fprintf(
-              stderr,
+              diagnosticStream(),
               "%s:%zu:%zu: error: '%s' collides with imported scoped "
               "identifier\n",
               entry->inputFilename, colliding->line, colliding->character,
-              (char *)nameMatch->data.enumType.constantNames.elements[enumIdx]);
-          fprintf(stderr, "%s:%zu:%zu: note: also introduced here\n",
+              nameMatch->data.enumType.constantNames.elements[enumIdx]);
+          fprintf(diagnosticStream(),
+                  "%s:%zu:%zu: note: also introduced here\n",
                   entry->inputFilename, import->line, import->character);
           return true;
         }
@@ -1105,13 +1116,14 @@ static bool checkScopedIdCollisionsWithCurrent(Node *import,
           SymbolTableEntry *collidingEntry =
               nameMatch->data.enumType.constantValues.elements[enumIdx];
           fprintf(
-              stderr,
+              diagnosticStream(),
               "%s:%zu:%zu: error: '%s' collides with imported scoped "
               "identifier\n",
               entry->inputFilename, collidingEntry->line,
               collidingEntry->character,
-              (char *)nameMatch->data.enumType.constantNames.elements[enumIdx]);
-          fprintf(stderr, "%s:%zu:%zu: note: also introduced here\n",
+              nameMatch->data.enumType.constantNames.elements[enumIdx]);
+          fprintf(diagnosticStream(),
+                  "%s:%zu:%zu: note: also introduced here\n",
                   entry->inputFilename, import->line, import->character);
           return true;
         }
@@ -1168,11 +1180,11 @@ void finishStructStab(FileListEntry *entry, Node *body,
                            stabEntry->file, stabEntry->line,
                            stabEntry->character);
       } else {
-        vectorInsert(&stabEntry->data.structType.fieldNames, name->data.id.id);
-        vectorInsert(&stabEntry->data.structType.fieldTypes, typeCopy(type));
+        stringVectorInsert(&stabEntry->data.structType.fieldNames,
+                           name->data.id.id);
+        vectorInsert(&stabEntry->data.structType.fieldTypes, type);
       }
     }
-    typeFree(type);
   }
 }
 
@@ -1197,11 +1209,11 @@ void finishUnionStab(FileListEntry *entry, Node *body,
                            stabEntry->file, stabEntry->line,
                            stabEntry->character);
       } else {
-        vectorInsert(&stabEntry->data.unionType.optionNames, name->data.id.id);
-        vectorInsert(&stabEntry->data.unionType.optionTypes, typeCopy(type));
+        stringVectorInsert(&stabEntry->data.unionType.optionNames,
+                           name->data.id.id);
+        vectorInsert(&stabEntry->data.unionType.optionTypes, type);
       }
     }
-    typeFree(type);
   }
 }
 
@@ -1232,8 +1244,8 @@ void finishEnumStab(FileListEntry *entry, Node *body,
           entry, constantName->line, constantName->character,
           constantName->data.id.id, stabEntry);
 
-      vectorInsert(&stabEntry->data.enumType.constantNames,
-                   constantName->data.id.id);
+      stringVectorInsert(&stabEntry->data.enumType.constantNames,
+                         constantName->data.id.id);
       vectorInsert(&stabEntry->data.enumType.constantValues,
                    constantName->data.id.entry);
 
@@ -1282,7 +1294,7 @@ void finishEnumStab(FileListEntry *entry, Node *body,
           // error - no such enum
           errored = true;
         } else if (stabEntry->kind != SK_ENUMCONST) {
-          fprintf(stderr,
+          fprintf(diagnosticStream(),
                   "%s:%zu:%zu: error: expected an extended integer "
                   "literal, found %s\n",
                   entry->inputFilename, constantValueNode->line,
@@ -1324,7 +1336,7 @@ void finishEnumStab(FileListEntry *entry, Node *body,
           if (curr == startIdx) {
             errored = true;
             SymbolTableEntry *start = enumConstants.elements[startIdx];
-            fprintf(stderr,
+            fprintf(diagnosticStream(),
                     "%s:%zu:%zu: error: circular reference in enumeration "
                     "constants\n",
                     start->file->inputFilename, start->line, start->character);
@@ -1333,7 +1345,8 @@ void finishEnumStab(FileListEntry *entry, Node *body,
               currPathNode = currPathNode->prev;
               SymbolTableEntry *currEntry =
                   enumConstants.elements[currPathNode->curr];
-              fprintf(stderr, "%s:%zu:%zu: note: references above\n",
+              fprintf(diagnosticStream(),
+                      "%s:%zu:%zu: note: references above\n",
                       currEntry->file->inputFilename, currEntry->line,
                       currEntry->character);
             }
@@ -1383,6 +1396,13 @@ void finishEnumStab(FileListEntry *entry, Node *body,
   // build the enum values
   size_t numProcessed = 0;
   memset(processed, 0, sizeof(bool) * enumConstants.size);
+  for (size_t idx = 0; idx < enumConstants.size; ++idx) {
+    SymbolTableEntry *constant = enumConstants.elements[idx];
+    if (constant->file->precompiled != NULL) {
+      processed[idx] = true;
+      ++numProcessed;
+    }
+  }
   while (numProcessed < enumConstants.size && !errored) {
     for (size_t idx = 0; idx < enumConstants.size; ++idx) {
       // for each unprocessed enum
@@ -1495,7 +1515,7 @@ void finishEnumStab(FileListEntry *entry, Node *body,
                 if (dependency->data.enumConst.data.unsignedValue ==
                     ULONG_MAX) {
                   errored = true;
-                  fprintf(stderr,
+                  fprintf(diagnosticStream(),
                           "%s:%zu:%zu: error: unrepresentable enumeration "
                           "constant value - value would overflow a ulong",
                           current->file->inputFilename, current->line,
@@ -1543,7 +1563,7 @@ void finishEnumStab(FileListEntry *entry, Node *body,
       // must be signed - this is a negative
       if (requiredSign == 1) {
         // unrepresentable enum
-        fprintf(stderr,
+        fprintf(diagnosticStream(),
                 "%s:%zu:%zu: error: unrepresentable enumeration - "
                 "enumeration values must be signed, but are large enough "
                 "to overflow a long",
@@ -1560,7 +1580,7 @@ void finishEnumStab(FileListEntry *entry, Node *body,
         // must be unsigned - this is greater than LONG_MAX
         if (requiredSign == -1) {
           // unrepresentable enum
-          fprintf(stderr,
+          fprintf(diagnosticStream(),
                   "%s:%zu:%zu: error: unrepresentable enumeration - "
                   "enumeration values must be signed, but are large enough "
                   "to overflow a long",
@@ -1674,9 +1694,8 @@ void finishTopLevelStab(FileListEntry *entry) {
 
         for (size_t nameIdx = 0; nameIdx < names->size; ++nameIdx) {
           Node *name = names->elements[nameIdx];
-          name->data.id.entry->data.variable.type = typeCopy(type);
+          name->data.id.entry->data.variable.type = type;
         }
-        typeFree(type);
 
         break;
       }
@@ -1697,25 +1716,26 @@ void finishTopLevelStab(FileListEntry *entry) {
                                    : hashMapGet(implicitStab, nameString);
           if (existing != NULL && existing->data.variable.type != NULL &&
               !typeEqual(existing->data.variable.type, type)) {
-            fprintf(stderr,
+            fprintf(diagnosticStream(),
                     "%s:%zu:%zu: error: redeclaration of %s as a variable of a "
                     "different type\n",
                     entry->inputFilename, name->line, name->character,
                     nameString);
-            fprintf(stderr, "%s:%zu:%zu: note: previously declared here\n",
+            fprintf(diagnosticStream(),
+                    "%s:%zu:%zu: note: previously declared here\n",
                     existing->file->inputFilename, existing->line,
                     existing->character);
             entry->errored = true;
           }
 
-          name->data.id.entry->data.variable.type = typeCopy(type);
+          name->data.id.entry->data.variable.type = type;
 
           Node *initializer = initializers->elements[nameIdx];
           if (initializer != NULL && initializer->type == NT_SCOPEDID) {
             SymbolTableEntry *enumConst =
                 environmentLookup(&env, initializer, false);
             if (enumConst != NULL && enumConst->kind != SK_ENUMCONST) {
-              fprintf(stderr,
+              fprintf(diagnosticStream(),
                       "%s:%zu:%zu: error: expected a value literal, found %s\n",
                       entry->inputFilename, initializer->line,
                       initializer->character,
@@ -1726,8 +1746,6 @@ void finishTopLevelStab(FileListEntry *entry) {
           }
         }
 
-        typeFree(type);
-
         break;
       }
       case NT_FUNDECL: {
@@ -1768,11 +1786,12 @@ void finishTopLevelStab(FileListEntry *entry) {
         if (existing != NULL && existing->data.function.returnType != NULL &&
             !typeEqual(existing->data.function.returnType, returnType)) {
           // redeclaration of function with different type
-          fprintf(stderr,
+          fprintf(diagnosticStream(),
                   "%s:%zu:%zu: error: redeclaration of %s as a function of a "
                   "different type\n",
                   entry->inputFilename, body->line, body->character, name);
-          fprintf(stderr, "%s:%zu:%zu: note: previously declared here\n",
+          fprintf(diagnosticStream(),
+                  "%s:%zu:%zu: note: previously declared here\n",
                   existing->file->inputFilename, existing->line,
                   existing->character);
           entry->errored = true;
@@ -1796,11 +1815,12 @@ void finishTopLevelStab(FileListEntry *entry) {
                          argType) &&
               !mismatch) {
             // redeclaration of function with different type
-            fprintf(stderr,
+            fprintf(diagnosticStream(),
                     "%s:%zu:%zu: error: redeclaration of %s as a function of a "
                     "different type\n",
                     entry->inputFilename, body->line, body->character, name);
-            fprintf(stderr, "%s:%zu:%zu: note: previously declared here\n",
+            fprintf(diagnosticStream(),
+                    "%s:%zu:%zu: note: previously declared here\n",
                     existing->file->inputFilename, existing->line,
                     existing->character);
             entry->errored = true;
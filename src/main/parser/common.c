@@ -23,6 +23,7 @@
 
 #include "fileList.h"
 #include "util/conversions.h"
+#include "util/diagnostics.h"
 
 /** array between token type (as int) and token name */
 static char const *const TOKEN_DESCRIPTORS[] = {
@@ -140,7 +141,7 @@ static char const *const TOKEN_DESCRIPTORS[] = {
 
 void errorExpectedString(FileListEntry *entry, char const *expected,
                          Token const *actual) {
-  fprintf(stderr, "%s:%zu:%zu: error: expected %s, but found %s\n",
+  fprintf(diagnosticStream(), "%s:%zu:%zu: error: expected %s, but found %s\n",
           entry->inputFilename, actual->line, actual->character, expected,
           TOKEN_DESCRIPTORS[actual->type]);
   entry->errored = true;
@@ -152,14 +153,15 @@ void errorExpectedToken(FileListEntry *entry, TokenType expected,
 void errorRedeclaration(FileListEntry *file, size_t line, size_t character,
                         char const *name, FileListEntry *collidingFile,
                         size_t collidingLine, size_t collidingChar) {
-  fprintf(stderr, "%s:%zu:%zu: error: redeclaration of %s\n",
+  fprintf(diagnosticStream(), "%s:%zu:%zu: error: redeclaration of %s\n",
           file->inputFilename, line, character, name);
-  fprintf(stderr, "%s:%zu:%zu: note: previously declared here\n",
+  fprintf(diagnosticStream(), "%s:%zu:%zu: note: previously declared here\n",
           collidingFile->inputFilename, collidingLine, collidingChar);
   file->errored = true;
 }
 void errorIntOverflow(FileListEntry *entry, Token *token) {
-  fprintf(stderr, "%s:%zu:%zu: error: integer constant is too large\n",
+  fprintf(diagnosticStream(),
+          "%s:%zu:%zu: error: integer constant is too large\n",
           entry->inputFilename, token->line, token->character);
   entry->errored = true;
 }
\ No newline at end of file
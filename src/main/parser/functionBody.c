@@ -23,10 +23,12 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "ast/type.h"
 #include "buildStab.h"
 #include "fileList.h"
 #include "parser/common.h"
 #include "util/conversions.h"
+#include "util/diagnostics.h"
 #include "util/internalError.h"
 
 // token stuff
@@ -42,16 +44,8 @@
  * @param t token to write into
  */
 static void next(Node *unparsed, Token *t) {
-  // get pointer to saved token
-  Token *saved =
-      unparsed->data.unparsed.tokens->elements[unparsed->data.unparsed.curr];
-  // give ownership of it to the caller
-  memcpy(t, saved, sizeof(Token));
-  // free malloc'ed block - this token has its guts ripped out
-  free(saved);
-  // clear it - we don't need to remember it any more
-  unparsed->data.unparsed.tokens->elements[unparsed->data.unparsed.curr++] =
-      NULL;
+  tokenBufferGet(unparsed->data.unparsed.tokens, unparsed->data.unparsed.curr++,
+                 t);
 }
 
 /**
@@ -62,17 +56,8 @@ static void next(Node *unparsed, Token *t) {
  * assumes you don't go past the start of the unparsed
  *
  * @param unparsed node to write to
- * @param t token to read from
  */
-static void prev(Node *unparsed, Token *t) {
-  // malloc new block
-  Token *saved = malloc(sizeof(Token));
-  // copy from t (t now has its guts ripped out)
-  memcpy(saved, t, sizeof(Token));
-  // save it
-  unparsed->data.unparsed.tokens->elements[--unparsed->data.unparsed.curr] =
-      saved;
-}
+static void prev(Node *unparsed) { --unparsed->data.unparsed.curr; }
 
 // miscellaneous functions
 
@@ -122,11 +107,10 @@ static void panicStmt(Node *unparsed) {
       case TT_ENUM:
       case TT_TYPEDEF:
       case TT_EOF: {
-        prev(unparsed, &token);
+        prev(unparsed);
         return;
       }
       default: {
-        tokenUninit(&token);
         break;
       }
     }
@@ -162,11 +146,10 @@ static void panicSwitch(Node *unparsed) {
       case TT_CASE:
       case TT_DEFAULT:
       case TT_EOF: {
-        prev(unparsed, &token);
+        prev(unparsed);
         return;
       }
       default: {
-        tokenUninit(&token);
         break;
       }
     }
@@ -205,11 +188,10 @@ static void panicStructOrUnion(Node *unparsed) {
       case TT_ID:
       case TT_EOF:
       case TT_RBRACE: {
-        prev(unparsed, &peek);
+        prev(unparsed);
         return;
       }
       default: {
-        tokenUninit(&peek);
         break;
       }
     }
@@ -233,11 +215,10 @@ static void panicEnum(Node *unparsed) {
       }
       case TT_EOF:
       case TT_RBRACE: {
-        prev(unparsed, &token);
+        prev(unparsed);
         return;
       }
       default: {
-        tokenUninit(&token);
         break;
       }
     }
@@ -259,7 +240,7 @@ static Node *parseAnyId(FileListEntry *entry, Node *unparsed) {
   next(unparsed, &idToken);
   if (idToken.type != TT_ID) {
     errorExpectedToken(entry, TT_ID, &idToken);
-    prev(unparsed, &idToken);
+    prev(unparsed);
     return NULL;
   }
 
@@ -268,7 +249,7 @@ static Node *parseAnyId(FileListEntry *entry, Node *unparsed) {
   next(unparsed, &scope);
   if (scope.type != TT_SCOPE) {
     // not a scoped id
-    prev(unparsed, &scope);
+    prev(unparsed);
     return idNodeCreate(&idToken);
   } else {
     // scoped id - saw scope
@@ -280,7 +261,7 @@ static Node *parseAnyId(FileListEntry *entry, Node *unparsed) {
       if (idToken.type != TT_ID) {
         errorExpectedToken(entry, TT_ID, &idToken);
 
-        prev(unparsed, &idToken);
+        prev(unparsed);
 
         nodeVectorFree(components);
         return NULL;
@@ -291,7 +272,7 @@ static Node *parseAnyId(FileListEntry *entry, Node *unparsed) {
       // if there's a scope, keep going, else return
       next(unparsed, &scope);
       if (scope.type != TT_SCOPE) {
-        prev(unparsed, &scope);
+        prev(unparsed);
         return scopedIdNodeCreate(components);
       }
     }
@@ -315,7 +296,7 @@ static Node *parseScopedId(FileListEntry *entry, Node *unparsed) {
     if (peek.type != TT_ID) {
       errorExpectedToken(entry, TT_ID, &peek);
 
-      prev(unparsed, &peek);
+      prev(unparsed);
 
       nodeVectorFree(components);
       return NULL;
@@ -326,7 +307,7 @@ static Node *parseScopedId(FileListEntry *entry, Node *unparsed) {
     // if there's a scope, keep going, else return
     next(unparsed, &peek);
     if (peek.type != TT_SCOPE) {
-      prev(unparsed, &peek);
+      prev(unparsed);
 
       if (components->size >= 2) {
         return scopedIdNodeCreate(components);
@@ -355,7 +336,7 @@ static Node *parseId(FileListEntry *entry, Node *unparsed) {
   if (id.type != TT_ID) {
     errorExpectedToken(entry, TT_ID, &id);
 
-    prev(unparsed, &id);
+    prev(unparsed);
     return NULL;
   }
 
@@ -385,12 +366,9 @@ static Node *parseExtendedIntLiteral(FileListEntry *entry, Node *unparsed,
     case TT_LIT_INT_B: {
       int8_t sign;
       uint64_t magnitude;
-      int retval = binaryToInteger(peek.string, &sign, &magnitude);
+      int retval = binaryToInteger(peek.string, peek.length, &sign, &magnitude);
       if (retval != 0) {
         errorIntOverflow(entry, &peek);
-
-        tokenUninit(&peek);
-
         return NULL;
       }
       Node *n = sizedIntegerLiteralNodeCreate(&peek, sign, magnitude);
@@ -400,12 +378,9 @@ static Node *parseExtendedIntLiteral(FileListEntry *entry, Node *unparsed,
     case TT_LIT_INT_O: {
       int8_t sign;
       uint64_t magnitude;
-      int retval = octalToInteger(peek.string, &sign, &magnitude);
+      int retval = octalToInteger(peek.string, peek.length, &sign, &magnitude);
       if (retval != 0) {
         errorIntOverflow(entry, &peek);
-
-        tokenUninit(&peek);
-
         return NULL;
       }
       Node *n = sizedIntegerLiteralNodeCreate(&peek, sign, magnitude);
@@ -416,12 +391,10 @@ static Node *parseExtendedIntLiteral(FileListEntry *entry, Node *unparsed,
     case TT_LIT_INT_D: {
       int8_t sign;
       uint64_t magnitude;
-      int retval = decimalToInteger(peek.string, &sign, &magnitude);
+      int retval =
+          decimalToInteger(peek.string, peek.length, &sign, &magnitude);
       if (retval != 0) {
         errorIntOverflow(entry, &peek);
-
-        tokenUninit(&peek);
-
         return NULL;
       }
       Node *n = sizedIntegerLiteralNodeCreate(&peek, sign, magnitude);
@@ -431,12 +404,10 @@ static Node *parseExtendedIntLiteral(FileListEntry *entry, Node *unparsed,
     case TT_LIT_INT_H: {
       int8_t sign;
       uint64_t magnitude;
-      int retval = hexadecimalToInteger(peek.string, &sign, &magnitude);
+      int retval =
+          hexadecimalToInteger(peek.string, peek.length, &sign, &magnitude);
       if (retval != 0) {
         errorIntOverflow(entry, &peek);
-
-        tokenUninit(&peek);
-
         return NULL;
       }
       Node *n = sizedIntegerLiteralNodeCreate(&peek, sign, magnitude);
@@ -444,7 +415,7 @@ static Node *parseExtendedIntLiteral(FileListEntry *entry, Node *unparsed,
       return n;
     }
     case TT_ID: {
-      prev(unparsed, &peek);
+      prev(unparsed);
       Node *n = parseScopedId(entry, unparsed);
       if (n == NULL) {
         return NULL;
@@ -455,7 +426,7 @@ static Node *parseExtendedIntLiteral(FileListEntry *entry, Node *unparsed,
         nodeFree(n);
         return NULL;
       } else if (stabEntry->kind != SK_ENUMCONST) {
-        fprintf(stderr,
+        fprintf(diagnosticStream(),
                 "%s:%zu:%zu: error: expected an extended integer "
                 "literal, found %s\n",
                 entry->inputFilename, n->line, n->character,
@@ -476,7 +447,7 @@ static Node *parseExtendedIntLiteral(FileListEntry *entry, Node *unparsed,
     default: {
       errorExpectedString(entry, "an exended integer literal", &peek);
 
-      prev(unparsed, &peek);
+      prev(unparsed);
 
       return NULL;
     }
@@ -520,7 +491,7 @@ static Node *parseAggregateInitializer(FileListEntry *entry, Node *unparsed,
       case TT_BAD_BIN:
       case TT_BAD_HEX: {
         // this is the start of a field
-        prev(unparsed, &peek);
+        prev(unparsed);
         Node *literal = parseLiteral(entry, unparsed, env);
         if (literal == NULL) {
           nodeVectorFree(literals);
@@ -532,9 +503,7 @@ static Node *parseAggregateInitializer(FileListEntry *entry, Node *unparsed,
         switch (peek.type) {
           case TT_RSQUARE: {
             // end of the init
-            Node *n = literalNodeCreate(LT_AGGREGATEINIT, start);
-            n->data.literal.data.aggregateInitVal = literals;
-            return n;
+            return aggregateInitLiteralNodeCreate(start, literals);
           }
           case TT_COMMA: {
             break;  // continue on
@@ -543,7 +512,7 @@ static Node *parseAggregateInitializer(FileListEntry *entry, Node *unparsed,
             errorExpectedString(entry, "a comma or a right square bracket",
                                 &peek);
 
-            prev(unparsed, &peek);
+            prev(unparsed);
 
             nodeVectorFree(literals);
             return NULL;
@@ -553,14 +522,12 @@ static Node *parseAggregateInitializer(FileListEntry *entry, Node *unparsed,
       }
       case TT_RSQUARE: {
         // end of the init
-        Node *n = literalNodeCreate(LT_AGGREGATEINIT, start);
-        n->data.literal.data.aggregateInitVal = literals;
-        return n;
+        return aggregateInitLiteralNodeCreate(start, literals);
       }
       default: {
         errorExpectedString(entry, "a literal", &peek);
 
-        prev(unparsed, &peek);
+        prev(unparsed);
 
         nodeVectorFree(literals);
         return NULL;
@@ -588,7 +555,7 @@ static Node *parseLiteral(FileListEntry *entry, Node *unparsed,
     case TT_LIT_INT_D:
     case TT_LIT_INT_H:
     case TT_ID: {
-      prev(unparsed, &peek);
+      prev(unparsed);
       return parseExtendedIntLiteral(entry, unparsed, env);
     }
     case TT_LIT_STRING: {
@@ -598,17 +565,19 @@ static Node *parseLiteral(FileListEntry *entry, Node *unparsed,
       return wstringLiteralNodeCreate(&peek);
     }
     case TT_LIT_DOUBLE: {
-      uint64_t bits = doubleStringToBits(peek.string);
+      char *string = tokenCopyString(&peek);
+      uint64_t bits = doubleStringToBits(string);
+      free(string);
       Node *n = literalNodeCreate(LT_DOUBLE, &peek);
       n->data.literal.data.doubleBits = bits;
-      tokenUninit(&peek);
       return n;
     }
     case TT_LIT_FLOAT: {
-      uint32_t bits = floatStringToBits(peek.string);
+      char *string = tokenCopyString(&peek);
+      uint32_t bits = floatStringToBits(string);
+      free(string);
       Node *n = literalNodeCreate(LT_FLOAT, &peek);
       n->data.literal.data.floatBits = bits;
-      tokenUninit(&peek);
       return n;
     }
 
@@ -634,7 +603,7 @@ static Node *parseLiteral(FileListEntry *entry, Node *unparsed,
     default: {
       errorExpectedString(entry, "a literal", &peek);
 
-      prev(unparsed, &peek);
+      prev(unparsed);
 
       return NULL;
     }
@@ -715,7 +684,7 @@ static Node *parseType(FileListEntry *entry, Node *unparsed, Environment *env,
         break;
       }
       case TT_ID: {
-        prev(unparsed, &start);
+        prev(unparsed);
         type = parseAnyId(entry, unparsed);
         if (type == NULL) return NULL;
         break;
@@ -723,7 +692,7 @@ static Node *parseType(FileListEntry *entry, Node *unparsed, Environment *env,
       default: {
         errorExpectedString(entry, "a type", &start);
 
-        prev(unparsed, &start);
+        prev(unparsed);
 
         return NULL;
       }
@@ -757,7 +726,7 @@ static Node *parseType(FileListEntry *entry, Node *unparsed, Environment *env,
         if (rsquare.type != TT_RSQUARE) {
           errorExpectedToken(entry, TT_RSQUARE, &rsquare);
 
-          prev(unparsed, &rsquare);
+          prev(unparsed);
 
           nodeFree(type);
           nodeFree(size);
@@ -781,7 +750,7 @@ static Node *parseType(FileListEntry *entry, Node *unparsed, Environment *env,
         if (peek.type == TT_RPAREN)
           doneArgs = true;
         else
-          prev(unparsed, &peek);
+          prev(unparsed);
         while (!doneArgs) {
           Token next2;
           next(unparsed, &next2);
@@ -801,7 +770,7 @@ static Node *parseType(FileListEntry *entry, Node *unparsed, Environment *env,
             case TT_DOUBLE:
             case TT_BOOL:
             case TT_ID: {
-              prev(unparsed, &next2);
+              prev(unparsed);
               Node *argType = parseType(entry, unparsed, env, NULL);
               if (argType == NULL) {
                 nodeVectorFree(argTypes);
@@ -813,11 +782,8 @@ static Node *parseType(FileListEntry *entry, Node *unparsed, Environment *env,
 
               Token id;
               next(unparsed, &id);
-              if (id.type == TT_ID)
-                // has an identifier - ignore this
-                tokenUninit(&id);
-              else
-                prev(unparsed, &id);
+              // if it has an identifier, ignore it
+              if (id.type != TT_ID) prev(unparsed);
 
               Token next3;
               next(unparsed, &next3);
@@ -835,7 +801,7 @@ static Node *parseType(FileListEntry *entry, Node *unparsed, Environment *env,
                   errorExpectedString(entry, "a comma or a right parenthesis",
                                       &next3);
 
-                  prev(unparsed, &next3);
+                  prev(unparsed);
 
                   nodeVectorFree(argTypes);
                   nodeFree(type);
@@ -847,7 +813,7 @@ static Node *parseType(FileListEntry *entry, Node *unparsed, Environment *env,
             default: {
               errorExpectedString(entry, "a type", &next2);
 
-              prev(unparsed, &next2);
+              prev(unparsed);
 
               nodeVectorFree(argTypes);
               nodeFree(type);
@@ -860,7 +826,7 @@ static Node *parseType(FileListEntry *entry, Node *unparsed, Environment *env,
         break;
       }
       default: {
-        prev(unparsed, &next1);
+        prev(unparsed);
         return type;
       }
     }
@@ -871,12 +837,11 @@ static Node *parseType(FileListEntry *entry, Node *unparsed, Environment *env,
  * parses a field or option declaration
  *
  * @param entry entry to lex from
- * @param start first token
  * @returns declaration or null if fatal error
  */
 static Node *parseFieldOrOptionDecl(FileListEntry *entry, Node *unparsed,
-                                    Environment *env, Token *start) {
-  prev(unparsed, start);
+                                    Environment *env) {
+  prev(unparsed);
   Node *type = parseType(entry, unparsed, env, NULL);
   if (type == NULL) {
     return NULL;
@@ -890,7 +855,7 @@ static Node *parseFieldOrOptionDecl(FileListEntry *entry, Node *unparsed,
     if (id.type != TT_ID) {
       errorExpectedToken(entry, TT_ID, &id);
 
-      prev(unparsed, &id);
+      prev(unparsed);
 
       nodeFree(type);
       nodeVectorFree(names);
@@ -914,7 +879,7 @@ static Node *parseFieldOrOptionDecl(FileListEntry *entry, Node *unparsed,
       default: {
         errorExpectedString(entry, "a semicolon or a comma", &peek);
 
-        prev(unparsed, &peek);
+        prev(unparsed);
 
         nodeFree(type);
         nodeVectorFree(names);
@@ -955,7 +920,7 @@ static Node *parsePrimaryExpression(FileListEntry *entry, Node *unparsed,
     next(unparsed, &peek);
     switch (peek.type) {
       case TT_ID: {
-        prev(unparsed, &peek);
+        prev(unparsed);
         Node *n = parseAnyId(entry, unparsed);
         SymbolTableEntry *stabEntry = environmentLookup(env, n, false);
         if (stabEntry == NULL) {
@@ -963,10 +928,10 @@ static Node *parsePrimaryExpression(FileListEntry *entry, Node *unparsed,
         } else if (stabEntry->kind != SK_ENUMCONST &&
                    stabEntry->kind != SK_FUNCTION &&
                    stabEntry->kind != SK_VARIABLE) {
-          fprintf(stderr,
+          fprintf(diagnosticStream(),
                   "%s:%zu:%zu: error: cannot use a type as a variable\n",
                   entry->inputFilename, n->line, n->character);
-          fprintf(stderr, "%s:%zu:%zu: note: declared here\n",
+          fprintf(diagnosticStream(), "%s:%zu:%zu: note: declared here\n",
                   stabEntry->file->inputFilename, stabEntry->line,
                   stabEntry->character);
           entry->errored = true;
@@ -998,7 +963,7 @@ static Node *parsePrimaryExpression(FileListEntry *entry, Node *unparsed,
       case TT_BAD_BIN:
       case TT_BAD_HEX:
       case TT_BAD_STRING: {
-        prev(unparsed, &peek);
+        prev(unparsed);
         return parseLiteral(entry, unparsed, env);
       }
       case TT_CAST: {
@@ -1007,7 +972,7 @@ static Node *parsePrimaryExpression(FileListEntry *entry, Node *unparsed,
         if (langle.type != TT_LANGLE) {
           errorExpectedToken(entry, TT_LANGLE, &langle);
 
-          prev(unparsed, &langle);
+          prev(unparsed);
           return NULL;
         }
 
@@ -1021,7 +986,7 @@ static Node *parsePrimaryExpression(FileListEntry *entry, Node *unparsed,
         if (rangle.type != TT_RANGLE) {
           errorExpectedToken(entry, TT_RANGLE, &rangle);
 
-          prev(unparsed, &rangle);
+          prev(unparsed);
 
           nodeFree(type);
           return NULL;
@@ -1032,7 +997,7 @@ static Node *parsePrimaryExpression(FileListEntry *entry, Node *unparsed,
         if (lparen.type != TT_LPAREN) {
           errorExpectedToken(entry, TT_LPAREN, &lparen);
 
-          prev(unparsed, &lparen);
+          prev(unparsed);
 
           nodeFree(type);
           return NULL;
@@ -1049,7 +1014,7 @@ static Node *parsePrimaryExpression(FileListEntry *entry, Node *unparsed,
         if (rparen.type != TT_RPAREN) {
           errorExpectedToken(entry, TT_RPAREN, &rparen);
 
-          prev(unparsed, &rparen);
+          prev(unparsed);
 
           nodeFree(target);
           nodeFree(type);
@@ -1091,7 +1056,7 @@ static Node *parsePrimaryExpression(FileListEntry *entry, Node *unparsed,
           case TT_DOUBLE:
           case TT_BOOL: {
             // unambiguously a type
-            prev(unparsed, &sizeofPeek);
+            prev(unparsed);
             Node *target = parseType(entry, unparsed, env, NULL);
             if (target == NULL) {
               return NULL;
@@ -1102,7 +1067,7 @@ static Node *parsePrimaryExpression(FileListEntry *entry, Node *unparsed,
             if (rparen.type != TT_RPAREN) {
               errorExpectedToken(entry, TT_RPAREN, &lparen);
 
-              prev(unparsed, &rparen);
+              prev(unparsed);
 
               nodeFree(target);
               return NULL;
@@ -1114,7 +1079,7 @@ static Node *parsePrimaryExpression(FileListEntry *entry, Node *unparsed,
           case TT_ID: {
             // maybe a type, maybe an expression - disambiguate
 
-            prev(unparsed, &peek);
+            prev(unparsed);
             Node *idNode = parseAnyId(entry, unparsed);
 
             SymbolTableEntry *symbolEntry =
@@ -1138,7 +1103,7 @@ static Node *parsePrimaryExpression(FileListEntry *entry, Node *unparsed,
                 if (rparen.type != TT_RPAREN) {
                   errorExpectedToken(entry, TT_RPAREN, &lparen);
 
-                  prev(unparsed, &rparen);
+                  prev(unparsed);
 
                   nodeFree(target);
                   return NULL;
@@ -1151,7 +1116,7 @@ static Node *parsePrimaryExpression(FileListEntry *entry, Node *unparsed,
               case SK_UNION:
               case SK_ENUM:
               case SK_TYPEDEF: {
-                prev(unparsed, &sizeofPeek);
+                prev(unparsed);
                 Node *target = parseType(entry, unparsed, env, idNode);
                 if (target == NULL) {
                   return NULL;
@@ -1162,7 +1127,7 @@ static Node *parsePrimaryExpression(FileListEntry *entry, Node *unparsed,
                 if (rparen.type != TT_RPAREN) {
                   errorExpectedToken(entry, TT_RPAREN, &lparen);
 
-                  prev(unparsed, &rparen);
+                  prev(unparsed);
 
                   nodeFree(target);
                   return NULL;
@@ -1207,7 +1172,7 @@ static Node *parsePrimaryExpression(FileListEntry *entry, Node *unparsed,
           case TT_NULL:
           case TT_LSQUARE: {
             // unambiguously an expression
-            prev(unparsed, &sizeofPeek);
+            prev(unparsed);
             Node *target = parseExpression(entry, unparsed, env, NULL);
             if (target == NULL) {
               return NULL;
@@ -1218,7 +1183,7 @@ static Node *parsePrimaryExpression(FileListEntry *entry, Node *unparsed,
             if (rparen.type != TT_RPAREN) {
               errorExpectedToken(entry, TT_RPAREN, &lparen);
 
-              prev(unparsed, &rparen);
+              prev(unparsed);
 
               nodeFree(target);
               return NULL;
@@ -1230,7 +1195,7 @@ static Node *parsePrimaryExpression(FileListEntry *entry, Node *unparsed,
             // unexpected token
             errorExpectedString(entry, "a type or an expression", &sizeofPeek);
 
-            prev(unparsed, &sizeofPeek);
+            prev(unparsed);
             return NULL;
           }
         }
@@ -1255,7 +1220,7 @@ static Node *parsePrimaryExpression(FileListEntry *entry, Node *unparsed,
       default: {
         errorExpectedString(entry, "a primary expression", &peek);
 
-        prev(unparsed, &peek);
+        prev(unparsed);
         return NULL;
       }
     }
@@ -1309,7 +1274,7 @@ static Node *parsePostfixExpression(FileListEntry *entry, Node *unparsed,
         if (peek.type == TT_RPAREN) {
           exp = funCallExpNodeCreate(exp, arguments);
         } else {
-          prev(unparsed, &peek);
+          prev(unparsed);
           Node *arg = parseAssignmentExpression(entry, unparsed, env, NULL);
           if (arg == NULL) {
             nodeVectorFree(arguments);
@@ -1343,7 +1308,7 @@ static Node *parsePostfixExpression(FileListEntry *entry, Node *unparsed,
                 errorExpectedString(entry, "a comma or a right-parenthesis",
                                     &peek);
 
-                prev(unparsed, &peek);
+                prev(unparsed);
 
                 nodeVectorFree(arguments);
                 nodeFree(exp);
@@ -1383,7 +1348,7 @@ static Node *parsePostfixExpression(FileListEntry *entry, Node *unparsed,
         break;
       }
       default: {
-        prev(unparsed, &op);
+        prev(unparsed);
         return exp;
       }
     }
@@ -1422,7 +1387,7 @@ static Node *parsePrefixExpression(FileListEntry *entry, Node *unparsed,
                                        target);
       }
       default: {
-        prev(unparsed, &peek);
+        prev(unparsed);
         return parsePostfixExpression(entry, unparsed, env, NULL);
       }
     }
@@ -1465,7 +1430,7 @@ static Node *parseMultiplicationExpression(FileListEntry *entry, Node *unparsed,
         break;
       }
       default: {
-        prev(unparsed, &op);
+        prev(unparsed);
         return exp;
       }
     }
@@ -1505,7 +1470,7 @@ static Node *parseAdditionExpression(FileListEntry *entry, Node *unparsed,
         break;
       }
       default: {
-        prev(unparsed, &op);
+        prev(unparsed);
         return exp;
       }
     }
@@ -1546,7 +1511,7 @@ static Node *parseShiftExpression(FileListEntry *entry, Node *unparsed,
         break;
       }
       default: {
-        prev(unparsed, &op);
+        prev(unparsed);
         return exp;
       }
     }
@@ -1588,7 +1553,7 @@ static Node *parseComparisonExpression(FileListEntry *entry, Node *unparsed,
         break;
       }
       default: {
-        prev(unparsed, &op);
+        prev(unparsed);
         return exp;
       }
     }
@@ -1628,7 +1593,7 @@ static Node *parseEqualityExpression(FileListEntry *entry, Node *unparsed,
         break;
       }
       default: {
-        prev(unparsed, &op);
+        prev(unparsed);
         return exp;
       }
     }
@@ -1669,7 +1634,7 @@ static Node *parseBitwiseExpression(FileListEntry *entry, Node *unparsed,
         break;
       }
       default: {
-        prev(unparsed, &op);
+        prev(unparsed);
         return exp;
       }
     }
@@ -1709,7 +1674,7 @@ static Node *parseLogicalExpression(FileListEntry *entry, Node *unparsed,
         break;
       }
       default: {
-        prev(unparsed, &op);
+        prev(unparsed);
         return exp;
       }
     }
@@ -1736,7 +1701,7 @@ static Node *parseTernaryExpression(FileListEntry *entry, Node *unparsed,
   Token question;
   next(unparsed, &question);
   if (question.type != TT_QUESTION) {
-    prev(unparsed, &question);
+    prev(unparsed);
     return predicate;
   }
 
@@ -1751,7 +1716,7 @@ static Node *parseTernaryExpression(FileListEntry *entry, Node *unparsed,
   if (colon.type != TT_COLON) {
     errorExpectedToken(entry, TT_COLON, &colon);
 
-    prev(unparsed, &colon);
+    prev(unparsed);
 
     nodeFree(consequent);
     nodeFree(predicate);
@@ -1811,7 +1776,7 @@ static Node *parseAssignmentExpression(FileListEntry *entry, Node *unparsed,
       return binOpExpNodeCreate(assignmentTokenToBinop(op.type), lhs, rhs);
     }
     default: {
-      prev(unparsed, &op);
+      prev(unparsed);
       return lhs;
     }
   }
@@ -1837,7 +1802,7 @@ static Node *parseExpression(FileListEntry *entry, Node *unparsed,
   Token comma;
   next(unparsed, &comma);
   if (comma.type != TT_COMMA) {
-    prev(unparsed, &comma);
+    prev(unparsed);
     return lhs;
   }
 
@@ -1875,7 +1840,7 @@ static Node *parseSwitchCase(FileListEntry *entry, Node *unparsed,
   if (colon.type != TT_COLON) {
     errorExpectedToken(entry, TT_COLON, &colon);
 
-    prev(unparsed, &colon);
+    prev(unparsed);
 
     nodeVectorFree(values);
     return NULL;
@@ -1896,13 +1861,13 @@ static Node *parseSwitchCase(FileListEntry *entry, Node *unparsed,
       if (colon.type != TT_COLON) {
         errorExpectedToken(entry, TT_COLON, &colon);
 
-        prev(unparsed, &colon);
+        prev(unparsed);
 
         nodeVectorFree(values);
         return NULL;
       }
     } else {
-      prev(unparsed, &peek);
+      prev(unparsed);
 
       environmentPush(env, hashMapCreate());
       Node *body = parseStmt(entry, unparsed, env);
@@ -1936,7 +1901,7 @@ static Node *parseSwitchDefault(FileListEntry *entry, Node *unparsed,
   if (colon.type != TT_COLON) {
     errorExpectedToken(entry, TT_COLON, &colon);
 
-    prev(unparsed, &colon);
+    prev(unparsed);
     panicSwitch(unparsed);
     return NULL;
   }
@@ -1956,6 +1921,23 @@ static Node *parseSwitchDefault(FileListEntry *entry, Node *unparsed,
 
 // context sensitive parsers
 
+/**
+ * pops a block's scope, laying out the types defined in it
+ *
+ * Any local opaque type has been defined by the time its block ends, so this is
+ * the earliest all of the block's types can be laid out.
+ *
+ * @param env environment to pop from
+ *
+ * @returns popped symbol table
+ */
+static HashMap *closeScope(Environment *env) {
+  HashMap *stab = environmentPop(env);
+  for (size_t idx = 0; idx < stab->size; ++idx)
+    stabEntryLayout(stab->values[idx]);
+  return stab;
+}
+
 /**
  * parses a compound stmt
  *
@@ -1978,19 +1960,19 @@ static Node *parseCompoundStmt(FileListEntry *entry, Node *unparsed,
     next(unparsed, &peek);
     switch (peek.type) {
       case TT_RBRACE: {
-        return compoundStmtNodeCreate(&lbrace, stmts, environmentPop(env));
+        return compoundStmtNodeCreate(&lbrace, stmts, closeScope(env));
       }
       case TT_EOF: {
-        fprintf(stderr, "%s:%zu:%zu: error: unmatched left brace\n",
+        fprintf(diagnosticStream(), "%s:%zu:%zu: error: unmatched left brace\n",
                 entry->inputFilename, lbrace.line, lbrace.character);
         entry->errored = true;
 
-        prev(unparsed, &peek);
+        prev(unparsed);
 
-        return compoundStmtNodeCreate(&lbrace, stmts, environmentPop(env));
+        return compoundStmtNodeCreate(&lbrace, stmts, closeScope(env));
       }
       default: {
-        prev(unparsed, &peek);
+        prev(unparsed);
         Node *stmt = parseStmt(entry, unparsed, env);
         if (stmt != NULL) vectorInsert(stmts, stmt);
         break;
@@ -2016,7 +1998,7 @@ static Node *parseIfStmt(FileListEntry *entry, Node *unparsed, Environment *env,
   if (lparen.type != TT_LPAREN) {
     errorExpectedToken(entry, TT_LPAREN, &lparen);
 
-    prev(unparsed, &lparen);
+    prev(unparsed);
     panicStmt(unparsed);
     return NULL;
   }
@@ -2032,7 +2014,7 @@ static Node *parseIfStmt(FileListEntry *entry, Node *unparsed, Environment *env,
   if (rparen.type != TT_RPAREN) {
     errorExpectedToken(entry, TT_RPAREN, &rparen);
 
-    prev(unparsed, &rparen);
+    prev(unparsed);
     panicStmt(unparsed);
 
     nodeFree(predicate);
@@ -2051,7 +2033,7 @@ static Node *parseIfStmt(FileListEntry *entry, Node *unparsed, Environment *env,
   Token elseKwd;
   next(unparsed, &elseKwd);
   if (elseKwd.type != TT_ELSE) {
-    prev(unparsed, &elseKwd);
+    prev(unparsed);
     return ifStmtNodeCreate(start, predicate, consequent, consequentStab, NULL,
                             NULL);
   }
@@ -2088,7 +2070,7 @@ static Node *parseWhileStmt(FileListEntry *entry, Node *unparsed,
   if (lparen.type != TT_LPAREN) {
     errorExpectedToken(entry, TT_LPAREN, &lparen);
 
-    prev(unparsed, &lparen);
+    prev(unparsed);
     panicStmt(unparsed);
     return NULL;
   }
@@ -2104,7 +2086,7 @@ static Node *parseWhileStmt(FileListEntry *entry, Node *unparsed,
   if (rparen.type != TT_RPAREN) {
     errorExpectedToken(entry, TT_RPAREN, &rparen);
 
-    prev(unparsed, &rparen);
+    prev(unparsed);
     panicStmt(unparsed);
 
     nodeFree(condition);
@@ -2150,7 +2132,7 @@ static Node *parseDoWhileStmt(FileListEntry *entry, Node *unparsed,
   if (whileKwd.type != TT_WHILE) {
     errorExpectedToken(entry, TT_WHILE, &whileKwd);
 
-    prev(unparsed, &whileKwd);
+    prev(unparsed);
     panicStmt(unparsed);
 
     nodeFree(body);
@@ -2163,7 +2145,7 @@ static Node *parseDoWhileStmt(FileListEntry *entry, Node *unparsed,
   if (lparen.type != TT_LPAREN) {
     errorExpectedToken(entry, TT_LPAREN, &lparen);
 
-    prev(unparsed, &lparen);
+    prev(unparsed);
     panicStmt(unparsed);
 
     nodeFree(body);
@@ -2185,7 +2167,7 @@ static Node *parseDoWhileStmt(FileListEntry *entry, Node *unparsed,
   if (rparen.type != TT_RPAREN) {
     errorExpectedToken(entry, TT_RPAREN, &rparen);
 
-    prev(unparsed, &rparen);
+    prev(unparsed);
     panicStmt(unparsed);
 
     nodeFree(condition);
@@ -2256,7 +2238,7 @@ static Node *parseForInitStmt(FileListEntry *entry, Node *unparsed,
     case TT_NULL:
     case TT_LSQUARE:
     case TT_SEMI: {
-      prev(unparsed, &peek);
+      prev(unparsed);
       return parseStmt(entry, unparsed, env);
     }
     default: {
@@ -2264,7 +2246,7 @@ static Node *parseForInitStmt(FileListEntry *entry, Node *unparsed,
           entry, "a variable declaration, an expression, or a semicolon",
           &peek);
 
-      prev(unparsed, &peek);
+      prev(unparsed);
       panicStmt(unparsed);
       return NULL;
     }
@@ -2288,7 +2270,7 @@ static Node *parseForStmt(FileListEntry *entry, Node *unparsed,
   if (lparen.type != TT_LPAREN) {
     errorExpectedToken(entry, TT_LPAREN, &lparen);
 
-    prev(unparsed, &lparen);
+    prev(unparsed);
     panicStmt(unparsed);
     return NULL;
   }
@@ -2315,7 +2297,7 @@ static Node *parseForStmt(FileListEntry *entry, Node *unparsed,
   if (semi.type != TT_SEMI) {
     errorExpectedToken(entry, TT_SEMI, &semi);
 
-    prev(unparsed, &semi);
+    prev(unparsed);
     panicStmt(unparsed);
 
     nodeFree(condition);
@@ -2329,7 +2311,7 @@ static Node *parseForStmt(FileListEntry *entry, Node *unparsed,
   Node *increment = NULL;
   if (peek.type != TT_RPAREN) {
     // increment isn't null
-    prev(unparsed, &peek);
+    prev(unparsed);
     increment = parseExpression(entry, unparsed, env, NULL);
     if (increment == NULL) {
       panicStmt(unparsed);
@@ -2340,7 +2322,7 @@ static Node *parseForStmt(FileListEntry *entry, Node *unparsed,
       return NULL;
     }
   } else {
-    prev(unparsed, &peek);
+    prev(unparsed);
   }
 
   Token rparen;
@@ -2348,7 +2330,7 @@ static Node *parseForStmt(FileListEntry *entry, Node *unparsed,
   if (rparen.type != TT_RPAREN) {
     errorExpectedToken(entry, TT_RPAREN, &rparen);
 
-    prev(unparsed, &rparen);
+    prev(unparsed);
     panicStmt(unparsed);
 
     nodeFree(increment);
@@ -2391,7 +2373,7 @@ static Node *parseSwitchStmt(FileListEntry *entry, Node *unparsed,
   if (lparen.type != TT_LPAREN) {
     errorExpectedToken(entry, TT_LPAREN, &lparen);
 
-    prev(unparsed, &lparen);
+    prev(unparsed);
     panicStmt(unparsed);
     return NULL;
   }
@@ -2407,7 +2389,7 @@ static Node *parseSwitchStmt(FileListEntry *entry, Node *unparsed,
   if (rparen.type != TT_RPAREN) {
     errorExpectedToken(entry, TT_RPAREN, &rparen);
 
-    prev(unparsed, &rparen);
+    prev(unparsed);
     panicStmt(unparsed);
 
     nodeFree(condition);
@@ -2419,7 +2401,7 @@ static Node *parseSwitchStmt(FileListEntry *entry, Node *unparsed,
   if (lbrace.type != TT_LBRACE) {
     errorExpectedToken(entry, TT_LBRACE, &lbrace);
 
-    prev(unparsed, &lbrace);
+    prev(unparsed);
     panicStmt(unparsed);
 
     nodeFree(condition);
@@ -2457,7 +2439,7 @@ static Node *parseSwitchStmt(FileListEntry *entry, Node *unparsed,
       default: {
         errorExpectedString(entry, "a right brace of a switch case", &peek);
 
-        prev(unparsed, &peek);
+        prev(unparsed);
         panicStmt(unparsed);
 
         nodeVectorFree(cases);
@@ -2468,7 +2450,7 @@ static Node *parseSwitchStmt(FileListEntry *entry, Node *unparsed,
   }
 
   if (cases->size == 0) {
-    fprintf(stderr,
+    fprintf(diagnosticStream(),
             "%s:%zu:%zu: error: expected at least one case in a switch "
             "statement\n",
             entry->inputFilename, lbrace.line, lbrace.character);
@@ -2499,7 +2481,7 @@ static Node *parseBreakStmt(FileListEntry *entry, Node *unparsed,
   if (semi.type != TT_SEMI) {
     errorExpectedToken(entry, TT_SEMI, &semi);
 
-    prev(unparsed, &semi);
+    prev(unparsed);
     panicStmt(unparsed);
     return NULL;
   }
@@ -2524,7 +2506,7 @@ static Node *parseContinueStmt(FileListEntry *entry, Node *unparsed,
   if (semi.type != TT_SEMI) {
     errorExpectedToken(entry, TT_SEMI, &semi);
 
-    prev(unparsed, &semi);
+    prev(unparsed);
     panicStmt(unparsed);
     return NULL;
   }
@@ -2549,7 +2531,7 @@ static Node *parseReturnStmt(FileListEntry *entry, Node *unparsed,
   if (peek.type == TT_SEMI) {
     return returnStmtNodeCreate(start, NULL);
   } else {
-    prev(unparsed, &peek);
+    prev(unparsed);
     Node *value = parseExpression(entry, unparsed, env, NULL);
 
     Token semi;
@@ -2557,7 +2539,7 @@ static Node *parseReturnStmt(FileListEntry *entry, Node *unparsed,
     if (semi.type != TT_SEMI) {
       errorExpectedToken(entry, TT_SEMI, &semi);
 
-      prev(unparsed, &semi);
+      prev(unparsed);
       panicStmt(unparsed);
 
       nodeFree(value);
@@ -2632,7 +2614,7 @@ static Node *parseVarDefnStmt(FileListEntry *entry, Node *unparsed,
           default: {
             errorExpectedString(entry, "a comma or a semicolon", &peek);
 
-            prev(unparsed, &peek);
+            prev(unparsed);
             panicStmt(unparsed);
 
             nodeVectorFree(initializers);
@@ -2652,7 +2634,7 @@ static Node *parseVarDefnStmt(FileListEntry *entry, Node *unparsed,
         // done
         vectorInsert(initializers, NULL);
         if (names->size == 0) {
-          fprintf(stderr,
+          fprintf(diagnosticStream(),
                   "%s:%zu:%zu: error: expected at least one name in a variable "
                   "declaration\n",
                   entry->inputFilename, typeNode->line, typeNode->character);
@@ -2671,7 +2653,7 @@ static Node *parseVarDefnStmt(FileListEntry *entry, Node *unparsed,
         errorExpectedString(entry, "a comma, a semicolon, or an equals sign",
                             &peek);
 
-        prev(unparsed, &peek);
+        prev(unparsed);
         panicStmt(unparsed);
 
         nodeVectorFree(initializers);
@@ -2694,7 +2676,7 @@ static Node *parseVarDefnStmt(FileListEntry *entry, Node *unparsed,
     Node *name = names->elements[idx];
     name->data.id.entry = variableStabEntryCreate(
         entry, name->line, name->character, name->data.id.id);
-    name->data.id.entry->data.variable.type = typeCopy(type);
+    name->data.id.entry->data.variable.type = type;
 
     SymbolTableEntry *existing =
         hashMapGet(environmentTop(env), name->data.id.id);
@@ -2704,9 +2686,8 @@ static Node *parseVarDefnStmt(FileListEntry *entry, Node *unparsed,
                          existing->file, existing->line, existing->character);
     }
 
-    hashMapPut(environmentTop(env), name->data.id.id, name->data.id.entry);
+    environmentPut(env, name->data.id.id, name->data.id.entry);
   }
-  typeFree(type);
 
   return varDefnStmtNodeCreate(typeNode, names, initializers);
 }
@@ -2734,7 +2715,7 @@ static Node *parseExpressionStmt(FileListEntry *entry, Node *unparsed,
   if (semi.type != TT_SEMI) {
     errorExpectedToken(entry, TT_SEMI, &semi);
 
-    prev(unparsed, &semi);
+    prev(unparsed);
     panicStmt(unparsed);
 
     nodeFree(expression);
@@ -2767,7 +2748,7 @@ static Node *parseOpaqueDecl(FileListEntry *entry, Node *unparsed,
   if (semicolon.type != TT_SEMI) {
     errorExpectedToken(entry, TT_SEMI, &semicolon);
 
-    prev(unparsed, &semicolon);
+    prev(unparsed);
     panicStmt(unparsed);
 
     nodeFree(name);
@@ -2785,7 +2766,7 @@ static Node *parseOpaqueDecl(FileListEntry *entry, Node *unparsed,
                        existing->file, existing->line, existing->character);
   }
 
-  hashMapPut(environmentTop(env), name->data.id.id, name->data.id.entry);
+  environmentPut(env, name->data.id.id, name->data.id.entry);
   return opaqueDeclNodeCreate(start, name);
 }
 
@@ -2812,7 +2793,7 @@ static Node *parseStructDecl(FileListEntry *entry, Node *unparsed,
   if (lbrace.type != TT_LBRACE) {
     errorExpectedToken(entry, TT_LBRACE, &lbrace);
 
-    prev(unparsed, &lbrace);
+    prev(unparsed);
     panicStmt(unparsed);
 
     nodeFree(name);
@@ -2841,7 +2822,7 @@ static Node *parseStructDecl(FileListEntry *entry, Node *unparsed,
       case TT_BOOL:
       case TT_ID: {
         // start of a field
-        Node *field = parseFieldOrOptionDecl(entry, unparsed, env, &peek);
+        Node *field = parseFieldOrOptionDecl(entry, unparsed, env);
         if (field == NULL) {
           panicStructOrUnion(unparsed);
           continue;
@@ -2856,7 +2837,7 @@ static Node *parseStructDecl(FileListEntry *entry, Node *unparsed,
       default: {
         errorExpectedString(entry, "a right brace or a field", &peek);
 
-        prev(unparsed, &peek);
+        prev(unparsed);
         panicStmt(unparsed);
 
         nodeFree(name);
@@ -2867,7 +2848,7 @@ static Node *parseStructDecl(FileListEntry *entry, Node *unparsed,
   }
 
   if (fields->size == 0) {
-    fprintf(stderr,
+    fprintf(diagnosticStream(),
             "%s:%zu:%zu: error: expected at least one field in a struct "
             "declaration\n",
             entry->inputFilename, lbrace.line, lbrace.character);
@@ -2883,7 +2864,7 @@ static Node *parseStructDecl(FileListEntry *entry, Node *unparsed,
   if (semicolon.type != TT_SEMI) {
     errorExpectedToken(entry, TT_SEMI, &semicolon);
 
-    prev(unparsed, &semicolon);
+    prev(unparsed);
     panicStmt(unparsed);
 
     nodeFree(name);
@@ -2898,8 +2879,11 @@ static Node *parseStructDecl(FileListEntry *entry, Node *unparsed,
       // overwrite the opaque
       name->data.id.entry = existing;
       existing->kind = SK_STRUCT;
-      vectorInit(&existing->data.structType.fieldNames);
+      stringVectorInit(&existing->data.structType.fieldNames);
       vectorInit(&existing->data.structType.fieldTypes);
+      existing->data.structType.layout.state = LS_NONE;
+      existing->data.structType.fieldOffsets = NULL;
+      hashMapInit(&existing->data.structType.fieldOffsetMap);
       finishStructStab(entry, body, name->data.id.entry, env);
     } else {
       // whoops - this already exists! complain!
@@ -2910,7 +2894,7 @@ static Node *parseStructDecl(FileListEntry *entry, Node *unparsed,
     // create a new entry
     name->data.id.entry = structStabEntryCreate(
         entry, start->line, start->character, name->data.id.id);
-    hashMapPut(environmentTop(env), name->data.id.id, name->data.id.entry);
+    environmentPut(env, name->data.id.id, name->data.id.entry);
     finishStructStab(entry, body, name->data.id.entry, env);
   }
 
@@ -2940,7 +2924,7 @@ static Node *parseUnionDecl(FileListEntry *entry, Node *unparsed,
   if (lbrace.type != TT_LBRACE) {
     errorExpectedToken(entry, TT_LBRACE, &lbrace);
 
-    prev(unparsed, &lbrace);
+    prev(unparsed);
     panicStmt(unparsed);
 
     nodeFree(name);
@@ -2969,7 +2953,7 @@ static Node *parseUnionDecl(FileListEntry *entry, Node *unparsed,
       case TT_BOOL:
       case TT_ID: {
         // start of an option
-        Node *option = parseFieldOrOptionDecl(entry, unparsed, env, &peek);
+        Node *option = parseFieldOrOptionDecl(entry, unparsed, env);
         if (option == NULL) {
           panicStructOrUnion(unparsed);
           continue;
@@ -2984,7 +2968,7 @@ static Node *parseUnionDecl(FileListEntry *entry, Node *unparsed,
       default: {
         errorExpectedString(entry, "a right brace or an option", &peek);
 
-        prev(unparsed, &peek);
+        prev(unparsed);
         panicStmt(unparsed);
 
         nodeFree(name);
@@ -2995,7 +2979,7 @@ static Node *parseUnionDecl(FileListEntry *entry, Node *unparsed,
   }
 
   if (options->size == 0) {
-    fprintf(stderr,
+    fprintf(diagnosticStream(),
             "%s:%zu:%zu: error: expected at least one options in a union "
             "declaration\n",
             entry->inputFilename, lbrace.line, lbrace.character);
@@ -3011,7 +2995,7 @@ static Node *parseUnionDecl(FileListEntry *entry, Node *unparsed,
   if (semicolon.type != TT_SEMI) {
     errorExpectedToken(entry, TT_SEMI, &semicolon);
 
-    prev(unparsed, &semicolon);
+    prev(unparsed);
     panicStmt(unparsed);
 
     nodeFree(name);
@@ -3026,8 +3010,9 @@ static Node *parseUnionDecl(FileListEntry *entry, Node *unparsed,
       // overwrite the opaque
       name->data.id.entry = existing;
       existing->kind = SK_UNION;
-      vectorInit(&existing->data.unionType.optionNames);
+      stringVectorInit(&existing->data.unionType.optionNames);
       vectorInit(&existing->data.unionType.optionTypes);
+      existing->data.unionType.layout.state = LS_NONE;
       finishUnionStab(entry, body, name->data.id.entry, env);
     } else {
       // whoops - this already exists! complain!
@@ -3038,7 +3023,7 @@ static Node *parseUnionDecl(FileListEntry *entry, Node *unparsed,
     // create a new entry
     name->data.id.entry = unionStabEntryCreate(
         entry, start->line, start->character, name->data.id.id);
-    hashMapPut(environmentTop(env), name->data.id.id, name->data.id.entry);
+    environmentPut(env, name->data.id.id, name->data.id.entry);
     finishUnionStab(entry, body, name->data.id.entry, env);
   }
 
@@ -3068,7 +3053,7 @@ static Node *parseEnumDecl(FileListEntry *entry, Node *unparsed,
   if (lbrace.type != TT_LBRACE) {
     errorExpectedToken(entry, TT_LBRACE, &lbrace);
 
-    prev(unparsed, &lbrace);
+    prev(unparsed);
     panicStmt(unparsed);
 
     nodeFree(name);
@@ -3113,7 +3098,7 @@ static Node *parseEnumDecl(FileListEntry *entry, Node *unparsed,
               default: {
                 errorExpectedString(entry, "a comma or a right brace", &peek);
 
-                prev(unparsed, &peek);
+                prev(unparsed);
                 panicEnum(unparsed);
                 continue;
               }
@@ -3136,7 +3121,7 @@ static Node *parseEnumDecl(FileListEntry *entry, Node *unparsed,
             errorExpectedString(
                 entry, "a comma, an equals sign, or a right brace", &peek);
 
-            prev(unparsed, &peek);
+            prev(unparsed);
             panicEnum(unparsed);
             continue;
           }
@@ -3151,7 +3136,7 @@ static Node *parseEnumDecl(FileListEntry *entry, Node *unparsed,
         errorExpectedString(entry, "a right brace or an enumeration constant",
                             &peek);
 
-        prev(unparsed, &peek);
+        prev(unparsed);
         panicStmt(unparsed);
 
         nodeFree(name);
@@ -3163,7 +3148,7 @@ static Node *parseEnumDecl(FileListEntry *entry, Node *unparsed,
   }
 
   if (constantNames->size == 0) {
-    fprintf(stderr,
+    fprintf(diagnosticStream(),
             "%s:%zu:%zu: error: expected at least one enumeration constant in "
             "a enumeration declaration\n",
             entry->inputFilename, lbrace.line, lbrace.character);
@@ -3182,7 +3167,7 @@ static Node *parseEnumDecl(FileListEntry *entry, Node *unparsed,
   if (semicolon.type != TT_SEMI) {
     errorExpectedToken(entry, TT_SEMI, &semicolon);
 
-    prev(unparsed, &semicolon);
+    prev(unparsed);
     panicStmt(unparsed);
 
     nodeFree(name);
@@ -3199,8 +3184,9 @@ static Node *parseEnumDecl(FileListEntry *entry, Node *unparsed,
       // overwrite the opaque
       name->data.id.entry = existing;
       existing->kind = SK_ENUM;
-      vectorInit(&existing->data.enumType.constantNames);
+      stringVectorInit(&existing->data.enumType.constantNames);
       vectorInit(&existing->data.enumType.constantValues);
+      existing->data.enumType.layout.state = LS_NONE;
       finishEnumStab(entry, body, name->data.id.entry, env);
     } else {
       // whoops - this already exists! complain!
@@ -3211,7 +3197,7 @@ static Node *parseEnumDecl(FileListEntry *entry, Node *unparsed,
     // create a new entry
     name->data.id.entry = enumStabEntryCreate(
         entry, start->line, start->character, name->data.id.id);
-    hashMapPut(environmentTop(env), name->data.id.id, name->data.id.entry);
+    environmentPut(env, name->data.id.id, name->data.id.entry);
     finishEnumStab(entry, body, name->data.id.entry, env);
   }
 
@@ -3250,7 +3236,7 @@ static Node *parseTypedefDecl(FileListEntry *entry, Node *unparsed,
   if (semicolon.type != TT_SEMI) {
     errorExpectedToken(entry, TT_SEMI, &semicolon);
 
-    prev(unparsed, &semicolon);
+    prev(unparsed);
     panicStmt(unparsed);
 
     nodeFree(originalType);
@@ -3276,7 +3262,7 @@ static Node *parseTypedefDecl(FileListEntry *entry, Node *unparsed,
     // create a new entry
     name->data.id.entry = typedefStabEntryCreate(
         entry, start->line, start->character, name->data.id.id);
-    hashMapPut(environmentTop(env), name->data.id.id, name->data.id.entry);
+    environmentPut(env, name->data.id.id, name->data.id.entry);
     finishTypedefStab(entry, body, name->data.id.entry, env);
   }
 
@@ -3298,7 +3284,7 @@ static Node *parseStmt(FileListEntry *entry, Node *unparsed, Environment *env) {
   switch (peek.type) {
     case TT_LBRACE: {
       // another compoundStmt
-      prev(unparsed, &peek);
+      prev(unparsed);
       return parseCompoundStmt(entry, unparsed, env);
     }
     case TT_IF: {
@@ -3339,14 +3325,14 @@ static Node *parseStmt(FileListEntry *entry, Node *unparsed, Environment *env) {
     case TT_FLOAT:
     case TT_DOUBLE:
     case TT_BOOL: {
-      prev(unparsed, &peek);
+      prev(unparsed);
       return parseVarDefnStmt(entry, unparsed, env, NULL);
     }
     case TT_ID: {
       // maybe varDefn, maybe expressionStmt - disambiguate
 
       // get the whole ID, if it's scoped
-      prev(unparsed, &peek);
+      prev(unparsed);
       Node *idNode = parseAnyId(entry, unparsed);
 
       SymbolTableEntry *symbolEntry = environmentLookup(env, idNode, false);
@@ -3404,7 +3390,7 @@ static Node *parseStmt(FileListEntry *entry, Node *unparsed, Environment *env) {
     case TT_FALSE:
     case TT_NULL: {
       // unambiguously an expressionStmt
-      prev(unparsed, &peek);
+      prev(unparsed);
       return parseExpressionStmt(entry, unparsed, env, NULL);
     }
     case TT_OPAQUE: {
@@ -3429,7 +3415,7 @@ static Node *parseStmt(FileListEntry *entry, Node *unparsed, Environment *env) {
       // unexpected token
       errorExpectedString(entry, "a declaration or a statement", &peek);
 
-      prev(unparsed, &peek);
+      prev(unparsed);
 
       panicStmt(unparsed);
       return NULL;
@@ -3437,58 +3423,40 @@ static Node *parseStmt(FileListEntry *entry, Node *unparsed, Environment *env) {
   }
 }
 
-void parseFunctionBody(FileListEntry *entry) {
+void parseFunctionBody(FileListEntry *entry, Node *body) {
   Environment env;
   environmentInit(&env, entry);
 
-  for (size_t bodyIdx = 0; bodyIdx < entry->ast->data.file.bodies->size;
-       ++bodyIdx) {
-    // for each top level thing
-    Node *body = entry->ast->data.file.bodies->elements[bodyIdx];
-    switch (body->type) {
-      // if it's a funDefn
-      case NT_FUNDEFN: {
-        SymbolTableEntry *functionEntry =
-            body->data.funDefn.name->data.id.entry;
-        // setup stab for arguments
-        HashMap *stab = body->data.funDefn.argStab;
-        environmentPush(&env, stab);
-
-        for (size_t argIdx = 0; argIdx < body->data.funDefn.argTypes->size;
-             ++argIdx) {
-          Node *argType = body->data.funDefn.argTypes->elements[argIdx];
-          Node *argName = body->data.funDefn.argNames->elements[argIdx];
-          SymbolTableEntry *stabEntry = variableStabEntryCreate(
-              entry, argType->line, argType->character, argName->data.id.id);
-          stabEntry->data.variable.type = nodeToType(argType, &env);
-          if (stabEntry->data.variable.type == NULL) entry->errored = true;
-          SymbolTableEntry *existing = hashMapGet(stab, argName->data.id.id);
-          if (existing != NULL) {
-            // already exists - complain!
-            errorRedeclaration(entry, argName->line, argName->character,
-                               argName->data.id.id, existing->file,
-                               existing->line, existing->character);
-          } else {
-            hashMapPut(stab, argName->data.id.id, stabEntry);
-            vectorInsert(&functionEntry->data.function.argumentEntries,
-                         stabEntry);
-          }
-        }
-
-        // parse and reference resolve body, replacing it in the original ast
-        Node *unparsed = body->data.funDefn.body;
-        body->data.funDefn.body = parseCompoundStmt(entry, unparsed, &env);
-        nodeFree(unparsed);
-
-        environmentPop(&env);
-        break;
-      }
-      default: {
-        // don't need to do anything
-        break;
-      }
+  SymbolTableEntry *functionEntry = body->data.funDefn.name->data.id.entry;
+  // setup stab for arguments
+  HashMap *stab = body->data.funDefn.argStab;
+  environmentPush(&env, stab);
+
+  for (size_t argIdx = 0; argIdx < body->data.funDefn.argTypes->size;
+       ++argIdx) {
+    Node *argType = body->data.funDefn.argTypes->elements[argIdx];
+    Node *argName = body->data.funDefn.argNames->elements[argIdx];
+    SymbolTableEntry *stabEntry = variableStabEntryCreate(
+        entry, argType->line, argType->character, argName->data.id.id);
+    stabEntry->data.variable.type = nodeToType(argType, &env);
+    if (stabEntry->data.variable.type == NULL) entry->errored = true;
+    SymbolTableEntry *existing = hashMapGet(stab, argName->data.id.id);
+    if (existing != NULL) {
+      // already exists - complain!
+      errorRedeclaration(entry, argName->line, argName->character,
+                         argName->data.id.id, existing->file, existing->line,
+                         existing->character);
+    } else {
+      environmentPut(&env, argName->data.id.id, stabEntry);
+      vectorInsert(&functionEntry->data.function.argumentEntries, stabEntry);
     }
   }
 
+  // parse and reference resolve body, replacing it in the original ast
+  Node *unparsed = body->data.funDefn.body;
+  body->data.funDefn.body = parseCompoundStmt(entry, unparsed, &env);
+  unparsedNodeFreeTokens(unparsed);
+
+  environmentPop(&env);
   environmentUninit(&env);
-}
\ No newline at end of file
+}
@@ -28,10 +28,14 @@
 #include "ast/ast.h"
 
 /**
- * parses all of the function bodies (unparsed nodes)
+ * parses the body (an unparsed node) of one function definition
  *
- * @param entry entry to read
+ * only writes to the function's own symbol tables and nodes, so the bodies of
+ * a file may be parsed concurrently
+ *
+ * @param entry entry the function is defined in
+ * @param body NT_FUNDEFN node to parse the body of
  */
-void parseFunctionBody(FileListEntry *entry);
+void parseFunctionBody(FileListEntry *entry, Node *body);
 
 #endif  // TLC_PARSER_FUNCTIONBODY_H_
\ No newline at end of file
@@ -22,6 +22,7 @@
 #include <stdio.h>
 
 #include "fileList.h"
+#include "util/diagnostics.h"
 #include "util/internalError.h"
 
 /**
@@ -70,7 +71,7 @@ static void checkStmt(FileListEntry *entry, Node *stmt, bool inSwitch) {
     }
     case NT_BREAKSTMT: {
       if (!inSwitch) {
-        fprintf(stderr,
+        fprintf(diagnosticStream(),
                 "%s:%zu:%zu: error: break statements may not be outside of a "
                 "loop or a switch\n",
                 entry->inputFilename, stmt->line, stmt->character);
@@ -79,7 +80,7 @@ static void checkStmt(FileListEntry *entry, Node *stmt, bool inSwitch) {
       break;
     }
     case NT_CONTINUESTMT: {
-      fprintf(stderr,
+      fprintf(diagnosticStream(),
               "%s:%zu:%zu: error: continue statements may not be outside of "
               "a loop\n",
               entry->inputFilename, stmt->line, stmt->character);
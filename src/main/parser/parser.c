@@ -19,11 +19,224 @@
 
 #include "parser/parser.h"
 
+#include <stdlib.h>
+
+#include "ast/environment.h"
+#include "ast/type.h"
 #include "fileList.h"
+#include "options.h"
 #include "parser/buildStab.h"
 #include "parser/functionBody.h"
 #include "parser/miscCheck.h"
+#include "parser/precompiled.h"
 #include "parser/topLevel.h"
+#include "util/arena.h"
+#include "util/hash.h"
+#include "util/threadPool.h"
+#include "util/timeReport.h"
+
+/** lexes and parses the top level of one file */
+static void parseFromSource(FileListEntry *entry) {
+  if (lexerStateInit(entry) != 0) {
+    entry->errored = true;
+    return;
+  }
+
+  entry->sourceHash = fnv1a(entry->lexerState.map, entry->lexerState.length);
+  if (options.pretokenize) lexerStatePretokenize(entry);
+  entry->ast = parseFile(entry);
+
+  lexerStateUninit(entry);
+}
+
+/**
+ * starts allocating nodes from a new arena
+ *
+ * @returns the arena
+ */
+static Arena *startArena(void) {
+  Arena *arena = arenaCreate();
+  nodeArenaSet(arena);
+  return arena;
+}
+
+/**
+ * stops allocating nodes from an arena, and gives it to the file's AST
+ *
+ * @param entry entry whose top level was just loaded or parsed
+ * @param arena arena nodes were allocated from
+ */
+static void finishArena(FileListEntry *entry, Arena *arena) {
+  nodeArenaSet(NULL);
+  if (entry->ast != NULL)
+    entry->ast->data.file.arena = arena;
+  else
+    arenaFree(arena);
+}
+
+/** loads or parses the top level of one file */
+static void parseFileTask(size_t idx, void *ignored) {
+  (void)ignored;
+  FileListEntry *entry = &fileList.entries[idx];
+  Arena *arena = startArena();
+  if (entry->isCode || (precompiledLoadCached(entry) != 0 &&
+                        (!options.useTdi || precompiledLoad(entry) != 0)))
+    parseFromSource(entry);
+  finishArena(entry, arena);
+}
+
+/**
+ * parses any loaded decl files whose dependencies have changed from source
+ *
+ * must be called after all files are parsed or loaded, and decl files indexed
+ */
+static void reparseStalePrecompiled(void) {
+  for (size_t idx = 0; idx < fileList.size; ++idx) {
+    FileListEntry *entry = &fileList.entries[idx];
+    if (entry->precompiled != NULL &&
+        precompiledCheckDependencies(entry) != 0) {
+      nodeFree(entry->ast);
+      entry->ast = NULL;
+      precompiledUnload(entry);
+      timeFileStart();
+      Arena *arena = startArena();
+      parseFromSource(entry);
+      finishArena(entry, arena);
+      timeFileEnd(idx);
+    }
+  }
+}
+
+/** links loaded decl files to the files they reference */
+static void precompiledLinkTask(size_t idx, void *ignored) {
+  (void)ignored;
+  precompiledLink(&fileList.entries[idx]);
+}
+
+/** pass 3 for decl files */
+static void startDeclStabTask(size_t idx, void *ignored) {
+  (void)ignored;
+  if (!fileList.entries[idx].isCode) startTopLevelStab(&fileList.entries[idx]);
+}
+
+/** pass 4 */
+static void checkScopedIdCollisionsTask(size_t idx, void *ignored) {
+  (void)ignored;
+  checkScopedIdCollisions(&fileList.entries[idx]);
+}
+
+/** indexes unscoped names for lookup, after pass 4 */
+static void indexModuleTask(size_t idx, void *ignored) {
+  (void)ignored;
+  environmentIndexModule(&fileList.entries[idx]);
+}
+
+/** pass 6 for decl files */
+static void finishDeclStabTask(size_t idx, void *ignored) {
+  (void)ignored;
+  if (!fileList.entries[idx].isCode)
+    finishTopLevelStab(&fileList.entries[idx]);
+}
+
+/** pass 6 for code files */
+static void finishCodeStabTask(size_t idx, void *ignored) {
+  (void)ignored;
+  if (fileList.entries[idx].isCode) finishTopLevelStab(&fileList.entries[idx]);
+}
+
+/**
+ * lays out every struct, union, and enum, after pass 6
+ *
+ * one file at a time, since laying out a type lays out the types it holds,
+ * which may be from another file
+ */
+static void layoutTypes(void) {
+  for (size_t fileIdx = 0; fileIdx < fileList.size; ++fileIdx) {
+    HashMap *stab = fileList.entries[fileIdx].ast->data.file.stab;
+    for (size_t idx = 0; idx < stab->size; ++idx)
+      stabEntryLayout(stab->values[idx]);
+  }
+}
+
+/** one function body to parse in pass 7 */
+typedef struct {
+  FileListEntry *entry; /**< file the function is defined in */
+  Node *body;           /**< NT_FUNDEFN to parse the body of */
+  Arena *arena;         /**< arena the body's nodes are allocated from */
+} FunctionBodyTask;
+
+/** pass 7 */
+static void parseFunctionBodyTask(size_t idx, void *data) {
+  FunctionBodyTask *task = (FunctionBodyTask *)data + idx;
+  task->arena = arenaCreate();
+  nodeArenaSet(task->arena);
+  parseFunctionBody(task->entry, task->body);
+  nodeArenaSet(NULL);
+}
+
+/**
+ * parses every function body in every code file, one function per task
+ */
+static void parseFunctionBodies(void) {
+  size_t count = 0;
+  for (size_t fileIdx = 0; fileIdx < fileList.size; ++fileIdx) {
+    FileListEntry *entry = &fileList.entries[fileIdx];
+    if (!entry->isCode) continue;
+    Vector *bodies = entry->ast->data.file.bodies;
+    for (size_t bodyIdx = 0; bodyIdx < bodies->size; ++bodyIdx) {
+      Node *body = bodies->elements[bodyIdx];
+      if (body->type == NT_FUNDEFN) ++count;
+    }
+  }
+
+  // tasks are in file order, then definition order, so diagnostics are too
+  FunctionBodyTask *tasks = malloc(sizeof(FunctionBodyTask) * count);
+  size_t *files = malloc(sizeof(size_t) * count);
+  size_t taskIdx = 0;
+  for (size_t fileIdx = 0; fileIdx < fileList.size; ++fileIdx) {
+    FileListEntry *entry = &fileList.entries[fileIdx];
+    if (!entry->isCode) continue;
+    Vector *bodies = entry->ast->data.file.bodies;
+    for (size_t bodyIdx = 0; bodyIdx < bodies->size; ++bodyIdx) {
+      Node *body = bodies->elements[bodyIdx];
+      if (body->type != NT_FUNDEFN) continue;
+      tasks[taskIdx].entry = entry;
+      tasks[taskIdx].body = body;
+      files[taskIdx] = fileIdx;
+      ++taskIdx;
+    }
+  }
+
+  threadPoolRunFor(count, files, parseFunctionBodyTask, tasks);
+
+  // bodies get their own arena, so they can be freed before the rest
+  for (size_t fileIdx = 0; fileIdx < fileList.size; ++fileIdx) {
+    FileListEntry *entry = &fileList.entries[fileIdx];
+    if (entry->isCode) entry->ast->data.file.bodyArena = arenaCreate();
+  }
+  for (taskIdx = 0; taskIdx < count; ++taskIdx)
+    arenaMerge(tasks[taskIdx].entry->ast->data.file.bodyArena,
+               tasks[taskIdx].arena);
+
+  free(files);
+  free(tasks);
+}
+
+/** pass 8 */
+static void checkMiscTask(size_t idx, void *ignored) {
+  (void)ignored;
+  if (fileList.entries[idx].isCode) checkMisc(&fileList.entries[idx]);
+}
+
+/**
+ * has any file errored
+ */
+static bool anyErrored(void) {
+  bool errored = false;
+  for (size_t idx = 0; idx < fileList.size; ++idx)
+    errored = errored || fileList.entries[idx].errored;
+  return errored;
+}
 
 int parse(void) {
   // IMPLEMENTATION NOTES
@@ -32,18 +245,25 @@ int parse(void) {
   // parse and symbol table builder are merged together.
   //
   // Pass one parses everything but function bodies - so the AST exists, but may
-  // contain unparsed nodes.
+  // contain unparsed nodes. Decl files with an up-to-date .tdi file are loaded
+  // instead - their AST has no bodies, and their symbol table is already
+  // complete, except for references to other files, which are linked at the
+  // end of pass three.
   //
   // Pass two resolves imports, by first making sure each decl file uniquely
   // names an import, then linking each import with it's referenced
-  // FileListEntry
+  // FileListEntry. Decl files are found by module name through an index of the
+  // file list, first built at the end of pass one so stale .tdi files can find
+  // their dependencies, and rebuilt here since re-parsing may have changed it.
   //
   // Pass three allocates symbol table entries (but doesn't fill them out
   // (mostly)) for types, and fills out the references for opaque type entries
   //
   // Pass four looks through the identifiers imported to make sure that each
   // imported identifier is always accessible (see function for detailed
-  // criteria for when an identifier is inaccessible)
+  // criteria for when an identifier is inaccessible). Each file then gets a
+  // lookup index, merging its own names with those it imports, so later passes
+  // can resolve an unscoped name with one probe.
   //
   // Pass five fills in the symbol table entry for enum types, checking for
   // circular dependencies among enum entries (a separate pass is required
@@ -53,7 +273,9 @@ int parse(void) {
   // Pass six fills in the symbol table entry for everything else, checking for
   // collisions among the entries (i.e. are all variables and functions defined
   // the same as they are declared?), and resolves references in variable
-  // definitions.
+  // definitions. Once every file is done, the size, alignment, and field
+  // offsets of each struct, union, and enum are worked out once and cached in
+  // their symbol table entries, so later phases don't recompute them.
   //
   // Pass seven parses function bodies, fills in the symbol table entries for
   // them, checking for collisions, and resolves identifier references (yes,
@@ -61,6 +283,21 @@ int parse(void) {
   //
   // Pass eight checks for miscellaneous restrictions, like those placed on
   // continue and break
+  //
+  // Passes one, four, six, seven, and eight only touch the file they're working
+  // on (other files' symbol tables are only read), so they run on the thread
+  // pool. Passes two and five, and laying out types in pass six, need to see
+  // all files at once. Pass three for code files may fill in opaque definitions
+  // in their implicit import, so it runs one file at a time. Pass seven goes
+  // further, and runs one task per function definition: a body only writes to
+  // its own symbol tables, so one large file doesn't leave the other threads
+  // idle.
+  //
+  // The nodes of each file are allocated from an arena owned by its file node,
+  // so freeing the file frees them all at once. Function bodies, parsed in pass
+  // seven, get a second arena, so they can be freed before the rest of the AST.
+  // Each body is parsed into an arena of its own, and these are merged into the
+  // file's body arena once the pass is done.
 
   // note on parser calling conventions:
   // a context-ignorant parser shall unlex as much as it needs to/can if an
@@ -76,88 +313,72 @@ int parse(void) {
   //  - cleanup
   //  - return NULL
 
-  int retval = 0;
-  bool errored = false; /**< has any part of the whole thing errored */
-
   // pass 1 - parse top level stuff, without populating symbol tables
-  lexerInitMaps();
-  for (size_t idx = 0; idx < fileList.size; ++idx) {
-    retval = lexerStateInit(&fileList.entries[idx]);
-    if (retval != 0) {
-      errored = true;
-      continue;
-    }
-
-    fileList.entries[idx].ast = parseFile(&fileList.entries[idx]);
-    errored = errored || fileList.entries[idx].errored;
-
-    lexerStateUninit(&fileList.entries[idx]);
-  }
-  lexerUninitMaps();
-  if (errored) return -1;
+  timePhaseStart("parse pass 1: top level");
+  threadPoolRun(fileList.size, parseFileTask, NULL);
+  fileListIndexModules(NULL);
+  reparseStalePrecompiled();
+  timePhaseEnd();
+  if (anyErrored()) return -1;
 
   // pass 2 - resolve imports and check for scoped id collision between imports
-  if (resolveImports() != 0) return -1;
+  timePhaseStart("parse pass 2: imports");
+  int retval = resolveImports();
+  timePhaseEnd();
+  if (retval != 0) return -1;
 
   // pass 3 - populate stab
-  for (size_t idx = 0; idx < fileList.size; ++idx) {
-    if (!fileList.entries[idx].isCode) {
-      startTopLevelStab(&fileList.entries[idx]);
-      errored = errored || fileList.entries[idx].errored;
-    }
-  }
+  timePhaseStart("parse pass 3: start symbol tables");
+  threadPoolRun(fileList.size, startDeclStabTask, NULL);
   for (size_t idx = 0; idx < fileList.size; ++idx) {
     if (fileList.entries[idx].isCode) {
+      timeFileStart();
       startTopLevelStab(&fileList.entries[idx]);
-      errored = errored || fileList.entries[idx].errored;
+      timeFileEnd(idx);
     }
   }
-  if (errored) return -1;
+  threadPoolRun(fileList.size, precompiledLinkTask, NULL);
+  timePhaseEnd();
+  if (anyErrored()) return -1;
 
   // pass 4 - check for scoped id collisions between imports
-  for (size_t idx = 0; idx < fileList.size; ++idx) {
-    checkScopedIdCollisions(&fileList.entries[idx]);
-    errored = errored || fileList.entries[idx].errored;
-  }
-  if (errored) return -1;
+  timePhaseStart("parse pass 4: scoped id collisions");
+  threadPoolRun(fileList.size, checkScopedIdCollisionsTask, NULL);
+  timePhaseEnd();
+  if (anyErrored()) return -1;
+  timePhaseStart("parse pass 4: lookup indices");
+  threadPoolRun(fileList.size, indexModuleTask, NULL);
+  timePhaseEnd();
 
   // pass 5 - build and fill in stab for enums - watch out for
   // dependency loops
-  if (buildTopLevelEnumStab() != 0) return -1;
+  timePhaseStart("parse pass 5: enumerations");
+  retval = buildTopLevelEnumStab();
+  timePhaseEnd();
+  if (retval != 0) return -1;
 
   // pass 6 - fill in stab for everything else
-  for (size_t idx = 0; idx < fileList.size; ++idx) {
-    if (!fileList.entries[idx].isCode) {
-      finishTopLevelStab(&fileList.entries[idx]);
-      errored = errored || fileList.entries[idx].errored;
-    }
-  }
-  for (size_t idx = 0; idx < fileList.size; ++idx) {
-    if (fileList.entries[idx].isCode) {
-      finishTopLevelStab(&fileList.entries[idx]);
-      errored = errored || fileList.entries[idx].errored;
-    }
-  }
-  if (errored) return -1;
+  timePhaseStart("parse pass 6: finish symbol tables");
+  threadPoolRun(fileList.size, finishDeclStabTask, NULL);
+  threadPoolRun(fileList.size, finishCodeStabTask, NULL);
+  timePhaseEnd();
+  if (anyErrored()) return -1;
+  timePhaseStart("parse pass 6: type layouts");
+  layoutTypes();
+  timePhaseEnd();
 
   // pass 7 - parse unparsed nodes, writing the symbol table as we go -
   // entries are filled in
-  for (size_t idx = 0; idx < fileList.size; ++idx) {
-    if (fileList.entries[idx].isCode) {
-      parseFunctionBody(&fileList.entries[idx]);
-      errored = errored || fileList.entries[idx].errored;
-    }
-  }
-  if (errored) return -1;
+  timePhaseStart("parse pass 7: function bodies");
+  parseFunctionBodies();
+  timePhaseEnd();
+  if (anyErrored()) return -1;
 
   // pass 8 - check additional constraints and warnings (continue/break)
-  for (size_t idx = 0; idx < fileList.size; ++idx) {
-    if (fileList.entries[idx].isCode) {
-      checkMisc(&fileList.entries[idx]);
-      errored = errored || fileList.entries[idx].errored;
-    }
-  }
-  if (errored) return -1;
+  timePhaseStart("parse pass 8: miscellaneous checks");
+  threadPoolRun(fileList.size, checkMiscTask, NULL);
+  timePhaseEnd();
+  if (anyErrored()) return -1;
 
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,1065 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Implementation of precompiled declaration module reading and writing
+//
+// A .tdi file is laid out as a header of HEADER_LENGTH 64-bit words, followed
+// by the body words, followed by a pool of NUL-terminated strings. There are
+// no pointers in the file - strings are referred to by their byte offset into
+// the string pool, and everything else is read in order. Identifiers in the
+// loaded symbol table are interned copies of the pooled strings, so they
+// outlive the mapping.
+//
+// The body is:
+//  - the module name: line, character, then a name
+//  - the imports: count, then line, character, and a name for each
+//  - the dependencies: count, then a module name string and source hash for
+//    every module transitively imported
+//  - the symbol table entries: count, then kind, id, line, and character for
+//    each
+//  - the contents of each entry, in the same order as the entries
+//
+// A name is a count of components, then the string, line, and character of
+// each component. Types are written as their kind followed by their contents;
+// a reference to a symbol table entry is either local (the entry's id) or
+// external (the entry's module name and id).
+
+#include "parser/precompiled.h"
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "fileList.h"
+#include "util/container/stringBuilder.h"
+#include "util/diagnostics.h"
+#include "util/format.h"
+#include "util/functional.h"
+#include "util/hash.h"
+#include "util/intern.h"
+#include "util/internalError.h"
+#include "util/threadPool.h"
+
+/** "TLCTDI01", read as a little-endian word - change when the layout does */
+#define TDI_MAGIC 0x3130494454434c54
+
+/** word indices into the header */
+enum {
+  HEADER_MAGIC,
+  HEADER_SOURCE_HASH,
+  HEADER_NUM_WORDS,
+  HEADER_STRINGS_LENGTH,
+  HEADER_LENGTH,
+};
+
+/** kind word used for a missing type */
+#define NO_TYPE UINT64_MAX
+
+/** the two kinds of reference to a symbol table entry */
+enum {
+  REF_LOCAL,
+  REF_EXTERNAL,
+};
+
+/**
+ * a type that refers to an entry in another module, to be read again when
+ * linking - types are interned, so they can't be filled in afterwards
+ */
+typedef struct {
+  size_t pos;     /**< position of the type in the image */
+  Type **slot;    /**< where to store the type, or NULL if in vector */
+  Vector *vector; /**< vector to store the type in, if slot is NULL */
+  size_t index;   /**< index in vector to store the type at */
+} Fixup;
+
+/**
+ * finds the decl module with the given stringified name
+ *
+ * @param name stringified name to look for
+ * @returns the module, or NULL if none has that name
+ */
+static FileListEntry *findModule(char const *name) {
+  return fileListFindDeclName(internString(name));
+}
+
+/** reader for the body of a mapped .tdi file */
+typedef struct {
+  uint64_t const *words;
+  size_t size;
+  size_t pos;
+  char const *strings;
+  size_t stringsLength;
+  bool ok;       /**< set to false if any read was out of bounds or invalid */
+  bool external; /**< set when a reference to another module is read */
+} Reader;
+
+static uint64_t readWord(Reader *r) {
+  if (r->pos >= r->size) {
+    r->ok = false;
+    return 0;
+  }
+  return r->words[r->pos++];
+}
+
+/**
+ * reads a count of things that each take at least one word
+ */
+static size_t readCount(Reader *r) {
+  uint64_t count = readWord(r);
+  if (count > r->size - r->pos) {
+    r->ok = false;
+    return 0;
+  }
+  return (size_t)count;
+}
+
+static char const *readString(Reader *r) {
+  uint64_t offset = readWord(r);
+  if (offset >= r->stringsLength) {
+    r->ok = false;
+    return internString("");
+  }
+  return internString(r->strings + offset);
+}
+
+/**
+ * reads a name as an NT_ID or NT_SCOPEDID node
+ *
+ * @returns node, or NULL if the name was invalid
+ */
+static Node *readName(Reader *r) {
+  size_t numComponents = readCount(r);
+  if (numComponents == 0) {
+    r->ok = false;
+    return NULL;
+  }
+
+  Vector *components = vectorCreate();
+  for (size_t idx = 0; idx < numComponents; ++idx) {
+    Token token;
+    token.type = TT_ID;
+    token.string = readString(r);
+    token.length = strlen(token.string);
+    token.line = readWord(r);
+    token.character = readWord(r);
+    vectorInsert(components, idNodeCreate(&token));
+  }
+
+  if (numComponents == 1) {
+    Node *id = components->elements[0];
+    vectorUninit(components, nullDtor);
+    free(components);
+    return id;
+  } else {
+    return scopedIdNodeCreate(components);
+  }
+}
+
+/**
+ * reads a type
+ *
+ * local references are resolved immediately. External references are resolved
+ * if linking, and otherwise set r->external and read as a reference to nothing
+ *
+ * @param linking file being linked, or NULL if loading
+ * @returns type, or NULL if there was no type (or the type was invalid)
+ */
+static Type *readType(Reader *r, HashMap *stab, FileListEntry *linking) {
+  uint64_t kind = readWord(r);
+  if (!r->ok || kind == NO_TYPE) return NULL;
+
+  switch (kind) {
+    case TK_KEYWORD: {
+      uint64_t keyword = readWord(r);
+      if (keyword > TK_BOOL) {
+        r->ok = false;
+        return NULL;
+      }
+      return keywordTypeCreate((TypeKeyword)keyword);
+    }
+    case TK_QUALIFIED: {
+      bool constQual = readWord(r) != 0;
+      bool volatileQual = readWord(r) != 0;
+      return qualifiedTypeCreate(readType(r, stab, linking), constQual,
+                                 volatileQual);
+    }
+    case TK_POINTER: {
+      return pointerTypeCreate(readType(r, stab, linking));
+    }
+    case TK_ARRAY: {
+      uint64_t length = readWord(r);
+      return arrayTypeCreate(length, readType(r, stab, linking));
+    }
+    case TK_FUNPTR: {
+      Type *returnType = readType(r, stab, linking);
+      size_t numArgs = readCount(r);
+      Vector argTypes;
+      vectorInit(&argTypes);
+      for (size_t idx = 0; idx < numArgs; ++idx)
+        vectorInsert(&argTypes, readType(r, stab, linking));
+      return funPtrTypeCreate(returnType, &argTypes);
+    }
+    case TK_AGGREGATE: {
+      size_t numTypes = readCount(r);
+      Vector types;
+      vectorInit(&types);
+      for (size_t idx = 0; idx < numTypes; ++idx)
+        vectorInsert(&types, readType(r, stab, linking));
+      return aggregateTypeCreate(&types);
+    }
+    case TK_REFERENCE: {
+      switch (readWord(r)) {
+        case REF_LOCAL: {
+          SymbolTableEntry *entry = hashMapGet(stab, readString(r));
+          if (entry == NULL) r->ok = false;
+          return referenceTypeCreate(entry);
+        }
+        case REF_EXTERNAL: {
+          char const *moduleName = readString(r);
+          char const *id = readString(r);
+          if (linking == NULL) {
+            r->external = true;
+            return referenceTypeCreate(NULL);
+          }
+
+          FileListEntry *file = findModule(moduleName);
+          SymbolTableEntry *referenced =
+              file == NULL ? NULL : hashMapGet(file->ast->data.file.stab, id);
+          if (referenced == NULL) {
+            fprintf(diagnosticStream(),
+                    "%s: error: precompiled declaration module refers to "
+                    "'%s::%s', which does not exist\n",
+                    linking->inputFilename, moduleName, id);
+            linking->errored = true;
+          }
+          return referenceTypeCreate(referenced);
+        }
+        default: {
+          r->ok = false;
+          return NULL;
+        }
+      }
+    }
+    default: {
+      r->ok = false;
+      return NULL;
+    }
+  }
+}
+
+/**
+ * reads a type to be stored in slot, or appended to vector if slot is NULL,
+ * adding a fixup if it refers to another module
+ */
+static Type *readFixableType(Reader *r, HashMap *stab, Vector *fixups,
+                             Type **slot, Vector *vector) {
+  size_t pos = r->pos;
+  r->external = false;
+  Type *t = readType(r, stab, NULL);
+  if (r->external) {
+    Fixup *fixup = malloc(sizeof(Fixup));
+    fixup->pos = pos;
+    fixup->slot = slot;
+    fixup->vector = vector;
+    fixup->index = vector == NULL ? 0 : vector->size;
+    vectorInsert(fixups, fixup);
+  }
+  return t;
+}
+
+/**
+ * reads the contents of a symbol table entry
+ */
+static void readEntryContents(Reader *r, FileListEntry *file,
+                              SymbolTableEntry *e, Vector *fixups) {
+  HashMap *stab = file->ast->data.file.stab;
+  switch (e->kind) {
+    case SK_VARIABLE: {
+      e->data.variable.type =
+          readFixableType(r, stab, fixups, &e->data.variable.type, NULL);
+      break;
+    }
+    case SK_FUNCTION: {
+      e->data.function.returnType = readFixableType(
+          r, stab, fixups, &e->data.function.returnType, NULL);
+      size_t numArgs = readCount(r);
+      for (size_t idx = 0; idx < numArgs; ++idx)
+        vectorInsert(&e->data.function.argumentTypes,
+                     readFixableType(r, stab, fixups, NULL,
+                                     &e->data.function.argumentTypes));
+      break;
+    }
+    case SK_OPAQUE: {
+      // definition is filled in by the code module, if any
+      break;
+    }
+    case SK_STRUCT: {
+      size_t numFields = readCount(r);
+      for (size_t idx = 0; idx < numFields; ++idx) {
+        stringVectorInsert(&e->data.structType.fieldNames, readString(r));
+        vectorInsert(&e->data.structType.fieldTypes,
+                     readFixableType(r, stab, fixups, NULL,
+                                     &e->data.structType.fieldTypes));
+      }
+      break;
+    }
+    case SK_UNION: {
+      size_t numOptions = readCount(r);
+      for (size_t idx = 0; idx < numOptions; ++idx) {
+        stringVectorInsert(&e->data.unionType.optionNames, readString(r));
+        vectorInsert(&e->data.unionType.optionTypes,
+                     readFixableType(r, stab, fixups, NULL,
+                                     &e->data.unionType.optionTypes));
+      }
+      break;
+    }
+    case SK_ENUM: {
+      e->data.enumType.backingType = readFixableType(
+          r, stab, fixups, &e->data.enumType.backingType, NULL);
+      size_t numConstants = readCount(r);
+      for (size_t idx = 0; idx < numConstants; ++idx) {
+        char const *id = readString(r);
+        size_t line = readWord(r);
+        size_t character = readWord(r);
+        SymbolTableEntry *constant =
+            enumConstStabEntryCreate(file, line, character, id, e);
+        constant->data.enumConst.signedness = readWord(r) != 0;
+        constant->data.enumConst.data.unsignedValue = readWord(r);
+        stringVectorInsert(&e->data.enumType.constantNames, id);
+        vectorInsert(&e->data.enumType.constantValues, constant);
+      }
+      break;
+    }
+    case SK_TYPEDEF: {
+      e->data.typedefType.actual = readFixableType(
+          r, stab, fixups, &e->data.typedefType.actual, NULL);
+      break;
+    }
+    default: {
+      r->ok = false;
+      break;
+    }
+  }
+}
+
+/**
+ * creates an empty symbol table entry of the given kind
+ *
+ * @returns entry, or NULL if the kind can't be at the top level
+ */
+static SymbolTableEntry *entryCreate(uint64_t kind, FileListEntry *file,
+                                     size_t line, size_t character,
+                                     char const *id) {
+  switch (kind) {
+    case SK_VARIABLE: {
+      return variableStabEntryCreate(file, line, character, id);
+    }
+    case SK_FUNCTION: {
+      return functionStabEntryCreate(file, line, character, id);
+    }
+    case SK_OPAQUE: {
+      return opaqueStabEntryCreate(file, line, character, id);
+    }
+    case SK_STRUCT: {
+      return structStabEntryCreate(file, line, character, id);
+    }
+    case SK_UNION: {
+      return unionStabEntryCreate(file, line, character, id);
+    }
+    case SK_ENUM: {
+      return enumStabEntryCreate(file, line, character, id);
+    }
+    case SK_TYPEDEF: {
+      return typedefStabEntryCreate(file, line, character, id);
+    }
+    default: {
+      return NULL;
+    }
+  }
+}
+
+/**
+ * frees a precompiled module
+ */
+static void precompiledModuleFree(PrecompiledModule *module) {
+  vectorUninit(&module->fixups, free);
+  if (module->mapped) munmap(module->map, module->length);
+  free(module);
+}
+
+/**
+ * reads the AST skeleton and symbol table of a module
+ *
+ * @returns status code (0 = OK)
+ */
+static int readModule(Reader *r, FileListEntry *entry,
+                      PrecompiledModule *module) {
+  Token keyword;
+  keyword.type = TT_MODULE;
+  keyword.string = NULL;
+  keyword.length = 0;
+  keyword.line = readWord(r);
+  keyword.character = readWord(r);
+  Node *moduleName = readName(r);
+  if (!r->ok) {
+    nodeFree(moduleName);
+    return -1;
+  }
+  Node *moduleNode = moduleNodeCreate(&keyword, moduleName);
+
+  Vector *imports = vectorCreate();
+  entry->ast = fileNodeCreate(moduleNode, imports, vectorCreate());
+  size_t numImports = readCount(r);
+  for (size_t idx = 0; idx < numImports && r->ok; ++idx) {
+    keyword.type = TT_IMPORT;
+    keyword.line = readWord(r);
+    keyword.character = readWord(r);
+    Node *importName = readName(r);
+    if (importName != NULL)
+      vectorInsert(imports, importNodeCreate(&keyword, importName));
+  }
+
+  // skip over dependencies - checked later
+  size_t numDependencies = readCount(r);
+  for (size_t idx = 0; idx < numDependencies * 2; ++idx) readWord(r);
+
+  // create all entries, then fill them in, so local references can be resolved
+  HashMap *stab = entry->ast->data.file.stab;
+  size_t numEntries = readCount(r);
+  SymbolTableEntry **entries = malloc(sizeof(SymbolTableEntry *) * numEntries);
+  size_t numCreated = 0;
+  for (; numCreated < numEntries && r->ok; ++numCreated) {
+    uint64_t kind = readWord(r);
+    char const *id = readString(r);
+    size_t line = readWord(r);
+    size_t character = readWord(r);
+    SymbolTableEntry *e = entryCreate(kind, entry, line, character, id);
+    if (e == NULL) {
+      r->ok = false;
+      break;
+    } else if (hashMapPut(stab, id, e) != 0) {
+      stabEntryFree(e);
+      r->ok = false;
+      break;
+    }
+    entries[numCreated] = e;
+  }
+  for (size_t idx = 0; idx < numCreated && r->ok; ++idx)
+    readEntryContents(r, entry, entries[idx], &module->fixups);
+  free(entries);
+
+  if (!r->ok || r->pos != r->size) {
+    nodeFree(entry->ast);
+    entry->ast = NULL;
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * initializes a reader for the body of a checked image
+ */
+static void readerInit(Reader *r, void const *image) {
+  uint64_t const *header = image;
+  r->words = header + HEADER_LENGTH;
+  r->size = header[HEADER_NUM_WORDS];
+  r->pos = 0;
+  r->strings = (char const *)(r->words + r->size);
+  r->stringsLength = header[HEADER_STRINGS_LENGTH];
+  r->ok = true;
+  r->external = false;
+}
+
+/**
+ * checks that the header of an image is consistent with its length
+ */
+static bool imageValid(void const *image, size_t length) {
+  if (length < HEADER_LENGTH * sizeof(uint64_t)) return false;
+
+  uint64_t const *header = image;
+  size_t bodyLength = length - HEADER_LENGTH * sizeof(uint64_t);
+  return header[HEADER_MAGIC] == TDI_MAGIC &&
+         header[HEADER_NUM_WORDS] <= bodyLength / sizeof(uint64_t) &&
+         header[HEADER_NUM_WORDS] * sizeof(uint64_t) +
+                 header[HEADER_STRINGS_LENGTH] ==
+             bodyLength &&
+         header[HEADER_STRINGS_LENGTH] != 0 &&
+         ((char const *)image)[length - 1] == '\0';
+}
+
+/**
+ * creates a module backed by the given image
+ *
+ * @param image image to read from
+ * @param length length of the image
+ * @param mapped is the image an mmap owned by the module
+ */
+static PrecompiledModule *precompiledModuleCreate(void *image, size_t length,
+                                                  bool mapped) {
+  PrecompiledModule *module = malloc(sizeof(PrecompiledModule));
+  module->map = image;
+  module->length = length;
+  module->mapped = mapped;
+  vectorInit(&module->fixups);
+  return module;
+}
+
+/**
+ * maps a .tdi file and checks its header
+ *
+ * @param filename name of file to map
+ * @returns module, or NULL if the file doesn't exist or isn't valid
+ */
+static PrecompiledModule *mapModule(char const *filename) {
+  int fd = open(filename, O_RDONLY);
+  if (fd == -1) return NULL;
+  struct stat statbuf;
+  if (fstat(fd, &statbuf) != 0) {
+    close(fd);
+    return NULL;
+  }
+  size_t length = (size_t)statbuf.st_size;
+  if (length < HEADER_LENGTH * sizeof(uint64_t)) {
+    close(fd);
+    return NULL;
+  }
+  void *map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == (void *)-1) return NULL;
+
+  if (!imageValid(map, length)) {
+    munmap(map, length);
+    return NULL;
+  }
+
+  return precompiledModuleCreate(map, length, true);
+}
+
+/**
+ * reads a module into an entry if it was built from the entry's current source
+ *
+ * @param entry entry to load into
+ * @param module module to read - freed if it can't be used
+ * @returns status code (0 = OK)
+ */
+static int loadModule(FileListEntry *entry, PrecompiledModule *module) {
+  uint64_t const *header = module->map;
+  Reader r;
+  readerInit(&r, module->map);
+  if (fnv1aFile(entry->inputFilename, &entry->sourceHash) != 0 ||
+      entry->sourceHash != header[HEADER_SOURCE_HASH] ||
+      readModule(&r, entry, module) != 0) {
+    precompiledModuleFree(module);
+    return -1;
+  }
+
+  entry->precompiled = module;
+  return 0;
+}
+
+int precompiledLoad(FileListEntry *entry) {
+  char *tdiFilename = format("%si", entry->inputFilename);
+  PrecompiledModule *module = mapModule(tdiFilename);
+  free(tdiFilename);
+  if (module == NULL) return -1;
+
+  return loadModule(entry, module);
+}
+
+int precompiledCheckDependencies(FileListEntry *entry) {
+  Reader r;
+  readerInit(&r, entry->precompiled->map);
+
+  // skip module name and imports - already validated when loading
+  r.pos += 2;
+  size_t numComponents = readWord(&r);
+  r.pos += 3 * numComponents;
+  size_t numImports = readWord(&r);
+  for (size_t idx = 0; idx < numImports; ++idx) {
+    r.pos += 2;
+    numComponents = readWord(&r);
+    r.pos += 3 * numComponents;
+  }
+
+  size_t numDependencies = readWord(&r);
+  for (size_t idx = 0; idx < numDependencies; ++idx) {
+    FileListEntry *dependency = findModule(readString(&r));
+    uint64_t hash = readWord(&r);
+    if (dependency == NULL || dependency->sourceHash != hash) return -1;
+  }
+  return 0;
+}
+
+void precompiledLink(FileListEntry *entry) {
+  PrecompiledModule *module = entry->precompiled;
+  if (module == NULL) return;
+
+  HashMap *stab = entry->ast->data.file.stab;
+  Reader r;
+  readerInit(&r, module->map);
+  for (size_t idx = 0; idx < module->fixups.size; ++idx) {
+    Fixup *fixup = module->fixups.elements[idx];
+    r.pos = fixup->pos;
+    Type *t = readType(&r, stab, entry);
+    if (fixup->slot != NULL)
+      *fixup->slot = t;
+    else
+      fixup->vector->elements[fixup->index] = t;
+  }
+
+  vectorUninit(&module->fixups, free);
+  vectorInit(&module->fixups);
+}
+
+/** accumulates the body and string pool of a .tdi file */
+typedef struct {
+  SizeVector words;
+  StringBuilder strings;
+} Writer;
+
+static void writeWord(Writer *w, uint64_t word) {
+  sizeVectorInsert(&w->words, word);
+}
+
+static void writeString(Writer *w, char const *s) {
+  writeWord(w, w->strings.size);
+  for (; *s != '\0'; ++s) stringBuilderPush(&w->strings, *s);
+  stringBuilderPush(&w->strings, '\0');
+}
+
+static void writeName(Writer *w, Node *name) {
+  if (name->type == NT_ID) {
+    writeWord(w, 1);
+    writeString(w, name->data.id.id);
+    writeWord(w, name->line);
+    writeWord(w, name->character);
+  } else {
+    Vector *components = name->data.scopedId.components;
+    writeWord(w, components->size);
+    for (size_t idx = 0; idx < components->size; ++idx) {
+      Node *component = components->elements[idx];
+      writeString(w, component->data.id.id);
+      writeWord(w, component->line);
+      writeWord(w, component->character);
+    }
+  }
+}
+
+static void writeType(Writer *w, Type const *t, FileListEntry *file) {
+  if (t == NULL) {
+    writeWord(w, NO_TYPE);
+    return;
+  }
+
+  writeWord(w, t->kind);
+  switch (t->kind) {
+    case TK_KEYWORD: {
+      writeWord(w, t->data.keyword.keyword);
+      break;
+    }
+    case TK_QUALIFIED: {
+      writeWord(w, t->data.qualified.constQual);
+      writeWord(w, t->data.qualified.volatileQual);
+      writeType(w, t->data.qualified.base, file);
+      break;
+    }
+    case TK_POINTER: {
+      writeType(w, t->data.pointer.base, file);
+      break;
+    }
+    case TK_ARRAY: {
+      writeWord(w, t->data.array.length);
+      writeType(w, t->data.array.type, file);
+      break;
+    }
+    case TK_FUNPTR: {
+      writeType(w, t->data.funPtr.returnType, file);
+      writeWord(w, t->data.funPtr.argTypes.size);
+      for (size_t idx = 0; idx < t->data.funPtr.argTypes.size; ++idx)
+        writeType(w, t->data.funPtr.argTypes.elements[idx], file);
+      break;
+    }
+    case TK_AGGREGATE: {
+      writeWord(w, t->data.aggregate.types.size);
+      for (size_t idx = 0; idx < t->data.aggregate.types.size; ++idx)
+        writeType(w, t->data.aggregate.types.elements[idx], file);
+      break;
+    }
+    case TK_REFERENCE: {
+      SymbolTableEntry *entry = t->data.reference.entry;
+      if (entry->file == file) {
+        writeWord(w, REF_LOCAL);
+        writeString(w, entry->id);
+      } else {
+        writeWord(w, REF_EXTERNAL);
+        char *moduleName =
+            stringifyId(entry->file->ast->data.file.module->data.module.id);
+        writeString(w, moduleName);
+        free(moduleName);
+        writeString(w, entry->id);
+      }
+      break;
+    }
+    default: {
+      error(__FILE__, __LINE__, "invalid type kind");
+    }
+  }
+}
+
+static void writeEntryContents(Writer *w, SymbolTableEntry *e) {
+  switch (e->kind) {
+    case SK_VARIABLE: {
+      writeType(w, e->data.variable.type, e->file);
+      break;
+    }
+    case SK_FUNCTION: {
+      writeType(w, e->data.function.returnType, e->file);
+      Vector *argumentTypes = &e->data.function.argumentTypes;
+      writeWord(w, argumentTypes->size);
+      for (size_t idx = 0; idx < argumentTypes->size; ++idx)
+        writeType(w, argumentTypes->elements[idx], e->file);
+      break;
+    }
+    case SK_OPAQUE: {
+      break;
+    }
+    case SK_STRUCT: {
+      writeWord(w, e->data.structType.fieldNames.size);
+      for (size_t idx = 0; idx < e->data.structType.fieldNames.size; ++idx) {
+        writeString(w, e->data.structType.fieldNames.elements[idx]);
+        writeType(w, e->data.structType.fieldTypes.elements[idx], e->file);
+      }
+      break;
+    }
+    case SK_UNION: {
+      writeWord(w, e->data.unionType.optionNames.size);
+      for (size_t idx = 0; idx < e->data.unionType.optionNames.size; ++idx) {
+        writeString(w, e->data.unionType.optionNames.elements[idx]);
+        writeType(w, e->data.unionType.optionTypes.elements[idx], e->file);
+      }
+      break;
+    }
+    case SK_ENUM: {
+      writeType(w, e->data.enumType.backingType, e->file);
+      Vector *constantValues = &e->data.enumType.constantValues;
+      writeWord(w, constantValues->size);
+      for (size_t idx = 0; idx < constantValues->size; ++idx) {
+        SymbolTableEntry *constant = constantValues->elements[idx];
+        writeString(w, constant->id);
+        writeWord(w, constant->line);
+        writeWord(w, constant->character);
+        writeWord(w, constant->data.enumConst.signedness);
+        writeWord(w, constant->data.enumConst.data.unsignedValue);
+      }
+      break;
+    }
+    case SK_TYPEDEF: {
+      writeType(w, e->data.typedefType.actual, e->file);
+      break;
+    }
+    default: {
+      error(__FILE__, __LINE__, "invalid top level symbol kind");
+    }
+  }
+}
+
+/**
+ * builds the body and string pool of a .tdi file
+ */
+static void writeModule(Writer *w, FileListEntry *entry) {
+  Node *module = entry->ast->data.file.module;
+  writeWord(w, module->line);
+  writeWord(w, module->character);
+  writeName(w, module->data.module.id);
+
+  Vector *imports = entry->ast->data.file.imports;
+  writeWord(w, imports->size);
+  for (size_t idx = 0; idx < imports->size; ++idx) {
+    Node *import = imports->elements[idx];
+    writeWord(w, import->line);
+    writeWord(w, import->character);
+    writeName(w, import->data.import.id);
+  }
+
+  Vector dependencies;
+  vectorInit(&dependencies);
+  fileListFindDependencies(entry, &dependencies);
+  writeWord(w, dependencies.size);
+  for (size_t idx = 0; idx < dependencies.size; ++idx) {
+    FileListEntry *dependency = dependencies.elements[idx];
+    char *name = stringifyId(dependency->ast->data.file.module->data.module.id);
+    writeString(w, name);
+    free(name);
+    writeWord(w, dependency->sourceHash);
+  }
+  vectorUninit(&dependencies, nullDtor);
+
+  HashMap *stab = entry->ast->data.file.stab;
+  writeWord(w, stab->size);
+  for (size_t idx = 0; idx < stab->size; ++idx) {
+    SymbolTableEntry *e = stab->values[idx];
+    writeWord(w, e->kind);
+    writeString(w, e->id);
+    writeWord(w, e->line);
+    writeWord(w, e->character);
+  }
+  for (size_t idx = 0; idx < stab->size; ++idx)
+    writeEntryContents(w, stab->values[idx]);
+}
+
+/**
+ * builds the image of a decl module
+ *
+ * @param entry entry to build the image of
+ * @param length output parameter for the length of the image, in bytes
+ * @returns image, in a malloc'd buffer
+ */
+static uint64_t *buildImage(FileListEntry *entry, size_t *length) {
+  Writer w;
+  sizeVectorInit(&w.words);
+  stringBuilderInit(&w.strings);
+  writeModule(&w, entry);
+
+  *length =
+      (HEADER_LENGTH + w.words.size) * sizeof(uint64_t) + w.strings.size;
+  uint64_t *image = malloc(*length);
+  image[HEADER_MAGIC] = TDI_MAGIC;
+  image[HEADER_SOURCE_HASH] = entry->sourceHash;
+  image[HEADER_NUM_WORDS] = w.words.size;
+  image[HEADER_STRINGS_LENGTH] = w.strings.size;
+  for (size_t idx = 0; idx < w.words.size; ++idx)
+    image[HEADER_LENGTH + idx] = w.words.elements[idx];
+  memcpy(image + HEADER_LENGTH + w.words.size, w.strings.string,
+         w.strings.size);
+
+  sizeVectorUninit(&w.words);
+  stringBuilderUninit(&w.strings);
+  return image;
+}
+
+/**
+ * writes out the .tdi file for a decl module
+ *
+ * @returns status code (0 = OK)
+ */
+static int precompiledWrite(FileListEntry *entry) {
+  size_t length;
+  uint64_t *image = buildImage(entry, &length);
+
+  // write to a temporary file, then move it into place, so nobody reads a
+  // partially written file
+  char *tdiFilename = format("%si", entry->inputFilename);
+  char *tempFilename = format("%s.XXXXXX", tdiFilename);
+  int retval = -1;
+  int fd = mkstemp(tempFilename);
+  if (fd != -1) {
+    FILE *out = fdopen(fd, "wb");
+    if (out == NULL) {
+      close(fd);
+    } else {
+      bool written = fwrite(image, sizeof(char), length, out) == length;
+      if (fclose(out) == 0 && written &&
+          rename(tempFilename, tdiFilename) == 0)
+        retval = 0;
+    }
+    if (retval != 0) unlink(tempFilename);
+  }
+  free(tempFilename);
+  free(tdiFilename);
+
+  free(image);
+  return retval;
+}
+
+static void precompiledWriteTask(size_t idx, void *ignored) {
+  (void)ignored;
+  FileListEntry *entry = &fileList.entries[idx];
+  if (entry->isCode || entry->precompiled != NULL) return;
+
+  if (precompiledWrite(entry) != 0)
+    fprintf(diagnosticStream(),
+            "%s: warning: cannot write precompiled declaration module\n",
+            entry->inputFilename);
+}
+
+void precompiledWriteAll(void) {
+  threadPoolRun(fileList.size, precompiledWriteTask, NULL);
+}
+
+/** a decl module kept in memory between compilations */
+typedef struct {
+  dev_t device;          /**< device of the source file */
+  ino_t inode;           /**< inode of the source file */
+  struct timespec mtime; /**< modification time of the source file */
+  uint64_t *image;       /**< image of the module */
+  size_t length;         /**< length of the image */
+} CachedModule;
+
+/** is the in-memory cache in use */
+static bool cacheEnabled = false;
+/** vector of CachedModule - only changed between compilations */
+static Vector cache;
+
+static void cachedModuleFree(CachedModule *cached) {
+  free(cached->image);
+  free(cached);
+}
+
+/**
+ * finds the cached module for a source file
+ *
+ * @param statbuf stat of the source file
+ * @returns index into the cache, or cache.size if the file isn't cached
+ */
+static size_t cacheFind(struct stat const *statbuf) {
+  size_t idx = 0;
+  for (; idx < cache.size; ++idx) {
+    CachedModule *cached = cache.elements[idx];
+    if (cached->device == statbuf->st_dev && cached->inode == statbuf->st_ino)
+      break;
+  }
+  return idx;
+}
+
+void precompiledCacheInit(void) {
+  cacheEnabled = true;
+  vectorInit(&cache);
+}
+
+int precompiledLoadCached(FileListEntry *entry) {
+  if (!cacheEnabled) return -1;
+
+  struct stat statbuf;
+  if (stat(entry->inputFilename, &statbuf) != 0) return -1;
+  size_t idx = cacheFind(&statbuf);
+  if (idx == cache.size) return -1;
+
+  // file must have the same modification time and contents
+  CachedModule *cached = cache.elements[idx];
+  if (statbuf.st_mtim.tv_sec != cached->mtime.tv_sec ||
+      statbuf.st_mtim.tv_nsec != cached->mtime.tv_nsec)
+    return -1;
+
+  return loadModule(entry, precompiledModuleCreate(cached->image,
+                                                   cached->length, false));
+}
+
+void precompiledCacheAll(void) {
+  if (!cacheEnabled) return;
+
+  for (size_t idx = 0; idx < fileList.size; ++idx) {
+    FileListEntry *entry = &fileList.entries[idx];
+    if (entry->isCode || entry->precompiled != NULL) continue;
+
+    struct stat statbuf;
+    if (stat(entry->inputFilename, &statbuf) != 0) continue;
+
+    CachedModule *cached = malloc(sizeof(CachedModule));
+    cached->device = statbuf.st_dev;
+    cached->inode = statbuf.st_ino;
+    cached->mtime = statbuf.st_mtim;
+    cached->image = buildImage(entry, &cached->length);
+
+    size_t cacheIdx = cacheFind(&statbuf);
+    if (cacheIdx == cache.size) {
+      vectorInsert(&cache, cached);
+    } else {
+      // replaced module is never in use - modules in use weren't parsed
+      cachedModuleFree(cache.elements[cacheIdx]);
+      cache.elements[cacheIdx] = cached;
+    }
+  }
+}
+
+int precompiledCacheWrite(FILE *out) {
+  uint64_t count = cache.size;
+  if (fwrite(&count, sizeof(uint64_t), 1, out) != 1) return -1;
+  for (size_t idx = 0; idx < cache.size; ++idx) {
+    CachedModule const *cached = cache.elements[idx];
+    uint64_t header[5] = {
+        cached->device,
+        cached->inode,
+        (uint64_t)cached->mtime.tv_sec,
+        (uint64_t)cached->mtime.tv_nsec,
+        cached->length,
+    };
+    if (fwrite(header, sizeof(uint64_t), 5, out) != 5 ||
+        fwrite(cached->image, sizeof(char), cached->length, out) !=
+            cached->length)
+      return -1;
+  }
+  return fflush(out) == 0 ? 0 : -1;
+}
+
+int precompiledCacheRead(FILE *in) {
+  if (!cacheEnabled) return -1;
+
+  uint64_t count;
+  if (fread(&count, sizeof(uint64_t), 1, in) != 1) return -1;
+
+  Vector modules;
+  vectorInit(&modules);
+  for (uint64_t idx = 0; idx < count; ++idx) {
+    uint64_t header[5];
+    if (fread(header, sizeof(uint64_t), 5, in) != 5 ||
+        header[4] < HEADER_LENGTH * sizeof(uint64_t)) {
+      vectorUninit(&modules, (void (*)(void *))cachedModuleFree);
+      return -1;
+    }
+
+    CachedModule *cached = malloc(sizeof(CachedModule));
+    cached->device = (dev_t)header[0];
+    cached->inode = (ino_t)header[1];
+    cached->mtime.tv_sec = (time_t)header[2];
+    cached->mtime.tv_nsec = (long)header[3];
+    cached->length = header[4];
+    cached->image = malloc(cached->length);
+    vectorInsert(&modules, cached);
+    if (fread(cached->image, sizeof(char), cached->length, in) !=
+            cached->length ||
+        !imageValid(cached->image, cached->length)) {
+      vectorUninit(&modules, (void (*)(void *))cachedModuleFree);
+      return -1;
+    }
+  }
+
+  vectorUninit(&cache, (void (*)(void *))cachedModuleFree);
+  memcpy(&cache, &modules, sizeof(Vector));
+  return 0;
+}
+
+void precompiledCacheUninit(void) {
+  if (!cacheEnabled) return;
+
+  vectorUninit(&cache, (void (*)(void *))cachedModuleFree);
+  cacheEnabled = false;
+}
+
+void precompiledUnload(FileListEntry *entry) {
+  if (entry->precompiled == NULL) return;
+
+  precompiledModuleFree(entry->precompiled);
+  entry->precompiled = NULL;
+}
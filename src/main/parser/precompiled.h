@@ -0,0 +1,155 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/**
+ * @file
+ * precompiled declaration modules (.tdi files)
+ *
+ * A .tdi file holds the resolved top-level symbol table of a decl module, so
+ * that the module doesn't need to be lexed, parsed, and have its symbol table
+ * built each time it's imported. It's only used if the hash of the source it
+ * was built from, and the hashes of all the modules it (transitively) imports,
+ * match the files given to this compilation.
+ */
+
+#ifndef TLC_PARSER_PRECOMPILED_H_
+#define TLC_PARSER_PRECOMPILED_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "util/container/vector.h"
+
+typedef struct FileListEntry FileListEntry;
+
+/** a loaded .tdi file */
+typedef struct PrecompiledModule {
+  void *map;     /**< image of the module - an mmap of the .tdi file, or an
+                    in-memory copy */
+  size_t length; /**< length of the image */
+  bool mapped;   /**< is map owned by this module */
+  Vector fixups; /**< vector of types referring to other modules, read again
+                    when linking - owning */
+} PrecompiledModule;
+
+/**
+ * tries to load a decl module from its .tdi file
+ *
+ * if successful, sets entry's sourceHash, and fills in entry's AST (with no
+ * bodies) and symbol table, except for references to other modules
+ *
+ * @param entry entry to load - must be a decl module
+ * @returns 0 if loaded, -1 if the module should be parsed from source
+ */
+int precompiledLoad(FileListEntry *entry);
+
+/**
+ * checks that the modules the loaded entry was built against are unchanged
+ *
+ * must be called after all files have had their module names parsed or loaded
+ *
+ * @param entry entry to check - must have been loaded
+ * @returns 0 if OK, -1 if the module should be parsed from source
+ */
+int precompiledCheckDependencies(FileListEntry *entry);
+
+/**
+ * resolves references to other modules in a loaded entry's symbol table
+ *
+ * must be called after the top level symbol tables of all files are started;
+ * sets entry->errored if a reference can't be resolved
+ *
+ * @param entry entry to link - does nothing if the entry was not loaded
+ */
+void precompiledLink(FileListEntry *entry);
+
+/**
+ * writes out the .tdi files for all decl modules that were parsed from source
+ *
+ * must be called after parsing succeeds; prints a warning for any file that
+ * can't be written
+ */
+void precompiledWriteAll(void);
+
+/**
+ * starts keeping decl modules in memory between compilations in this process
+ *
+ * decl modules are added by precompiledCacheAll, and used by
+ * precompiledLoadCached as long as their source file's modification time and
+ * contents are unchanged
+ */
+void precompiledCacheInit(void);
+
+/**
+ * tries to load a decl module from the in-memory cache
+ *
+ * like precompiledLoad, but does nothing if the cache was never started
+ *
+ * @param entry entry to load - must be a decl module
+ * @returns 0 if loaded, -1 if the module should be parsed from source
+ */
+int precompiledLoadCached(FileListEntry *entry);
+
+/**
+ * adds all decl modules that were parsed from source to the in-memory cache,
+ * replacing any older copies
+ *
+ * must be called after parsing succeeds; does nothing if the cache was never
+ * started
+ */
+void precompiledCacheAll(void);
+
+/**
+ * writes every module in the in-memory cache to a stream
+ *
+ * used to hand the cache back from a process that compiled on a copy of it
+ *
+ * @param out stream to write to
+ * @returns status code (0 = OK)
+ */
+int precompiledCacheWrite(FILE *out);
+
+/**
+ * replaces the in-memory cache with the modules written by
+ * precompiledCacheWrite
+ *
+ * the cache is left unchanged if the stream ends early or is malformed
+ *
+ * @param in stream to read from
+ * @returns status code (0 = OK)
+ */
+int precompiledCacheRead(FILE *in);
+
+/**
+ * stops keeping decl modules in memory, and frees all cached modules
+ */
+void precompiledCacheUninit(void);
+
+/**
+ * releases the image backing a loaded entry
+ *
+ * must be called after the entry's AST is freed
+ *
+ * @param entry entry to unload - does nothing if the entry was not loaded
+ */
+void precompiledUnload(FileListEntry *entry);
+
+#endif  // TLC_PARSER_PRECOMPILED_H_
@@ -26,6 +26,8 @@
 #include "fileList.h"
 #include "parser/common.h"
 #include "util/conversions.h"
+#include "util/diagnostics.h"
+#include "util/intern.h"
 
 // panics
 
@@ -71,7 +73,6 @@ static void panicTopLevel(FileListEntry *entry) {
         return;
       }
       default: {
-        tokenUninit(&token);
         break;
       }
     }
@@ -114,7 +115,6 @@ static void panicStructOrUnion(FileListEntry *entry) {
         return;
       }
       default: {
-        tokenUninit(&token);
         break;
       }
     }
@@ -142,7 +142,6 @@ static void panicEnum(FileListEntry *entry) {
         return;
       }
       default: {
-        tokenUninit(&token);
         break;
       }
     }
@@ -280,12 +279,9 @@ static Node *parseExtendedIntLiteral(FileListEntry *entry) {
     case TT_LIT_INT_B: {
       int8_t sign;
       uint64_t magnitude;
-      int retval = binaryToInteger(peek.string, &sign, &magnitude);
+      int retval = binaryToInteger(peek.string, peek.length, &sign, &magnitude);
       if (retval != 0) {
         errorIntOverflow(entry, &peek);
-
-        tokenUninit(&peek);
-
         return NULL;
       }
       Node *n = sizedIntegerLiteralNodeCreate(&peek, sign, magnitude);
@@ -295,12 +291,9 @@ static Node *parseExtendedIntLiteral(FileListEntry *entry) {
     case TT_LIT_INT_O: {
       int8_t sign;
       uint64_t magnitude;
-      int retval = octalToInteger(peek.string, &sign, &magnitude);
+      int retval = octalToInteger(peek.string, peek.length, &sign, &magnitude);
       if (retval != 0) {
         errorIntOverflow(entry, &peek);
-
-        tokenUninit(&peek);
-
         return NULL;
       }
       Node *n = sizedIntegerLiteralNodeCreate(&peek, sign, magnitude);
@@ -311,12 +304,10 @@ static Node *parseExtendedIntLiteral(FileListEntry *entry) {
     case TT_LIT_INT_D: {
       int8_t sign;
       uint64_t magnitude;
-      int retval = decimalToInteger(peek.string, &sign, &magnitude);
+      int retval =
+          decimalToInteger(peek.string, peek.length, &sign, &magnitude);
       if (retval != 0) {
         errorIntOverflow(entry, &peek);
-
-        tokenUninit(&peek);
-
         return NULL;
       }
       Node *n = sizedIntegerLiteralNodeCreate(&peek, sign, magnitude);
@@ -326,12 +317,10 @@ static Node *parseExtendedIntLiteral(FileListEntry *entry) {
     case TT_LIT_INT_H: {
       int8_t sign;
       uint64_t magnitude;
-      int retval = hexadecimalToInteger(peek.string, &sign, &magnitude);
+      int retval =
+          hexadecimalToInteger(peek.string, peek.length, &sign, &magnitude);
       if (retval != 0) {
         errorIntOverflow(entry, &peek);
-
-        tokenUninit(&peek);
-
         return NULL;
       }
       Node *n = sizedIntegerLiteralNodeCreate(&peek, sign, magnitude);
@@ -404,9 +393,7 @@ static Node *parseAggregateInitializer(FileListEntry *entry, Token *start) {
         switch (peek.type) {
           case TT_RSQUARE: {
             // end of the init
-            Node *n = literalNodeCreate(LT_AGGREGATEINIT, start);
-            n->data.literal.data.aggregateInitVal = literals;
-            return n;
+            return aggregateInitLiteralNodeCreate(start, literals);
           }
           case TT_COMMA: {
             break;  // continue on
@@ -425,9 +412,7 @@ static Node *parseAggregateInitializer(FileListEntry *entry, Token *start) {
       }
       case TT_RSQUARE: {
         // end of the init
-        Node *n = literalNodeCreate(LT_AGGREGATEINIT, start);
-        n->data.literal.data.aggregateInitVal = literals;
-        return n;
+        return aggregateInitLiteralNodeCreate(start, literals);
       }
       default: {
         errorExpectedString(entry, "a right square bracket or a literal",
@@ -470,17 +455,19 @@ static Node *parseLiteral(FileListEntry *entry) {
       return wstringLiteralNodeCreate(&peek);
     }
     case TT_LIT_DOUBLE: {
-      uint64_t bits = doubleStringToBits(peek.string);
+      char *string = tokenCopyString(&peek);
+      uint64_t bits = doubleStringToBits(string);
+      free(string);
       Node *n = literalNodeCreate(LT_DOUBLE, &peek);
       n->data.literal.data.doubleBits = bits;
-      tokenUninit(&peek);
       return n;
     }
     case TT_LIT_FLOAT: {
-      uint32_t bits = floatStringToBits(peek.string);
+      char *string = tokenCopyString(&peek);
+      uint32_t bits = floatStringToBits(string);
+      free(string);
       Node *n = literalNodeCreate(LT_FLOAT, &peek);
       n->data.literal.data.floatBits = bits;
-      tokenUninit(&peek);
       return n;
     }
     case TT_TRUE:
@@ -664,7 +651,7 @@ static Node *parseType(FileListEntry *entry) {
             case TT_DOUBLE:
             case TT_BOOL:
             case TT_ID: {
-              unLex(entry, &start);
+              unLex(entry, &next2);
               Node *argType = parseType(entry);
               if (argType == NULL) {
                 nodeVectorFree(argTypes);
@@ -676,11 +663,8 @@ static Node *parseType(FileListEntry *entry) {
 
               Token id;
               lex(entry, &id);
-              if (id.type == TT_ID)
-                // has an identifier - ignore this
-                tokenUninit(&id);
-              else
-                unLex(entry, &id);
+              // if it has an identifier, ignore it
+              if (id.type != TT_ID) unLex(entry, &id);
 
               Token next3;
               lex(entry, &next3);
@@ -1261,6 +1245,18 @@ static Node *finishVarDefn(FileListEntry *entry, Node *type, Vector *names,
   }
 }
 
+/**
+ * adds a token to the tokens of an unparsed function body
+ *
+ * The token's string is interned, since the body is parsed after the file is
+ * unmapped
+ */
+static void saveToken(TokenBuffer *tokens, Token *token) {
+  if (token->string != NULL && token->type != TT_ID)
+    token->string = internRange(token->string, token->length);
+  tokenBufferPush(tokens, token);
+}
+
 /**
  * makes a function body unparsed
  *
@@ -1271,16 +1267,15 @@ static Node *finishVarDefn(FileListEntry *entry, Node *type, Vector *names,
  * @returns unparsed node, or NULL if fatal error
  */
 static Node *parseFuncBody(FileListEntry *entry, Token *start) {
-  Vector *tokens = vectorCreate();
-  Token *startCopy = malloc(sizeof(Token));
-  memcpy(startCopy, start, sizeof(Token));
-  vectorInsert(tokens, startCopy);
+  TokenBuffer *tokens = malloc(sizeof(TokenBuffer));
+  tokenBufferInit(tokens);
+  saveToken(tokens, start);
 
   size_t levels = 1;
   while (levels > 0) {
-    Token *token = malloc(sizeof(Token));
-    lex(entry, token);
-    switch (token->type) {
+    Token token;
+    lex(entry, &token);
+    switch (token.type) {
       case TT_LBRACE: {
         ++levels;
         break;
@@ -1292,20 +1287,20 @@ static Node *parseFuncBody(FileListEntry *entry, Token *start) {
       case TT_EOF: {
         // unmatched brace! - will let parseFunctionBody (in functionBody.c)
         // complain about it
-        vectorInsert(tokens, token);
+        saveToken(tokens, &token);
 
         // put a copy of the EOF token back - safe and not
         // strictly necessary: parseBodies will pull another token
         // from the lexer, which thinks every token past the end is
         // an EOF, and EOFs are all flat objects in memory
-        unLex(entry, token);
+        unLex(entry, &token);
         return unparsedNodeCreate(tokens);
       }
       default: {
         break;
       }
     }
-    vectorInsert(tokens, token);
+    saveToken(tokens, &token);
   }
   return unparsedNodeCreate(tokens);
 }
@@ -1635,7 +1630,7 @@ static Node *parseStructDecl(FileListEntry *entry, Token *start) {
   }
 
   if (fields->size == 0) {
-    fprintf(stderr,
+    fprintf(diagnosticStream(),
             "%s:%zu:%zu: error: expected at least one field in a struct "
             "declaration\n",
             entry->inputFilename, lbrace.line, lbrace.character);
@@ -1736,7 +1731,7 @@ static Node *parseUnionDecl(FileListEntry *entry, Token *start) {
   }
 
   if (options->size == 0) {
-    fprintf(stderr,
+    fprintf(diagnosticStream(),
             "%s:%zu:%zu: error: expected at least one option in a union "
             "declaration\n",
             entry->inputFilename, lbrace.line, lbrace.character);
@@ -1877,7 +1872,7 @@ static Node *parseEnumDecl(FileListEntry *entry, Token *start) {
   }
 
   if (constantNames->size == 0) {
-    fprintf(stderr,
+    fprintf(diagnosticStream(),
             "%s:%zu:%zu: error: expected at least one enumeration constant in "
             "a enumeration declaration\n",
             entry->inputFilename, lbrace.line, lbrace.character);
@@ -0,0 +1,354 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Implementation of the compile server and client
+//
+// A request is sent as the length of its body, as a uint64_t, along with the
+// client's stdout and stderr file descriptors, followed by the body: the
+// client's working directory and then each argument, each NUL-terminated. The
+// response is the exit code, as an int.
+
+#include "server.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdnoreturn.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "options.h"
+#include "parser/precompiled.h"
+#include "util/container/vector.h"
+#include "util/functional.h"
+
+/** number of file descriptors sent with a request */
+#define NUM_FDS 2
+
+/**
+ * fills in a socket address
+ *
+ * @returns status code (0 = OK)
+ */
+static int makeAddress(struct sockaddr_un *address, char const *socketPath) {
+  memset(address, 0, sizeof(struct sockaddr_un));
+  address->sun_family = AF_UNIX;
+  if (strlen(socketPath) >= sizeof(address->sun_path)) return -1;
+  strcpy(address->sun_path, socketPath);
+  return 0;
+}
+
+/**
+ * reads exactly length bytes
+ *
+ * @returns status code (0 = OK)
+ */
+static int readAll(int fd, void *buffer, size_t length) {
+  char *current = buffer;
+  while (length > 0) {
+    ssize_t got = read(fd, current, length);
+    if (got <= 0) return -1;
+    current += got;
+    length -= (size_t)got;
+  }
+  return 0;
+}
+
+/**
+ * writes exactly length bytes
+ *
+ * @returns status code (0 = OK)
+ */
+static int writeAll(int fd, void const *buffer, size_t length) {
+  char const *current = buffer;
+  while (length > 0) {
+    ssize_t wrote = write(fd, current, length);
+    if (wrote <= 0) return -1;
+    current += wrote;
+    length -= (size_t)wrote;
+  }
+  return 0;
+}
+
+/**
+ * receives the length of a request and its file descriptors
+ *
+ * @param conn connection to read from
+ * @param length output parameter for the length of the body
+ * @param fds output parameter for the file descriptors
+ * @returns status code (0 = OK)
+ */
+static int receiveHeader(int conn, uint64_t *length, int fds[NUM_FDS]) {
+  union {
+    char buffer[CMSG_SPACE(sizeof(int) * NUM_FDS)];
+    struct cmsghdr align;
+  } control;
+  struct iovec iov = {length, sizeof(uint64_t)};
+  struct msghdr message;
+  memset(&message, 0, sizeof(struct msghdr));
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control.buffer;
+  message.msg_controllen = sizeof(control.buffer);
+
+  ssize_t got = recvmsg(conn, &message, 0);
+  if (got <= 0) return -1;
+
+  struct cmsghdr *cmsg = CMSG_FIRSTHDR(&message);
+  if (cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET ||
+      cmsg->cmsg_type != SCM_RIGHTS ||
+      cmsg->cmsg_len != CMSG_LEN(sizeof(int) * NUM_FDS))
+    return -1;
+  memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * NUM_FDS);
+
+  // rest of the length may come separately
+  if (readAll(conn, (char *)length + got, sizeof(uint64_t) - (size_t)got) !=
+      0) {
+    for (size_t idx = 0; idx < NUM_FDS; ++idx) close(fds[idx]);
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * runs one compilation in a worker process, then sends the worker's decl module
+ * cache back to the server and exits
+ *
+ * @param cachePipe where to write the cache
+ * @param fds the client's stdout and stderr
+ * @param cwd directory to compile in
+ * @param args arguments to compile with
+ * @param compile function to compile with
+ * @param defaults options to start the compilation with
+ */
+noreturn static void runWorker(int cachePipe, int const fds[NUM_FDS],
+                               char const *cwd, Vector const *args,
+                               CompileFunction compile,
+                               Options const *defaults) {
+  dup2(fds[0], STDOUT_FILENO);
+  dup2(fds[1], STDERR_FILENO);
+
+  int code;
+  if (args->size == 0) {
+    fprintf(stderr, "tlc: error: malformed request\n");
+    code = EXIT_FAILURE;
+  } else if (chdir(cwd) != 0) {
+    fprintf(stderr, "tlc: error: cannot change to directory '%s'\n", cwd);
+    code = EXIT_FAILURE;
+  } else {
+    memcpy(&options, defaults, sizeof(Options));
+    code = compile(args->size, (char const *const *)args->elements);
+  }
+  fflush(stdout);
+  fflush(stderr);
+
+  FILE *out = fdopen(cachePipe, "wb");
+  if (out != NULL) {
+    precompiledCacheWrite(out);
+    fclose(out);
+  }
+  _exit(code);
+}
+
+/**
+ * runs one request
+ *
+ * The compilation runs in a forked worker, so an internal compiler error or a
+ * crash only ends that compilation; the worker's decl module cache replaces the
+ * server's if it finishes handing it back.
+ *
+ * @param conn connection to the client
+ * @param compile function to compile with
+ * @param defaults options to start the compilation with
+ */
+static void serveRequest(int conn, CompileFunction compile,
+                         Options const *defaults) {
+  uint64_t length;
+  int fds[NUM_FDS];
+  if (receiveHeader(conn, &length, fds) != 0) return;
+
+  char *body = malloc(length + 1);
+  if (body == NULL || readAll(conn, body, length) != 0) {
+    free(body);
+    for (size_t idx = 0; idx < NUM_FDS; ++idx) close(fds[idx]);
+    return;
+  }
+  body[length] = '\0';
+
+  // split body into working directory and arguments
+  char const *cwd = body;
+  Vector args;
+  vectorInit(&args);
+  for (char *current = body + strlen(body) + 1; current < body + length;
+       current += strlen(current) + 1)
+    vectorInsert(&args, current);
+
+  int code = EXIT_FAILURE;
+  int cachePipe[2];
+  pid_t worker = -1;
+  fflush(stdout);
+  fflush(stderr);
+  if (pipe(cachePipe) == 0) {
+    worker = fork();
+    if (worker == 0) {
+      close(cachePipe[0]);
+      runWorker(cachePipe[1], fds, cwd, &args, compile, defaults);
+    } else if (worker == -1) {
+      close(cachePipe[0]);
+      close(cachePipe[1]);
+    }
+  }
+
+  if (worker == -1) {
+    dprintf(fds[1], "tlc: error: cannot start compilation\n");
+  } else {
+    close(cachePipe[1]);
+    FILE *in = fdopen(cachePipe[0], "rb");
+    if (in != NULL) {
+      precompiledCacheRead(in);
+      fclose(in);
+    } else {
+      close(cachePipe[0]);
+    }
+
+    int status;
+    while (waitpid(worker, &status, 0) == -1) {
+      if (errno != EINTR) {
+        status = -1;
+        break;
+      }
+    }
+    if (status != -1 && WIFEXITED(status))
+      code = WEXITSTATUS(status);
+    else
+      dprintf(fds[1], "tlc: error: compilation terminated abnormally\n");
+  }
+  for (size_t idx = 0; idx < NUM_FDS; ++idx) close(fds[idx]);
+
+  writeAll(conn, &code, sizeof(int));
+
+  vectorUninit(&args, nullDtor);
+  free(body);
+}
+
+int serverRun(char const *socketPath, CompileFunction compile) {
+  struct sockaddr_un address;
+  if (makeAddress(&address, socketPath) != 0) {
+    fprintf(stderr, "tlc: error: socket path '%s' is too long\n", socketPath);
+    return EXIT_FAILURE;
+  }
+
+  int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sock == -1) {
+    fprintf(stderr, "tlc: error: cannot create socket\n");
+    return EXIT_FAILURE;
+  }
+
+  // a leftover socket from a server that's no longer running is replaced
+  if (connect(sock, (struct sockaddr *)&address, sizeof(address)) == 0) {
+    fprintf(stderr, "tlc: error: a server is already running at '%s'\n",
+            socketPath);
+    close(sock);
+    return EXIT_FAILURE;
+  }
+  unlink(socketPath);
+
+  if (bind(sock, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+      listen(sock, SOMAXCONN) != 0) {
+    fprintf(stderr, "tlc: error: cannot listen on '%s'\n", socketPath);
+    close(sock);
+    return EXIT_FAILURE;
+  }
+
+  // a client going away mid-compilation shouldn't stop the server
+  signal(SIGPIPE, SIG_IGN);
+
+  Options defaults;
+  memcpy(&defaults, &options, sizeof(Options));
+  precompiledCacheInit();
+
+  while (true) {
+    int conn = accept(sock, NULL, NULL);
+    if (conn == -1) continue;
+    serveRequest(conn, compile, &defaults);
+    close(conn);
+  }
+}
+
+int clientRun(char const *socketPath, size_t argc, char const *const *argv) {
+  struct sockaddr_un address;
+  if (makeAddress(&address, socketPath) != 0) return -1;
+
+  int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sock == -1) return -1;
+  if (connect(sock, (struct sockaddr *)&address, sizeof(address)) != 0) {
+    close(sock);
+    return -1;
+  }
+
+  char *cwd = getcwd(NULL, 0);
+  if (cwd == NULL) {
+    close(sock);
+    return -1;
+  }
+
+  uint64_t length = strlen(cwd) + 1;
+  for (size_t idx = 0; idx < argc; ++idx) length += strlen(argv[idx]) + 1;
+
+  union {
+    char buffer[CMSG_SPACE(sizeof(int) * NUM_FDS)];
+    struct cmsghdr align;
+  } control;
+  memset(&control, 0, sizeof(control));
+  struct iovec iov = {&length, sizeof(uint64_t)};
+  struct msghdr message;
+  memset(&message, 0, sizeof(struct msghdr));
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control.buffer;
+  message.msg_controllen = sizeof(control.buffer);
+  struct cmsghdr *cmsg = CMSG_FIRSTHDR(&message);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int) * NUM_FDS);
+  int fds[NUM_FDS] = {STDOUT_FILENO, STDERR_FILENO};
+  memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * NUM_FDS);
+
+  bool sent = sendmsg(sock, &message, 0) == sizeof(uint64_t) &&
+              writeAll(sock, cwd, strlen(cwd) + 1) == 0;
+  for (size_t idx = 0; idx < argc && sent; ++idx)
+    sent = writeAll(sock, argv[idx], strlen(argv[idx]) + 1) == 0;
+  free(cwd);
+
+  int code;
+  if (!sent || readAll(sock, &code, sizeof(int)) != 0) {
+    fprintf(stderr, "tlc: error: lost connection to server at '%s'\n",
+            socketPath);
+    code = EXIT_FAILURE;
+  }
+
+  close(sock);
+  return code;
+}
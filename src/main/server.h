@@ -0,0 +1,61 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/**
+ * @file
+ * resident compile server and its client
+ *
+ * The server listens on a Unix socket and runs one compilation at a time, each
+ * in the client's working directory and with the client's stdout and stderr.
+ * Decl modules stay in memory between compilations, so a compilation only pays
+ * to parse the decl modules that changed. Each compilation runs in a forked
+ * worker, so one that fails with an internal error doesn't stop the server.
+ */
+
+#ifndef TLC_SERVER_H_
+#define TLC_SERVER_H_
+
+#include <stddef.h>
+
+/**
+ * compiles given command line arguments, and returns the exit code
+ */
+typedef int (*CompileFunction)(size_t argc, char const *const *argv);
+
+/**
+ * runs the compile server until killed
+ *
+ * @param socketPath path to create the socket at
+ * @param compile function to run each compilation with
+ * @returns exit code, if the server could not be started
+ */
+int serverRun(char const *socketPath, CompileFunction compile);
+
+/**
+ * sends a compilation to the compile server, and waits for it to finish
+ *
+ * @param socketPath path of the server's socket
+ * @param argc number of arguments (including name of program)
+ * @param argv list of arguments (including name of program)
+ * @returns exit code of the compilation, or -1 if the server couldn't be
+ * reached
+ */
+int clientRun(char const *socketPath, size_t argc, char const *const *argv);
+
+#endif  // TLC_SERVER_H_
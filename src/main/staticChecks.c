@@ -23,5 +23,9 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "lexer/lexer.h"
+
 static_assert(sizeof(size_t) <= sizeof(uint64_t),
-              "size_t must be no larger than an unsigned 64 bit integer");
\ No newline at end of file
+              "size_t must be no larger than an unsigned 64 bit integer");
+static_assert(TT_BAD_HEX <= UINT8_MAX,
+              "token types must fit in a byte to be stored in a TokenBuffer");
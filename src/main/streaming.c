@@ -0,0 +1,130 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Implementation of streaming compilation
+
+#include "streaming.h"
+
+#include <stdlib.h>
+
+#include "arch/interface.h"
+#include "ast/ast.h"
+#include "exitCode.h"
+#include "ir/dump.h"
+#include "ir/ir.h"
+#include "optimization/optimization.h"
+#include "options.h"
+#include "translation/traceSchedule.h"
+#include "translation/translation.h"
+#include "typechecker/typechecker.h"
+#include "util/diagnostics.h"
+#include "util/threadPool.h"
+#include "util/timeReport.h"
+
+/**
+ * dumps a file's IR, if the given debug-dump stop was requested
+ */
+static void dumpFileIr(DebugDumpOption stop, FileListEntry *file) {
+  if (options.dump == stop) irDump(diagnosticStream(), file);
+}
+
+int compileFile(FileListEntry *file) {
+  typecheckFile(file);
+  if (file->errored) return CODE_TYPECHECK_ERROR;
+
+  translateFile(file);
+  fileNodeFreeFunctionBodies(file->ast);
+  dumpFileIr(OPTION_DD_TRANSLATION, file);
+  if (options.debugValidateIr &&
+      validateFileBlockedIr(file, "translation") != 0)
+    return CODE_IR_ERROR;
+  if (options.dump == OPTION_DD_TRANSLATION) return CODE_SUCCESS;
+
+  optimizeBlockedIrFile(file);
+  dumpFileIr(OPTION_DD_BLOCKED_OPTIMIZATION, file);
+  if (options.debugValidateIr &&
+      validateFileBlockedIr(file, "optimization before trace scheduling") != 0)
+    return CODE_IR_ERROR;
+  if (options.dump == OPTION_DD_BLOCKED_OPTIMIZATION) return CODE_SUCCESS;
+
+  traceScheduleFile(file);
+  dumpFileIr(OPTION_DD_TRACE_SCHEDULING, file);
+  if (options.debugValidateIr &&
+      validateFileScheduledIr(file, "trace scheduling") != 0)
+    return CODE_IR_ERROR;
+  if (options.dump == OPTION_DD_TRACE_SCHEDULING) return CODE_SUCCESS;
+
+  optimizeScheduledIrFile(file);
+  dumpFileIr(OPTION_DD_SCHEDULED_OPTIMIZATION, file);
+  if (options.debugValidateIr &&
+      validateFileScheduledIr(file, "optimization after trace scheduling") !=
+          0)
+    return CODE_IR_ERROR;
+  if (options.dump == OPTION_DD_SCHEDULED_OPTIMIZATION) return CODE_SUCCESS;
+
+  backendFile(file);
+  return CODE_SUCCESS;
+}
+
+static void typecheckDeclTask(size_t idx, void *ignored) {
+  (void)ignored;
+  if (!fileList.entries[idx].isCode) typecheckFile(&fileList.entries[idx]);
+}
+
+static void compileFileTask(size_t idx, void *data) {
+  int *codes = data;
+  FileListEntry *file = &fileList.entries[idx];
+  if (file->isCode) {
+    codes[idx] = compileFile(file);
+    // backend frees the IR only if the file got that far - it doesn't if
+    // compilation stopped at a debug-dump
+    if (codes[idx] != CODE_SUCCESS || options.dump != OPTION_DD_NONE)
+      vectorUninit(&file->irFrags, (void (*)(void *))irFragFree);
+  } else {
+    codes[idx] = CODE_SUCCESS;
+    vectorUninit(&file->irFrags, (void (*)(void *))irFragFree);
+  }
+}
+
+int compileStreaming(bool *irFreed) {
+  typecheckInit();
+
+  timePhaseStart("typecheck");
+  threadPoolRun(fileList.size, typecheckDeclTask, NULL);
+  timePhaseEnd();
+  for (size_t idx = 0; idx < fileList.size; ++idx) {
+    if (fileList.entries[idx].errored) return CODE_TYPECHECK_ERROR;
+  }
+
+  int *codes = malloc(sizeof(int) * fileList.size);
+  timePhaseStart("streaming compilation");
+  threadPoolRun(fileList.size, compileFileTask, codes);
+  timePhaseEnd();
+  *irFreed = true;
+
+  // report the earliest phase that failed, as compiling phase by phase would
+  int code = CODE_SUCCESS;
+  for (size_t idx = 0; idx < fileList.size; ++idx) {
+    if (codes[idx] != CODE_SUCCESS &&
+        (code == CODE_SUCCESS || codes[idx] < code))
+      code = codes[idx];
+  }
+  free(codes);
+  return code;
+}
@@ -0,0 +1,59 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+/**
+ * @file
+ * streaming compilation - taking code files through the compiler one at a time
+ */
+
+#ifndef TLC_STREAMING_H_
+#define TLC_STREAMING_H_
+
+#include <stdbool.h>
+
+#include "fileList.h"
+
+/**
+ * takes one code file from typechecking through the backend, or up to the
+ * requested debug-dump stop
+ *
+ * must be after typecheckInit, and the file must be parsed; the file's
+ * function bodies are freed once it's translated, and the backend frees its IR
+ * if the file gets that far
+ *
+ * @param file file to compile
+ * @returns exit code for the file
+ */
+int compileFile(FileListEntry *file);
+
+/**
+ * compiles each code file on its own, after typechecking the decl files
+ *
+ * a code file's function bodies are freed once it's translated, and its IR
+ * once it's been through the backend, so only the files being worked on have
+ * their bodies or IR in memory
+ *
+ * @param irFreed output parameter set to true once the IR of every file has
+ * been freed
+ * @returns exit code for main
+ */
+int compileStreaming(bool *irFreed);
+
+#endif  // TLC_STREAMING_H_
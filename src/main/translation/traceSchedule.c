@@ -19,10 +19,13 @@
 
 #include "translation/traceSchedule.h"
 
+#include <stdlib.h>
+
 #include "fileList.h"
 #include "ir/ir.h"
 #include "ir/shorthand.h"
 #include "util/internalError.h"
+#include "util/threadPool.h"
 
 static void copyOverLastInstruction(IRBlock *b, IRBlock *out) {
   // TODO: can make this more efficient by copying over the listnode
@@ -124,15 +127,21 @@ static IRInstruction *oneArgJumpFromTwoArgJump(IRInstruction *i) {
     }
   }
 }
-static void scheduleBlock(IRBlock *b, IRBlock *out, LinkedList *blocks,
-                          Vector *frags) {
-  for (ListNode *currBlock = blocks->head->next; currBlock != blocks->tail;
-       currBlock = currBlock->next) {
-    if (currBlock->data == b) {
-      removeNode(currBlock);
-      break;
-    }
-  }
+/**
+ * finds a block that hasn't been scheduled yet
+ *
+ * @returns index of the block, or cfg->numBlocks if it isn't in the fragment
+ * or was already scheduled
+ */
+static size_t findUnscheduled(IRCfg const *cfg, bool const *scheduled,
+                              size_t label) {
+  size_t idx = irCfgIndexOf(cfg, label);
+  return idx == cfg->numBlocks || scheduled[idx] ? cfg->numBlocks : idx;
+}
+static void scheduleBlock(size_t idx, IRBlock *out, IRCfg const *cfg,
+                          IRFragIndex const *frags, bool *scheduled) {
+  IRBlock *b = cfg->blocks[idx];
+  scheduled[idx] = true;
   // add a label
   IR(out, LABEL(b->label));
 
@@ -161,8 +170,10 @@ static void scheduleBlock(IRBlock *b, IRBlock *out, LinkedList *blocks,
       // if it's a jump to a local, schedule that block and skip the jump,
       // otherwise, copy the jump verbatim
       if (irOperandIsLocal(last->args[0])) {
-        IRBlock *found = findBlock(blocks, localOperandName(last->args[0]));
-        if (found != NULL) scheduleBlock(found, out, blocks, frags);
+        size_t found =
+            findUnscheduled(cfg, scheduled, localOperandName(last->args[0]));
+        if (found != cfg->numBlocks)
+          scheduleBlock(found, out, cfg, frags, scheduled);
       } else {
         copyOverLastInstruction(b, out);
       }
@@ -170,11 +181,13 @@ static void scheduleBlock(IRBlock *b, IRBlock *out, LinkedList *blocks,
     }
     case IO_JUMPTABLE: {
       copyOverLastInstruction(b, out);
-      IRFrag *table = findFrag(frags, localOperandName(last->args[1]));
-      for (size_t idx = 0; idx < table->data.data.data.size; ++idx) {
-        IRDatum *datum = table->data.data.data.elements[idx];
-        IRBlock *found = findBlock(blocks, datum->data.localLabel);
-        if (found != NULL) scheduleBlock(found, out, blocks, frags);
+      IRFrag *table = irFragIndexFind(frags, localOperandName(last->args[1]));
+      for (size_t datumIdx = 0; datumIdx < table->data.data.data.size;
+           ++datumIdx) {
+        IRDatum *datum = table->data.data.data.elements[datumIdx];
+        size_t found = findUnscheduled(cfg, scheduled, datum->data.localLabel);
+        if (found != cfg->numBlocks)
+          scheduleBlock(found, out, cfg, frags, scheduled);
       }
       break;
     }
@@ -200,14 +213,16 @@ static void scheduleBlock(IRBlock *b, IRBlock *out, LinkedList *blocks,
     case IO_J2FNZ: {
       // both must be jumps to locals - assume falsehood is more likely
       IR(out, oneArgJumpFromTwoArgJump(last));
-      IRBlock *found = findBlock(blocks, localOperandName(last->args[1]));
-      if (found != NULL) {
-        scheduleBlock(found, out, blocks, frags);
+      size_t found =
+          findUnscheduled(cfg, scheduled, localOperandName(last->args[1]));
+      if (found != cfg->numBlocks) {
+        scheduleBlock(found, out, cfg, frags, scheduled);
       } else {
         IR(out, JUMP(localOperandName(last->args[1])));
       }
-      found = findBlock(blocks, localOperandName(last->args[0]));
-      if (found != NULL) scheduleBlock(found, out, blocks, frags);
+      found = findUnscheduled(cfg, scheduled, localOperandName(last->args[0]));
+      if (found != cfg->numBlocks)
+        scheduleBlock(found, out, cfg, frags, scheduled);
       break;
     }
     case IO_RETURN: {
@@ -221,25 +236,39 @@ static void scheduleBlock(IRBlock *b, IRBlock *out, LinkedList *blocks,
             "passing");
     }
   }
-  irBlockFree(b);
 }
 
-void traceSchedule(void) {
-  for (size_t fileIdx = 0; fileIdx < fileList.size; ++fileIdx) {
-    if (fileList.entries[fileIdx].isCode) {
-      FileListEntry *file = &fileList.entries[fileIdx];
-      for (size_t fragIdx = 0; fragIdx < file->irFrags.size; ++fragIdx) {
-        IRFrag *frag = file->irFrags.elements[fragIdx];
-        if (frag->type == FT_TEXT) {
-          LinkedList blocks;
-          blocks.head = frag->data.text.blocks.head;
-          blocks.tail = frag->data.text.blocks.tail;
-          linkedListInit(&frag->data.text.blocks);
-          IRBlock *out = BLOCK(0, &frag->data.text.blocks);
-          scheduleBlock(blocks.head->next->data, out, &blocks, &file->irFrags);
-          linkedListUninit(&blocks, (void (*)(void *))irBlockFree);
-        }
-      }
+void traceScheduleFile(FileListEntry *file) {
+  IRFragIndex frags;
+  irFragIndexInit(&frags, &file->irFrags, file->nextId);
+  for (size_t fragIdx = 0; fragIdx < file->irFrags.size; ++fragIdx) {
+    IRFrag *frag = file->irFrags.elements[fragIdx];
+    if (frag->type == FT_TEXT) {
+      // the old blocks are left to be released with the fragment's arena
+      LinkedList blocks;
+      blocks.head = frag->data.text.blocks.head;
+      blocks.tail = frag->data.text.blocks.tail;
+      irArenaSet(frag->data.text.arena);
+      linkedListInit(&frag->data.text.blocks);
+      IRCfg cfg;
+      irCfgInit(&cfg, &blocks, &frags);
+      bool *scheduled = calloc(cfg.numBlocks, sizeof(bool));
+      IRBlock *out = BLOCK(0, &frag->data.text.blocks);
+      scheduleBlock(0, out, &cfg, &frags, scheduled);
+      irArenaSet(NULL);
+      free(scheduled);
+      irCfgUninit(&cfg);
     }
   }
+  irFragIndexUninit(&frags);
+}
+
+static void traceScheduleTask(size_t fileIdx, void *ignored) {
+  (void)ignored;
+  FileListEntry *file = &fileList.entries[fileIdx];
+  if (file->isCode) traceScheduleFile(file);
+}
+
+void traceSchedule(void) {
+  threadPoolRun(fileList.size, traceScheduleTask, NULL);
 }
\ No newline at end of file
@@ -24,6 +24,8 @@
 #ifndef TLC_TRANSLATION_TRACESCHEDULE_H_
 #define TLC_TRANSLATION_TRACESCHEDULE_H_
 
+typedef struct FileListEntry FileListEntry;
+
 /**
  * trace-schedules all of the files' IR
  *
@@ -31,4 +33,13 @@
  */
 void traceSchedule(void);
 
+/**
+ * trace-schedules one code file's IR
+ *
+ * the file must have been translated first
+ *
+ * @param file code file to schedule
+ */
+void traceScheduleFile(FileListEntry *file);
+
 #endif  // TLC_TRANSLATION_TRACESCHEDULE_H_
\ No newline at end of file
@@ -27,6 +27,7 @@
 #include "util/internalError.h"
 #include "util/numericSizing.h"
 #include "util/string.h"
+#include "util/threadPool.h"
 
 size_t fresh(FileListEntry *file) { return file->nextId++; }
 
@@ -699,26 +700,20 @@ static void translateInitializer(Vector *data, Vector *irFrags,
           break;
         }
         case SK_STRUCT: {
-          size_t pos = 0;
-          for (size_t idx = 0; idx < entry->data.structType.fieldTypes.size;
-               ++idx) {
+          size_t numFields = entry->data.structType.fieldTypes.size;
+          for (size_t idx = 0; idx < numFields; ++idx) {
             translateInitializer(
                 data, irFrags, entry->data.structType.fieldTypes.elements[idx],
                 initializer->data.literal.data.aggregateInitVal->elements[idx],
                 file);
-            pos += typeSizeof(entry->data.structType.fieldTypes.elements[idx]);
-            size_t padded;
-            if (idx < entry->data.structType.fieldTypes.size - 1) {
-              padded = incrementToMultiple(
-                  pos,
-                  typeAlignof(
-                      entry->data.structType.fieldTypes.elements[idx + 1]));
-            } else {
-              padded = incrementToMultiple(pos, typeAlignof(type));
-            }
+            size_t pos =
+                entry->data.structType.fieldOffsets[idx] +
+                typeSizeof(entry->data.structType.fieldTypes.elements[idx]);
+            size_t padded = idx < numFields - 1
+                                ? entry->data.structType.fieldOffsets[idx + 1]
+                                : entry->data.structType.layout.size;
             if (padded != pos)
               vectorInsert(data, paddingDatumCreate(padded - pos));
-            pos = padded;
           }
           break;
         }
@@ -1078,11 +1073,11 @@ static IROperand *translateCast(IRBlock *b, IROperand *src,
     IROperand *out = TEMPOF(fresh(file), toType);
     SymbolTableEntry *entry = toType->data.reference.entry;
     size_t srcOffset = 0;
-    size_t destOffset = 0;
     for (size_t idx = 0; idx < fromType->data.aggregate.types.size; ++idx) {
       Type const *srcElementType = fromType->data.aggregate.types.elements[idx];
       Type const *destElementType =
           entry->data.structType.fieldTypes.elements[idx];
+      size_t destOffset = entry->data.structType.fieldOffsets[idx];
       IROperand *uncastElement = TEMPOF(fresh(file), srcElementType);
       IR(b, OFFSET_LOAD(irOperandCopy(uncastElement), irOperandCopy(src),
                         OFFSET((int64_t)srcOffset)));
@@ -1090,14 +1085,10 @@ static IROperand *translateCast(IRBlock *b, IROperand *src,
                                              destElementType, file);
       IR(b, OFFSET_STORE(irOperandCopy(out), castElement,
                          OFFSET((int64_t)destOffset)));
-      if (idx + 1 < fromType->data.aggregate.types.size) {
+      if (idx + 1 < fromType->data.aggregate.types.size)
         srcOffset = incrementToMultiple(
             srcOffset + typeSizeof(srcElementType),
             typeAlignof(fromType->data.aggregate.types.elements[idx + 1]));
-        destOffset = incrementToMultiple(
-            destOffset + typeSizeof(destElementType),
-            typeAlignof(entry->data.structType.fieldTypes.elements[idx + 1]));
-      }
     }
     irOperandFree(src);
     return out;
@@ -1423,7 +1414,6 @@ static IROperand *translateMulStyleOp(IRBlock *b, IROperand *lhs,
     IR(b, BINOP(unsignedOp, irOperandCopy(out), castLhs, castRhs));
   else
     IR(b, BINOP(signedOp, irOperandCopy(out), castLhs, castRhs));
-  typeFree(merged);
   return out;
 }
 /**
@@ -1555,9 +1545,8 @@ static IROperand *translateShift(IRBlock *b, IROperand *lhs,
                                  Type const *rhsType, IROperator op,
                                  FileListEntry *file) {
   IROperand *out = TEMPOF(fresh(file), lhsType);
-  Type *ubyteType = keywordTypeCreate(TK_UBYTE);
-  IROperand *castRhs = translateCast(b, rhs, rhsType, ubyteType, file);
-  typeFree(ubyteType);
+  IROperand *castRhs =
+      translateCast(b, rhs, rhsType, keywordTypeCreate(TK_UBYTE), file);
   IR(b, BINOP(op, irOperandCopy(out), lhs, castRhs));
   return out;
 }
@@ -1674,7 +1663,6 @@ static IROperand *translateComparison(IRBlock *b, IROperand *lhs,
     IR(b, BINOP(unsignedOp, irOperandCopy(out), castLhs, castRhs));
   else
     IR(b, BINOP(signedOp, irOperandCopy(out), castLhs, castRhs));
-  typeFree(merged);
   return out;
 }
 /**
@@ -2041,7 +2029,6 @@ static LValue *translateExpressionLValue(LinkedList *blocks, Node const *e,
               arithmeticTypeMerge(expressionTypeof(lhs), expressionTypeof(rhs));
           IROperand *castResult =
               translateCast(b, rawResult, merged, expressionTypeof(lhs), file);
-          typeFree(merged);
           translateLValueStore(b, lvalue, castResult, file);
           IR(b, JUMP(nextLabel));
           return lvalue;
@@ -2332,7 +2319,6 @@ static void translateExpressionPredicate(LinkedList *blocks, Node const *e,
           IR(b, CJUMP(binopToCjump(e->data.binOpExp.op, typeFloating(merged),
                                    typeSignedIntegral(merged)),
                       trueLabel, falseLabel, castedLhs, castedRhs));
-          typeFree(merged);
           break;
         }
         case BO_FIELD:
@@ -2672,7 +2658,6 @@ static IROperand *translateExpressionValue(LinkedList *blocks, Node const *e,
               arithmeticTypeMerge(expressionTypeof(lhs), expressionTypeof(rhs));
           IROperand *castResult =
               translateCast(b, rawResult, merged, expressionTypeof(lhs), file);
-          typeFree(merged);
           translateLValueStore(b, lvalue, castResult, file);
           IR(b, JUMP(nextLabel));
           lvalueFree(lvalue);
@@ -3310,7 +3295,6 @@ static void translateExpressionVoid(LinkedList *blocks, Node const *e,
               arithmeticTypeMerge(expressionTypeof(lhs), expressionTypeof(rhs));
           IROperand *castResult =
               translateCast(b, rawResult, merged, expressionTypeof(lhs), file);
-          typeFree(merged);
           translateLValueStore(b, lvalue, castResult, file);
           IR(b, JUMP(nextLabel));
           lvalueFree(lvalue);
@@ -4042,10 +4026,7 @@ static void translateStmt(LinkedList *blocks, Node *stmt, size_t label,
   }
 }
 
-/**
- * translate the given file
- */
-static void translateFile(FileListEntry *file) {
+void translateFile(FileListEntry *file) {
   char *namePrefix =
       generatePrefix(file->ast->data.file.module->data.module.id);
   Vector *bodies = file->ast->data.file.bodies;
@@ -4058,6 +4039,8 @@ static void translateFile(FileListEntry *file) {
             suffixName(namePrefix, body->data.funDefn.name->data.id.id));
         vectorInsert(&file->irFrags, frag);
         LinkedList *blocks = &frag->data.text.blocks;
+        irArenaSet(frag->data.text.arena);
+        frag->data.text.firstId = file->nextId;
 
         size_t returnValueAddressTemp = fresh(file);
         size_t returnValueTemp = fresh(file);
@@ -4073,6 +4056,8 @@ static void translateFile(FileListEntry *file) {
 
         generateFunctionExit(blocks, entry, returnValueAddressTemp,
                              returnValueTemp, exitLabel, file);
+        frag->data.text.numIds = file->nextId - frag->data.text.firstId;
+        irArenaSet(NULL);
         break;
       }
       case NT_VARDEFN: {
@@ -4092,8 +4077,12 @@ static void translateFile(FileListEntry *file) {
   free(namePrefix);
 }
 
+static void translateFileTask(size_t idx, void *ignored) {
+  (void)ignored;
+  if (fileList.entries[idx].isCode) translateFile(&fileList.entries[idx]);
+}
+
 void translate(void) {
   // for each code file, translate it
-  for (size_t idx = 0; idx < fileList.size; ++idx)
-    if (fileList.entries[idx].isCode) translateFile(&fileList.entries[idx]);
+  threadPoolRun(fileList.size, translateFileTask, NULL);
 }
\ No newline at end of file
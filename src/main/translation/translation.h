@@ -50,4 +50,13 @@ char *getMangledName(SymbolTableEntry *entry);
  */
 void translate(void);
 
+/**
+ * translates one code file into IR
+ *
+ * must have a valid typechecked AST, should always succeed
+ *
+ * @param file code file to translate
+ */
+void translateFile(FileListEntry *file);
+
 #endif  // TLC_TRANSLATION_TRANSLATION_H_
\ No newline at end of file
@@ -25,10 +25,14 @@
 #include <string.h>
 
 #include "fileList.h"
+#include "util/diagnostics.h"
 #include "util/internalError.h"
+#include "util/threadPool.h"
 
 /**
  * static bool type to compare with for conditionals
+ *
+ * only written by typecheckInit, so concurrent tasks may share it
  */
 static Type *boolType;
 
@@ -43,7 +47,7 @@ static void errorNoImplicitConversion(FileListEntry *entry, size_t line,
                                       Type const *to) {
   char *fromString = typeToString(from);
   char *toString = typeToString(to);
-  fprintf(stderr,
+  fprintf(diagnosticStream(),
           "%s:%zu:%zu: error: cannot implicitly convert a value of type '%s' "
           "to a value of type '%s'\n",
           entry->inputFilename, line, character, fromString, toString);
@@ -59,7 +63,7 @@ static void errorNoBinOp(FileListEntry *entry, size_t line, size_t character,
                          Type const *rhsType) {
   char *lhsString = typeToString(lhsType);
   char *rhsString = typeToString(rhsType);
-  fprintf(stderr,
+  fprintf(diagnosticStream(),
           "%s:%zu:%zu: error: cannot perform %s on a value of type '%s' and a "
           "value of type '%s'\n",
           entry->inputFilename, line, character, op, lhsString, rhsString);
@@ -73,7 +77,7 @@ static void errorNoBinOp(FileListEntry *entry, size_t line, size_t character,
 static void errorNoUnOp(FileListEntry *entry, size_t line, size_t character,
                         char const *op, Type const *target) {
   char *typeString = typeToString(target);
-  fprintf(stderr,
+  fprintf(diagnosticStream(),
           "%s:%zu:%zu: error: cannot perform %s on a value of type '%s'\n",
           entry->inputFilename, line, character, op, typeString);
   entry->errored = true;
@@ -85,7 +89,7 @@ static void errorNoUnOp(FileListEntry *entry, size_t line, size_t character,
 static void errorNoMember(FileListEntry *entry, size_t line, size_t character,
                           char const *member, Type const *type) {
   char *typeString = typeToString(type);
-  fprintf(stderr,
+  fprintf(diagnosticStream(),
           "%s:%zu:%zu: error: no member named '%s' on a value of "
           "type '%s'\n",
           entry->inputFilename, line, character, member, typeString);
@@ -98,7 +102,7 @@ static void errorNoMember(FileListEntry *entry, size_t line, size_t character,
 static void errorNoMembers(FileListEntry *entry, size_t line, size_t character,
                            Type const *type) {
   char *typeString = typeToString(type);
-  fprintf(stderr,
+  fprintf(diagnosticStream(),
           "%s:%zu:%zu: error: cannot access members on a value of "
           "type '%s'\n",
           entry->inputFilename, line, character, typeString);
@@ -110,7 +114,7 @@ static void errorNoMembers(FileListEntry *entry, size_t line, size_t character,
  */
 static void errorNotLvalue(FileListEntry *entry, size_t line, size_t character,
                            char const *op) {
-  fprintf(stderr, "%s:%zu:%zu: error: cannot %s a non-lvalue\n",
+  fprintf(diagnosticStream(), "%s:%zu:%zu: error: cannot %s a non-lvalue\n",
           entry->inputFilename, line, character, op);
   entry->errored = true;
 }
@@ -120,7 +124,7 @@ static void errorNotLvalue(FileListEntry *entry, size_t line, size_t character,
 static void errorIncompleteType(FileListEntry *entry, size_t line,
                                 size_t character, Type const *t) {
   char *typeString = typeToString(t);
-  fprintf(stderr,
+  fprintf(diagnosticStream(),
           "%s:%zu:%zu: error: values of type '%s' do not exist; the type is "
           "incomplete\n",
           entry->inputFilename, line, character, typeString);
@@ -133,7 +137,8 @@ static void errorIncompleteType(FileListEntry *entry, size_t line,
 static void errorRecursiveDecl(FileListEntry *entry, size_t line,
                                size_t character, char const *what,
                                char const *name) {
-  fprintf(stderr, "%s:%zu:%zu: error: the %s '%s' may not contain itself\n",
+  fprintf(diagnosticStream(),
+          "%s:%zu:%zu: error: the %s '%s' may not contain itself\n",
           entry->inputFilename, line, character, what, name);
   entry->errored = true;
 }
@@ -203,13 +208,18 @@ static bool isLvalue(Node const *exp) {
 
 /**
  * marks the given expression as needing to be stored in memory
+ *
+ * only variables belonging to the current file are marked - global variables
+ * from other files always live in memory, and may be shared with other files
+ * being typechecked concurrently. Globals of the current file may still be
+ * marked by several of its functions at once, so escapes is atomic
  */
-static void markEscapes(Node *exp) {
+static void markEscapes(Node *exp, FileListEntry *file) {
   switch (exp->type) {
     case NT_BINOPEXP: {
       switch (exp->data.binOpExp.op) {
         case BO_SEQ: {
-          markEscapes(exp->data.binOpExp.rhs);
+          markEscapes(exp->data.binOpExp.rhs, file);
           break;
         }
         case BO_ASSIGN:
@@ -226,7 +236,7 @@ static void markEscapes(Node *exp) {
         case BO_BITORASSIGN:
         case BO_LANDASSIGN:
         case BO_LORASSIGN: {
-          markEscapes(exp->data.binOpExp.lhs);
+          markEscapes(exp->data.binOpExp.lhs, file);
           break;
         }
         default: {
@@ -236,8 +246,8 @@ static void markEscapes(Node *exp) {
       break;
     }
     case NT_TERNARYEXP: {
-      markEscapes(exp->data.ternaryExp.consequent);
-      markEscapes(exp->data.ternaryExp.alternative);
+      markEscapes(exp->data.ternaryExp.consequent, file);
+      markEscapes(exp->data.ternaryExp.alternative, file);
       break;
     }
     case NT_UNOPEXP: {
@@ -245,7 +255,7 @@ static void markEscapes(Node *exp) {
         case UO_DEREF:
         case UO_PREINC:
         case UO_PREDEC: {
-          markEscapes(exp->data.unOpExp.target);
+          markEscapes(exp->data.unOpExp.target, file);
           break;
         }
         default: {
@@ -255,11 +265,13 @@ static void markEscapes(Node *exp) {
       break;
     }
     case NT_ID: {
-      exp->data.id.entry->data.variable.escapes = true;
+      if (exp->data.id.entry->file == file)
+        exp->data.id.entry->data.variable.escapes = true;
       break;
     }
     case NT_SCOPEDID: {
-      exp->data.scopedId.entry->data.variable.escapes = true;
+      if (exp->data.scopedId.entry->file == file)
+        exp->data.scopedId.entry->data.variable.escapes = true;
       break;
     }
     default: {
@@ -300,7 +312,7 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
                            "assign a value to");
           } else if (lhsType != NULL && lhsType->kind == TK_QUALIFIED &&
                      lhsType->data.qualified.constQual) {
-            fprintf(stderr,
+            fprintf(diagnosticStream(),
                     "%s:%zu:%zu: error: cannot assign a value to a constant "
                     "variable\n",
                     entry->inputFilename, exp->line, exp->character);
@@ -326,14 +338,13 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
                 !typeImplicitlyConvertable(merged, lhsType))
               errorNoImplicitConversion(entry, exp->line, exp->character,
                                         merged, lhsType);
-            typeFree(merged);
 
             if (!isLvalue(exp->data.binOpExp.lhs)) {
               errorNotLvalue(entry, exp->line, exp->character,
                              "assign a value to");
             } else if (lhsType != NULL && lhsType->kind == TK_QUALIFIED &&
                        lhsType->data.qualified.constQual) {
-              fprintf(stderr,
+              fprintf(diagnosticStream(),
                       "%s:%zu:%zu: error: cannot assign a value to a constant "
                       "variable\n",
                       entry->inputFilename, exp->line, exp->character);
@@ -359,14 +370,13 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
                 !typeImplicitlyConvertable(merged, lhsType))
               errorNoImplicitConversion(entry, exp->line, exp->character,
                                         merged, lhsType);
-            typeFree(merged);
 
             if (!isLvalue(exp->data.binOpExp.lhs)) {
               errorNotLvalue(entry, exp->line, exp->character,
                              "assign a value to");
             } else if (lhsType != NULL && lhsType->kind == TK_QUALIFIED &&
                        lhsType->data.qualified.constQual) {
-              fprintf(stderr,
+              fprintf(diagnosticStream(),
                       "%s:%zu:%zu: error: cannot assign a value to a constant "
                       "variable\n",
                       entry->inputFilename, exp->line, exp->character);
@@ -392,14 +402,13 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
                 !typeImplicitlyConvertable(merged, lhsType))
               errorNoImplicitConversion(entry, exp->line, exp->character,
                                         merged, lhsType);
-            typeFree(merged);
 
             if (!isLvalue(exp->data.binOpExp.lhs)) {
               errorNotLvalue(entry, exp->line, exp->character,
                              "assign a value to");
             } else if (lhsType != NULL && lhsType->kind == TK_QUALIFIED &&
                        lhsType->data.qualified.constQual) {
-              fprintf(stderr,
+              fprintf(diagnosticStream(),
                       "%s:%zu:%zu: error: cannot assign a value to a constant "
                       "variable\n",
                       entry->inputFilename, exp->line, exp->character);
@@ -426,7 +435,6 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
                   !typeImplicitlyConvertable(merged, lhsType))
                 errorNoImplicitConversion(entry, exp->line, exp->character,
                                           merged, lhsType);
-              typeFree(merged);
 
               if (!isLvalue(exp->data.binOpExp.lhs)) {
                 errorNotLvalue(entry, exp->line, exp->character,
@@ -434,7 +442,7 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
               } else if (lhsType != NULL && lhsType->kind == TK_QUALIFIED &&
                          lhsType->data.qualified.constQual) {
                 fprintf(
-                    stderr,
+                    diagnosticStream(),
                     "%s:%zu:%zu: error: cannot assign a value to a constant "
                     "variable\n",
                     entry->inputFilename, exp->line, exp->character);
@@ -447,7 +455,7 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
               } else if (lhsType != NULL && lhsType->kind == TK_QUALIFIED &&
                          lhsType->data.qualified.constQual) {
                 fprintf(
-                    stderr,
+                    diagnosticStream(),
                     "%s:%zu:%zu: error: cannot assign a value to a constant "
                     "variable\n",
                     entry->inputFilename, exp->line, exp->character);
@@ -479,7 +487,6 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
                   !typeImplicitlyConvertable(merged, lhsType))
                 errorNoImplicitConversion(entry, exp->line, exp->character,
                                           merged, lhsType);
-              typeFree(merged);
 
               if (!isLvalue(exp->data.binOpExp.lhs)) {
                 errorNotLvalue(entry, exp->line, exp->character,
@@ -487,7 +494,7 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
               } else if (lhsType != NULL && lhsType->kind == TK_QUALIFIED &&
                          lhsType->data.qualified.constQual) {
                 fprintf(
-                    stderr,
+                    diagnosticStream(),
                     "%s:%zu:%zu: error: cannot assign a value to a constant "
                     "variable\n",
                     entry->inputFilename, exp->line, exp->character);
@@ -500,7 +507,7 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
               } else if (lhsType != NULL && lhsType->kind == TK_QUALIFIED &&
                          lhsType->data.qualified.constQual) {
                 fprintf(
-                    stderr,
+                    diagnosticStream(),
                     "%s:%zu:%zu: error: cannot assign a value to a constant "
                     "variable\n",
                     entry->inputFilename, exp->line, exp->character);
@@ -533,7 +540,7 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
                            "assign a value to");
           } else if (lhsType != NULL && lhsType->kind == TK_QUALIFIED &&
                      lhsType->data.qualified.constQual) {
-            fprintf(stderr,
+            fprintf(diagnosticStream(),
                     "%s:%zu:%zu: error: cannot assign a value to a constant "
                     "variable\n",
                     entry->inputFilename, exp->line, exp->character);
@@ -560,7 +567,7 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
                            "assign a value to");
           } else if (lhsType != NULL && lhsType->kind == TK_QUALIFIED &&
                      lhsType->data.qualified.constQual) {
-            fprintf(stderr,
+            fprintf(diagnosticStream(),
                     "%s:%zu:%zu: error: cannot assign a value to a constant "
                     "variable\n",
                     entry->inputFilename, exp->line, exp->character);
@@ -588,14 +595,13 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
                 !typeImplicitlyConvertable(merged, lhsType))
               errorNoImplicitConversion(entry, exp->line, exp->character,
                                         merged, lhsType);
-            typeFree(merged);
 
             if (!isLvalue(exp->data.binOpExp.lhs)) {
               errorNotLvalue(entry, exp->line, exp->character,
                              "assign a value to");
             } else if (lhsType != NULL && lhsType->kind == TK_QUALIFIED &&
                        lhsType->data.qualified.constQual) {
-              fprintf(stderr,
+              fprintf(diagnosticStream(),
                       "%s:%zu:%zu: error: cannot assign a value to a constant "
                       "variable\n",
                       entry->inputFilename, exp->line, exp->character);
@@ -624,7 +630,7 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
                            "assign a value to");
           } else if (lhsType != NULL && lhsType->kind == TK_QUALIFIED &&
                      lhsType->data.qualified.constQual) {
-            fprintf(stderr,
+            fprintf(diagnosticStream(),
                     "%s:%zu:%zu: error: cannot assign a value to a constant "
                     "variable\n",
                     entry->inputFilename, exp->line, exp->character);
@@ -841,9 +847,8 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
               if (ref->kind == SK_STRUCT) {
                 for (size_t idx = 0; idx < ref->data.structType.fieldNames.size;
                      ++idx) {
-                  if (strcmp(exp->data.binOpExp.rhs->data.id.id,
-                             ref->data.structType.fieldNames.elements[idx]) ==
-                      0) {
+                  if (exp->data.binOpExp.rhs->data.id.id ==
+                      ref->data.structType.fieldNames.elements[idx]) {
                     return exp->data.binOpExp.type = typeCopy(
                                ref->data.structType.fieldTypes.elements[idx]);
                   }
@@ -851,9 +856,8 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
               } else {
                 for (size_t idx = 0; idx < ref->data.unionType.optionNames.size;
                      ++idx) {
-                  if (strcmp(exp->data.binOpExp.rhs->data.id.id,
-                             ref->data.unionType.optionNames.elements[idx]) ==
-                      0) {
+                  if (exp->data.binOpExp.rhs->data.id.id ==
+                      ref->data.unionType.optionNames.elements[idx]) {
                     return exp->data.binOpExp.type = typeCopy(
                                ref->data.unionType.optionTypes.elements[idx]);
                   }
@@ -881,9 +885,8 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
               if (ref->kind == SK_STRUCT) {
                 for (size_t idx = 0; idx < ref->data.structType.fieldNames.size;
                      ++idx) {
-                  if (strcmp(exp->data.binOpExp.rhs->data.id.id,
-                             ref->data.structType.fieldNames.elements[idx]) ==
-                      0) {
+                  if (exp->data.binOpExp.rhs->data.id.id ==
+                      ref->data.structType.fieldNames.elements[idx]) {
                     return exp->data.binOpExp.type = typeCopy(
                                ref->data.structType.fieldTypes.elements[idx]);
                   }
@@ -891,9 +894,8 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
               } else {
                 for (size_t idx = 0; idx < ref->data.unionType.optionNames.size;
                      ++idx) {
-                  if (strcmp(exp->data.binOpExp.rhs->data.id.id,
-                             ref->data.unionType.optionNames.elements[idx]) ==
-                      0) {
+                  if (exp->data.binOpExp.rhs->data.id.id ==
+                      ref->data.unionType.optionNames.elements[idx]) {
                     return exp->data.binOpExp.type = typeCopy(
                                ref->data.unionType.optionTypes.elements[idx]);
                   }
@@ -935,7 +937,7 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
               !typeExplicitlyConvertable(target, exp->data.binOpExp.type)) {
             char *fromString = typeToString(target);
             char *toString = typeToString(exp->data.binOpExp.type);
-            fprintf(stderr,
+            fprintf(diagnosticStream(),
                     "%s:%zu:%zu: error: cannot convert a value of type '%s' to "
                     "a value of type '%s'\n",
                     entry->inputFilename, exp->line, exp->character, fromString,
@@ -971,7 +973,7 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
       if (consequentType != NULL && alternativeType != NULL && merged == NULL) {
         char *consequentString = typeToString(consequentType);
         char *alternativeString = typeToString(alternativeType);
-        fprintf(stderr,
+        fprintf(diagnosticStream(),
                 "%s:%zu:%zu: error: type mismatch in ternary expression - "
                 "cannot find common type between %s and %s\n",
                 entry->inputFilename, exp->line, exp->character,
@@ -1010,7 +1012,7 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
             errorNotLvalue(entry, exp->line, exp->character,
                            "take the address of");
           } else {
-            markEscapes(exp->data.unOpExp.target);
+            markEscapes(exp->data.unOpExp.target, entry);
           }
 
           if (type != NULL) {
@@ -1157,7 +1159,7 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
         } else {
           if (stripped->data.funPtr.argTypes.size !=
               exp->data.funCallExp.arguments->size) {
-            fprintf(stderr,
+            fprintf(diagnosticStream(),
                     "%s:%zu:%zu: error: function expects %zu arguments, but "
                     "was called with %zu\n",
                     entry->inputFilename, exp->line, exp->character,
@@ -1243,15 +1245,17 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
                      pointerTypeCreate(keywordTypeCreate(TK_VOID));
         }
         case LT_AGGREGATEINIT: {
-          exp->data.literal.type = aggregateTypeCreate();
+          Vector types;
+          vectorInit(&types);
           for (size_t idx = 0;
                idx < exp->data.literal.data.aggregateInitVal->size; ++idx) {
             vectorInsert(
-                &exp->data.literal.type->data.aggregate.types,
+                &types,
                 typeCopy(typecheckExpression(
                     exp->data.literal.data.aggregateInitVal->elements[idx],
                     entry)));
           }
+          exp->data.literal.type = aggregateTypeCreate(&types);
           return exp->data.literal.type;
         }
         default: {
@@ -1271,15 +1275,14 @@ static Type const *typecheckExpression(Node *exp, FileListEntry *entry) {
         return exp->data.id.type =
                    typeCopy(exp->data.id.entry->data.variable.type);
       } else {
+        Vector *argumentTypes =
+            &exp->data.id.entry->data.function.argumentTypes;
+        Vector argTypes;
+        vectorInit(&argTypes);
+        for (size_t idx = 0; idx < argumentTypes->size; ++idx)
+          vectorInsert(&argTypes, argumentTypes->elements[idx]);
         exp->data.id.type = funPtrTypeCreate(
-            typeCopy(exp->data.id.entry->data.function.returnType));
-        for (size_t idx = 0;
-             idx < exp->data.id.entry->data.function.argumentTypes.size;
-             ++idx) {
-          vectorInsert(&exp->data.id.type->data.funPtr.argTypes,
-                       typeCopy(exp->data.id.entry->data.function.argumentTypes
-                                    .elements[idx]));
-        }
+            exp->data.id.entry->data.function.returnType, &argTypes);
         return exp->data.id.type;
       }
     }
@@ -1365,7 +1368,7 @@ static void typecheckStmt(Node *stmt, Type const *returnType,
           typecheckExpression(stmt->data.switchStmt.condition, entry);
       if (!typeSwitchable(conditionType)) {
         char *typeString = typeToString(conditionType);
-        fprintf(stderr,
+        fprintf(diagnosticStream(),
                 "%s:%zu:%zu: error: cannot switch on values of type '%s'\n",
                 entry->inputFilename, stmt->data.switchStmt.condition->line,
                 stmt->data.switchStmt.condition->character, typeString);
@@ -1427,11 +1430,11 @@ static void typecheckStmt(Node *stmt, Type const *returnType,
         Node *c = cases->elements[idx];
         if (c->type == NT_SWITCHDEFAULT) {
           if (seenDefault) {
-            fprintf(stderr,
+            fprintf(diagnosticStream(),
                     "%s:%zu:%zu: error: cannot have multiple default cases in "
                     "a switch statement\n",
                     entry->inputFilename, c->line, c->character);
-            fprintf(stderr, "%s:%zu:%zu: note: first seen here\n",
+            fprintf(diagnosticStream(), "%s:%zu:%zu: note: first seen here\n",
                     entry->inputFilename, firstLine, firstCharacter);
             entry->errored = true;
           } else {
@@ -1567,12 +1570,13 @@ static void typecheckStmt(Node *stmt, Type const *returnType,
                                    values[currValue - 1].value.signedVal) ||
                   (!isSigned && values[valueIdx].value.unsignedVal ==
                                     values[currValue - 1].value.unsignedVal)) {
-                fprintf(stderr,
+                fprintf(diagnosticStream(),
                         "%s:%zu:%zu: error: cannot have multiple cases with "
                         "the same value in a switch statement\n",
                         entry->inputFilename, values[currValue - 1].line,
                         values[currValue - 1].character);
-                fprintf(stderr, "%s:%zu:%zu: note: first seen here\n",
+                fprintf(diagnosticStream(),
+                        "%s:%zu:%zu: note: first seen here\n",
                         entry->inputFilename, values[valueIdx].line,
                         values[valueIdx].character);
                 entry->errored = true;
@@ -1600,7 +1604,7 @@ static void typecheckStmt(Node *stmt, Type const *returnType,
         if (!(returnType->kind == TK_KEYWORD &&
               returnType->data.keyword.keyword == TK_VOID)) {
           char *typeString = typeToString(returnType);
-          fprintf(stderr,
+          fprintf(diagnosticStream(),
                   "%s:%zu:%zu: error: must return a value from a function "
                   "returining '%s'\n",
                   entry->inputFilename, stmt->line, stmt->character,
@@ -1666,133 +1670,181 @@ static void typecheckStmt(Node *stmt, Type const *returnType,
   }
 }
 
+void typecheckInit(void) { boolType = keywordTypeCreate(TK_BOOL); }
+
 /**
- * typechecks a file
+ * typechecks one top level form
  *
- * @param entry entry to typecheck
+ * @param entry entry containing the form
+ * @param body form to typecheck
  */
-static void typecheckFile(FileListEntry *entry) {
-  Vector *bodies = entry->ast->data.file.bodies;
-  for (size_t idx = 0; idx < bodies->size; ++idx) {
-    Node *body = bodies->elements[idx];
-    switch (body->type) {
-      case NT_VARDEFN: {
-        Vector *names = body->data.varDefn.names;
-        Vector *initializers = body->data.varDefn.initializers;
-        Node *firstName = names->elements[0];
-        if (!typeComplete(firstName->data.id.entry->data.variable.type))
-          errorIncompleteType(entry, body->data.varDefn.type->line,
-                              body->data.varDefn.type->character,
-                              firstName->data.id.entry->data.variable.type);
-        for (size_t idx = 0; idx < names->size; ++idx) {
-          Node *name = names->elements[idx];
-          Node *initializer = initializers->elements[idx];
-          if (initializer != NULL) {
-            Type const *initializerType =
-                typecheckExpression(initializer, entry);
-            if (initializerType != NULL &&
-                !typeImplicitlyConvertable(
-                    initializerType, name->data.id.entry->data.variable.type)) {
-              errorNoImplicitConversion(
-                  entry, initializer->line, initializer->character,
-                  initializerType, name->data.id.entry->data.variable.type);
-            }
-          }
-        }
-        break;
-      }
-      case NT_VARDECL: {
-        Vector *names = body->data.varDecl.names;
-        Node *firstName = names->elements[0];
-        if (!typeComplete(firstName->data.id.entry->data.variable.type))
-          errorIncompleteType(entry, body->data.varDecl.type->line,
-                              body->data.varDecl.type->character,
-                              firstName->data.id.entry->data.variable.type);
-        break;
-      }
-      case NT_FUNDEFN: {
-        Type const *returnType =
-            body->data.funDefn.name->data.id.entry->data.function.returnType;
-        if (!((returnType->kind == TK_KEYWORD &&
-               returnType->data.keyword.keyword == TK_VOID) ||
-              typeComplete(returnType)))
-          errorIncompleteType(entry, body->data.funDefn.returnType->line,
-                              body->data.funDefn.returnType->character,
-                              returnType);
-        Vector *argTypes = &body->data.funDefn.name->data.id.entry->data
-                                .function.argumentTypes;
-        for (size_t idx = 0; idx < argTypes->size; ++idx) {
-          if (!typeComplete(argTypes->elements[idx])) {
-            Node *typeNode = body->data.funDefn.argTypes->elements[idx];
-            errorIncompleteType(entry, typeNode->line, typeNode->character,
-                                argTypes->elements[idx]);
+static void typecheckBody(FileListEntry *entry, Node *body) {
+  switch (body->type) {
+    case NT_VARDEFN: {
+      Vector *names = body->data.varDefn.names;
+      Vector *initializers = body->data.varDefn.initializers;
+      Node *firstName = names->elements[0];
+      if (!typeComplete(firstName->data.id.entry->data.variable.type))
+        errorIncompleteType(entry, body->data.varDefn.type->line,
+                            body->data.varDefn.type->character,
+                            firstName->data.id.entry->data.variable.type);
+      for (size_t idx = 0; idx < names->size; ++idx) {
+        Node *name = names->elements[idx];
+        Node *initializer = initializers->elements[idx];
+        if (initializer != NULL) {
+          Type const *initializerType = typecheckExpression(initializer, entry);
+          if (initializerType != NULL &&
+              !typeImplicitlyConvertable(
+                  initializerType, name->data.id.entry->data.variable.type)) {
+            errorNoImplicitConversion(
+                entry, initializer->line, initializer->character,
+                initializerType, name->data.id.entry->data.variable.type);
           }
         }
-        typecheckStmt(body->data.funDefn.body, returnType, entry);
-        break;
       }
-      case NT_FUNDECL: {
-        Type const *returnType =
-            body->data.funDecl.name->data.id.entry->data.function.returnType;
-        if (!((returnType->kind == TK_KEYWORD &&
-               returnType->data.keyword.keyword == TK_VOID) ||
-              typeComplete(returnType)))
-          errorIncompleteType(entry, body->data.funDecl.returnType->line,
-                              body->data.funDecl.returnType->character,
-                              returnType);
-        Vector *argTypes = &body->data.funDecl.name->data.id.entry->data
-                                .function.argumentTypes;
-        for (size_t idx = 0; idx < argTypes->size; ++idx) {
-          if (!typeComplete(argTypes->elements[idx])) {
-            Node *typeNode = body->data.funDecl.argTypes->elements[idx];
-            errorIncompleteType(entry, typeNode->line, typeNode->character,
-                                argTypes->elements[idx]);
-          }
+      break;
+    }
+    case NT_VARDECL: {
+      Vector *names = body->data.varDecl.names;
+      Node *firstName = names->elements[0];
+      if (!typeComplete(firstName->data.id.entry->data.variable.type))
+        errorIncompleteType(entry, body->data.varDecl.type->line,
+                            body->data.varDecl.type->character,
+                            firstName->data.id.entry->data.variable.type);
+      break;
+    }
+    case NT_FUNDEFN: {
+      Type const *returnType =
+          body->data.funDefn.name->data.id.entry->data.function.returnType;
+      if (!((returnType->kind == TK_KEYWORD &&
+             returnType->data.keyword.keyword == TK_VOID) ||
+            typeComplete(returnType)))
+        errorIncompleteType(entry, body->data.funDefn.returnType->line,
+                            body->data.funDefn.returnType->character,
+                            returnType);
+      Vector *argTypes =
+          &body->data.funDefn.name->data.id.entry->data.function.argumentTypes;
+      for (size_t idx = 0; idx < argTypes->size; ++idx) {
+        if (!typeComplete(argTypes->elements[idx])) {
+          Node *typeNode = body->data.funDefn.argTypes->elements[idx];
+          errorIncompleteType(entry, typeNode->line, typeNode->character,
+                              argTypes->elements[idx]);
         }
-        break;
       }
-      case NT_STRUCTDECL: {
-        if (structRecursive(body->data.structDecl.name->data.id.entry)) {
-          errorRecursiveDecl(entry, body->line, body->character, "struct",
-                             body->data.structDecl.name->data.id.id);
+      typecheckStmt(body->data.funDefn.body, returnType, entry);
+      break;
+    }
+    case NT_FUNDECL: {
+      Type const *returnType =
+          body->data.funDecl.name->data.id.entry->data.function.returnType;
+      if (!((returnType->kind == TK_KEYWORD &&
+             returnType->data.keyword.keyword == TK_VOID) ||
+            typeComplete(returnType)))
+        errorIncompleteType(entry, body->data.funDecl.returnType->line,
+                            body->data.funDecl.returnType->character,
+                            returnType);
+      Vector *argTypes =
+          &body->data.funDecl.name->data.id.entry->data.function.argumentTypes;
+      for (size_t idx = 0; idx < argTypes->size; ++idx) {
+        if (!typeComplete(argTypes->elements[idx])) {
+          Node *typeNode = body->data.funDecl.argTypes->elements[idx];
+          errorIncompleteType(entry, typeNode->line, typeNode->character,
+                              argTypes->elements[idx]);
         }
-        break;
       }
-      case NT_UNIONDECL: {
-        if (unionRecursive(body->data.unionDecl.name->data.id.entry)) {
-          errorRecursiveDecl(entry, body->line, body->character, "union",
-                             body->data.unionDecl.name->data.id.id);
-        }
-        break;
+      break;
+    }
+    case NT_STRUCTDECL: {
+      if (structRecursive(body->data.structDecl.name->data.id.entry)) {
+        errorRecursiveDecl(entry, body->line, body->character, "struct",
+                           body->data.structDecl.name->data.id.id);
       }
-      case NT_TYPEDEFDECL: {
-        if (typedefRecursive(body->data.typedefDecl.name->data.id.entry)) {
-          errorRecursiveDecl(entry, body->line, body->character, "typedef",
-                             body->data.typedefDecl.name->data.id.id);
-        }
-        break;
+      break;
+    }
+    case NT_UNIONDECL: {
+      if (unionRecursive(body->data.unionDecl.name->data.id.entry)) {
+        errorRecursiveDecl(entry, body->line, body->character, "union",
+                           body->data.unionDecl.name->data.id.id);
       }
-      default: {
-        break;  // nothing to check
+      break;
+    }
+    case NT_TYPEDEFDECL: {
+      if (typedefRecursive(body->data.typedefDecl.name->data.id.entry)) {
+        errorRecursiveDecl(entry, body->line, body->character, "typedef",
+                           body->data.typedefDecl.name->data.id.id);
       }
+      break;
+    }
+    default: {
+      break;  // nothing to check
     }
   }
 }
 
+void typecheckFile(FileListEntry *entry) {
+  Vector *bodies = entry->ast->data.file.bodies;
+  for (size_t idx = 0; idx < bodies->size; ++idx)
+    typecheckBody(entry, bodies->elements[idx]);
+}
+
+/** a run of top level forms in one file, typechecked as one task */
+typedef struct {
+  FileListEntry *entry; /**< file the forms are in */
+  size_t start;         /**< index of the first form in the file's bodies */
+  size_t end;           /**< index one past the last form */
+} TypecheckTask;
+
+static void typecheckTask(size_t idx, void *data) {
+  TypecheckTask *task = (TypecheckTask *)data + idx;
+  Vector *bodies = task->entry->ast->data.file.bodies;
+  for (size_t bodyIdx = task->start; bodyIdx < task->end; ++bodyIdx)
+    typecheckBody(task->entry, bodies->elements[bodyIdx]);
+}
+
 int typecheck(void) {
   bool errored = false;
 
-  boolType = keywordTypeCreate(TK_BOOL);
-
-  // for each code file, type check it
-  for (size_t idx = 0; idx < fileList.size; ++idx) {
-    typecheckFile(&fileList.entries[idx]);
-    errored = errored || fileList.entries[idx].errored;
+  typecheckInit();
+
+  // each function definition is its own task, and the forms between them are
+  // grouped into one task, so a file with many functions is spread over all
+  // of the threads - tasks are in source order, so diagnostics are too
+  size_t maxTasks = 0;
+  for (size_t fileIdx = 0; fileIdx < fileList.size; ++fileIdx)
+    maxTasks += fileList.entries[fileIdx].ast->data.file.bodies->size;
+  TypecheckTask *tasks = malloc(sizeof(TypecheckTask) * maxTasks);
+  size_t *files = malloc(sizeof(size_t) * maxTasks);
+  size_t count = 0;
+  for (size_t fileIdx = 0; fileIdx < fileList.size; ++fileIdx) {
+    FileListEntry *entry = &fileList.entries[fileIdx];
+    Vector *bodies = entry->ast->data.file.bodies;
+    size_t start = 0;
+    for (size_t bodyIdx = 0; bodyIdx <= bodies->size; ++bodyIdx) {
+      bool isFunction =
+          bodyIdx < bodies->size &&
+          ((Node *)bodies->elements[bodyIdx])->type == NT_FUNDEFN;
+      if (bodyIdx == bodies->size || isFunction) {
+        if (start < bodyIdx) {
+          tasks[count] = (TypecheckTask){entry, start, bodyIdx};
+          files[count++] = fileIdx;
+        }
+        if (isFunction) {
+          tasks[count] = (TypecheckTask){entry, bodyIdx, bodyIdx + 1};
+          files[count++] = fileIdx;
+        }
+        start = bodyIdx + 1;
+      }
+    }
   }
 
-  typeFree(boolType);
+  threadPoolRunFor(count, files, typecheckTask, tasks);
+  free(files);
+  free(tasks);
+
+  for (size_t idx = 0; idx < fileList.size; ++idx)
+    errored = errored || fileList.entries[idx].errored;
 
   if (errored) return -1;
 
   return 0;
-}
\ No newline at end of file
+}
@@ -25,6 +25,8 @@
 #ifndef TLC_TYPECHECKER_TYPECHECKER_
 #define TLC_TYPECHECKER_TYPECHECKER_
 
+#include "fileList.h"
+
 /**
  * typechecks all of the files in the file list
  *
@@ -34,4 +36,18 @@
  */
 int typecheck(void);
 
+/**
+ * sets up to typecheck individual files
+ */
+void typecheckInit(void);
+
+/**
+ * typechecks one file, setting its errored flag if it has errors
+ *
+ * must be after typecheckInit, and the file must have a valid AST
+ *
+ * @param entry entry to typecheck
+ */
+void typecheckFile(FileListEntry *entry);
+
 #endif  // TLC_TYPECHECKER_TYPECHECKER_
\ No newline at end of file
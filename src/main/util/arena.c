@@ -0,0 +1,172 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Implementation of the arena allocator
+
+#include "util/arena.h"
+
+#include <stdalign.h>
+#include <stdlib.h>
+
+/** size of the first chunk's data */
+#define MIN_CHUNK_SIZE ((size_t)4 * 1024)
+/** largest size of a chunk's data, not counting big allocations */
+#define CHUNK_SIZE ((size_t)64 * 1024)
+
+/** a chunk of memory allocations are made from */
+struct ArenaChunk {
+  ArenaChunk *next; /**< next older chunk */
+  max_align_t data[];
+};
+
+/** something to release when the arena is reset or freed */
+struct ArenaCleanup {
+  ArenaCleanup *next; /**< next older cleanup */
+  void (*cleanup)(void *);
+  void *data;
+};
+
+/**
+ * rounds size up to a multiple of the maximum alignment
+ */
+static size_t alignSize(size_t size) {
+  return (size + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+}
+
+Arena *arenaCreate(void) {
+  Arena *arena = malloc(sizeof(Arena));
+  arena->chunks = NULL;
+  arena->next = NULL;
+  arena->end = NULL;
+  arena->chunkSize = MIN_CHUNK_SIZE;
+  arena->cleanups = NULL;
+  return arena;
+}
+
+void *arenaAlloc(Arena *arena, size_t size) {
+  size = alignSize(size);
+  if (arena->next != NULL && (size_t)(arena->end - arena->next) >= size) {
+    void *allocated = arena->next;
+    arena->next += size;
+    return allocated;
+  }
+
+  if (size > CHUNK_SIZE / 4) {
+    // big allocations get their own chunk, behind the current one
+    ArenaChunk *chunk = malloc(sizeof(ArenaChunk) + size);
+    if (arena->chunks == NULL) {
+      chunk->next = NULL;
+      arena->chunks = chunk;
+    } else {
+      chunk->next = arena->chunks->next;
+      arena->chunks->next = chunk;
+    }
+    return chunk->data;
+  }
+
+  size_t chunkSize = arena->chunkSize;
+  while (chunkSize < size) chunkSize *= 2;
+  if (arena->chunkSize < CHUNK_SIZE) arena->chunkSize *= 2;
+
+  ArenaChunk *chunk = malloc(sizeof(ArenaChunk) + chunkSize);
+  chunk->next = arena->chunks;
+  arena->chunks = chunk;
+  arena->next = (char *)chunk->data + size;
+  arena->end = (char *)chunk->data + chunkSize;
+  return chunk->data;
+}
+
+void arenaAddCleanup(Arena *arena, void (*cleanup)(void *), void *data) {
+  ArenaCleanup *record = arenaAlloc(arena, sizeof(ArenaCleanup));
+  record->next = arena->cleanups;
+  record->cleanup = cleanup;
+  record->data = data;
+  arena->cleanups = record;
+}
+
+void arenaMerge(Arena *into, Arena *from) {
+  if (from == NULL) return;
+
+  if (from->cleanups != NULL) {
+    ArenaCleanup *last = from->cleanups;
+    while (last->next != NULL) last = last->next;
+    last->next = into->cleanups;
+    into->cleanups = from->cleanups;
+  }
+
+  if (into->chunks == NULL) {
+    // nothing to keep - take over from's chunks entirely
+    into->chunks = from->chunks;
+    into->next = from->next;
+    into->end = from->end;
+  } else if (from->chunks != NULL) {
+    // splice from's chunks in behind into's current chunk
+    ArenaChunk *last = from->chunks;
+    while (last->next != NULL) last = last->next;
+    last->next = into->chunks->next;
+    into->chunks->next = from->chunks;
+  }
+  free(from);
+}
+
+/**
+ * runs and forgets all of an arena's cleanups
+ */
+static void runCleanups(Arena *arena) {
+  for (ArenaCleanup *record = arena->cleanups; record != NULL;
+       record = record->next)
+    record->cleanup(record->data);
+  arena->cleanups = NULL;
+}
+
+/**
+ * frees a list of chunks
+ */
+static void freeChunks(ArenaChunk *chunk) {
+  while (chunk != NULL) {
+    ArenaChunk *next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+}
+
+void arenaReset(Arena *arena) {
+  runCleanups(arena);
+
+  if (arena->end == NULL) {
+    // no current chunk - only big allocations, if anything
+    freeChunks(arena->chunks);
+    arena->chunks = NULL;
+    return;
+  }
+
+  // the current chunk is always first, and is the biggest ordinary chunk
+  ArenaChunk *current = arena->chunks;
+  freeChunks(current->next);
+  current->next = NULL;
+  arena->next = (char *)current->data;
+}
+
+void arenaFree(Arena *arena) {
+  if (arena == NULL) return;
+
+  runCleanups(arena);
+  freeChunks(arena->chunks);
+  free(arena);
+}
@@ -0,0 +1,104 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/**
+ * @file
+ * bump allocator, freed all at once
+ */
+
+#ifndef TLC_UTIL_ARENA_H_
+#define TLC_UTIL_ARENA_H_
+
+#include <stddef.h>
+
+typedef struct ArenaChunk ArenaChunk;
+typedef struct ArenaCleanup ArenaCleanup;
+
+/**
+ * allocates from chunks, and frees all of its allocations at once
+ *
+ * chunks start small and double in size, so an arena that only ever holds a
+ * little (e.g. one function's body) doesn't waste much
+ *
+ * things that can't live in the arena themselves can be given to it with a
+ * cleanup, which releases them when the arena is reset or freed
+ */
+typedef struct {
+  ArenaChunk *chunks;     /**< chunks allocated, most recent first */
+  char *next;             /**< start of free space in the current chunk */
+  char *end;              /**< end of the current chunk */
+  size_t chunkSize;       /**< size of the next chunk to allocate */
+  ArenaCleanup *cleanups; /**< cleanups to run, most recent first */
+} Arena;
+
+/**
+ * allocating ctor
+ *
+ * @returns allocated and initialized empty Arena
+ */
+Arena *arenaCreate(void);
+
+/**
+ * allocates memory from the arena, aligned for any type
+ *
+ * @param arena arena to allocate from
+ * @param size number of bytes to allocate
+ * @returns allocated memory, valid until the arena is freed
+ */
+void *arenaAlloc(Arena *arena, size_t size);
+
+/**
+ * registers a cleanup to run when the arena is reset or freed
+ *
+ * cleanups run most recent first, before any of the arena's memory is freed,
+ * so they may use memory allocated from the arena
+ *
+ * @param arena arena to register with
+ * @param cleanup function to run
+ * @param data argument to pass to the cleanup
+ */
+void arenaAddCleanup(Arena *arena, void (*cleanup)(void *), void *data);
+
+/**
+ * moves all of from's allocations and cleanups into into, and frees from
+ *
+ * allocations keep their addresses, and are freed along with into
+ *
+ * @param into arena to take the allocations
+ * @param from arena to empty and free, may be null
+ */
+void arenaMerge(Arena *into, Arena *from);
+
+/**
+ * runs the arena's cleanups and frees everything allocated from it, keeping
+ * the current chunk to allocate from again
+ *
+ * @param arena arena to reset
+ */
+void arenaReset(Arena *arena);
+
+/**
+ * runs the arena's cleanups, and frees the arena and everything allocated from
+ * it
+ *
+ * @param arena arena to free, may be null
+ */
+void arenaFree(Arena *arena);
+
+#endif  // TLC_UTIL_ARENA_H_
@@ -0,0 +1,81 @@
+// Copyright 2022 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "util/container/bitSet.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define WORD_BITS 64
+
+size_t bitSetWords(size_t size) { return (size + WORD_BITS - 1) / WORD_BITS; }
+
+uint64_t *bitSetCreate(size_t size) {
+  return calloc(bitSetWords(size), sizeof(uint64_t));
+}
+
+bool bitSetContains(uint64_t const *set, size_t idx) {
+  return (set[idx / WORD_BITS] >> (idx % WORD_BITS) & 1) != 0;
+}
+void bitSetAdd(uint64_t *set, size_t idx) {
+  set[idx / WORD_BITS] |= (uint64_t)1 << (idx % WORD_BITS);
+}
+void bitSetRemove(uint64_t *set, size_t idx) {
+  set[idx / WORD_BITS] &= ~((uint64_t)1 << (idx % WORD_BITS));
+}
+
+void bitSetClear(uint64_t *set, size_t size) {
+  memset(set, 0, bitSetWords(size) * sizeof(uint64_t));
+}
+void bitSetFill(uint64_t *set, size_t size) {
+  size_t words = bitSetWords(size);
+  memset(set, 0xff, words * sizeof(uint64_t));
+  // keep the bits past the end clear, so sets compare equal word-by-word
+  if (size % WORD_BITS != 0)
+    set[words - 1] = ((uint64_t)1 << (size % WORD_BITS)) - 1;
+}
+void bitSetCopy(uint64_t *dst, uint64_t const *src, size_t size) {
+  memcpy(dst, src, bitSetWords(size) * sizeof(uint64_t));
+}
+bool bitSetEqual(uint64_t const *a, uint64_t const *b, size_t size) {
+  return memcmp(a, b, bitSetWords(size) * sizeof(uint64_t)) == 0;
+}
+bool bitSetUnion(uint64_t *dst, uint64_t const *src, size_t size) {
+  uint64_t changed = 0;
+  for (size_t idx = 0; idx < bitSetWords(size); ++idx) {
+    uint64_t old = dst[idx];
+    dst[idx] |= src[idx];
+    changed |= old ^ dst[idx];
+  }
+  return changed != 0;
+}
+bool bitSetIntersect(uint64_t *dst, uint64_t const *src, size_t size) {
+  uint64_t changed = 0;
+  for (size_t idx = 0; idx < bitSetWords(size); ++idx) {
+    uint64_t old = dst[idx];
+    dst[idx] &= src[idx];
+    changed |= old ^ dst[idx];
+  }
+  return changed != 0;
+}
+void bitSetTransfer(uint64_t *dst, uint64_t const *gen, uint64_t const *src,
+                    uint64_t const *kill, size_t size) {
+  for (size_t idx = 0; idx < bitSetWords(size); ++idx)
+    dst[idx] = gen[idx] | (src[idx] & ~kill[idx]);
+}
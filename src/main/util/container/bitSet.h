@@ -0,0 +1,86 @@
+// Copyright 2022 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/**
+ * @file
+ * A fixed-size set of small integers
+ */
+
+#ifndef TLC_UTIL_CONTAINER_BITSET_H_
+#define TLC_UTIL_CONTAINER_BITSET_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A bit set is an array of words holding the integers in [0, size); the size
+ * isn't stored, so whole-set operations take it as an argument
+ *
+ * Many sets of the same size may share one allocation, with set idx starting
+ * at idx * bitSetWords(size)
+ */
+
+/**
+ * number of words needed to hold a set
+ *
+ * @param size number of bits in the set
+ */
+size_t bitSetWords(size_t size);
+
+/**
+ * allocating ctor - free with free()
+ *
+ * @param size number of bits in the set
+ * @returns empty set
+ */
+uint64_t *bitSetCreate(size_t size) __attribute__((malloc));
+
+/** is idx in the set */
+bool bitSetContains(uint64_t const *set, size_t idx);
+/** add idx to the set */
+void bitSetAdd(uint64_t *set, size_t idx);
+/** remove idx from the set */
+void bitSetRemove(uint64_t *set, size_t idx);
+
+/** remove everything from the set */
+void bitSetClear(uint64_t *set, size_t size);
+/** add everything in [0, size) to the set */
+void bitSetFill(uint64_t *set, size_t size);
+/** dst = src */
+void bitSetCopy(uint64_t *dst, uint64_t const *src, size_t size);
+/** are the sets equal */
+bool bitSetEqual(uint64_t const *a, uint64_t const *b, size_t size);
+/**
+ * dst = dst | src
+ *
+ * @returns whether dst changed
+ */
+bool bitSetUnion(uint64_t *dst, uint64_t const *src, size_t size);
+/**
+ * dst = dst & src
+ *
+ * @returns whether dst changed
+ */
+bool bitSetIntersect(uint64_t *dst, uint64_t const *src, size_t size);
+/** dst = gen | (src & ~kill) - the usual dataflow transfer function */
+void bitSetTransfer(uint64_t *dst, uint64_t const *gen, uint64_t const *src,
+                    uint64_t const *kill, size_t size);
+
+#endif  // TLC_UTIL_CONTAINER_BITSET_H_
@@ -18,14 +18,140 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 // Implementation of generic hash map
+//
+// The table is a Swiss table: slots are split into groups of GROUP_WIDTH, and
+// a key's hash picks the group to start probing at and a seven bit tag. A
+// lookup compares the tag against all of a group's control bytes at once
+// (using SSE2, where available), only looks at entries whose tag matches, and
+// stops at the first group with an empty slot. There's no removal, so there
+// are no tombstones.
 
 #include "util/container/hashMap.h"
 
 #include <stdlib.h>
-#include <string.h>
 
-#include "optimization.h"
-#include "util/hash.h"
+#include "util/intern.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/** number of slots probed at once */
+#define GROUP_WIDTH 16
+/** control byte of an empty slot - full slots have the high bit clear */
+#define CONTROL_EMPTY 0x80
+
+/** bitmask of slots in a group, lowest bit is first slot */
+typedef uint32_t GroupMask;
+
+#ifdef __SSE2__
+/**
+ * finds slots in a group with the given control byte
+ */
+static GroupMask groupMatch(uint8_t const *control, uint8_t tag) {
+  __m128i group = _mm_loadu_si128((__m128i const *)control);
+  return (GroupMask)_mm_movemask_epi8(
+      _mm_cmpeq_epi8(group, _mm_set1_epi8((char)tag)));
+}
+
+/**
+ * finds empty slots in a group
+ */
+static GroupMask groupMatchEmpty(uint8_t const *control) {
+  return (GroupMask)_mm_movemask_epi8(
+      _mm_loadu_si128((__m128i const *)control));
+}
+#else
+static GroupMask groupMatch(uint8_t const *control, uint8_t tag) {
+  GroupMask mask = 0;
+  for (size_t idx = 0; idx < GROUP_WIDTH; ++idx)
+    if (control[idx] == tag) mask |= (GroupMask)1 << idx;
+  return mask;
+}
+
+static GroupMask groupMatchEmpty(uint8_t const *control) {
+  return groupMatch(control, CONTROL_EMPTY);
+}
+#endif
+
+/** top seven bits of a hash, stored in the control byte */
+static uint8_t hashTag(uint64_t hash) { return (uint8_t)(hash >> 57); }
+
+/**
+ * finds an entry
+ *
+ * @returns index of the entry, or map->size if it isn't there
+ */
+static size_t findEntry(HashMap const *map, char const *key, uint64_t hash) {
+  if (map->size == 0) return map->size;
+
+  uint8_t tag = hashTag(hash);
+  size_t groupMask = map->numSlots / GROUP_WIDTH - 1;
+  size_t group = hash & groupMask;
+  for (size_t step = 1;; ++step) {
+    size_t first = group * GROUP_WIDTH;
+    for (GroupMask matches = groupMatch(map->control + first, tag);
+         matches != 0; matches &= matches - 1) {
+      size_t entry = map->slots[first + (size_t)__builtin_ctz(matches)];
+      if (map->keys[entry] == key) return entry;
+    }
+    if (groupMatchEmpty(map->control + first) != 0) return map->size;
+    group = (group + step) & groupMask;  // triangular probing
+  }
+}
+
+/**
+ * puts an entry in the first empty slot in its probe sequence
+ */
+static void placeEntry(HashMap *map, size_t entry) {
+  uint64_t hash = map->hashes[entry];
+  size_t groupMask = map->numSlots / GROUP_WIDTH - 1;
+  size_t group = hash & groupMask;
+  for (size_t step = 1;; ++step) {
+    size_t first = group * GROUP_WIDTH;
+    GroupMask empty = groupMatchEmpty(map->control + first);
+    if (empty != 0) {
+      size_t slot = first + (size_t)__builtin_ctz(empty);
+      map->control[slot] = hashTag(hash);
+      map->slots[slot] = entry;
+      return;
+    }
+    group = (group + step) & groupMask;
+  }
+}
+
+/**
+ * doubles the number of slots (or allocates the first group), and makes room
+ * for more entries
+ */
+static void grow(HashMap *map) {
+  map->numSlots = map->numSlots == 0 ? GROUP_WIDTH : map->numSlots * 2;
+  // keep the table at most seven eighths full
+  map->capacity = map->numSlots - map->numSlots / 8;
+  map->keys = realloc(map->keys, map->capacity * sizeof(char const *));
+  map->values = realloc(map->values, map->capacity * sizeof(void *));
+  map->hashes = realloc(map->hashes, map->capacity * sizeof(uint64_t));
+
+  free(map->control);
+  free(map->slots);
+  map->control = malloc(map->numSlots * sizeof(uint8_t));
+  for (size_t idx = 0; idx < map->numSlots; ++idx)
+    map->control[idx] = CONTROL_EMPTY;
+  map->slots = malloc(map->numSlots * sizeof(size_t));
+  for (size_t idx = 0; idx < map->size; ++idx) placeEntry(map, idx);
+}
+
+/**
+ * adds an entry, known not to be in the map
+ */
+static void addEntry(HashMap *map, char const *key, uint64_t hash,
+                     void *value) {
+  if (map->size == map->capacity) grow(map);
+  map->keys[map->size] = key;
+  map->values[map->size] = value;
+  map->hashes[map->size] = hash;
+  placeEntry(map, map->size++);
+}
 
 HashMap *hashMapCreate(void) {
   HashMap *map = malloc(sizeof(HashMap));
@@ -34,126 +160,44 @@ HashMap *hashMapCreate(void) {
 }
 
 void hashMapInit(HashMap *map) {
+  // nothing is allocated until the first entry is added
   map->size = 0;
-  map->capacity = PTR_VECTOR_INIT_CAPACITY;
-  map->keys = calloc(map->capacity, sizeof(char const *));
-  map->values = malloc(map->capacity * sizeof(void *));
+  map->capacity = 0;
+  map->keys = NULL;
+  map->values = NULL;
+  map->hashes = NULL;
+  map->numSlots = 0;
+  map->control = NULL;
+  map->slots = NULL;
 }
 
 void *hashMapGet(HashMap const *map, char const *key) {
-  uint64_t hash = djb2xor(key);
-  hash %= map->capacity;
-
-  if (map->keys[hash] == NULL) {
-    return NULL;                                   // not found
-  } else if (strcmp(map->keys[hash], key) != 0) {  // collision
-    uint64_t hash2 = djb2add(key) + 1;
-    for (size_t idx = (hash + hash2) % map->capacity; idx != hash;
-         idx = (idx + hash2) % map->capacity) {
-      if (map->keys[idx] == NULL) {
-        return NULL;
-      } else if (strcmp(map->keys[idx], key) == 0) {  // found it!
-        return map->values[idx];
-      }
-    }
-    return NULL;  // searched everywhere, couldn't find it
-  } else {        // found it
-    return map->values[hash];
-  }
+  size_t entry = findEntry(map, key, internHash(key));
+  return entry == map->size ? NULL : map->values[entry];
 }
 
 int hashMapPut(HashMap *map, char const *key, void *data) {
-  uint64_t hash = djb2xor(key) % map->capacity;
-
-  if (map->keys[hash] == NULL) {
-    map->keys[hash] = key;
-    map->values[hash] = data;
-    ++map->size;
-    return 0;                                      // empty spot
-  } else if (strcmp(map->keys[hash], key) != 0) {  // collision
-    uint64_t hash2 = djb2add(key) + 1;
-    for (size_t idx = (hash + hash2) % map->capacity; idx != hash;
-         idx = (idx + hash2) % map->capacity) {
-      if (map->keys[idx] == NULL) {  // empty spot
-        map->keys[idx] = key;
-        map->values[idx] = data;
-        ++map->size;
-        return 0;
-      } else if (strcmp(map->keys[idx], key) == 0) {  // already in there
-        return -1;
-      }
-    }
-    size_t oldSize = map->capacity;  // unavoidable collision
-    char const **oldKeys = map->keys;
-    void **oldValues = map->values;
-    map->capacity *= 2;
-    map->keys = calloc(map->capacity, sizeof(char const *));
-    map->values = malloc(map->capacity * sizeof(void *));  // resize the map
-    map->size = 0;
-    for (size_t idx = 0; idx < oldSize; ++idx) {
-      if (oldKeys[idx] != NULL) {
-        // can set, since we know the element doesn't exist
-        hashMapSet(map, oldKeys[idx], oldValues[idx]);
-      }
-    }
-    free(oldKeys);
-    free(oldValues);
-    return hashMapPut(map, key, data);  // recurse
-  } else {                              // already in there
-    return -1;
-  }
+  uint64_t hash = internHash(key);
+  if (findEntry(map, key, hash) != map->size) return -1;  // already in there
+  addEntry(map, key, hash, data);
+  return 0;
 }
 
 void hashMapSet(HashMap *map, char const *key, void *data) {
-  uint64_t hash = djb2xor(key) % map->capacity;
-
-  if (map->keys[hash] == NULL) {
-    map->keys[hash] = key;
-    map->values[hash] = data;
-    ++map->size;
-    return;                                        // empty spot
-  } else if (strcmp(map->keys[hash], key) != 0) {  // collision
-    uint64_t hash2 = djb2add(key) + 1;
-    for (size_t idx = (hash + hash2) % map->capacity; idx != hash;
-         idx = (idx + hash2) % map->capacity) {
-      if (map->keys[idx] == NULL) {  // empty spot
-        map->keys[idx] = key;
-        map->values[idx] = data;
-        ++map->size;
-        return;
-      } else if (strcmp(map->keys[idx], key) == 0) {  // already in there
-        map->values[idx] = data;
-        return;
-      }
-    }
-    size_t oldCap = map->capacity;  // unavoidable collision
-    char const **oldKeys = map->keys;
-    void **oldValues = map->values;
-    map->capacity *= 2;
-    map->keys = calloc(map->capacity, sizeof(char const *));
-    map->values = malloc(map->capacity * sizeof(void *));  // resize the map
-    map->size = 0;
-    for (size_t idx = 0; idx < oldCap; ++idx) {
-      if (oldKeys[idx] != NULL) {
-        hashMapSet(map, oldKeys[idx], oldValues[idx]);
-      }
-    }
-    free(oldKeys);
-    free(oldValues);
-    hashMapSet(map, key, data);  // recurse
-    return;
-  } else {  // already in there
-    map->values[hash] = data;
-    return;
+  uint64_t hash = internHash(key);
+  size_t entry = findEntry(map, key, hash);
+  if (entry == map->size) {
+    addEntry(map, key, hash, data);
+  } else {
+    map->values[entry] = data;
   }
 }
 
 void hashMapUninit(HashMap *map, void (*dtor)(void *)) {
-  for (size_t idx = 0; idx < map->capacity; ++idx) {
-    if (map->keys[idx] != NULL) {
-      dtor(map->values[idx]);
-    }
-  }
+  for (size_t idx = 0; idx < map->size; ++idx) dtor(map->values[idx]);
   free(map->keys);
   free(map->values);
-}
\ No newline at end of file
+  free(map->hashes);
+  free(map->control);
+  free(map->slots);
+}
@@ -19,20 +19,37 @@
 
 /**
  * @file
- * A java-style generic hash map between char const *keys and void *values
+ * A java-style generic hash map between interned char const *keys and void
+ * *values
  */
 
 #ifndef TLC_UTIL_CONTAINER_HASHMAP_H_
 #define TLC_UTIL_CONTAINER_HASHMAP_H_
 
 #include <stddef.h>
+#include <stdint.h>
 
-/** A hash table between a string (not owned) and a value pointer */
+/**
+ * A hash table between an interned string (not owned) and a value pointer
+ *
+ * Keys must come from internString or internRange; they are compared by
+ * address. Entries are stored in keys and values in the order they were
+ * added, so iterating from zero to size visits them in that order.
+ *
+ * Entries are found through an open addressed table of slots, with a control
+ * byte per slot holding the top seven bits of the hash of the key in the slot,
+ * or marking it as empty. Slots are probed a group at a time, comparing all of
+ * a group's control bytes at once.
+ */
 typedef struct {
-  size_t size;
-  size_t capacity;
-  char const **keys;
-  void **values;
+  size_t size;       /**< number of entries */
+  size_t capacity;   /**< number of entries there is room for */
+  char const **keys; /**< keys, in insertion order */
+  void **values;     /**< values, in insertion order */
+  uint64_t *hashes;  /**< hashes of the keys, in insertion order */
+  size_t numSlots;   /**< number of slots, zero or a power of two */
+  uint8_t *control;  /**< control byte of each slot */
+  size_t *slots;     /**< index of the entry in each full slot */
 } HashMap;
 
 /**
@@ -85,4 +102,4 @@ void hashMapSet(HashMap *map, char const *key, void *value);
  */
 void hashMapUninit(HashMap *map, void (*dtor)(void *));
 
-#endif  // TLC_UTIL_CONTAINER_HASHMAP_H_
\ No newline at end of file
+#endif  // TLC_UTIL_CONTAINER_HASHMAP_H_
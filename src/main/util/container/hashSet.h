@@ -28,11 +28,16 @@
 #include <stdbool.h>
 #include <stddef.h>
 
-/** A set of strings, not owned by this */
+#include "util/container/hashMap.h"
+
+/**
+ * A set of interned strings, not owned by this
+ *
+ * Elements must come from internString or internRange; they are compared by
+ * address
+ */
 typedef struct {
-  size_t size;
-  size_t capacity;
-  char const **elements;
+  HashMap map; /**< map from each element to a non-NULL marker */
 } HashSet;
 
 /**
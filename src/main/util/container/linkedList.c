@@ -21,9 +21,29 @@
 
 #include <stdlib.h>
 
+/** arena to allocate nodes from, if any */
+static _Thread_local Arena *currentArena = NULL;
+
+void linkedListArenaSet(Arena *arena) { currentArena = arena; }
+
+static ListNode *nodeCreate(void) {
+  ListNode *n;
+  if (currentArena != NULL) {
+    n = arenaAlloc(currentArena, sizeof(ListNode));
+    n->inArena = true;
+  } else {
+    n = malloc(sizeof(ListNode));
+    n->inArena = false;
+  }
+  return n;
+}
+static void nodeFree(ListNode *n) {
+  if (!n->inArena) free(n);
+}
+
 void linkedListInit(LinkedList *l) {
-  l->head = malloc(sizeof(ListNode));
-  l->tail = malloc(sizeof(ListNode));
+  l->head = nodeCreate();
+  l->tail = nodeCreate();
   l->head->next = l->tail;
   l->head->prev = NULL;
   l->head->data = NULL;
@@ -32,14 +52,14 @@ void linkedListInit(LinkedList *l) {
   l->tail->data = NULL;
 }
 void insertNodeAfter(ListNode *n, void *data) {
-  ListNode *newNode = malloc(sizeof(ListNode));
+  ListNode *newNode = nodeCreate();
   newNode->data = data;
   newNode->prev = n;
   newNode->next = n->next;
   newNode->next->prev = newNode->prev->next = newNode;
 }
 void insertNodeBefore(ListNode *n, void *data) {
-  ListNode *newNode = malloc(sizeof(ListNode));
+  ListNode *newNode = nodeCreate();
   newNode->data = data;
   newNode->prev = n->prev;
   newNode->next = n;
@@ -52,7 +72,7 @@ void *removeNode(ListNode *n) {
   n->next->prev = n->prev;
   n->prev->next = n->next;
   void *retval = n->data;
-  free(n);
+  nodeFree(n);
   return retval;
 }
 size_t linkedListLength(LinkedList *l) {
@@ -65,6 +85,6 @@ void linkedListUninit(LinkedList *l, void (*dtor)(void *)) {
   while (l->head->next != l->tail) {
     dtor(removeNode(l->head->next));
   }
-  free(l->head);
-  free(l->tail);
+  nodeFree(l->head);
+  nodeFree(l->tail);
 }
\ No newline at end of file
@@ -25,13 +25,17 @@
 #ifndef TLC_UTIL_CONTAINER_LINKEDLIST_H_
 #define TLC_UTIL_CONTAINER_LINKEDLIST_H_
 
+#include <stdbool.h>
 #include <stddef.h>
 
+#include "util/arena.h"
+
 /** a doubly linked list node */
 typedef struct ListNode {
   struct ListNode *next;
   struct ListNode *prev;
   void *data;
+  bool inArena; /**< allocated from an arena, and freed with it */
 } ListNode;
 
 /**
@@ -44,6 +48,13 @@ typedef struct {
   struct ListNode *tail;
 } LinkedList;
 
+/**
+ * sets the arena list nodes created by the current thread are allocated from
+ *
+ * @param arena arena to allocate from, or NULL to allocate individually
+ */
+void linkedListArenaSet(Arena *arena);
+
 /**
  * ctor
  */
@@ -61,4 +61,18 @@ void sizeVectorInsert(SizeVector *vector, size_t element) {
   }
   vector->elements[vector->size++] = element;
 }
-void sizeVectorUninit(SizeVector *vector) { free(vector->elements); }
\ No newline at end of file
+void sizeVectorUninit(SizeVector *vector) { free(vector->elements); }
+void stringVectorInit(StringVector *vector) {
+  vector->size = 0;
+  vector->capacity = PTR_VECTOR_INIT_CAPACITY;
+  vector->elements = malloc(vector->capacity * sizeof(char const *));
+}
+void stringVectorInsert(StringVector *vector, char const *element) {
+  if (vector->size == vector->capacity) {
+    vector->capacity *= VECTOR_GROWTH_FACTOR;
+    vector->elements =
+        realloc(vector->elements, vector->capacity * sizeof(char const *));
+  }
+  vector->elements[vector->size++] = element;
+}
+void stringVectorUninit(StringVector *vector) { free(vector->elements); }
@@ -82,4 +82,23 @@ void sizeVectorInsert(SizeVector *v, size_t elm);
  */
 void sizeVectorUninit(SizeVector *v);
 
+/** vector of strings, not owned by the vector */
+typedef struct {
+  size_t size;
+  size_t capacity;
+  char const **elements;
+} StringVector;
+/**
+ * in place ctor
+ */
+void stringVectorInit(StringVector *v);
+/**
+ * insert - amortized constant time
+ */
+void stringVectorInsert(StringVector *v, char const *elm);
+/**
+ * in place dtor
+ */
+void stringVectorUninit(StringVector *v);
+
 #endif  // TLC_UTIL_CONTAINER_VECTOR_H_
\ No newline at end of file
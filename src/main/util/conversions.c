@@ -103,7 +103,10 @@ bool isNybble(char c) {
          (c >= 'A' && c <= 'F');
 }
 
-int binaryToInteger(char *string, int8_t *sign, uint64_t *magnitudeOut) {
+int binaryToInteger(char const *string, size_t length, int8_t *sign,
+                    uint64_t *magnitudeOut) {
+  char const *end = string + length;
+
   // check sign
   switch (string[0]) {
     case '0': {
@@ -132,7 +135,7 @@ int binaryToInteger(char *string, int8_t *sign, uint64_t *magnitudeOut) {
 
   // get value
   uint64_t magnitude = 0;
-  for (; *string != '\0'; ++string) {
+  for (; string != end; ++string) {
     uint64_t oldMagnitude = magnitude;
     magnitude *= 2;
     magnitude += (uint8_t)(charToU8(*string) - charToU8('0'));
@@ -145,7 +148,10 @@ int binaryToInteger(char *string, int8_t *sign, uint64_t *magnitudeOut) {
   *magnitudeOut = magnitude;
   return 0;
 }
-int octalToInteger(char *string, int8_t *sign, uint64_t *magnitudeOut) {
+int octalToInteger(char const *string, size_t length, int8_t *sign,
+                   uint64_t *magnitudeOut) {
+  char const *end = string + length;
+
   // check sign
   switch (string[0]) {
     case '0': {
@@ -174,7 +180,7 @@ int octalToInteger(char *string, int8_t *sign, uint64_t *magnitudeOut) {
 
   // get value
   uint64_t magnitude = 0;
-  for (; *string != '\0'; ++string) {
+  for (; string != end; ++string) {
     uint64_t oldMagnitude = magnitude;
     magnitude *= 8;
     magnitude += (uint8_t)(charToU8(*string) - charToU8('0'));
@@ -187,7 +193,10 @@ int octalToInteger(char *string, int8_t *sign, uint64_t *magnitudeOut) {
   *magnitudeOut = magnitude;
   return 0;
 }
-int decimalToInteger(char *string, int8_t *sign, uint64_t *magnitudeOut) {
+int decimalToInteger(char const *string, size_t length, int8_t *sign,
+                     uint64_t *magnitudeOut) {
+  char const *end = string + length;
+
   // check sign
   switch (string[0]) {
     case '-': {
@@ -213,7 +222,7 @@ int decimalToInteger(char *string, int8_t *sign, uint64_t *magnitudeOut) {
 
   // get value
   uint64_t magnitude = 0;
-  for (; *string != '\0'; ++string) {
+  for (; string != end; ++string) {
     uint64_t oldMagnitude = magnitude;
     magnitude *= 10;
     magnitude += (uint8_t)(charToU8(*string) - charToU8('0'));
@@ -226,7 +235,10 @@ int decimalToInteger(char *string, int8_t *sign, uint64_t *magnitudeOut) {
   *magnitudeOut = magnitude;
   return 0;
 }
-int hexadecimalToInteger(char *string, int8_t *sign, uint64_t *magnitudeOut) {
+int hexadecimalToInteger(char const *string, size_t length, int8_t *sign,
+                         uint64_t *magnitudeOut) {
+  char const *end = string + length;
+
   // check sign
   switch (string[0]) {
     case '0': {
@@ -255,7 +267,7 @@ int hexadecimalToInteger(char *string, int8_t *sign, uint64_t *magnitudeOut) {
 
   // get value
   uint64_t magnitude = 0;
-  for (; *string != '\0'; ++string) {
+  for (; string != end; ++string) {
     uint64_t oldMagnitude = magnitude;
     magnitude *= 16;
     magnitude += nybbleToU8(*string);
@@ -26,6 +26,7 @@
 #define TLC_UTIL_CONVERSIONS_H_
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /**
@@ -95,38 +96,46 @@ bool isNybble(char c);
  * converts a binary integer to a sign and a magnitude
  *
  * @param string string to convert (from lexer - assumes string is good)
+ * @param length length of string
  * @param sign output pointer to sign
  * @param magnitudeOut output pointer to magnitude
  * @returns status code - 0 for OK, 1 for size error
  */
-int binaryToInteger(char *string, int8_t *sign, uint64_t *magnitudeOut);
+int binaryToInteger(char const *string, size_t length, int8_t *sign,
+                    uint64_t *magnitudeOut);
 /**
  * converts an octal integer to a sign and a magnitude
  *
  * @param string string to convert (from lexer - assumes string is good)
+ * @param length length of string
  * @param sign output pointer to sign
  * @param magnitudeOut output pointer to magnitude
  * @returns status code - 0 for OK, 1 for size error
  */
-int octalToInteger(char *string, int8_t *sign, uint64_t *magnitudeOut);
+int octalToInteger(char const *string, size_t length, int8_t *sign,
+                   uint64_t *magnitudeOut);
 /**
  * converts a decimal integer to a sign and a magnitude
  *
  * @param string string to convert (from lexer - assumes string is good)
+ * @param length length of string
  * @param sign output pointer to sign
  * @param magnitudeOut output pointer to magnitude
  * @returns status code - 0 for OK, 1 for size error
  */
-int decimalToInteger(char *string, int8_t *sign, uint64_t *magnitudeOut);
+int decimalToInteger(char const *string, size_t length, int8_t *sign,
+                     uint64_t *magnitudeOut);
 /**
  * converts a hexadecimal integer to a sign and a magnitude
  *
  * @param string string to convert (from lexer - assumes string is good)
+ * @param length length of string
  * @param sign output pointer to sign
  * @param magnitudeOut output pointer to magnitude
  * @returns status code - 0 for OK, 1 for size error
  */
-int hexadecimalToInteger(char *string, int8_t *sign, uint64_t *magnitudeOut);
+int hexadecimalToInteger(char const *string, size_t length, int8_t *sign,
+                         uint64_t *magnitudeOut);
 
 /**
  * converts a float to a set of bits
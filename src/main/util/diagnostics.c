@@ -0,0 +1,52 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "util/diagnostics.h"
+
+#include <stdlib.h>
+
+#include "util/internalError.h"
+
+/** buffer stream for the current thread, or NULL if not buffering */
+static _Thread_local FILE *buffer = NULL;
+/** contents of buffer */
+static _Thread_local char *bufferContents = NULL;
+/** length of buffer */
+static _Thread_local size_t bufferLength = 0;
+
+FILE *diagnosticStream(void) { return buffer != NULL ? buffer : stderr; }
+
+void diagnosticsBufferStart(void) {
+  if (buffer != NULL)
+    error(__FILE__, __LINE__, "diagnostics already being buffered");
+  buffer = open_memstream(&bufferContents, &bufferLength);
+  if (buffer == NULL)
+    error(__FILE__, __LINE__, "could not create diagnostic buffer");
+}
+
+char *diagnosticsBufferEnd(void) {
+  if (buffer == NULL)
+    error(__FILE__, __LINE__, "diagnostics not being buffered");
+  fclose(buffer);
+  buffer = NULL;
+  char *contents = bufferContents;
+  bufferContents = NULL;
+  bufferLength = 0;
+  return contents;
+}
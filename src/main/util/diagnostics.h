@@ -0,0 +1,55 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/**
+ * @file
+ * per-thread diagnostic output, optionally buffered
+ */
+
+#ifndef TLC_UTIL_DIAGNOSTICS_H_
+#define TLC_UTIL_DIAGNOSTICS_H_
+
+#include <stdio.h>
+
+/**
+ * gets the stream that user-facing diagnostics (errors, warnings, notes)
+ * should be printed to
+ *
+ * this is stderr, unless the current thread is buffering diagnostics
+ *
+ * @returns stream to print diagnostics to
+ */
+FILE *diagnosticStream(void);
+
+/**
+ * starts buffering diagnostics printed by the current thread
+ *
+ * must not be called while already buffering
+ */
+void diagnosticsBufferStart(void);
+
+/**
+ * stops buffering diagnostics printed by the current thread
+ *
+ * @returns everything printed since the buffer was started (caller owns the
+ * memory)
+ */
+char *diagnosticsBufferEnd(void);
+
+#endif  // TLC_UTIL_DIAGNOSTICS_H_
@@ -19,6 +19,12 @@
 
 #include "util/hash.h"
 
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 uint64_t djb2xor(char const *s) {
   uint64_t hash = 5381;
   for (; *s != '\0'; ++s) {
@@ -35,4 +41,67 @@ uint64_t djb2add(char const *s) {
     hash += (uint64_t)*s;
   }
   return hash;
-}
\ No newline at end of file
+}
+
+/** odd constant with no obvious bit pattern */
+static uint64_t const HASH_MULTIPLIER = 0x9e3779b97f4a7c15;
+
+/**
+ * finalizer from MurmurHash3 - mixes every bit of the input into every bit of
+ * the output
+ */
+static uint64_t mix(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccd;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53;
+  x ^= x >> 33;
+  return x;
+}
+
+uint64_t stringHash(char const *data, size_t length) {
+  uint64_t hash = length * HASH_MULTIPLIER;
+  for (; length >= sizeof(uint64_t);
+       data += sizeof(uint64_t), length -= sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, data, sizeof(uint64_t));
+    hash = (hash ^ word) * HASH_MULTIPLIER;
+    hash ^= hash >> 29;
+  }
+  uint64_t word = 0;
+  memcpy(&word, data, length);
+  return mix(hash ^ word);
+}
+
+uint64_t fnv1a(char const *data, size_t length) {
+  uint64_t hash = 0xcbf29ce484222325;
+  for (size_t idx = 0; idx < length; ++idx) {
+    hash ^= (unsigned char)data[idx];
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+int fnv1aFile(char const *filename, uint64_t *hash) {
+  int fd = open(filename, O_RDONLY);
+  if (fd == -1) return -1;
+  struct stat statbuf;
+  if (fstat(fd, &statbuf) != 0) {
+    close(fd);
+    return -1;
+  }
+
+  size_t length = (size_t)statbuf.st_size;
+  if (length == 0) {
+    close(fd);
+    *hash = fnv1a(NULL, 0);
+    return 0;
+  }
+
+  char *map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == (void *)-1) return -1;
+  *hash = fnv1a(map, length);
+  munmap(map, length);
+  return 0;
+}
@@ -25,6 +25,7 @@
 #ifndef TLC_UTIL_HASH_H_
 #define TLC_UTIL_HASH_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 /**
@@ -43,4 +44,32 @@ uint64_t djb2xor(char const *s);
  */
 uint64_t djb2add(char const *s);
 
+/**
+ * hash a block of memory, eight bytes at a time; every bit of the result
+ * depends on every bit of the input
+ *
+ * @param data memory to hash
+ * @param length length of data
+ * @returns hash of the data
+ */
+uint64_t stringHash(char const *data, size_t length);
+
+/**
+ * hash a block of memory using 64 bit FNV-1a
+ *
+ * @param data memory to hash
+ * @param length length of data
+ * @returns FNV-1a hash of the data
+ */
+uint64_t fnv1a(char const *data, size_t length);
+
+/**
+ * hash the contents of a file using 64 bit FNV-1a
+ *
+ * @param filename name of file to hash
+ * @param hash output parameter for the hash
+ * @returns status code (0 = OK)
+ */
+int fnv1aFile(char const *filename, uint64_t *hash);
+
 #endif  // TLC_UTIL_HASH_H_
\ No newline at end of file
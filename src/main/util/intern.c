@@ -0,0 +1,128 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Implementation of identifier interning
+//
+// Interned strings are stored in an arena, each preceded by its hash. The
+// table is split into shards by hash, each with its own lock, so that files
+// being lexed in parallel rarely wait on each other.
+
+#include "util/intern.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/arena.h"
+#include "util/hash.h"
+
+/** log base 2 of the number of shards */
+#define SHARD_BITS 4
+/** number of shards */
+#define NUM_SHARDS (1 << SHARD_BITS)
+/** starting capacity of a shard; must be a power of two */
+#define SHARD_INIT_CAPACITY 256
+
+/** part of the interning table */
+typedef struct {
+  pthread_mutex_t lock;
+  size_t size;
+  size_t capacity;
+  char const **strings; /**< open addressed table of interned strings */
+  Arena *arena;         /**< storage for the strings */
+} Shard;
+
+static Shard shards[NUM_SHARDS];
+static pthread_once_t shardsInitialized = PTHREAD_ONCE_INIT;
+
+static void shardsInit(void) {
+  for (size_t idx = 0; idx < NUM_SHARDS; ++idx) {
+    pthread_mutex_init(&shards[idx].lock, NULL);
+    shards[idx].size = 0;
+    shards[idx].capacity = SHARD_INIT_CAPACITY;
+    shards[idx].strings = calloc(SHARD_INIT_CAPACITY, sizeof(char const *));
+    shards[idx].arena = arenaCreate();
+  }
+}
+
+uint64_t internHash(char const *s) {
+  uint64_t hash;
+  memcpy(&hash, s - sizeof(uint64_t), sizeof(uint64_t));
+  return hash;
+}
+
+/**
+ * inserts an interned string into a shard's table, which must have room
+ */
+static void shardInsert(Shard *shard, char const *s) {
+  size_t mask = shard->capacity - 1;
+  size_t idx = internHash(s) & mask;
+  while (shard->strings[idx] != NULL) idx = (idx + 1) & mask;
+  shard->strings[idx] = s;
+  ++shard->size;
+}
+
+/**
+ * doubles the capacity of a shard's table
+ */
+static void shardGrow(Shard *shard) {
+  size_t oldCapacity = shard->capacity;
+  char const **oldStrings = shard->strings;
+  shard->capacity *= 2;
+  shard->strings = calloc(shard->capacity, sizeof(char const *));
+  shard->size = 0;
+  for (size_t idx = 0; idx < oldCapacity; ++idx)
+    if (oldStrings[idx] != NULL) shardInsert(shard, oldStrings[idx]);
+  free(oldStrings);
+}
+
+char const *internRange(char const *start, size_t length) {
+  uint64_t hash = stringHash(start, length);
+  // low bits pick the slot, so use high bits to pick the shard
+  Shard *shard = &shards[hash >> (64 - SHARD_BITS)];
+
+  pthread_once(&shardsInitialized, shardsInit);
+  pthread_mutex_lock(&shard->lock);
+
+  size_t mask = shard->capacity - 1;
+  for (size_t idx = hash & mask; shard->strings[idx] != NULL;
+       idx = (idx + 1) & mask) {
+    char const *candidate = shard->strings[idx];
+    if (internHash(candidate) == hash &&
+        strncmp(candidate, start, length) == 0 && candidate[length] == '\0') {
+      pthread_mutex_unlock(&shard->lock);
+      return candidate;
+    }
+  }
+
+  // not found - add it
+  char *stored = arenaAlloc(shard->arena, sizeof(uint64_t) + length + 1);
+  memcpy(stored, &hash, sizeof(uint64_t));
+  stored += sizeof(uint64_t);
+  memcpy(stored, start, length);
+  stored[length] = '\0';
+
+  // keep the table at most half full
+  if (2 * (shard->size + 1) > shard->capacity) shardGrow(shard);
+  shardInsert(shard, stored);
+  pthread_mutex_unlock(&shard->lock);
+  return stored;
+}
+
+char const *internString(char const *s) { return internRange(s, strlen(s)); }
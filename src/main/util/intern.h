@@ -0,0 +1,61 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/**
+ * @file
+ * identifier interning
+ *
+ * Each distinct string is stored once, along with its hash, so interned
+ * strings can be compared by address and hashed without reading them.
+ */
+
+#ifndef TLC_UTIL_INTERN_H_
+#define TLC_UTIL_INTERN_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * interns a string; thread safe
+ *
+ * @param s string to intern
+ * @returns interned copy of s, valid until the end of the program
+ */
+char const *internString(char const *s);
+
+/**
+ * interns part of a string; thread safe
+ *
+ * @param start start of the string to intern
+ * @param length number of characters to intern
+ * @returns interned copy of the characters, valid until the end of the
+ * program
+ */
+char const *internRange(char const *start, size_t length);
+
+/**
+ * gets the hash of an interned string
+ *
+ * @param s interned string (must have been produced by internString or
+ * internRange)
+ * @returns hash of the string, equal to stringHash(s, strlen(s))
+ */
+uint64_t internHash(char const *s);
+
+#endif  // TLC_UTIL_INTERN_H_
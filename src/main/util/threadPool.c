@@ -0,0 +1,178 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Implementation of a simple fork-join thread pool
+
+#include "util/threadPool.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "util/diagnostics.h"
+#include "util/internalError.h"
+#include "util/timeReport.h"
+
+/** total number of threads, including the main thread */
+static size_t numThreads = 1;
+/** worker threads (numThreads - 1 of them) */
+static pthread_t *workers = NULL;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+/** signalled when a new batch is posted, or the pool is stopping */
+static pthread_cond_t workPosted = PTHREAD_COND_INITIALIZER;
+/** signalled when the last task of a batch is done */
+static pthread_cond_t workDone = PTHREAD_COND_INITIALIZER;
+/** incremented every time a batch is posted */
+static size_t generation = 0;
+/** set when the workers should exit */
+static bool stopping = false;
+
+/** the current batch of work - only changed while no tasks are running */
+static struct {
+  void (*fn)(size_t, void *);
+  void *data;
+  size_t const *files; /**< file each task is timed against, or NULL */
+  size_t count;
+  size_t next;        /**< next index to hand out */
+  size_t remaining;   /**< number of tasks not yet finished */
+  char **diagnostics; /**< buffered diagnostics from each task */
+} batch;
+
+/** is the current thread running a task */
+static _Thread_local bool inTask = false;
+
+/**
+ * runs one task, timing it as work on one file
+ */
+static void runTask(void (*fn)(size_t, void *), size_t idx, void *data,
+                    size_t const *files) {
+  inTask = true;
+  timeFileStart();
+  fn(idx, data);
+  timeFileEnd(files != NULL ? files[idx] : idx);
+  inTask = false;
+}
+
+/**
+ * runs tasks from the current batch until there are none left
+ *
+ * must be called with lock held, returns with lock held
+ */
+static void runTasks(void) {
+  while (batch.next < batch.count) {
+    size_t idx = batch.next++;
+    pthread_mutex_unlock(&lock);
+
+    diagnosticsBufferStart();
+    runTask(batch.fn, idx, batch.data, batch.files);
+    char *diagnostics = diagnosticsBufferEnd();
+
+    pthread_mutex_lock(&lock);
+    batch.diagnostics[idx] = diagnostics;
+    if (--batch.remaining == 0) pthread_cond_broadcast(&workDone);
+  }
+}
+
+static void *workerMain(void *ignored) {
+  (void)ignored;
+  size_t seen = 0;
+  pthread_mutex_lock(&lock);
+  while (true) {
+    while (!stopping && generation == seen)
+      pthread_cond_wait(&workPosted, &lock);
+    if (stopping) break;
+    seen = generation;
+    runTasks();
+  }
+  pthread_mutex_unlock(&lock);
+  return NULL;
+}
+
+void threadPoolInit(size_t threads) {
+  if (workers != NULL)
+    error(__FILE__, __LINE__, "thread pool initialized twice");
+  if (threads <= 1) return;
+
+  numThreads = threads;
+  stopping = false;
+  workers = malloc(sizeof(pthread_t) * (numThreads - 1));
+  for (size_t idx = 0; idx < numThreads - 1; ++idx) {
+    if (pthread_create(&workers[idx], NULL, workerMain, NULL) != 0)
+      error(__FILE__, __LINE__, "could not start worker thread");
+  }
+}
+
+void threadPoolRunFor(size_t count, size_t const *files,
+                      void (*fn)(size_t idx, void *data), void *data) {
+  if (inTask) {
+    // already in a task - run it here, as part of the current task
+    for (size_t idx = 0; idx < count; ++idx) fn(idx, data);
+    return;
+  } else if (numThreads <= 1 || count <= 1) {
+    // not worth handing off - run it here
+    for (size_t idx = 0; idx < count; ++idx) runTask(fn, idx, data, files);
+    return;
+  }
+
+  pthread_mutex_lock(&lock);
+  batch.fn = fn;
+  batch.data = data;
+  batch.files = files;
+  batch.count = count;
+  batch.next = 0;
+  batch.remaining = count;
+  batch.diagnostics = calloc(count, sizeof(char *));
+  ++generation;
+  pthread_cond_broadcast(&workPosted);
+
+  // help out, then wait for stragglers
+  runTasks();
+  while (batch.remaining != 0) pthread_cond_wait(&workDone, &lock);
+  char **diagnostics = batch.diagnostics;
+  batch.diagnostics = NULL;
+  pthread_mutex_unlock(&lock);
+
+  for (size_t idx = 0; idx < count; ++idx) {
+    fputs(diagnostics[idx], stderr);
+    free(diagnostics[idx]);
+  }
+  free(diagnostics);
+}
+
+void threadPoolRun(size_t count, void (*fn)(size_t idx, void *data),
+                   void *data) {
+  threadPoolRunFor(count, NULL, fn, data);
+}
+
+void threadPoolUninit(void) {
+  if (workers == NULL) return;
+
+  pthread_mutex_lock(&lock);
+  stopping = true;
+  pthread_cond_broadcast(&workPosted);
+  pthread_mutex_unlock(&lock);
+
+  for (size_t idx = 0; idx < numThreads - 1; ++idx)
+    pthread_join(workers[idx], NULL);
+  free(workers);
+  workers = NULL;
+  numThreads = 1;
+}
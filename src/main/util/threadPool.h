@@ -0,0 +1,80 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/**
+ * @file
+ * global pool of worker threads for running per-file work concurrently
+ */
+
+#ifndef TLC_UTIL_THREADPOOL_H_
+#define TLC_UTIL_THREADPOOL_H_
+
+#include <stddef.h>
+
+/**
+ * starts the global thread pool
+ *
+ * if never called, all work is done on the calling thread
+ *
+ * @param numThreads total number of threads to use, including the calling
+ * thread - one means run everything on the calling thread
+ */
+void threadPoolInit(size_t numThreads);
+
+/**
+ * calls fn(idx, data) for each idx in [0, count), possibly concurrently, and
+ * waits for all calls to finish
+ *
+ * diagnostics printed to diagnosticStream() by each call are buffered and
+ * printed to stderr in order of idx once all calls are done, so output is the
+ * same as if the calls had been made one after another. If called from within
+ * a task, the calls are made one after another on the current thread
+ *
+ * outside of a task, each call is timed as work on file idx for the time
+ * report, so idx should be an index into the global file list
+ *
+ * @param count number of calls to make
+ * @param fn function to call
+ * @param data extra argument to pass to fn
+ */
+void threadPoolRun(size_t count, void (*fn)(size_t idx, void *data),
+                   void *data);
+
+/**
+ * calls fn(idx, data) for each idx in [0, count), possibly concurrently, and
+ * waits for all calls to finish, timing call idx as work on file files[idx]
+ *
+ * for work finer-grained than a file (e.g. one function each), with the same
+ * buffering of diagnostics as threadPoolRun. Calls are handed out in order of
+ * idx to whichever thread is free, so a few large calls don't hold up the rest
+ *
+ * @param count number of calls to make
+ * @param files index into the global file list of each call's file
+ * @param fn function to call
+ * @param data extra argument to pass to fn
+ */
+void threadPoolRunFor(size_t count, size_t const *files,
+                      void (*fn)(size_t idx, void *data), void *data);
+
+/**
+ * stops and joins all the threads in the global thread pool
+ */
+void threadPoolUninit(void);
+
+#endif  // TLC_UTIL_THREADPOOL_H_
@@ -0,0 +1,323 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "util/timeReport.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "fileList.h"
+#include "util/container/vector.h"
+#include "util/internalError.h"
+
+/** timings for one phase */
+typedef struct {
+  char const *name;   /**< name of the phase, non-owning */
+  uint64_t wall;      /**< wall time, in nanoseconds */
+  uint64_t cpu;       /**< cpu time, summed over all threads, in nanoseconds */
+  long rssDelta;      /**< increase in peak resident set size, in KiB */
+  uint64_t *fileWall; /**< wall time for each file, in nanoseconds */
+  uint64_t *fileCpu;  /**< cpu time for each file, in nanoseconds */
+  bool *fileTimed;    /**< was any work done for each file */
+} Phase;
+
+/** one slice of work, for the trace file */
+typedef struct {
+  char const *name; /**< name of the phase, non-owning */
+  size_t file;      /**< index of file, or SIZE_MAX if a whole phase */
+  size_t thread;    /**< which thread did the work */
+  uint64_t start;   /**< start time, in nanoseconds since init */
+  uint64_t length;  /**< duration, in nanoseconds */
+} TraceEvent;
+
+static bool enabled = false;
+/** time at which timeReportInit was called */
+static uint64_t epoch;
+/** Vector of Phase, in order of start time */
+static Vector phases;
+/** phase currently being timed, or NULL if none */
+static Phase *current = NULL;
+static uint64_t phaseWallStart;
+static uint64_t phaseCpuStart;
+static long phaseRssStart;
+
+/** protects events and nextThread */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+/** Vector of TraceEvent */
+static Vector events;
+static size_t nextThread = 0;
+static _Thread_local size_t thread = SIZE_MAX;
+static _Thread_local uint64_t fileWallStart;
+static _Thread_local uint64_t fileCpuStart;
+
+/**
+ * reads a clock
+ *
+ * @param clock clock to read
+ * @returns time in nanoseconds
+ */
+static uint64_t now(clockid_t clock) {
+  struct timespec t;
+  clock_gettime(clock, &t);
+  return (uint64_t)t.tv_sec * 1000000000 + (uint64_t)t.tv_nsec;
+}
+
+/**
+ * @returns peak resident set size so far, in KiB
+ */
+static long peakRss(void) {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+/**
+ * records a trace event
+ *
+ * must be called with lock held
+ */
+static void addEvent(char const *name, size_t file, uint64_t start,
+                     uint64_t end) {
+  if (thread == SIZE_MAX) thread = nextThread++;
+
+  TraceEvent *event = malloc(sizeof(TraceEvent));
+  event->name = name;
+  event->file = file;
+  event->thread = thread;
+  event->start = start - epoch;
+  event->length = end - start;
+  vectorInsert(&events, event);
+}
+
+void timeReportInit(void) {
+  enabled = true;
+  epoch = now(CLOCK_MONOTONIC);
+  vectorInit(&phases);
+  vectorInit(&events);
+  // the calling thread is always thread zero
+  thread = nextThread++;
+}
+
+void timePhaseStart(char const *name) {
+  if (!enabled) return;
+  if (current != NULL) error(__FILE__, __LINE__, "phases may not be nested");
+
+  current = malloc(sizeof(Phase));
+  current->name = name;
+  current->fileWall = calloc(fileList.size, sizeof(uint64_t));
+  current->fileCpu = calloc(fileList.size, sizeof(uint64_t));
+  current->fileTimed = calloc(fileList.size, sizeof(bool));
+  vectorInsert(&phases, current);
+
+  phaseRssStart = peakRss();
+  phaseCpuStart = now(CLOCK_PROCESS_CPUTIME_ID);
+  phaseWallStart = now(CLOCK_MONOTONIC);
+}
+
+void timePhaseEnd(void) {
+  if (!enabled) return;
+  if (current == NULL) error(__FILE__, __LINE__, "no phase to end");
+
+  uint64_t wallEnd = now(CLOCK_MONOTONIC);
+  current->wall = wallEnd - phaseWallStart;
+  current->cpu = now(CLOCK_PROCESS_CPUTIME_ID) - phaseCpuStart;
+  current->rssDelta = peakRss() - phaseRssStart;
+
+  pthread_mutex_lock(&lock);
+  addEvent(current->name, SIZE_MAX, phaseWallStart, wallEnd);
+  pthread_mutex_unlock(&lock);
+
+  current = NULL;
+}
+
+void timeFileStart(void) {
+  if (!enabled || current == NULL) return;
+
+  fileCpuStart = now(CLOCK_THREAD_CPUTIME_ID);
+  fileWallStart = now(CLOCK_MONOTONIC);
+}
+
+void timeFileEnd(size_t fileIdx) {
+  if (!enabled || current == NULL) return;
+
+  uint64_t wallEnd = now(CLOCK_MONOTONIC);
+  uint64_t cpu = now(CLOCK_THREAD_CPUTIME_ID) - fileCpuStart;
+
+  // parts of one file may be worked on by several threads at once
+  pthread_mutex_lock(&lock);
+  current->fileWall[fileIdx] += wallEnd - fileWallStart;
+  current->fileCpu[fileIdx] += cpu;
+  current->fileTimed[fileIdx] = true;
+  addEvent(current->name, fileIdx, fileWallStart, wallEnd);
+  pthread_mutex_unlock(&lock);
+}
+
+/** width of the phase name column */
+#define NAME_WIDTH 48
+
+/**
+ * formats a duration as milliseconds
+ *
+ * @param out stream to print to
+ * @param ns duration, in nanoseconds
+ */
+static void printMillis(FILE *out, uint64_t ns) {
+  fprintf(out, " %8" PRIu64 ".%03" PRIu64, ns / 1000000, ns / 1000 % 1000);
+}
+
+void timeReportPrint(FILE *out) {
+  if (!enabled) return;
+
+  for (size_t fileIdx = 0; fileIdx < fileList.size; ++fileIdx) {
+    bool timed = false;
+    for (size_t phaseIdx = 0; phaseIdx < phases.size; ++phaseIdx) {
+      Phase *phase = phases.elements[phaseIdx];
+      timed = timed || phase->fileTimed[fileIdx];
+    }
+    if (!timed) continue;
+
+    fprintf(out, "time report for %s:\n",
+            fileList.entries[fileIdx].inputFilename);
+    fprintf(out, "  %-*s %12s %12s\n", NAME_WIDTH, "phase", "wall (ms)",
+            "cpu (ms)");
+    uint64_t totalWall = 0;
+    uint64_t totalCpu = 0;
+    for (size_t phaseIdx = 0; phaseIdx < phases.size; ++phaseIdx) {
+      Phase *phase = phases.elements[phaseIdx];
+      if (!phase->fileTimed[fileIdx]) continue;
+
+      fprintf(out, "  %-*s", NAME_WIDTH, phase->name);
+      printMillis(out, phase->fileWall[fileIdx]);
+      printMillis(out, phase->fileCpu[fileIdx]);
+      fprintf(out, "\n");
+      totalWall += phase->fileWall[fileIdx];
+      totalCpu += phase->fileCpu[fileIdx];
+    }
+    fprintf(out, "  %-*s", NAME_WIDTH, "total");
+    printMillis(out, totalWall);
+    printMillis(out, totalCpu);
+    fprintf(out, "\n");
+  }
+
+  fprintf(out, "time report totals:\n");
+  fprintf(out, "  %-*s %12s %12s %22s\n", NAME_WIDTH, "phase", "wall (ms)",
+          "cpu (ms)", "peak rss delta (KiB)");
+  uint64_t totalWall = 0;
+  uint64_t totalCpu = 0;
+  long totalRss = 0;
+  for (size_t phaseIdx = 0; phaseIdx < phases.size; ++phaseIdx) {
+    Phase *phase = phases.elements[phaseIdx];
+    fprintf(out, "  %-*s", NAME_WIDTH, phase->name);
+    printMillis(out, phase->wall);
+    printMillis(out, phase->cpu);
+    fprintf(out, " %22ld\n", phase->rssDelta);
+    totalWall += phase->wall;
+    totalCpu += phase->cpu;
+    totalRss += phase->rssDelta;
+  }
+  fprintf(out, "  %-*s", NAME_WIDTH, "total");
+  printMillis(out, totalWall);
+  printMillis(out, totalCpu);
+  fprintf(out, " %22ld\n", totalRss);
+  fprintf(out, "peak rss: %ld KiB\n", peakRss());
+}
+
+/**
+ * prints a string as a JSON string literal
+ *
+ * @param out stream to print to
+ * @param s string to print
+ */
+static void printJsonString(FILE *out, char const *s) {
+  fputc('"', out);
+  for (; *s != '\0'; ++s) {
+    unsigned char c = (unsigned char)*s;
+    if (c == '"' || c == '\\')
+      fprintf(out, "\\%c", c);
+    else if (c < ' ')
+      fprintf(out, "\\u%04x", c);
+    else
+      fputc(c, out);
+  }
+  fputc('"', out);
+}
+
+/**
+ * prints a duration as microseconds, the unit used by the trace format
+ *
+ * @param out stream to print to
+ * @param ns duration, in nanoseconds
+ */
+static void printMicros(FILE *out, uint64_t ns) {
+  fprintf(out, "%" PRIu64 ".%03" PRIu64, ns / 1000, ns % 1000);
+}
+
+int timeReportWriteTrace(char const *filename) {
+  if (!enabled) return 0;
+
+  FILE *out = fopen(filename, "w");
+  if (out == NULL) return -1;
+
+  fprintf(out, "{\"traceEvents\":[\n");
+  for (size_t idx = 0; idx < events.size; ++idx) {
+    TraceEvent *event = events.elements[idx];
+    fprintf(out, "{\"name\":");
+    printJsonString(out, event->name);
+    fprintf(out, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":",
+            event->file == SIZE_MAX ? "phase" : "file");
+    printMicros(out, event->start);
+    fprintf(out, ",\"dur\":");
+    printMicros(out, event->length);
+    fprintf(out, ",\"pid\":1,\"tid\":%zu", event->thread);
+    if (event->file != SIZE_MAX) {
+      fprintf(out, ",\"args\":{\"file\":");
+      printJsonString(out, fileList.entries[event->file].inputFilename);
+      fprintf(out, "}");
+    }
+    fprintf(out, "}%s\n", idx + 1 == events.size ? "" : ",");
+  }
+  fprintf(out, "],\"displayTimeUnit\":\"ms\"}\n");
+
+  return fclose(out) == 0 ? 0 : -1;
+}
+
+/**
+ * deinitializes and frees a phase
+ *
+ * @param phase phase to free
+ */
+static void phaseFree(Phase *phase) {
+  free(phase->fileWall);
+  free(phase->fileCpu);
+  free(phase->fileTimed);
+  free(phase);
+}
+
+void timeReportUninit(void) {
+  if (!enabled) return;
+
+  vectorUninit(&phases, (void (*)(void *))phaseFree);
+  vectorUninit(&events, free);
+  enabled = false;
+}
@@ -0,0 +1,88 @@
+// Copyright 2021 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/**
+ * @file
+ * per-phase timing and memory usage reporting (--time-report, --time-trace)
+ */
+
+#ifndef TLC_UTIL_TIMEREPORT_H_
+#define TLC_UTIL_TIMEREPORT_H_
+
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * starts recording timings
+ *
+ * if never called, all other time report functions do nothing. Must be called
+ * after the file list is filled in
+ */
+void timeReportInit(void);
+
+/**
+ * starts timing a phase of compilation
+ *
+ * phases may not be nested
+ *
+ * @param name name of the phase, not owned
+ */
+void timePhaseStart(char const *name);
+
+/**
+ * finishes timing the current phase
+ */
+void timePhaseEnd(void);
+
+/**
+ * starts timing the current phase's work on one file
+ *
+ * may be called from any thread, but each thread may only time one file at
+ * a time
+ */
+void timeFileStart(void);
+
+/**
+ * finishes timing the current phase's work on one file
+ *
+ * @param fileIdx index into the global file list of the file worked on
+ */
+void timeFileEnd(size_t fileIdx);
+
+/**
+ * prints per-file and total timings as tables
+ *
+ * @param out stream to print to
+ */
+void timeReportPrint(FILE *out);
+
+/**
+ * writes all timings as a Chrome trace event format JSON file
+ *
+ * @param filename name of file to write to
+ * @returns status code (0 = OK)
+ */
+int timeReportWriteTrace(char const *filename);
+
+/**
+ * stops recording timings and frees the recorded timings
+ */
+void timeReportUninit(void);
+
+#endif  // TLC_UTIL_TIMEREPORT_H_
@@ -44,6 +44,9 @@ int main(int argc, char *argv[]) {
     testBigInteger();
   if (argc <= 1 || containsString((size_t)argc, argv, "conversions"))
     testConversions();
+  if (argc <= 1 || containsString((size_t)argc, argv, "arena")) testArena();
+  if (argc <= 1 || containsString((size_t)argc, argv, "dataflow"))
+    testDataflow();
 
   if (argc <= 1 || containsString((size_t)argc, argv, "commandLineArgs"))
     testCommandLineArgs();
@@ -59,6 +62,9 @@ int main(int argc, char *argv[]) {
     testTraceScheduling();
   if (argc <= 1 || containsString((size_t)argc, argv, "scheduledOptimization"))
     testScheduledOptimization();
+  if (argc <= 1 || containsString((size_t)argc, argv, "server")) testServer();
+  if (argc <= 1 || containsString((size_t)argc, argv, "streaming"))
+    testStreaming();
 
   return testStatusStatus();
 }
\ No newline at end of file
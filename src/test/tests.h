@@ -29,6 +29,10 @@
 void testBigInteger(void);
 /** tests numeric conversions */
 void testConversions(void);
+/** tests the arena allocator */
+void testArena(void);
+/** tests bit sets and dataflow analyses */
+void testDataflow(void);
 /** tests command line argument parsing */
 void testCommandLineArgs(void);
 /** tests lexing */
@@ -45,5 +49,9 @@ void testBlockedOptimization(void);
 void testTraceScheduling(void);
 /** tests optimzation after scheduling */
 void testScheduledOptimization(void);
+/** tests the compile server and client */
+void testServer(void);
+/** tests streaming compilation */
+void testStreaming(void);
 
 #endif  // TLC_TEST_TESTS_H_
\ No newline at end of file
@@ -0,0 +1,150 @@
+// Copyright 2022 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+/**
+ * @file
+ * tests for the arena allocator
+ */
+
+#include "util/arena.h"
+
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "engine.h"
+#include "tests.h"
+
+static void testArenaAlignment(void) {
+  Arena *arena = arenaCreate();
+  bool aligned = true;
+  bool separate = true;
+  unsigned char *previous = NULL;
+  size_t previousSize = 0;
+  for (size_t size = 1; size <= 100; ++size) {
+    unsigned char *allocated = arenaAlloc(arena, size);
+    if ((uintptr_t)allocated % alignof(max_align_t) != 0) aligned = false;
+    memset(allocated, (int)size, size);
+    if (previous != NULL &&
+        (previous[0] != (unsigned char)previousSize ||
+         previous[previousSize - 1] != (unsigned char)previousSize))
+      separate = false;
+    previous = allocated;
+    previousSize = size;
+  }
+  test("arena allocations are aligned for any type", aligned);
+  test("arena allocations don't overlap", separate);
+  arenaFree(arena);
+}
+
+static void testArenaLargeAllocations(void) {
+  Arena *arena = arenaCreate();
+  char *before = arenaAlloc(arena, 16);
+  size_t largeSize = (size_t)1024 * 1024;
+  char *large = arenaAlloc(arena, largeSize);
+  memset(large, 'x', largeSize);
+  char *after = arenaAlloc(arena, 16);
+  test("large arena allocation is usable",
+       large[0] == 'x' && large[largeSize - 1] == 'x');
+  test("large arena allocation is aligned",
+       (uintptr_t)large % alignof(max_align_t) == 0);
+  test("small allocations continue around a large allocation",
+       after == before + 16);
+
+  // larger than the first chunk, but not big enough for its own chunk
+  size_t mediumSize = (size_t)8 * 1024;
+  char *medium = arenaAlloc(arena, mediumSize);
+  memset(medium, 'y', mediumSize);
+  test("allocation larger than a chunk is usable",
+       medium[0] == 'y' && medium[mediumSize - 1] == 'y' &&
+           large[largeSize - 1] == 'x');
+  arenaFree(arena);
+
+  arena = arenaCreate();
+  large = arenaAlloc(arena, largeSize);
+  memset(large, 'z', largeSize);
+  char *small = arenaAlloc(arena, 16);
+  test("large allocation in an empty arena is usable",
+       large[largeSize - 1] == 'z' && small != NULL);
+  arenaFree(arena);
+}
+
+static void testArenaReset(void) {
+  Arena *arena = arenaCreate();
+  char *first = arenaAlloc(arena, 32);
+  arenaAlloc(arena, (size_t)1024 * 1024);
+  arenaAlloc(arena, 64);
+  arenaReset(arena);
+  test("reset arena reuses its current chunk", arenaAlloc(arena, 32) == first);
+  test("reset arena allocates after its reused memory",
+       arenaAlloc(arena, 32) == first + 32);
+  arenaFree(arena);
+
+  arena = arenaCreate();
+  arenaAlloc(arena, (size_t)1024 * 1024);
+  arenaReset(arena);
+  char *reused = arenaAlloc(arena, 32);
+  test("arena with only large allocations can be reset and reused",
+       reused != NULL);
+  arenaFree(arena);
+}
+
+/** a cleanup that appends its tag to a shared log */
+typedef struct {
+  char *log;
+  char tag;
+} Tagged;
+static void taggedCleanup(void *data) {
+  Tagged *tagged = data;
+  tagged->log[strlen(tagged->log)] = tagged->tag;
+}
+
+static void testArenaCleanups(void) {
+  char log[8] = {0};
+  Tagged a = {log, 'a'};
+  Tagged b = {log, 'b'};
+  Tagged c = {log, 'c'};
+
+  Arena *arena = arenaCreate();
+  arenaAddCleanup(arena, taggedCleanup, &a);
+  arenaAddCleanup(arena, taggedCleanup, &b);
+  arenaReset(arena);
+  test("reset runs cleanups, most recent first", strcmp(log, "ba") == 0);
+  arenaReset(arena);
+  test("reset forgets cleanups once they've run", strcmp(log, "ba") == 0);
+
+  memset(log, 0, sizeof(log));
+  Arena *other = arenaCreate();
+  arenaAddCleanup(arena, taggedCleanup, &a);
+  arenaAddCleanup(other, taggedCleanup, &b);
+  arenaAddCleanup(other, taggedCleanup, &c);
+  arenaMerge(arena, other);
+  arenaFree(arena);
+  test("merged arena runs both arenas' cleanups when freed",
+       strcmp(log, "cba") == 0);
+}
+
+void testArena(void) {
+  testArenaAlignment();
+  testArenaLargeAllocations();
+  testArenaReset();
+  testArenaCleanups();
+}
@@ -31,6 +31,7 @@
 #include "fileList.h"
 #include "ir/dump.h"
 #include "ir/ir.h"
+#include "ir/shorthand.h"
 #include "optimization/optimization.h"
 #include "options.h"
 #include "parser/parser.h"
@@ -40,9 +41,77 @@
 #include "util/dump.h"
 #include "util/filesystem.h"
 
+/** labels and temps in the phi validation tests */
+enum {
+  ENTRY_LABEL = 1,
+  THEN_LABEL,
+  ELSE_LABEL,
+  MERGE_LABEL,
+  CONDITION_TEMP,
+  RESULT_TEMP,
+  NUM_IDS,
+};
+
+static IROperand *intTemp(size_t name) { return TEMP(name, 4, 4, AH_GP); }
+static IROperand *intConstant(uint32_t value) {
+  return CONSTANT(4, intDatumCreate(value));
+}
+
+/**
+ * validates a diamond whose merge block has a phi choosing from the given
+ * labels
+ *
+ * @returns result of validateBlockedIr
+ */
+static int validatePhiFrom(size_t firstLabel, size_t secondLabel) {
+  FileListEntry entries[1];
+  fileList.entries = &entries[0];
+  fileList.size = 1;
+  fileListEntryInit(&entries[0], "phi.tc", true);
+  entries[0].nextId = NUM_IDS;
+
+  IRFrag *frag = textFragCreate(format("phi"));
+  vectorInsert(&entries[0].irFrags, frag);
+  irArenaSet(frag->data.text.arena);
+  LinkedList *blocks = &frag->data.text.blocks;
+  IRBlock *b = BLOCK(ENTRY_LABEL, blocks);
+  IR(b, MOVE(intTemp(CONDITION_TEMP), intConstant(1)));
+  IR(b, CJUMP(IO_J2L, THEN_LABEL, ELSE_LABEL, intTemp(CONDITION_TEMP),
+              intConstant(2)));
+  b = BLOCK(THEN_LABEL, blocks);
+  IR(b, JUMP(MERGE_LABEL));
+  b = BLOCK(ELSE_LABEL, blocks);
+  IR(b, JUMP(MERGE_LABEL));
+  b = BLOCK(MERGE_LABEL, blocks);
+  IRInstruction *phi = irPhiCreate(2);
+  phi->args[0] = intTemp(RESULT_TEMP);
+  phi->args[1] = LOCAL(firstLabel);
+  phi->args[2] = intConstant(3);
+  phi->args[3] = LOCAL(secondLabel);
+  phi->args[4] = intConstant(4);
+  IR(b, phi);
+  IR(b, RETURN());
+  irArenaSet(NULL);
+
+  int retval = validateBlockedIr("phi validation test");
+  irFragVectorUninit(&entries[0].irFrags);
+  return retval;
+}
+
+static void testPhiValidation(void) {
+  test("phi choosing from each predecessor is valid",
+       validatePhiFrom(THEN_LABEL, ELSE_LABEL) == 0);
+  test("phi choosing from a block that isn't a predecessor is invalid",
+       validatePhiFrom(ENTRY_LABEL, ELSE_LABEL) != 0);
+  test("phi choosing from a predecessor twice is invalid",
+       validatePhiFrom(THEN_LABEL, THEN_LABEL) != 0);
+}
+
 void testBlockedOptimization(void) {
   Options original;
   memcpy(&original, &options, sizeof(Options));
+  // also check the IR between the steps of each optimization
+  options.debugValidateIr = true;
 
   DIR *archs = opendir("testFiles/translation");
   assert("couldn't open arch dir" && archs != NULL);
@@ -98,6 +167,9 @@ void testBlockedOptimization(void) {
              validateBlockedIr("translation") == 0);
 
       optimizeBlockedIr();
+      testDynamic(format("optimizing %s keeps its ir valid at every step",
+                         entries[0].inputFilename),
+                  !entries[0].errored);
 
       char *expectedName =
           format("testFiles/translation/%s/expectedBlockedOptimized/%s",
@@ -126,5 +198,8 @@ void testBlockedOptimization(void) {
   }
   closedir(archs);
 
+  options.arch = OPTION_A_X86_64_LINUX;
+  testPhiValidation();
+
   memcpy(&options, &original, sizeof(Options));
 }
\ No newline at end of file
@@ -339,6 +339,243 @@ static void testOptions(void) {
        retval == 0);
   test("debug-dump ir option is correctly set",
        options.dump == OPTION_DD_SCHEDULED_OPTIMIZATION);
+
+  // -j N
+  argc = 4;
+  char const *const argv20[] = {
+      "./tlc",
+      "-j",
+      "4",
+      "foo.tc",
+  };
+  retval = parseArgs(argc, argv20, &numFiles);
+
+  test("command line with -j 4 passes", retval == 0);
+  test("jobs option is correctly set", options.jobs == 4);
+  test("number of files with -j 4 is correct", numFiles == 1);
+
+  // -jN
+  argc = 3;
+  char const *const argv21[] = {
+      "./tlc",
+      "-j2",
+      "foo.tc",
+  };
+  retval = parseArgs(argc, argv21, &numFiles);
+
+  test("command line with -j2 passes", retval == 0);
+  test("jobs option is correctly set", options.jobs == 2);
+
+  // -j without a number
+  argc = 2;
+  char const *const argv22[] = {
+      "./tlc",
+      "-j",
+  };
+  retval = parseArgs(argc, argv22, &numFiles);
+  test("command line with -j and no number fails", retval != 0);
+
+  // -j0
+  argc = 3;
+  char const *const argv23[] = {
+      "./tlc",
+      "-j0",
+      "foo.tc",
+  };
+  retval = parseArgs(argc, argv23, &numFiles);
+  test("command line with -j0 fails", retval != 0);
+
+  // -j with a non-number
+  argc = 4;
+  char const *const argv24[] = {
+      "./tlc",
+      "-j",
+      "x",
+      "foo.tc",
+  };
+  retval = parseArgs(argc, argv24, &numFiles);
+  test("command line with -j x fails", retval != 0);
+
+  // --time-report
+  argc = 3;
+  char const *const argv25[] = {
+      "./tlc",
+      "--time-report",
+      "foo.tc",
+  };
+  retval = parseArgs(argc, argv25, &numFiles);
+
+  test("command line with time-report passes", retval == 0);
+  test("time-report option is correctly set", options.timeReport == true);
+
+  // --time-trace=...
+  argc = 3;
+  char const *const argv26[] = {
+      "./tlc",
+      "--time-trace=trace.json",
+      "foo.tc",
+  };
+  retval = parseArgs(argc, argv26, &numFiles);
+
+  test("command line with time-trace passes", retval == 0);
+  test("time-trace option is correctly set",
+       options.timeTraceFile != NULL &&
+           strcmp(options.timeTraceFile, "trace.json") == 0);
+
+  argc = 3;
+  char const *const argv27[] = {
+      "./tlc",
+      "--time-trace=",
+      "foo.tc",
+  };
+  retval = parseArgs(argc, argv27, &numFiles);
+  test("command line with empty time-trace fails", retval != 0);
+
+  // --emit-tdi, --use-tdi
+  argc = 4;
+  char const *const argv28[] = {
+      "./tlc",
+      "--emit-tdi",
+      "--no-use-tdi",
+      "foo.td",
+  };
+  retval = parseArgs(argc, argv28, &numFiles);
+
+  test("command line with emit-tdi and no-use-tdi passes", retval == 0);
+  test("emit-tdi option is correctly set", options.emitTdi == true);
+  test("use-tdi option is correctly set", options.useTdi == false);
+
+  argc = 4;
+  char const *const argv29[] = {
+      "./tlc",
+      "--no-emit-tdi",
+      "--use-tdi",
+      "foo.td",
+  };
+  retval = parseArgs(argc, argv29, &numFiles);
+
+  test("command line with no-emit-tdi and use-tdi passes", retval == 0);
+  test("no-emit-tdi option is correctly set", options.emitTdi == false);
+  test("use-tdi option is correctly set", options.useTdi == true);
+
+  // -MD, -MF, --incremental
+  argc = 3;
+  char const *const argv30[] = {
+      "./tlc",
+      "-MD",
+      "foo.tc",
+  };
+  retval = parseArgs(argc, argv30, &numFiles);
+
+  test("command line with -MD passes", retval == 0);
+  test("-MD option is correctly set", options.dependencyFile == true);
+  test("-MD option doesn't set a file name",
+       options.dependencyFileName == NULL);
+
+  options.dependencyFile = false;
+  argc = 4;
+  char const *const argv31[] = {
+      "./tlc",
+      "-MF",
+      "deps.mk",
+      "foo.tc",
+  };
+  retval = parseArgs(argc, argv31, &numFiles);
+
+  test("command line with -MF passes", retval == 0);
+  test("-MF option doesn't turn on -MD", options.dependencyFile == false);
+  test("-MF file name is correctly set",
+       strcmp(options.dependencyFileName, "deps.mk") == 0);
+  test("-MF file name isn't counted as a file", numFiles == 1);
+
+  argc = 3;
+  char const *const argv32[] = {
+      "./tlc",
+      "-MFdeps.d",
+      "foo.tc",
+  };
+  retval = parseArgs(argc, argv32, &numFiles);
+
+  test("command line with attached -MF passes", retval == 0);
+  test("attached -MF file name is correctly set",
+       strcmp(options.dependencyFileName, "deps.d") == 0);
+
+  argc = 3;
+  char const *const argv33[] = {
+      "./tlc",
+      "foo.tc",
+      "-MF",
+  };
+  retval = parseArgs(argc, argv33, &numFiles);
+  test("command line with -MF missing its file fails", retval != 0);
+
+  argc = 3;
+  char const *const argv34[] = {
+      "./tlc",
+      "--incremental=build",
+      "foo.tc",
+  };
+  retval = parseArgs(argc, argv34, &numFiles);
+
+  test("command line with incremental passes", retval == 0);
+  test("incremental directory is correctly set",
+       strcmp(options.incrementalDir, "build") == 0);
+
+  argc = 3;
+  char const *const argv35[] = {
+      "./tlc",
+      "--incremental=",
+      "foo.tc",
+  };
+  retval = parseArgs(argc, argv35, &numFiles);
+  test("command line with empty incremental fails", retval != 0);
+
+  // --stream
+  argc = 3;
+  char const *const argv36[] = {
+      "./tlc",
+      "--stream",
+      "foo.tc",
+  };
+  retval = parseArgs(argc, argv36, &numFiles);
+
+  test("command line with stream passes", retval == 0);
+  test("stream option is correctly set", options.stream == true);
+
+  argc = 3;
+  char const *const argv37[] = {
+      "./tlc",
+      "--no-stream",
+      "foo.tc",
+  };
+  retval = parseArgs(argc, argv37, &numFiles);
+
+  test("command line with no-stream passes", retval == 0);
+  test("no-stream option is correctly set", options.stream == false);
+
+  // --pretokenize
+  argc = 3;
+  char const *const argv38[] = {
+      "./tlc",
+      "--pretokenize",
+      "foo.tc",
+  };
+  retval = parseArgs(argc, argv38, &numFiles);
+
+  test("command line with pretokenize passes", retval == 0);
+  test("pretokenize option is correctly set", options.pretokenize == true);
+
+  argc = 3;
+  char const *const argv39[] = {
+      "./tlc",
+      "--no-pretokenize",
+      "foo.tc",
+  };
+  retval = parseArgs(argc, argv39, &numFiles);
+
+  test("command line with no-pretokenize passes", retval == 0);
+  test("no-pretokenize option is correctly set",
+       options.pretokenize == false);
 }
 
 void testCommandLineArgs(void) {
@@ -0,0 +1,202 @@
+// Copyright 2022 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/**
+ * @file
+ * tests for bit sets and dataflow analyses
+ */
+
+#include "ir/dataflow.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "engine.h"
+#include "ir/shorthand.h"
+#include "tests.h"
+#include "util/container/bitSet.h"
+#include "util/format.h"
+
+static void testBitSetOps(void) {
+  size_t size = 130;  // more than two words, with a partial last word
+  test("bit set words round up", bitSetWords(size) == 3 &&
+                                     bitSetWords(128) == 2 &&
+                                     bitSetWords(0) == 0);
+
+  uint64_t *a = bitSetCreate(size);
+  uint64_t *b = bitSetCreate(size);
+  uint64_t *empty = bitSetCreate(size);
+  test("new bit set is empty", !bitSetContains(a, 0) &&
+                                   !bitSetContains(a, 129) &&
+                                   bitSetEqual(a, empty, size));
+
+  bitSetAdd(a, 0);
+  bitSetAdd(a, 63);
+  bitSetAdd(a, 64);
+  bitSetAdd(a, 129);
+  test("added bits are in the set",
+       bitSetContains(a, 0) && bitSetContains(a, 63) &&
+           bitSetContains(a, 64) && bitSetContains(a, 129));
+  test("other bits aren't in the set",
+       !bitSetContains(a, 1) && !bitSetContains(a, 62) &&
+           !bitSetContains(a, 65) && !bitSetContains(a, 128));
+  bitSetRemove(a, 63);
+  test("removed bit isn't in the set",
+       !bitSetContains(a, 63) && bitSetContains(a, 64));
+
+  bitSetCopy(b, a, size);
+  test("copied set is equal", bitSetEqual(a, b, size));
+  test("union with a subset doesn't change the set",
+       !bitSetUnion(a, b, size) && bitSetEqual(a, b, size));
+  bitSetClear(b, size);
+  bitSetAdd(b, 100);
+  test("union with new bits changes the set",
+       bitSetUnion(a, b, size) && bitSetContains(a, 100) &&
+           bitSetContains(a, 129));
+  test("intersection with a superset doesn't change the set",
+       !bitSetIntersect(b, a, size) && bitSetContains(b, 100));
+  test("intersection removes bits not in both sets",
+       bitSetIntersect(a, b, size) && bitSetContains(a, 100) &&
+           !bitSetContains(a, 0) && !bitSetContains(a, 129));
+
+  bitSetFill(a, size);
+  test("filled set contains every bit",
+       bitSetContains(a, 0) && bitSetContains(a, 129));
+  test("filled set has no bits past the end", (a[2] >> 2) == 0);
+  bitSetClear(a, size);
+  test("cleared set is empty", bitSetEqual(a, empty, size));
+
+  // dst = gen | (src & ~kill)
+  uint64_t *gen = bitSetCreate(size);
+  uint64_t *src = bitSetCreate(size);
+  uint64_t *kill = bitSetCreate(size);
+  bitSetAdd(gen, 1);
+  bitSetAdd(src, 2);
+  bitSetAdd(src, 70);
+  bitSetAdd(kill, 70);
+  bitSetAdd(kill, 1);
+  bitSetFill(a, size);
+  bitSetTransfer(a, gen, src, kill, size);
+  test("transfer keeps gen, even if killed", bitSetContains(a, 1));
+  test("transfer keeps src bits that aren't killed", bitSetContains(a, 2));
+  test("transfer removes killed src bits", !bitSetContains(a, 70));
+  test("transfer overwrites dst", !bitSetContains(a, 0));
+
+  free(a);
+  free(b);
+  free(empty);
+  free(gen);
+  free(src);
+  free(kill);
+}
+
+/** labels and temps in the loop test - ids are dense, starting from zero */
+enum {
+  ENTRY_LABEL,
+  HEADER_LABEL,
+  BODY_LABEL,
+  EXIT_LABEL,
+  COUNTER_TEMP,
+  LIMIT_TEMP,
+  RESULT_TEMP,
+  NUM_IDS,
+};
+
+static IROperand *longTemp(size_t name) { return TEMP(name, 8, 8, AH_GP); }
+static IROperand *longConstant(uint64_t value) {
+  return CONSTANT(8, longDatumCreate(value));
+}
+
+static void testLoopLiveness(void) {
+  // entry:  counter = 0; limit = 10; jump header
+  // header: if counter < limit jump body else jump exit
+  // body:   counter = counter + 1; jump header
+  // exit:   result = counter; return result
+  IRFrag *frag = textFragCreate(format("loop"));
+  irArenaSet(frag->data.text.arena);
+  LinkedList *blocks = &frag->data.text.blocks;
+  IRBlock *b = BLOCK(ENTRY_LABEL, blocks);
+  IR(b, MOVE(longTemp(COUNTER_TEMP), longConstant(0)));
+  IR(b, MOVE(longTemp(LIMIT_TEMP), longConstant(10)));
+  IR(b, JUMP(HEADER_LABEL));
+  b = BLOCK(HEADER_LABEL, blocks);
+  IR(b, CJUMP(IO_J2L, BODY_LABEL, EXIT_LABEL, longTemp(COUNTER_TEMP),
+              longTemp(LIMIT_TEMP)));
+  b = BLOCK(BODY_LABEL, blocks);
+  IR(b, BINOP(IO_ADD, longTemp(COUNTER_TEMP), longTemp(COUNTER_TEMP),
+              longConstant(1)));
+  IR(b, JUMP(HEADER_LABEL));
+  b = BLOCK(EXIT_LABEL, blocks);
+  IR(b, MOVE(longTemp(RESULT_TEMP), longTemp(COUNTER_TEMP)));
+  IR(b, MOVE(REG(0, 8), longTemp(RESULT_TEMP)));
+  IR(b, RETURN());
+  irArenaSet(NULL);
+
+  Vector frags;
+  vectorInit(&frags);
+  vectorInsert(&frags, frag);
+  IRFragIndex index;
+  irFragIndexInit(&index, &frags, NUM_IDS);
+  IRCfg cfg;
+  irCfgInit(&cfg, blocks, &index);
+  Liveness liveness;
+  livenessInit(&liveness, &cfg, 0, NUM_IDS);
+
+  // blocks are numbered in list order, so block idx has label idx
+  test("nothing is live into the entry block",
+       !bitSetContains(livenessIn(&liveness, ENTRY_LABEL), COUNTER_TEMP) &&
+           !bitSetContains(livenessIn(&liveness, ENTRY_LABEL), LIMIT_TEMP));
+  test("loop-carried temp is live around the back edge",
+       bitSetContains(livenessOut(&liveness, BODY_LABEL), COUNTER_TEMP) &&
+           bitSetContains(livenessIn(&liveness, HEADER_LABEL),
+                          COUNTER_TEMP) &&
+           bitSetContains(livenessIn(&liveness, BODY_LABEL), COUNTER_TEMP));
+  test("loop-invariant temp is live through the whole loop",
+       bitSetContains(livenessOut(&liveness, ENTRY_LABEL), LIMIT_TEMP) &&
+           bitSetContains(livenessOut(&liveness, BODY_LABEL), LIMIT_TEMP) &&
+           bitSetContains(livenessIn(&liveness, HEADER_LABEL), LIMIT_TEMP));
+  test("temp read after the loop is live out of the loop",
+       bitSetContains(livenessIn(&liveness, EXIT_LABEL), COUNTER_TEMP) &&
+           !bitSetContains(livenessIn(&liveness, EXIT_LABEL), LIMIT_TEMP));
+  test("temp defined and used in one block isn't live into it",
+       !bitSetContains(livenessIn(&liveness, EXIT_LABEL), RESULT_TEMP));
+
+  // step back through the loop body
+  uint64_t *live = bitSetCreate(NUM_IDS);
+  bitSetCopy(live, livenessOut(&liveness, BODY_LABEL), NUM_IDS);
+  IRBlock *body = blocks->head->next->next->next->data;
+  IRInstruction const *add = body->instructions.head->next->data;
+  livenessStep(&liveness, live, add);
+  test("stepping over a read-modify-write keeps its temp live",
+       bitSetContains(live, COUNTER_TEMP) && bitSetContains(live, LIMIT_TEMP));
+  test("liveness checks operands by temp name",
+       livenessIsLive(&liveness, live, add->args[0]));
+  free(live);
+
+  livenessUninit(&liveness);
+  irCfgUninit(&cfg);
+  irFragIndexUninit(&index);
+  irFragVectorUninit(&frags);
+}
+
+void testDataflow(void) {
+  testBitSetOps();
+  testLoopLiveness();
+}
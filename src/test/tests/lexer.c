@@ -25,6 +25,7 @@
 #include "lexer/lexer.h"
 
 #include <assert.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -204,13 +205,13 @@ static void testAllTokens(void) {
       break;
     }
     if (TOKENS[idx].string != NULL && token.string != NULL &&
-        strcmp(TOKENS[idx].string, token.string) != 0) {
+        (strlen(TOKENS[idx].string) != token.length ||
+         strncmp(TOKENS[idx].string, token.string, token.length) != 0)) {
       additionalDataOK = false;
       messageString = TOKEN_NAMES[token.type];
       break;
     }
 
-    if (token.string != NULL) free(token.string);
     entry.errored = false;
   }
   testDynamic(format("lex accepts token for %s", messageString), errorFlagOK);
@@ -315,13 +316,13 @@ static void testErrors(void) {
       break;
     }
     if (TOKENS[idx].string != NULL && token.string != NULL &&
-        strcmp(TOKENS[idx].string, token.string) != 0) {
+        (strlen(TOKENS[idx].string) != token.length ||
+         strncmp(TOKENS[idx].string, token.string, token.length) != 0)) {
       additionalDataOK = false;
       messageString = TOKEN_NAMES[token.type];
       break;
     }
 
-    if (token.string != NULL) free(token.string);
     entry.errored = false;
   }
   testDynamic(format("token has expected error flag for %s", messageString),
@@ -372,8 +373,7 @@ static void testErrors(void) {
        token.character == 1);
   test("unterminated string literal is at expected line", token.line == 1);
   test("unterminated string literal's additional data is correct",
-       strcmp(token.string, "") == 0);
-  free(token.string);
+       token.length == 0);
   entry.errored = false;
 
   lex(&entry, &token);
@@ -388,13 +388,122 @@ static void testErrors(void) {
   lexerStateUninit(&entry);
 }
 
+static void testWhitespace(void) {
+  FileListEntry entry;  // forge the entry
+  entry.inputFilename = "testFiles/lexer/whitespace.tc";
+  entry.isCode = true;
+  entry.errored = false;
+
+  test("lexer initializes okay", lexerStateInit(&entry) == 0);
+
+  FILE *expected = fopen("testFiles/lexer/whitespace.txt", "r");
+  test("expected positions are readable", expected != NULL);
+  if (expected == NULL) {
+    lexerStateUninit(&entry);
+    return;
+  }
+
+  // the expected line and character of each token, ending with the eof
+  bool positionsOk = true;
+  bool typesOk = true;
+  size_t line;
+  size_t character;
+  Token token;
+  token.type = TT_ID;
+  while (token.type != TT_EOF &&
+         fscanf(expected, "%zu:%zu", &line, &character) == 2) {
+    lex(&entry, &token);
+    if (token.line != line || token.character != character)
+      positionsOk = false;
+    if (token.type != TT_ID && token.type != TT_EOF) typesOk = false;
+  }
+  test("whitespace and comments are skipped", typesOk);
+  test("whitespace and comments keep positions", positionsOk);
+  test("whitespace and comments end with eof", token.type == TT_EOF);
+  test("whitespace and comments produce no errors", entry.errored == false);
+
+  fclose(expected);
+  lexerStateUninit(&entry);
+}
+
+static void testNearKeywords(void) {
+  FileListEntry entry;  // forge the entry
+  entry.inputFilename = "testFiles/lexer/nearKeywords.tc";
+  entry.isCode = true;
+  entry.errored = false;
+
+  test("lexer initializes okay", lexerStateInit(&entry) == 0);
+
+  bool idsOk = true;
+  size_t numIds = 0;
+  Token token;
+  for (lex(&entry, &token); token.type != TT_EOF; lex(&entry, &token)) {
+    if (token.type != TT_ID || strlen(token.string) != token.length)
+      idsOk = false;
+    ++numIds;
+  }
+  test("words close to keywords are ids", idsOk);
+  test("words close to keywords are all lexed", numIds == 25);
+  test("words close to keywords produce no errors", entry.errored == false);
+
+  lexerStateUninit(&entry);
+}
+
+static void testPretokenized(void) {
+  FileListEntry streamed;  // forge the entries
+  streamed.inputFilename = "testFiles/lexer/allTokens.tc";
+  streamed.isCode = true;
+  streamed.errored = false;
+  FileListEntry pretokenized;
+  pretokenized.inputFilename = "testFiles/lexer/allTokens.tc";
+  pretokenized.isCode = true;
+  pretokenized.errored = false;
+
+  test("lexer initializes okay", lexerStateInit(&streamed) == 0);
+  test("lexer initializes okay", lexerStateInit(&pretokenized) == 0);
+  lexerStatePretokenize(&pretokenized);
+
+  bool tokensOk = true;
+  size_t numTokens = 0;
+  Token expected;
+  Token actual;
+  do {
+    lex(&streamed, &expected);
+    lex(&pretokenized, &actual);
+    if (expected.type != actual.type || expected.line != actual.line ||
+        expected.character != actual.character ||
+        expected.length != actual.length ||
+        (expected.string != NULL &&
+         memcmp(expected.string, actual.string, expected.length) != 0))
+      tokensOk = false;
+    ++numTokens;
+  } while (expected.type != TT_EOF);
+  test("pretokenized tokens match lexed tokens", tokensOk);
+  test("pretokenized buffer holds every token",
+       pretokenized.lexerState.tokens.size == numTokens);
+
+  lex(&pretokenized, &actual);
+  test("pretokenized lexer repeats eof", actual.type == TT_EOF);
+  unLex(&pretokenized, &actual);
+  lex(&pretokenized, &actual);
+  test("pretokenized lexer repeats eof after unlex", actual.type == TT_EOF);
+
+  for (size_t idx = 0; idx < numTokens + 1; ++idx)
+    unLex(&pretokenized, &actual);
+  lex(&pretokenized, &actual);
+  test("pretokenized lexer can push back many tokens",
+       actual.type == TT_MODULE && actual.line == 1 && actual.character == 1);
+
+  lexerStateUninit(&pretokenized);
+  lexerStateUninit(&streamed);
+}
+
 void testLexer(void) {
   assert("can't bless lexer tests" && !status.bless);
 
-  lexerInitMaps();
-
   testAllTokens();
   testErrors();
-
-  lexerUninitMaps();
+  testWhitespace();
+  testNearKeywords();
+  testPretokenized();
 }
\ No newline at end of file
@@ -25,16 +25,68 @@
 #include "parser/parser.h"
 
 #include <assert.h>
+#include <dirent.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "ast/dump.h"
+#include "ast/symbolTable.h"
+#include "ast/type.h"
+#include "dependencyFile.h"
 #include "engine.h"
 #include "fileList.h"
+#include "incremental.h"
 #include "ir/ir.h"
+#include "options.h"
+#include "parser/precompiled.h"
 #include "tests.h"
 #include "util/dump.h"
+#include "util/functional.h"
+
+/** reads all of a file, returning an empty string if it can't be read */
+static char *readFile(char const *filename) {
+  char *contents = NULL;
+  size_t length = 0;
+  FILE *out = open_memstream(&contents, &length);
+  FILE *in = fopen(filename, "rb");
+  if (in != NULL) {
+    for (int c = fgetc(in); c != EOF; c = fgetc(in)) fputc(c, out);
+    fclose(in);
+  }
+  fclose(out);
+  return contents;
+}
+
+/**
+ * parses the file list, capturing everything printed to stderr
+ *
+ * @param errors output parameter for what was printed (owned by the caller)
+ * @returns result of parse
+ */
+static int parseCaptured(char **errors) {
+  char errName[] = "/tmp/tlc-test-XXXXXX";
+  int errFd = mkstemp(errName);
+
+  fflush(stderr);
+  int savedStderr = dup(STDERR_FILENO);
+  dup2(errFd, STDERR_FILENO);
+  close(errFd);
+
+  int retval = parse();
+
+  fflush(stderr);
+  dup2(savedStderr, STDERR_FILENO);
+  close(savedStderr);
+
+  *errors = readFile(errName);
+  remove(errName);
+  return retval;
+}
 
 static void testModuleParser(void) {
   FileListEntry entries[1];
@@ -121,6 +173,57 @@ static void testImportParser(void) {
   vectorUninit(&entries[1].irFrags, (void (*)(void *))irFragFree);
   nodeFree(entries[2].ast);
   vectorUninit(&entries[2].irFrags, (void (*)(void *))irFragFree);
+
+  char *errors;
+  fileListEntryInit(&entries[0], "testFiles/parser/input/ambiguousImport.tc",
+                    true);
+  fileListEntryInit(&entries[1], "testFiles/parser/input/ambiguousA.td", false);
+  fileListEntryInit(&entries[2], "testFiles/parser/input/ambiguousB.td", false);
+  testDynamic(format("parser rejects %s", entries[0].inputFilename),
+              parseCaptured(&errors) != 0);
+  testDynamic(format("errors in %s", entries[0].inputFilename),
+              entries[0].errored == true);
+  testDynamic(
+      format("name in two imports of %s is ambiguous, with a note for each",
+             entries[0].inputFilename),
+      strcmp(errors,
+             "testFiles/parser/input/ambiguousImport.tc:7:10: error: 'x' "
+             "declared in mutliple imported modules\n"
+             "testFiles/parser/input/ambiguousA.td:3:5: note: declared here\n"
+             "testFiles/parser/input/ambiguousB.td:3:5: note: declared "
+             "here\n") == 0);
+  free(errors);
+  nodeFree(entries[0].ast);
+  vectorUninit(&entries[0].irFrags, (void (*)(void *))irFragFree);
+  nodeFree(entries[1].ast);
+  vectorUninit(&entries[1].irFrags, (void (*)(void *))irFragFree);
+  nodeFree(entries[2].ast);
+  vectorUninit(&entries[2].irFrags, (void (*)(void *))irFragFree);
+
+  // the module's own x and its implicit import's y shadow the ambiguous ones
+  FileListEntry shadowEntries[4];
+  fileList.entries = &shadowEntries[0];
+  fileList.size = 4;
+  fileListEntryInit(&shadowEntries[0],
+                    "testFiles/parser/input/shadowedImport.tc", true);
+  fileListEntryInit(&shadowEntries[1], "testFiles/parser/input/shadowing.td",
+                    false);
+  fileListEntryInit(&shadowEntries[2], "testFiles/parser/input/ambiguousA.td",
+                    false);
+  fileListEntryInit(&shadowEntries[3], "testFiles/parser/input/ambiguousB.td",
+                    false);
+  testDynamic(format("parser accepts %s", shadowEntries[0].inputFilename),
+              parseCaptured(&errors) == 0);
+  testDynamic(format("no errors in %s", shadowEntries[0].inputFilename),
+              shadowEntries[0].errored == false && errors[0] == '\0');
+  testDynamic(format("ast of %s is correct", shadowEntries[0].inputFilename),
+              dumpEqual(&shadowEntries[0], astDump,
+                        "testFiles/parser/expected/shadowedImport.txt"));
+  free(errors);
+  for (size_t idx = 0; idx < 4; ++idx) {
+    nodeFree(shadowEntries[idx].ast);
+    vectorUninit(&shadowEntries[idx].irFrags, (void (*)(void *))irFragFree);
+  }
 }
 
 static void testFunDefnParser(void) {
@@ -480,6 +583,300 @@ static void testTypedefDeclParser(void) {
   vectorUninit(&entries[0].irFrags, (void (*)(void *))irFragFree);
 }
 
+/**
+ * describe the top level symbol table of a file, so symbol tables built
+ * different ways can be compared
+ *
+ * @returns description (owned by the caller)
+ */
+static char *describeStab(FileListEntry const *entry) {
+  char *description;
+  size_t length;
+  FILE *out = open_memstream(&description, &length);
+  HashMap const *stab = entry->ast->data.file.stab;
+  for (size_t idx = 0; idx < stab->size; ++idx) {
+    SymbolTableEntry const *e = stab->values[idx];
+    fprintf(out, "%s %s at %zu:%zu:", symbolKindToString(e->kind), e->id,
+            e->line, e->character);
+    char *typeString;
+    switch (e->kind) {
+      case SK_VARIABLE: {
+        typeString = typeToString(e->data.variable.type);
+        fprintf(out, " %s", typeString);
+        free(typeString);
+        break;
+      }
+      case SK_FUNCTION: {
+        typeString = typeToString(e->data.function.returnType);
+        fprintf(out, " %s", typeString);
+        free(typeString);
+        typeString = typeVectorToString(&e->data.function.argumentTypes);
+        fprintf(out, " (%s)", typeString);
+        free(typeString);
+        break;
+      }
+      case SK_STRUCT: {
+        for (size_t field = 0; field < e->data.structType.fieldNames.size;
+             ++field) {
+          typeString =
+              typeToString(e->data.structType.fieldTypes.elements[field]);
+          fprintf(out, " %s %s;", typeString,
+                  (char const *)e->data.structType.fieldNames.elements[field]);
+          free(typeString);
+        }
+        break;
+      }
+      case SK_UNION: {
+        for (size_t option = 0; option < e->data.unionType.optionNames.size;
+             ++option) {
+          typeString =
+              typeToString(e->data.unionType.optionTypes.elements[option]);
+          fprintf(out, " %s %s;", typeString,
+                  (char const *)e->data.unionType.optionNames.elements[option]);
+          free(typeString);
+        }
+        break;
+      }
+      case SK_ENUM: {
+        typeString = typeToString(e->data.enumType.backingType);
+        fprintf(out, " %s", typeString);
+        free(typeString);
+        for (size_t constant = 0;
+             constant < e->data.enumType.constantValues.size; ++constant) {
+          SymbolTableEntry const *c =
+              e->data.enumType.constantValues.elements[constant];
+          if (c->data.enumConst.signedness)
+            fprintf(out, " %s = %lld,", c->id,
+                    (long long)c->data.enumConst.data.signedValue);
+          else
+            fprintf(out, " %s = %llu,", c->id,
+                    (unsigned long long)c->data.enumConst.data.unsignedValue);
+        }
+        break;
+      }
+      case SK_TYPEDEF: {
+        typeString = typeToString(e->data.typedefType.actual);
+        fprintf(out, " %s", typeString);
+        free(typeString);
+        break;
+      }
+      default: {
+        break;
+      }
+    }
+    fprintf(out, "\n");
+  }
+  fclose(out);
+  return description;
+}
+
+/** copies a file, returning whether it worked */
+static bool copyFile(char const *from, char const *to) {
+  FILE *in = fopen(from, "rb");
+  if (in == NULL) return false;
+  FILE *out = fopen(to, "wb");
+  if (out == NULL) {
+    fclose(in);
+    return false;
+  }
+  bool ok = true;
+  for (int c = fgetc(in); c != EOF; c = fgetc(in)) ok = fputc(c, out) != EOF;
+  fclose(in);
+  return fclose(out) == 0 && ok;
+}
+
+static void testPrecompiledDeclParser(void) {
+  Options original;
+  memcpy(&original, &options, sizeof(Options));
+
+  char dirName[] = "/tmp/tlc-test-XXXXXX";
+  bool madeDir = mkdtemp(dirName) != NULL;
+  test("precompiled test directory is created", madeDir);
+  if (!madeDir) return;
+  char *sourceName = format("%s/precompiled.td", dirName);
+  char *tdiName = format("%si", sourceName);
+  test("precompiled test source is copied",
+       copyFile("testFiles/parser/input/precompiled.td", sourceName));
+
+  FileListEntry entries[1];
+  fileList.entries = &entries[0];
+  fileList.size = 1;
+
+  // parse from source and write the module out
+  options.useTdi = false;
+  fileListEntryInit(&entries[0], sourceName, false);
+  test("parser accepts precompiled.td from source", parse() == 0);
+  test("precompiled.td is parsed from source",
+       entries[0].precompiled == NULL);
+  char *parsed = describeStab(&entries[0]);
+  precompiledWriteAll();
+  nodeFree(entries[0].ast);
+  vectorUninit(&entries[0].irFrags, (void (*)(void *))irFragFree);
+
+  // load it back in
+  options.useTdi = true;
+  fileListEntryInit(&entries[0], sourceName, false);
+  test("parser accepts precompiled.td from precompiled module", parse() == 0);
+  test("precompiled.td is loaded from precompiled module",
+       entries[0].precompiled != NULL);
+  char *loaded = describeStab(&entries[0]);
+  test("loaded declarations match parsed declarations",
+       strcmp(parsed, loaded) == 0);
+  free(loaded);
+  nodeFree(entries[0].ast);
+  precompiledUnload(&entries[0]);
+  vectorUninit(&entries[0].irFrags, (void (*)(void *))irFragFree);
+
+  // change the source - the precompiled module is stale
+  FILE *source = fopen(sourceName, "ab");
+  fputs("\nint extra;", source);
+  fclose(source);
+  fileListEntryInit(&entries[0], sourceName, false);
+  test("parser accepts changed precompiled.td", parse() == 0);
+  test("stale precompiled module is ignored", entries[0].precompiled == NULL);
+  loaded = describeStab(&entries[0]);
+  test("changed declarations are parsed from source",
+       strcmp(parsed, loaded) != 0);
+  free(loaded);
+  nodeFree(entries[0].ast);
+  vectorUninit(&entries[0].irFrags, (void (*)(void *))irFragFree);
+
+  free(parsed);
+  remove(tdiName);
+  remove(sourceName);
+  rmdir(dirName);
+  free(tdiName);
+  free(sourceName);
+
+  memcpy(&options, &original, sizeof(Options));
+}
+
+/**
+ * goes through the front end the way the compiler does, writing dependency
+ * files and incremental build records
+ *
+ * @param entries space for the two file list entries
+ * @param codeName code file to compile
+ * @param declName decl file the code file imports
+ * @returns number of code files that weren't skipped
+ */
+static size_t compileFrontEnd(FileListEntry entries[2], char const *codeName,
+                              char const *declName) {
+  fileList.entries = &entries[0];
+  fileList.size = 2;
+  fileListEntryInit(&entries[0], codeName, true);
+  fileListEntryInit(&entries[1], declName, false);
+  fileListIndexPaths();
+
+  size_t numCodes = incrementalFilter();
+  bool success = true;
+  if (numCodes != 0) {
+    success = parse() == 0;
+    if (success && options.dependencyFile)
+      success = writeDependencyFiles() == 0;
+    if (success) incrementalCollect();
+  }
+  incrementalFinish(success);
+
+  for (size_t idx = 0; idx < fileList.size; ++idx) {
+    nodeFree(fileList.entries[idx].ast);
+    vectorUninit(&fileList.entries[idx].irFrags,
+                 (void (*)(void *))irFragFree);
+  }
+  hashMapUninit(&fileList.paths, nullDtor);
+  hashMapInit(&fileList.paths);
+  return numCodes;
+}
+
+static void testDependencyTracking(void) {
+  Options original;
+  memcpy(&original, &options, sizeof(Options));
+
+  char dirName[] = "/tmp/tlc-test-XXXXXX";
+  bool madeDir = mkdtemp(dirName) != NULL;
+  test("dependency test directory is created", madeDir);
+  if (!madeDir) return;
+  char *codeName = format("%s/foo.tc", dirName);
+  char *declName = format("%s/target.td", dirName);
+  char *depName = format("%s/foo.d", dirName);
+  char *allDepsName = format("%s/all.d", dirName);
+  char *recordDir = format("%s/records", dirName);
+  test("dependency test sources are copied",
+       copyFile("testFiles/parser/input/importWithId.tc", codeName) &&
+           copyFile("testFiles/parser/input/target.td", declName) &&
+           mkdir(recordDir, 0700) == 0);
+
+  FileListEntry entries[2];
+  char *expected = format("%s/foo.s: %s/foo.tc \\\n  %s/target.td\n",
+                          dirName, dirName, dirName);
+
+  // one dependency file per code file
+  options.dependencyFile = true;
+  options.dependencyFileName = NULL;
+  test("-MD compiles foo.tc",
+       compileFrontEnd(entries, codeName, declName) == 1);
+  char *contents = readFile(depName);
+  test("-MD writes foo.s's prerequisites to foo.d",
+       strcmp(contents, expected) == 0);
+  free(contents);
+
+  // all dependencies to one file
+  options.dependencyFileName = allDepsName;
+  compileFrontEnd(entries, codeName, declName);
+  contents = readFile(allDepsName);
+  test("-MF writes foo.s's prerequisites to the named file",
+       strcmp(contents, expected) == 0);
+  free(contents);
+  options.dependencyFile = false;
+  options.dependencyFileName = NULL;
+
+  // incremental builds
+  options.incrementalDir = recordDir;
+  test("first incremental compilation compiles foo.tc",
+       compileFrontEnd(entries, codeName, declName) == 1);
+  test("unchanged foo.tc is skipped",
+       compileFrontEnd(entries, codeName, declName) == 0);
+
+  struct timespec later[2] = {{0, UTIME_NOW}, {0, UTIME_NOW}};
+  later[1].tv_sec = time(NULL) + 60;
+  later[1].tv_nsec = 0;
+  utimensat(AT_FDCWD, declName, later, 0);
+  test("foo.tc is skipped if target.td is touched but unchanged",
+       compileFrontEnd(entries, codeName, declName) == 0);
+
+  FILE *decl = fopen(declName, "ab");
+  fputs("\nint extra;", decl);
+  fclose(decl);
+  test("foo.tc is rebuilt after target.td changes",
+       compileFrontEnd(entries, codeName, declName) == 1);
+  test("rebuilt foo.tc is skipped again",
+       compileFrontEnd(entries, codeName, declName) == 0);
+
+  free(expected);
+  DIR *records = opendir(recordDir);
+  for (struct dirent *record = readdir(records); record != NULL;
+       record = readdir(records)) {
+    if (record->d_name[0] == '.') continue;
+    char *recordName = format("%s/%s", recordDir, record->d_name);
+    remove(recordName);
+    free(recordName);
+  }
+  closedir(records);
+  rmdir(recordDir);
+  remove(allDepsName);
+  remove(depName);
+  remove(declName);
+  remove(codeName);
+  rmdir(dirName);
+  free(recordDir);
+  free(allDepsName);
+  free(depName);
+  free(declName);
+  free(codeName);
+
+  memcpy(&options, &original, sizeof(Options));
+}
+
 static void testCompoundStmtParser(void) {
   FileListEntry entries[1];
   fileList.entries = &entries[0];
@@ -1299,6 +1696,8 @@ void testParser(void) {
   testUnionDeclParser();
   testEnumDeclParser();
   testTypedefDeclParser();
+  testPrecompiledDeclParser();
+  testDependencyTracking();
 
   testCompoundStmtParser();
   testIfStmtParser();
@@ -0,0 +1,193 @@
+// Copyright 2022 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/**
+ * @file
+ * tests for the compile server and client
+ */
+
+#include "server.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "engine.h"
+#include "tests.h"
+#include "util/format.h"
+#include "util/internalError.h"
+
+/**
+ * stands in for compiling: prints the working directory and arguments, and
+ * returns the number of arguments - or crashes, if asked to
+ */
+static int echoCompile(size_t argc, char const *const *argv) {
+  if (argc == 2 && strcmp(argv[1], "crash") == 0)
+    error(__FILE__, __LINE__, "crash requested");
+
+  char *cwd = getcwd(NULL, 0);
+  printf("%s:", cwd);
+  free(cwd);
+  for (size_t idx = 0; idx < argc; ++idx) printf(" %s", argv[idx]);
+  printf("\n");
+  fprintf(stderr, "done\n");
+  return (int)argc;
+}
+
+/**
+ * reads all of a file
+ *
+ * @returns contents (owned by the caller), or an empty string if the file
+ * can't be read
+ */
+static char *readFile(char const *filename) {
+  char *contents = NULL;
+  size_t length = 0;
+  FILE *out = open_memstream(&contents, &length);
+  FILE *in = fopen(filename, "rb");
+  if (in != NULL) {
+    for (int c = fgetc(in); c != EOF; c = fgetc(in)) fputc(c, out);
+    fclose(in);
+  }
+  fclose(out);
+  return contents;
+}
+
+/**
+ * sends a compilation to the server, capturing its stdout and stderr
+ *
+ * @param socketPath server to send to
+ * @param dirName directory to capture output in
+ * @param argc number of arguments
+ * @param argv arguments
+ * @param out output parameter for the compilation's stdout
+ * @param err output parameter for the compilation's stderr
+ * @returns result of clientRun
+ */
+static int runCaptured(char const *socketPath, char const *dirName,
+                       size_t argc, char const *const *argv, char **out,
+                       char **err) {
+  char *outName = format("%s/stdout", dirName);
+  char *errName = format("%s/stderr", dirName);
+  int outFd = open(outName, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  int errFd = open(errName, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+
+  fflush(stdout);
+  fflush(stderr);
+  int savedStdout = dup(STDOUT_FILENO);
+  int savedStderr = dup(STDERR_FILENO);
+  dup2(outFd, STDOUT_FILENO);
+  dup2(errFd, STDERR_FILENO);
+  close(outFd);
+  close(errFd);
+
+  int code = clientRun(socketPath, argc, argv);
+
+  fflush(stdout);
+  fflush(stderr);
+  dup2(savedStdout, STDOUT_FILENO);
+  dup2(savedStderr, STDERR_FILENO);
+  close(savedStdout);
+  close(savedStderr);
+
+  *out = readFile(outName);
+  *err = readFile(errName);
+  remove(outName);
+  remove(errName);
+  free(outName);
+  free(errName);
+  return code;
+}
+
+void testServer(void) {
+  char dirName[] = "/tmp/tlc-test-XXXXXX";
+  bool madeDir = mkdtemp(dirName) != NULL;
+  test("server test directory is created", madeDir);
+  if (!madeDir) return;
+  char *socketPath = format("%s/socket", dirName);
+
+  char const *const argv[] = {"./tlc", "foo.tc", "--bar"};
+  char *out;
+  char *err;
+  test("client without a server fails to connect",
+       runCaptured(socketPath, dirName, 3, argv, &out, &err) == -1);
+  free(out);
+  free(err);
+
+  fflush(stdout);
+  fflush(stderr);
+  pid_t server = fork();
+  if (server == 0) _exit(serverRun(socketPath, echoCompile));
+  test("server is started", server != -1);
+  if (server == -1) {
+    free(socketPath);
+    rmdir(dirName);
+    return;
+  }
+
+  // wait for the server to start listening
+  int code = -1;
+  for (size_t tries = 0; tries < 500 && code == -1; ++tries) {
+    code = runCaptured(socketPath, dirName, 3, argv, &out, &err);
+    if (code == -1) {
+      free(out);
+      free(err);
+      struct timespec delay = {0, 10000000};
+      nanosleep(&delay, NULL);
+    }
+  }
+  test("client reaches server", code != -1);
+  if (code != -1) {
+    char *cwd = getcwd(NULL, 0);
+    char *expected = format("%s: ./tlc foo.tc --bar\n", cwd);
+    test("server returns the compilation's exit code", code == 3);
+    test("compilation runs in the client's directory with its arguments",
+         strcmp(out, expected) == 0);
+    test("compilation writes to the client's stderr",
+         strcmp(err, "done\n") == 0);
+    free(expected);
+    free(cwd);
+    free(out);
+    free(err);
+
+    char const *const crashArgv[] = {"./tlc", "crash"};
+    code = runCaptured(socketPath, dirName, 2, crashArgv, &out, &err);
+    test("crashing compilation fails", code != -1 && code != 0);
+    test("crashing compilation reports an internal error to the client",
+         strstr(err, "internal compiler error") != NULL);
+    free(out);
+    free(err);
+
+    code = runCaptured(socketPath, dirName, 3, argv, &out, &err);
+    test("server keeps running after a compilation crashes", code == 3);
+    free(out);
+    free(err);
+  }
+
+  kill(server, SIGTERM);
+  waitpid(server, NULL, 0);
+  remove(socketPath);
+  rmdir(dirName);
+  free(socketPath);
+}
@@ -0,0 +1,100 @@
+// Copyright 2022 Justin Hu
+//
+// This file is part of the T Language Compiler.
+//
+// The T Language Compiler is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// The T Language Compiler is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// the T Language Compiler. If not see <https://www.gnu.org/licenses/>.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+/**
+ * @file
+ * tests for streaming compilation
+ */
+
+#include "streaming.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ast/ast.h"
+#include "engine.h"
+#include "exitCode.h"
+#include "fileList.h"
+#include "ir/dump.h"
+#include "ir/ir.h"
+#include "options.h"
+#include "parser/parser.h"
+#include "tests.h"
+#include "typechecker/typechecker.h"
+#include "util/diagnostics.h"
+#include "util/dump.h"
+#include "util/format.h"
+
+/** a debug-dump stop, and the IR expected once compilation stops there */
+typedef struct {
+  DebugDumpOption stop;
+  char const *name;
+  char const *expected;
+} DumpStop;
+
+static void testDumpStops(void) {
+  DumpStop const stops[] = {
+      {OPTION_DD_TRANSLATION, "translation", "expectedUnoptimized"},
+      {OPTION_DD_BLOCKED_OPTIMIZATION, "blocked-optimization",
+       "expectedBlockedOptimized"},
+      {OPTION_DD_TRACE_SCHEDULING, "trace-scheduling", "expectedScheduled"},
+      {OPTION_DD_SCHEDULED_OPTIMIZATION, "scheduled-optimization",
+       "expectedScheduledOptimized"},
+  };
+
+  FileListEntry entries[1];
+  fileList.entries = &entries[0];
+  fileList.size = 1;
+  for (size_t idx = 0; idx < sizeof(stops) / sizeof(DumpStop); ++idx) {
+    fileListEntryInit(&entries[0],
+                      "testFiles/translation/x86_64-linux/input/ifStmt.tc",
+                      true);
+    test("streaming test input parses", parse() == 0);
+    typecheckInit();
+
+    options.dump = stops[idx].stop;
+    diagnosticsBufferStart();
+    int code = compileFile(&entries[0]);
+    char *dumped = diagnosticsBufferEnd();
+    testDynamic(format("streamed file stopped at %s succeeds", stops[idx].name),
+                code == CODE_SUCCESS);
+    testDynamic(format("streamed file stopped at %s is dumped", stops[idx].name),
+                dumped[0] != '\0');
+    char *expectedName =
+        format("testFiles/translation/x86_64-linux/%s/ifStmt.txt",
+               stops[idx].expected);
+    testDynamic(format("streamed file isn't compiled past %s", stops[idx].name),
+                dumpEqual(&entries[0], irDump, expectedName));
+    free(expectedName);
+    free(dumped);
+
+    irFragVectorUninit(&entries[0].irFrags);
+    nodeFree(entries[0].ast);
+  }
+}
+
+void testStreaming(void) {
+  Options original;
+  memcpy(&original, &options, sizeof(Options));
+
+  testDumpStops();
+
+  memcpy(&options, &original, sizeof(Options));
+}
@@ -26,15 +26,106 @@
 
 #include <assert.h>
 #include <dirent.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
+#include <unistd.h>
 
+#include "ast/dump.h"
 #include "engine.h"
 #include "fileList.h"
+#include "ir/ir.h"
 #include "parser/parser.h"
 #include "tests.h"
 #include "util/format.h"
+#include "util/intern.h"
+#include "util/threadPool.h"
+
+/** results of running the front end over a file */
+typedef struct {
+  char *errors;  /**< everything printed to stderr */
+  char *ast;     /**< dump of the ast afterwards */
+  bool escapes;  /**< does the global 'shared' escape, if it exists */
+} FrontEndResult;
+
+/** reads all of a stream from its start */
+static char *readFile(FILE *in) {
+  char *contents = NULL;
+  size_t length = 0;
+  FILE *out = open_memstream(&contents, &length);
+  rewind(in);
+  for (int c = fgetc(in); c != EOF; c = fgetc(in)) fputc(c, out);
+  fclose(out);
+  return contents;
+}
+
+/**
+ * parses and typechecks a file on its own, capturing everything printed to
+ * stderr
+ */
+static void runFrontEnd(char const *filename, FrontEndResult *result) {
+  FileListEntry entries[1];
+  fileList.entries = &entries[0];
+  fileList.size = 1;
+  fileListEntryInit(&entries[0], filename, true);
+
+  FILE *errors = tmpfile();
+  fflush(stderr);
+  int savedStderr = dup(STDERR_FILENO);
+  dup2(fileno(errors), STDERR_FILENO);
+
+  if (parse() == 0) typecheck();
+
+  fflush(stderr);
+  dup2(savedStderr, STDERR_FILENO);
+  close(savedStderr);
+  result->errors = readFile(errors);
+  fclose(errors);
+
+  size_t length;
+  FILE *ast = open_memstream(&result->ast, &length);
+  astDump(ast, &entries[0]);
+  fclose(ast);
+
+  SymbolTableEntry *shared =
+      hashMapGet(entries[0].ast->data.file.stab, internString("shared"));
+  result->escapes = shared != NULL && shared->data.variable.escapes;
+
+  nodeFree(entries[0].ast);
+  vectorUninit(&entries[0].irFrags, (void (*)(void *))irFragFree);
+}
+
+/**
+ * checks that parsing and typechecking a file with errors in several of its
+ * functions gives the same results on four threads as on one
+ *
+ * @param filename file to run
+ * @param escapes should the global 'shared' escape
+ */
+static void testParallelFrontEnd(char const *filename, bool escapes) {
+  FrontEndResult serial;
+  runFrontEnd(filename, &serial);
+
+  threadPoolInit(4);
+  FrontEndResult parallel;
+  runFrontEnd(filename, &parallel);
+  threadPoolUninit();
+
+  testDynamic(format("%s has errors", filename), serial.errors[0] != '\0');
+  testDynamic(format("%s has the same errors in parallel", filename),
+              strcmp(serial.errors, parallel.errors) == 0);
+  testDynamic(format("%s has the same ast in parallel", filename),
+              strcmp(serial.ast, parallel.ast) == 0);
+  testDynamic(format("%s has the right escaping variables in parallel",
+                     filename),
+              serial.escapes == escapes && parallel.escapes == escapes);
+
+  free(serial.errors);
+  free(serial.ast);
+  free(parallel.errors);
+  free(parallel.ast);
+}
 
 void testTypechecker(void) {
   assert("can't bless typechecker tests" && !status.bless);
@@ -54,6 +145,7 @@ void testTypechecker(void) {
     entries[0].inputFilename = name;
     entries[0].isCode = true;
     entries[0].errored = false;
+    entries[0].precompiled = NULL;
 
     int parseStatus = parse();
     assert("couldn't parse file in testTypechecker's accepted file list" &&
@@ -79,6 +171,7 @@ void testTypechecker(void) {
     entries[0].inputFilename = name;
     entries[0].isCode = true;
     entries[0].errored = false;
+    entries[0].precompiled = NULL;
 
     int parseStatus = parse();
     assert("couldn't parse file in testTypechecker's rejected file list" &&
@@ -89,4 +182,7 @@ void testTypechecker(void) {
     free(name);
   }
   closedir(rejected);
-}
\ No newline at end of file
+
+  testParallelFrontEnd("testFiles/typechecker/parallel/parseErrors.tc", false);
+  testParallelFrontEnd("testFiles/typechecker/parallel/typeErrors.tc", true);
+}